@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+// number of children of a node
+static const uint32_t DARY_HEAP_ARITY = 4;
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<DaryHeapScheduler> ()
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DaryHeapScheduler::BottomUp (uint32_t index)
+{
+  // hold the moving element aside and shift the parents down into the hole
+  EventKey key = m_keys[index];
+  EventImpl *impl = m_impls[index];
+  while (index > 0)
+    {
+      uint32_t parent = (index - 1) / DARY_HEAP_ARITY;
+      if (!(key < m_keys[parent]))
+        {
+          break;
+        }
+      m_keys[index] = m_keys[parent];
+      m_impls[index] = m_impls[parent];
+      index = parent;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+DaryHeapScheduler::TopDown (uint32_t index)
+{
+  uint32_t size = m_keys.size ();
+  EventKey key = m_keys[index];
+  EventImpl *impl = m_impls[index];
+  while (true)
+    {
+      uint32_t first = index * DARY_HEAP_ARITY + 1;
+      if (first >= size)
+        {
+          break;
+        }
+      uint32_t last = first + DARY_HEAP_ARITY;
+      if (last > size)
+        {
+          last = size;
+        }
+      uint32_t smallest = first;
+      for (uint32_t child = first + 1; child < last; child++)
+        {
+          if (m_keys[child] < m_keys[smallest])
+            {
+              smallest = child;
+            }
+        }
+      if (!(m_keys[smallest] < key))
+        {
+          break;
+        }
+      m_keys[index] = m_keys[smallest];
+      m_impls[index] = m_impls[smallest];
+      index = smallest;
+    }
+  m_keys[index] = key;
+  m_impls[index] = impl;
+}
+
+void
+DaryHeapScheduler::RemoveAt (uint32_t index)
+{
+  uint32_t last = m_keys.size () - 1;
+  if (index != last)
+    {
+      m_keys[index] = m_keys[last];
+      m_impls[index] = m_impls[last];
+    }
+  m_keys.pop_back ();
+  m_impls.pop_back ();
+  if (index < last)
+    {
+      // the element moved in from the bottom may go either way
+      if (index > 0 && m_keys[index] < m_keys[(index - 1) / DARY_HEAP_ARITY])
+        {
+          BottomUp (index);
+        }
+      else
+        {
+          TopDown (index);
+        }
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  m_keys.push_back (ev.key);
+  m_impls.push_back (ev.impl);
+  BottomUp (m_keys.size () - 1);
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_keys.empty ();
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  return next;
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event next;
+  next.impl = m_impls[0];
+  next.key = m_keys[0];
+  RemoveAt (0);
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint32_t uid = ev.key.m_uid;
+  for (uint32_t i = 0; i < m_keys.size (); i++)
+    {
+      if (uid == m_keys[i].m_uid)
+        {
+          NS_ASSERT (m_impls[i] == ev.impl);
+          RemoveAt (i);
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+DaryHeapScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t last = 0;
+  for (uint32_t i = 0; i < m_keys.size (); i++)
+    {
+      if (m_impls[i]->IsCancelled ())
+        {
+          Event ev;
+          ev.impl = m_impls[i];
+          ev.key = m_keys[i];
+          removed.push_back (ev);
+        }
+      else
+        {
+          m_keys[last] = m_keys[i];
+          m_impls[last] = m_impls[i];
+          last++;
+        }
+    }
+  m_keys.resize (last);
+  m_impls.resize (last);
+  // heapify the survivors bottom-up, starting from the last parent
+  for (uint32_t i = (last + 2) / DARY_HEAP_ARITY; i-- > 0; )
+    {
+      TopDown (i);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a 4-ary implicit heap event scheduler
+ *
+ * Same classic data structure as HeapScheduler, with two changes aimed at
+ * the cache:
+ *  - every node has four children instead of two, so the heap is half as
+ *    deep and the four children compared at each level of a top-down
+ *    heapify sit next to each other in memory.
+ *  - the event keys and the EventImpl pointers are kept in two parallel
+ *    arrays. The comparisons only ever touch the keys, which are 16 bytes
+ *    each: the four children of a node fit in a single 64 byte line.
+ *
+ * The root is at index 0 and the children of node i are at 4i+1 to 4i+4.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DaryHeapScheduler ();
+  virtual ~DaryHeapScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
+
+private:
+  /* Move the element at index up until its parent is smaller. */
+  void BottomUp (uint32_t index);
+  /* Move the element at index down until its children are larger. */
+  void TopDown (uint32_t index);
+  /* Remove the element at index, replacing it with the last one. */
+  void RemoveAt (uint32_t index);
+
+  std::vector<EventKey> m_keys;
+  std::vector<EventImpl *> m_impls;
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
@@ -25,6 +25,8 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "double.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
 
@@ -46,6 +48,17 @@ DefaultSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DefaultSimulatorImpl")
     .SetParent<SimulatorImpl> ()
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CompactionRatio",
+                   "Remove the cancelled events from the event list once there are "
+                   "more than this many of them per live event. 0 disables it.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_compactionRatio),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("CompactionMinimum",
+                   "Never compact the event list while it holds fewer cancelled events than this.",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_compactionMinimum),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -64,6 +77,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+  m_compactions = 0;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
 }
@@ -137,12 +152,33 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  if (next.impl->IsCancelled () && m_cancelledEvents > 0)
+    {
+      m_cancelledEvents--;
+    }
   next.impl->Invoke ();
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
 }
 
+void
+DefaultSimulatorImpl::CompactEvents (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Scheduler::Event> removed;
+  m_events->RemoveCancelled (removed);
+  for (std::vector<Scheduler::Event>::const_iterator i = removed.begin (); i != removed.end (); ++i)
+    {
+      i->impl->Unref ();
+    }
+  m_unscheduledEvents -= removed.size ();
+  m_cancelledEvents = 0;
+  m_compactions++;
+  NS_LOG_LOGIC ("compaction removed " << removed.size () << " events, "
+                << m_unscheduledEvents << " left");
+}
+
 bool 
 DefaultSimulatorImpl::IsFinished (void) const
 {
@@ -353,6 +389,18 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () == 2)
+        {
+          // destroy events are not in the event list
+          return;
+        }
+      m_cancelledEvents++;
+      if (m_compactionRatio > 0
+          && m_cancelledEvents >= m_compactionMinimum
+          && m_cancelledEvents > m_compactionRatio * (m_unscheduledEvents - static_cast<int> (m_cancelledEvents)))
+        {
+          CompactEvents ();
+        }
     }
 }
 
@@ -404,4 +452,16 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint32_t
+DefaultSimulatorImpl::GetCancelledEvents (void) const
+{
+  return m_cancelledEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCompactions (void) const
+{
+  return m_compactions;
+}
+
 } // namespace ns3
@@ -63,10 +63,26 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \return the number of cancelled events still in the event list
+   *
+   * A cancelled event stays in the event list until it is due or the
+   * event list is compacted.
+   */
+  uint32_t GetCancelledEvents (void) const;
+  /**
+   * \return the number of times the event list has been compacted
+   */
+  uint32_t GetCompactions (void) const;
+
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
   void ProcessEventsWithContext (void);
+  /**
+   * Remove the cancelled events from the event list.
+   */
+  void CompactEvents (void);
  
   struct EventWithContext {
     uint32_t context;
@@ -90,6 +106,13 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  // number of cancelled events still in the event list
+  uint32_t m_cancelledEvents;
+  uint32_t m_compactions;
+  // the event list is compacted when there are more than m_compactionRatio
+  // cancelled events per live one, and at least m_compactionMinimum of them
+  double m_compactionRatio;
+  uint32_t m_compactionMinimum;
 
   SystemThread::ThreadId m_main;
 };
@@ -18,13 +18,163 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include "ns3/core-config.h"
 #include "event-impl.h"
 #include "log.h"
 
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+// the free lists are per thread where the compiler supports it,
+// otherwise events simply go through the global allocator
+#if defined (__GNUC__)
+#define EVENT_POOL_ENABLED 1
+#define EVENT_POOL_THREAD __thread
+#endif
+
 namespace ns3 {
 
+#ifdef EVENT_POOL_ENABLED
+namespace {
+
+// size classes are multiples of the granularity
+const std::size_t EVENT_POOL_GRANULARITY = 16;
+const std::size_t EVENT_POOL_CLASSES = 8;
+// beyond this many free blocks, memory goes back to the global allocator
+const uint32_t EVENT_POOL_MAX_FREE = 8192;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+struct FreeList
+{
+  FreeBlock *head;
+  uint32_t size;
+};
+
+// zero-initialized, one set per thread
+EVENT_POOL_THREAD FreeList g_eventFreeLists[EVENT_POOL_CLASSES];
+
+#ifdef HAVE_PTHREAD_H
+pthread_once_t g_eventPoolOnce = PTHREAD_ONCE_INIT;
+pthread_key_t g_eventPoolKey;
+// set once the free lists of the thread are handed to the key
+EVENT_POOL_THREAD bool g_eventPoolRegistered = false;
+
+/**
+ * Give the free blocks of an exiting thread back to the global allocator
+ */
+void
+ReleaseEventFreeLists (void *p)
+{
+  FreeList *lists = static_cast<FreeList *> (p);
+  for (std::size_t i = 0; i < EVENT_POOL_CLASSES; ++i)
+    {
+      while (lists[i].head != 0)
+        {
+          FreeBlock *block = lists[i].head;
+          lists[i].head = block->next;
+          ::operator delete (block);
+        }
+      lists[i].size = 0;
+    }
+  // events deleted by later destructors of the thread register it again
+  g_eventPoolRegistered = false;
+}
+
+void
+CreateEventPoolKey (void)
+{
+  pthread_key_create (&g_eventPoolKey, &ReleaseEventFreeLists);
+}
+
+/**
+ * Make sure the free lists of this thread are released when it exits
+ */
+void
+RegisterEventFreeLists (void)
+{
+  pthread_once (&g_eventPoolOnce, &CreateEventPoolKey);
+  pthread_setspecific (g_eventPoolKey, g_eventFreeLists);
+  g_eventPoolRegistered = true;
+}
+#endif /* HAVE_PTHREAD_H */
+
+} // anonymous namespace
+#endif /* EVENT_POOL_ENABLED */
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+#ifdef EVENT_POOL_ENABLED
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass < EVENT_POOL_CLASSES)
+    {
+      FreeList &list = g_eventFreeLists[sizeClass];
+      if (list.head != 0)
+        {
+          FreeBlock *block = list.head;
+          list.head = block->next;
+          list.size--;
+          return block;
+        }
+      // every block of a class has the size of the class
+      return ::operator new ((sizeClass + 1) * EVENT_POOL_GRANULARITY);
+    }
+#endif /* EVENT_POOL_ENABLED */
+  return ::operator new (size);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+#ifdef EVENT_POOL_ENABLED
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass < EVENT_POOL_CLASSES)
+    {
+      FreeList &list = g_eventFreeLists[sizeClass];
+      if (list.size < EVENT_POOL_MAX_FREE)
+        {
+#ifdef HAVE_PTHREAD_H
+          if (!g_eventPoolRegistered)
+            {
+              RegisterEventFreeLists ();
+            }
+#endif /* HAVE_PTHREAD_H */
+          FreeBlock *block = static_cast<FreeBlock *> (p);
+          block->next = list.head;
+          list.head = block;
+          list.size++;
+          return;
+        }
+    }
+#endif /* EVENT_POOL_ENABLED */
+  ::operator delete (p);
+}
+
+uint32_t
+EventImpl::GetFreeBlocks (void)
+{
+  uint32_t blocks = 0;
+#ifdef EVENT_POOL_ENABLED
+  for (std::size_t i = 0; i < EVENT_POOL_CLASSES; ++i)
+    {
+      blocks += g_eventFreeLists[i].size;
+    }
+#endif /* EVENT_POOL_ENABLED */
+  return blocks;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
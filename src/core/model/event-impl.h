@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +36,14 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are small, short-lived and allocated at a very high rate, so
+ * they do not go through the global allocator each time: the memory of
+ * a deleted event is kept on a free list of its size class (a multiple
+ * of 16 bytes, up to 128 bytes) and handed to the next event of that
+ * class. The free lists are per thread, so that the threads scheduling
+ * events with a context into the realtime simulator need no lock; an
+ * event may be freed by another thread than the one which allocated it.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -58,6 +67,24 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * \param size the size of the event
+   * \returns memory for the event, from the free list of its size class
+   */
+  static void *operator new (std::size_t size);
+  /**
+   * \param p the memory of the event
+   * \param size the size of the event
+   *
+   * Put the memory of the event on the free list of its size class.
+   */
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * \returns the number of freed event blocks the calling thread keeps
+   * for reuse, 0 when events go through the global allocator
+   */
+  static uint32_t GetFreeBlocks (void);
+
 protected:
   virtual void Notify (void) = 0;
 
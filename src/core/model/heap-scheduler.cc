@@ -236,5 +236,29 @@ HeapScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+void
+HeapScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t last = Root ();
+  for (uint32_t i = Root (); i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
+        {
+          removed.push_back (m_heap[i]);
+        }
+      else
+        {
+          m_heap[last++] = m_heap[i];
+        }
+    }
+  m_heap.resize (last);
+  // heapify the survivors bottom-up
+  for (uint32_t i = Last () / 2; i >= Root (); i--)
+    {
+      TopDown (i);
+    }
+}
+
 } // namespace ns3
 
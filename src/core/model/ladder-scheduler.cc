@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+// maximum number of rungs of the ladder
+static const uint32_t LADDER_MAX_RUNGS = 8;
+// a bucket with more events than this is spread over a new rung
+static const uint32_t LADDER_THRESHOLD = 50;
+// a bottom with more events than this is turned into a rung
+static const uint32_t LADDER_BOTTOM_MAX = 4 * LADDER_THRESHOLD;
+
+namespace {
+
+// moves the cancelled events of a bucket to removed, keeping the others in order
+void
+RemoveCancelledFrom (std::vector<Scheduler::Event> &bucket, std::vector<Scheduler::Event> &removed)
+{
+  std::vector<Scheduler::Event>::iterator last = bucket.begin ();
+  for (std::vector<Scheduler::Event>::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->impl->IsCancelled ())
+        {
+          removed.push_back (*i);
+        }
+      else
+        {
+          *last++ = *i;
+        }
+    }
+  bucket.erase (last, bucket.end ());
+}
+
+// orders bottom by decreasing key, so that the next event is at the back
+struct LaterEvent
+{
+  bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const
+  {
+    return b.key < a.key;
+  }
+};
+
+} // anonymous namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (LADDER_MAX_RUNGS),
+    m_nRungs (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint64_t
+LadderScheduler::SpawnRung (Bucket &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < LADDER_MAX_RUNGS);
+  NS_ASSERT (start < end);
+
+  // about one event per bucket, so there are never more buckets than events
+  Rung &rung = m_rungs[m_nRungs++];
+  rung.start = start;
+  rung.width = (end - start) / events.size () + 1;
+  rung.current = 0;
+  // every bucket of a rung is empty once it has been dropped
+  rung.buckets.resize ((end - start + rung.width - 1) / rung.width);
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      NS_ASSERT (i->key.m_ts >= start && i->key.m_ts < end);
+      rung.buckets[(i->key.m_ts - start) / rung.width].push_back (*i);
+    }
+  events.clear ();
+  return start + rung.buckets.size () * rung.width;
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, LaterEvent ()), ev);
+  if (m_bottom.size () > LADDER_BOTTOM_MAX
+      && m_nRungs < LADDER_MAX_RUNGS
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      // too many events scheduled close to now, stop sorting them
+      uint64_t end = m_nRungs > 0 ? CurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+      SpawnRung (m_bottom, m_bottom.back ().key.m_ts, end);
+    }
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size > 0);
+
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          NS_ASSERT (!m_top.empty ());
+          if (m_top.size () <= LADDER_THRESHOLD)
+            {
+              m_bottom.swap (m_top);
+              std::sort (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+              m_topStart = m_topMax + 1;
+              return;
+            }
+          m_topStart = SpawnRung (m_top, m_topMin, m_topMax + 1);
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.current < rung.buckets.size () && rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      if (rung.current == rung.buckets.size ())
+        {
+          // the rung is exhausted, carry on with the previous one
+          m_nRungs--;
+          continue;
+        }
+
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t end = CurrentStart (rung) + rung.width;
+      rung.current++;
+      if (bucket.size () > LADDER_THRESHOLD
+          && rung.width > 1
+          && m_nRungs < LADDER_MAX_RUNGS)
+        {
+          uint64_t start = end;
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              start = std::min (start, i->key.m_ts);
+            }
+          SpawnRung (bucket, start, end);
+          continue;
+        }
+
+      m_bottom.swap (bucket);
+      std::sort (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  m_size++;
+
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      m_top.push_back (ev);
+      return;
+    }
+
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= CurrentStart (rung))
+        {
+          uint64_t index = (ts - rung.start) / rung.width;
+          NS_ASSERT (index < rung.buckets.size ());
+          rung.buckets[index].push_back (ev);
+          return;
+        }
+    }
+
+  InsertBottom (ev);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      // refilling bottom does not change the content of the queue
+      const_cast<LadderScheduler *> (this)->Refill ();
+    }
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  Event next = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  m_size--;
+
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket = &m_bottom;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= CurrentStart (rung))
+            {
+              bucket = &rung.buckets[(ts - rung.start) / rung.width];
+              break;
+            }
+        }
+    }
+
+  if (bucket == &m_bottom)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, LaterEvent ());
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      NS_ASSERT (i->impl == ev.impl);
+      m_bottom.erase (i);
+      return;
+    }
+
+  // top and buckets are unsorted
+  for (Bucket::iterator i = bucket->begin (); i != bucket->end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (i->impl == ev.impl);
+          *i = bucket->back ();
+          bucket->pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::RemoveCancelled (std::vector<Event> &removed)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t before = removed.size ();
+  RemoveCancelledFrom (m_top, removed);
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      for (uint32_t j = rung.current; j < rung.buckets.size (); j++)
+        {
+          RemoveCancelledFrom (rung.buckets[j], removed);
+        }
+    }
+  RemoveCancelledFrom (m_bottom, removed);
+  m_size -= removed.size () - before;
+}
+
+} // namespace ns3
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue published in 2005 in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale Discrete
+ * Event Simulation" by Tang, Goh and Thng. Events live in one of three tiers:
+ *  - Top: an unsorted array of the events furthest in the future. An insert
+ *    into it is a push_back.
+ *  - the Ladder: up to 8 rungs of buckets. The first rung is built from Top
+ *    when everything closer has been consumed, with about one event per
+ *    bucket. A bucket holding too many events is spread over a new, finer
+ *    rung instead of being sorted.
+ *  - Bottom: a small sorted array of the events due next, taken from the
+ *    first non-empty bucket of the last rung.
+ *
+ * Unlike the calendar queue, the bucket width is derived from the events
+ * themselves each time a rung is built, so there is no resizing heuristic
+ * to get wrong when the event distribution changes: a few million flow
+ * timers far ahead do not slow down the packet events due next.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+  virtual void RemoveCancelled (std::vector<Event> &removed);
+
+private:
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  struct Rung
+  {
+    // timestamp at the start of the first bucket
+    uint64_t start;
+    // duration of a bucket
+    uint64_t width;
+    // first bucket not consumed yet
+    uint32_t current;
+    std::vector<Bucket> buckets;
+  };
+
+  /* Timestamp at the start of the first bucket not consumed yet. */
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  /* Spread events over a new rung covering [start, end). Return the end of the rung. */
+  uint64_t SpawnRung (Bucket &events, uint64_t start, uint64_t end);
+  /* Keep the events of bottom sorted, the next one at the back. */
+  void InsertBottom (const Event &ev);
+  /* Fill bottom from the ladder or from top. */
+  void Refill (void);
+
+  // unsorted events at or after m_topStart
+  Bucket m_top;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  uint64_t m_topStart;
+  // rungs in use are [0, m_nRungs), each one finer than the previous
+  std::vector<Rung> m_rungs;
+  uint32_t m_nRungs;
+  // sorted by decreasing key
+  Bucket m_bottom;
+  // number of events in queue
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -22,6 +22,7 @@
 #define SCHEDULER_H
 
 #include <stdint.h>
+#include <vector>
 #include "object.h"
 
 namespace ns3 {
@@ -102,6 +103,17 @@ public:
    * This methods cannot be invoked if the list is empty.
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * \param removed the events removed, appended to
+   *
+   * Remove from the event list every event whose EventImpl has been
+   * cancelled.  As with the other Remove methods, the caller is
+   * responsible for unref'ing the removed events.
+   *
+   * The default implementation removes nothing: the cancelled events
+   * stay in the event list until they are due.
+   */
+  virtual void RemoveCancelled (std::vector<Event> &removed);
 };
 
 /* Note the invariants which this function must provide:
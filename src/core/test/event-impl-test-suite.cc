@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/test.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+
+#include <set>
+#include <vector>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * An event counting its invocations
+ */
+class CountingEvent : public EventImpl
+{
+public:
+  CountingEvent (uint32_t *count)
+    : m_count (count)
+  {
+  }
+
+protected:
+  virtual void Notify (void)
+  {
+    (*m_count)++;
+  }
+
+private:
+  uint32_t *m_count;
+};
+
+/**
+ * What a thread freeing the events of another thread sees
+ */
+struct ForeignFree
+{
+  std::vector<EventImpl *> events; //!< Events allocated by the main thread
+  uint32_t freed;                  //!< Blocks the thread gained by freeing them
+  uint32_t reused;                 //!< Blocks of the events allocated again by the thread
+  uint32_t invoked;                //!< Invocations of the events allocated again
+};
+
+void
+FreeForeignEvents (ForeignFree *state)
+{
+  uint32_t before = EventImpl::GetFreeBlocks ();
+  std::set<EventImpl *> blocks (state->events.begin (), state->events.end ());
+  for (std::vector<EventImpl *>::iterator i = state->events.begin (); i != state->events.end (); ++i)
+    {
+      delete *i;
+    }
+  state->freed = EventImpl::GetFreeBlocks () - before;
+
+  // The blocks now belong to the free lists of this thread
+  std::vector<EventImpl *> again;
+  for (uint32_t i = 0; i < state->events.size (); ++i)
+    {
+      again.push_back (new CountingEvent (&state->invoked));
+      state->reused += blocks.count (again.back ());
+      again.back ()->Invoke ();
+    }
+  for (std::vector<EventImpl *>::iterator i = again.begin (); i != again.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * What a thread sees of its free lists while it exits
+ */
+struct ExitRelease
+{
+  pthread_key_t key;
+  uint32_t calls;       //!< Calls of the destructor of the key
+  uint32_t kept;        //!< Blocks the thread kept before exiting
+  uint32_t released;    //!< Blocks left once the free lists were released
+  uint32_t registered;  //!< Blocks kept from an event freed after the release
+};
+
+/**
+ * Destructor of the key of the test; it is set again once, so that by its
+ * second call every destructor of the thread, the one of the free lists
+ * included, has run at least once
+ */
+void
+CheckExitRelease (void *p)
+{
+  ExitRelease *state = static_cast<ExitRelease *> (p);
+  if (++state->calls == 1)
+    {
+      pthread_setspecific (state->key, state);
+      return;
+    }
+  state->released = EventImpl::GetFreeBlocks ();
+  uint32_t count = 0;
+  delete new CountingEvent (&count);
+  state->registered = EventImpl::GetFreeBlocks ();
+}
+
+void
+FreeEventsAndExit (ExitRelease *state)
+{
+  uint32_t count = 0;
+  std::vector<EventImpl *> events;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      events.push_back (new CountingEvent (&count));
+    }
+  for (std::vector<EventImpl *>::iterator i = events.begin (); i != events.end (); ++i)
+    {
+      delete *i;
+    }
+  state->kept = EventImpl::GetFreeBlocks ();
+  pthread_setspecific (state->key, state);
+}
+#endif /* HAVE_PTHREAD_H */
+
+} // anonymous namespace
+
+/**
+ * Checks events allocated by a thread and freed by another go to the free
+ * lists of the thread freeing them, which reuses them
+ */
+class EventImplForeignFreeTestCase : public TestCase
+{
+public:
+  EventImplForeignFreeTestCase ();
+  virtual void DoRun (void);
+};
+
+EventImplForeignFreeTestCase::EventImplForeignFreeTestCase ()
+  : TestCase ("Check events freed by another thread")
+{
+}
+
+void
+EventImplForeignFreeTestCase::DoRun (void)
+{
+  static const uint32_t EVENTS = 1000;
+  ForeignFree state;
+  state.freed = 0;
+  state.reused = 0;
+  state.invoked = 0;
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < EVENTS; ++i)
+    {
+      state.events.push_back (new CountingEvent (&count));
+    }
+  uint32_t before = EventImpl::GetFreeBlocks ();
+
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&FreeForeignEvents, &state));
+  thread->Start ();
+  thread->Join ();
+
+  NS_TEST_EXPECT_MSG_EQ (state.freed, EVENTS, "The freeing thread must keep the blocks");
+  NS_TEST_EXPECT_MSG_EQ (state.reused, EVENTS, "The freeing thread must reuse the blocks");
+  NS_TEST_EXPECT_MSG_EQ (state.invoked, EVENTS, "The reused blocks must hold working events");
+  NS_TEST_EXPECT_MSG_EQ (EventImpl::GetFreeBlocks (), before, "The allocating thread must not get the blocks back");
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Checks the free lists of a thread are released when it exits, and that
+ * an event freed by a later destructor of the thread is still kept
+ */
+class EventImplExitReleaseTestCase : public TestCase
+{
+public:
+  EventImplExitReleaseTestCase ();
+  virtual void DoRun (void);
+};
+
+EventImplExitReleaseTestCase::EventImplExitReleaseTestCase ()
+  : TestCase ("Check the free lists of an exiting thread are released")
+{
+}
+
+void
+EventImplExitReleaseTestCase::DoRun (void)
+{
+  ExitRelease state;
+  state.calls = 0;
+  state.kept = 0;
+  state.released = 0;
+  state.registered = 0;
+  NS_TEST_ASSERT_MSG_EQ (pthread_key_create (&state.key, &CheckExitRelease), 0, "Cannot create a key");
+
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&FreeEventsAndExit, &state));
+  thread->Start ();
+  thread->Join ();
+  pthread_key_delete (state.key);
+
+  NS_TEST_EXPECT_MSG_EQ (state.kept, 100, "The thread must keep the blocks it freed");
+  NS_TEST_ASSERT_MSG_EQ (state.calls, 2, "The destructor of the test did not run twice");
+  NS_TEST_EXPECT_MSG_EQ (state.released, 0, "The free lists must be released when the thread exits");
+  NS_TEST_EXPECT_MSG_EQ (state.registered, 1, "An event freed after the release must be kept again");
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Runs the test cases of the EventImpl free lists
+ */
+class EventImplTestSuite : public TestSuite
+{
+public:
+  EventImplTestSuite ();
+};
+
+EventImplTestSuite::EventImplTestSuite ()
+  : TestSuite ("event-impl", UNIT)
+{
+  // without free lists, events go through the global allocator
+  uint32_t count = 0;
+  delete new CountingEvent (&count);
+  if (EventImpl::GetFreeBlocks () == 0)
+    {
+      return;
+    }
+  AddTestCase (new EventImplForeignFreeTestCase, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new EventImplExitReleaseTestCase, TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
+}
+
+static EventImplTestSuite g_eventImplTestSuite; //!< The test suite
@@ -19,10 +19,14 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/uinteger.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 
 using namespace ns3;
 
@@ -168,6 +172,61 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SimulatorCompactionTestCase : public TestCase
+{
+public:
+  SimulatorCompactionTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Count (void);
+  uint32_t m_count;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorCompactionTestCase::SimulatorCompactionTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that cancelled events are compacted out of " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorCompactionTestCase::Count (void)
+{
+  m_count++;
+}
+
+void
+SimulatorCompactionTestCase::DoRun (void)
+{
+  m_count = 0;
+
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Compaction is only implemented by DefaultSimulatorImpl");
+  impl->SetAttribute ("CompactionMinimum", UintegerValue (100));
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (i + 1), &SimulatorCompactionTestCase::Count, this));
+    }
+  // the 501st cancel leaves more cancelled events than live ones
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      if (i % 4 != 0)
+        {
+          ids[i].Cancel ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (impl->GetCompactions (), 1, "The event list should have been compacted once");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetCancelledEvents (), 249, "Cancels after the compaction are still resident");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 250, "Only the events not cancelled should have run");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetCancelledEvents (), 0, "Cancelled events are dropped when they come due");
+  Simulator::Destroy ();
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -469,11 +528,21 @@ public:
     factory.SetTypeId (ListScheduler::GetTypeId ());
 
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (MapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (HeapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
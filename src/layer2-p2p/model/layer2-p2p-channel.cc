@@ -21,8 +21,11 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/log.h"
 
+#include <vector>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Layer2P2PChannel");
@@ -94,11 +97,29 @@ Layer2P2PChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Ptr<Packet> originalPacket = p->Copy ();
+  Ptr<Node> dstNode = m_link[wire].m_dst->GetNode ();
+  Ptr<Packet> originalPacket;
+  if (MultithreadedSimulatorImpl::IsRunning ()
+      && dstNode->GetSystemId () != src->GetNode ()->GetSystemId ())
+    {
+      // The ends are run by different threads of MultithreadedSimulatorImpl,
+      // which must not share the reference counted data of the packet: hand
+      // over a deserialized copy, as the MPI engines do.
+      uint32_t size = p->GetSerializedSize ();
+      std::vector<uint8_t> buffer (size);
+      p->Serialize (&buffer[0], size);
+      originalPacket = Create<Packet> (&buffer[0], size, true);
+    }
+  else
+    {
+      originalPacket = p->Copy ();
+    }
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  // Bind the device by pointer, so the thread of the sender does not touch
+  // its reference count; the channel keeps it alive.
+  Simulator::ScheduleWithContext (dstNode->GetId (),
                                   txTime + m_delay, &Layer2P2PNetDevice::Receive,
-                                  m_link[wire].m_dst, originalPacket);
+                                  PeekPointer (m_link[wire].m_dst), originalPacket);
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (originalPacket, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -85,6 +85,11 @@ Layer2P2PNetDevice::GetTypeId (void)
 		BooleanValue (false),
 		MakeBooleanAccessor (&Layer2P2PNetDevice::m_sdnEnable),
 		MakeBooleanChecker ())
+	.AddAttribute ("SdnFastReceive",
+		"Hand received frames to the sdn receive callback without copying them or removing their header and trailer.",
+		BooleanValue (false),
+		MakeBooleanAccessor (&Layer2P2PNetDevice::m_sdnFastReceive),
+		MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -431,6 +436,12 @@ Layer2P2PNetDevice::Receive (Ptr<Packet> packet)
       return;
     }
 
+  if (IsSdnEnabled () && m_sdnFastReceive)
+    {
+      ReceiveSdnFast (packet);
+      return;
+    }
+
   //
   // Trace sinks will expect complete packets, not packets without some of the
   // headers.
@@ -438,9 +449,9 @@ Layer2P2PNetDevice::Receive (Ptr<Packet> packet)
   Ptr<Packet> originalPacket = packet->Copy ();
   Ptr<Packet> copyPacket = packet->Copy ();
 
-  EthernetHeader header (false);
-  copyPacket->RemoveHeader (header);
-
+  //
+  // The FCS covers the header and the payload, as computed in AddHeader.
+  //
   EthernetTrailer trailer;
   copyPacket->RemoveTrailer (trailer);
   if (Node::ChecksumEnabled ())
@@ -456,6 +467,9 @@ Layer2P2PNetDevice::Receive (Ptr<Packet> packet)
       return;
     }
 
+  EthernetHeader header (false);
+  copyPacket->RemoveHeader (header);
+
   NS_LOG_LOGIC ("Pkt source is " << header.GetSource ());
   NS_LOG_LOGIC ("Pkt destination is " << header.GetDestination ());
 
@@ -551,6 +565,41 @@ Layer2P2PNetDevice::Receive (Ptr<Packet> packet)
     }
 }
 
+void
+Layer2P2PNetDevice::ReceiveSdnFast (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  EthernetHeader header (false);
+  packet->PeekHeader (header);
+
+  //
+  // The FCS covers the header and the payload, as computed in AddHeader. It is
+  // only checked when checksums are enabled, otherwise it always passes anyway.
+  //
+  if (Node::ChecksumEnabled ())
+    {
+      EthernetTrailer trailer;
+      packet->PeekTrailer (trailer);
+      trailer.EnableFcs (true);
+      Ptr<Packet> frame = packet->CreateFragment (0, packet->GetSize () - trailer.GetSerializedSize ());
+      if (!trailer.CheckFcs (frame))
+        {
+          NS_LOG_INFO ("CRC error on Packet " << packet);
+          m_phyRxDropTrace (packet);
+          return;
+        }
+    }
+
+  NS_LOG_LOGIC ("Pkt source is " << header.GetSource ());
+  NS_LOG_LOGIC ("Pkt destination is " << header.GetDestination ());
+
+  if (!m_sdnRxCallback.IsNull ())
+    {
+      m_sdnRxCallback (this, packet, header.GetLengthType (), header.GetSource ());
+    }
+}
+
 Ptr<Queue>
 Layer2P2PNetDevice::GetQueue (void) const
 { 
@@ -824,4 +873,18 @@ Layer2P2PNetDevice::IsSdnEnabled (void)
   return m_sdnEnable;
 }
 
+void
+Layer2P2PNetDevice::SetSdnFastReceive (bool sdnFastReceive)
+{
+  NS_LOG_FUNCTION (sdnFastReceive);
+  m_sdnFastReceive = sdnFastReceive;
+}
+
+bool
+Layer2P2PNetDevice::IsSdnFastReceiveEnabled (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_sdnFastReceive;
+}
+
 } // namespace ns3
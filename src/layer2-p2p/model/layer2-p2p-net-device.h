@@ -172,6 +172,23 @@ public:
    */
   void SetSdnEnable (bool enable);
 
+  /**
+   * Are frames handed to the Sdn receive callback without copies?
+   *
+   * \returns True if the fast Sdn receive path is enabled
+   */
+  bool IsSdnFastReceiveEnabled (void);
+
+  /**
+   * Enable or disable the fast Sdn receive path. The received frame is then
+   * handed as is to the Sdn receive callback, which takes it over: its header
+   * and trailer are only peeked at, and the FCS is only checked when checksums
+   * are enabled.
+   *
+   * \param enable Enables the fast path if true, otherwise disable.
+   */
+  void SetSdnFastReceive (bool enable);
+
   /**
    * Set the encapsulation mode of this device.
    *
@@ -304,6 +321,13 @@ private:
    */
   bool ProcessHeader (Ptr<Packet> p, uint16_t& param);
 
+  /**
+   * Hands a received frame over to the Sdn receive callback as is, the
+   * fast Sdn receive path.
+   * \param packet The received frame, header and trailer included
+   */
+  void ReceiveSdnFast (Ptr<Packet> packet);
+
   /**
    * Start Sending a Packet Down the Wire.
    *
@@ -341,6 +365,11 @@ private:
    */
   bool m_sdnEnable;
 
+  /**
+   * Hand frames to the Sdn receive callback without copying them
+   */
+  bool m_sdnFastReceive;
+
   /**
    * Enumeration of the states of the transmit machine of the net device.
    */
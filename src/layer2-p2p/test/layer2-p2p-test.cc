@@ -3,6 +3,10 @@
 #include "ns3/simulator.h"
 #include "ns3/layer2-p2p-net-device.h"
 #include "ns3/layer2-p2p-channel.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -73,6 +77,140 @@ Layer2P2PTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the fast Sdn receive path
+ *
+ * It sends the same frames to an Sdn enabled device with and without the
+ * fast receive path, with and without checksums, and checks the Sdn
+ * receive callback gets the same frames either way.
+ */
+class Layer2P2PSdnFastReceiveTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  Layer2P2PSdnFastReceiveTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief A frame handed to the Sdn receive callback
+   */
+  struct Frame
+  {
+    std::vector<uint8_t> data; //!< The frame bytes, header and trailer included
+    uint16_t protocol;         //!< The protocol passed to the callback
+    Address from;              //!< The source passed to the callback
+  };
+
+  /**
+   * \brief Send frames from one device to an Sdn enabled one
+   *
+   * \param fast Whether the receiving device uses the fast Sdn receive path
+   * \param checksum Whether checksums are enabled
+   * \param frames The frames the Sdn receive callback got
+   */
+  void RunLink (bool fast, bool checksum, std::vector<Frame> &frames);
+
+  /**
+   * \brief Record a frame handed to the Sdn receive callback
+   */
+  bool SdnReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<Frame> *m_frames; //!< The frames of the current run
+};
+
+Layer2P2PSdnFastReceiveTest::Layer2P2PSdnFastReceiveTest ()
+  : TestCase ("Layer2P2P fast Sdn receive path"),
+    m_frames (0)
+{
+}
+
+bool
+Layer2P2PSdnFastReceiveTest::SdnReceive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  Frame frame;
+  frame.data.resize (packet->GetSize ());
+  packet->CopyData (&frame.data[0], frame.data.size ());
+  frame.protocol = protocol;
+  frame.from = from;
+  m_frames->push_back (frame);
+  return true;
+}
+
+void
+Layer2P2PSdnFastReceiveTest::RunLink (bool fast, bool checksum, std::vector<Frame> &frames)
+{
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (checksum));
+
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<Layer2P2PNetDevice> devA = CreateObject<Layer2P2PNetDevice> ();
+  Ptr<Layer2P2PNetDevice> devB = CreateObject<Layer2P2PNetDevice> ();
+  Ptr<Layer2P2PChannel> channel = CreateObject<Layer2P2PChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address ("00:00:00:00:00:02"));
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  devB->SetSdnEnable (true);
+  devB->SetSdnFastReceive (fast);
+  devB->SetSdnReceiveCallback (MakeCallback (&Layer2P2PSdnFastReceiveTest::SdnReceive, this));
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  frames.clear ();
+  m_frames = &frames;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      std::vector<uint8_t> payload (10 + 300 * i);
+      for (uint32_t j = 0; j < payload.size (); ++j)
+        {
+          payload[j] = static_cast<uint8_t> (i + j);
+        }
+      Ptr<Packet> p = Create<Packet> (&payload[0], payload.size ());
+      Address dest = i % 2 ? devB->GetAddress () : devB->GetBroadcast ();
+      Simulator::Schedule (Seconds (1.0 + i), &Layer2P2PNetDevice::Send, devA, p, dest, i < 2 ? 0x800 : 0x806);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (false));
+}
+
+void
+Layer2P2PSdnFastReceiveTest::DoRun (void)
+{
+  for (uint32_t checksum = 0; checksum < 2; ++checksum)
+    {
+      std::vector<Frame> regular;
+      std::vector<Frame> fast;
+      RunLink (false, checksum, regular);
+      RunLink (true, checksum, fast);
+
+      NS_TEST_ASSERT_MSG_EQ (regular.size (), 4, "Every frame must reach the Sdn callback");
+      NS_TEST_ASSERT_MSG_EQ (fast.size (), regular.size (), "The fast path must deliver every frame");
+      for (uint32_t i = 0; i < regular.size (); ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ ((fast[i].data == regular[i].data), true,
+                                 "Frame " << i << " differs, checksums " << checksum);
+          NS_TEST_EXPECT_MSG_EQ (fast[i].protocol, regular[i].protocol,
+                                 "Frame " << i << " protocol differs, checksums " << checksum);
+          NS_TEST_EXPECT_MSG_EQ ((fast[i].from == regular[i].from), true,
+                                 "Frame " << i << " source differs, checksums " << checksum);
+        }
+    }
+}
+
 /**
  * \brief TestSuite for Layer2P2P module
  */
@@ -89,6 +227,7 @@ Layer2P2PTestSuite::Layer2P2PTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new Layer2P2PTest, TestCase::QUICK);
+  AddTestCase (new Layer2P2PSdnFastReceiveTest, TestCase::QUICK);
 }
 
 static Layer2P2PTestSuite g_pointToPointTestSuite; //!< The testsuite
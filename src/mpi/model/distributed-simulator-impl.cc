@@ -19,6 +19,7 @@
 
 #include "distributed-simulator-impl.h"
 #include "granted-time-window-mpi-interface.h"
+#include "shared-memory-interface.h"
 #include "mpi-interface.h"
 
 #include "ns3/simulator.h"
@@ -32,6 +33,8 @@
 #include "ns3/log.h"
 
 #include <cmath>
+#include <vector>
+#include <algorithm>
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -92,17 +95,18 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
 
-#ifdef NS3_MPI
+#ifndef NS3_MPI
+  if (!SharedMemoryInterface::IsActive ())
+    {
+      NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+    }
+#endif
   m_myId = MpiInterface::GetSystemId ();
   m_systemCount = MpiInterface::GetSize ();
 
   // Allocate the LBTS message buffer
   m_pLBTS = new LbtsMessage[m_systemCount];
   m_grantedTime = Seconds (0);
-#else
-  NS_UNUSED (m_systemCount);
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
-#endif
 
   m_stop = false;
   m_globalFinished = false;
@@ -164,7 +168,6 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
 {
   NS_LOG_FUNCTION (this);
 
-#ifdef NS3_MPI
   if (MpiInterface::GetSize () <= 1)
     {
       m_lookAhead = Seconds (0);
@@ -261,7 +264,18 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
       sendbuf  = m_lookAhead.GetInteger ();
     }
 
-  MPI_Allreduce (&sendbuf, &recvbuf, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+  if (SharedMemoryInterface::IsActive ())
+    {
+      std::vector<long> sendbufs (m_systemCount);
+      SharedMemoryInterface::Allgather (&sendbuf, &sendbufs[0], sizeof (long));
+      recvbuf = *std::max_element (sendbufs.begin (), sendbufs.end ());
+    }
+  else
+    {
+#ifdef NS3_MPI
+      MPI_Allreduce (&sendbuf, &recvbuf, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    }
 
   /* For nodes that did not compute a lookahead use max from ranks
    * that did compute a value.  An edge case occurs if all nodes have
@@ -274,10 +288,6 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
       m_lookAhead = Time (recvbuf);
       m_grantedTime = m_lookAhead;
     }
-
-#else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
-#endif
 }
 
 void
@@ -369,7 +379,7 @@ DistributedSimulatorImpl::Run (void)
 {
   NS_LOG_FUNCTION (this);
 
-#ifdef NS3_MPI
+  bool sharedMemory = SharedMemoryInterface::IsActive ();
   CalculateLookAhead ();
   m_stop = false;
   while (!m_globalFinished)
@@ -384,18 +394,43 @@ DistributedSimulatorImpl::Run (void)
       if (nextTime > m_grantedTime || IsLocalFinished () )
         {
           // Can't process next event, calculate a new LBTS
-          // First receive any pending messages
-          GrantedTimeWindowMpiInterface::ReceiveMessages ();
-          // reset next time
-          nextTime = Next ();
-          // And check for send completes
-          GrantedTimeWindowMpiInterface::TestSendComplete ();
+          uint32_t rxCount;
+          uint32_t txCount;
+          if (sharedMemory)
+            {
+              // Packets are already in the rings, receive the pending ones
+              SharedMemoryInterface::ReceiveMessages ();
+              nextTime = Next ();
+              rxCount = SharedMemoryInterface::GetRxCount ();
+              txCount = SharedMemoryInterface::GetTxCount ();
+            }
+          else
+            {
+              // First send the packets batched during the window
+              GrantedTimeWindowMpiInterface::FlushBatches ();
+              // Then receive any pending messages
+              GrantedTimeWindowMpiInterface::ReceiveMessages ();
+              // reset next time
+              nextTime = Next ();
+              // And check for send completes
+              GrantedTimeWindowMpiInterface::TestSendComplete ();
+              rxCount = GrantedTimeWindowMpiInterface::GetRxCount ();
+              txCount = GrantedTimeWindowMpiInterface::GetTxCount ();
+            }
           // Finally calculate the lbts
-          LbtsMessage lMsg (GrantedTimeWindowMpiInterface::GetRxCount (), GrantedTimeWindowMpiInterface::GetTxCount (), 
-                            m_myId, IsLocalFinished (), nextTime);
+          LbtsMessage lMsg (rxCount, txCount, m_myId, IsLocalFinished (), nextTime);
           m_pLBTS[m_myId] = lMsg;
-          MPI_Allgather (&lMsg, sizeof (LbtsMessage), MPI_BYTE, m_pLBTS,
-                         sizeof (LbtsMessage), MPI_BYTE, MPI_COMM_WORLD);
+          if (sharedMemory)
+            {
+              SharedMemoryInterface::Allgather (&lMsg, m_pLBTS, sizeof (LbtsMessage));
+            }
+          else
+            {
+#ifdef NS3_MPI
+              MPI_Allgather (&lMsg, sizeof (LbtsMessage), MPI_BYTE, m_pLBTS,
+                             sizeof (LbtsMessage), MPI_BYTE, MPI_COMM_WORLD);
+#endif
+            }
           Time smallestTime = m_pLBTS[0].GetSmallestTime ();
           // The totRx and totTx counts insure there are no transient
           // messages;  If totRx != totTx, there are transients,
@@ -442,9 +477,6 @@ DistributedSimulatorImpl::Run (void)
   // If the simulator stopped naturally by lack of events, make a
   // consistency test to check that we didn't lose any events along the way.
   NS_ASSERT (!m_events->IsEmpty () || m_unscheduledEvents == 0);
-#else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
-#endif
 }
 
 uint32_t DistributedSimulatorImpl::GetSystemId () const
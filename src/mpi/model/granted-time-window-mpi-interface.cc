@@ -23,6 +23,8 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <cstring>
+#include <algorithm>
 
 #include "granted-time-window-mpi-interface.h"
 #include "mpi-receiver.h"
@@ -35,6 +37,8 @@
 #include "ns3/simulator-impl.h"
 #include "ns3/nstime.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
 
 #ifdef NS3_MPI
 #include <mpi.h>
@@ -44,6 +48,16 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GrantedTimeWindowMpiInterface");
 
+static GlobalValue g_mpiBatchSize = GlobalValue ("MpiBatchSize",
+                                                 "Size in bytes of the buffers packets to a remote rank are batched in, "
+                                                 "sent when full or at the end of a granted time window. "
+                                                 "0 sends one MPI message per packet. Must be the same on every rank.",
+                                                 UintegerValue (0),
+                                                 MakeUintegerChecker<uint32_t> ());
+
+// Packet metadata ahead of the serialized packet: rx time, node and device
+const uint32_t MPI_PACKET_HEADER_SIZE = 16;
+
 
 SentBuffer::SentBuffer ()
 {
@@ -83,6 +97,10 @@ bool                  GrantedTimeWindowMpiInterface::m_enabled = false;
 uint32_t              GrantedTimeWindowMpiInterface::m_rxCount = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_txCount = 0;
 std::list<SentBuffer> GrantedTimeWindowMpiInterface::m_pendingTx;
+uint32_t              GrantedTimeWindowMpiInterface::m_batchSize = 0;
+uint32_t              GrantedTimeWindowMpiInterface::m_rxBufferSize = MAX_MPI_MSG_SIZE;
+std::vector<uint8_t*> GrantedTimeWindowMpiInterface::m_txBatches;
+std::vector<uint32_t> GrantedTimeWindowMpiInterface::m_txBatchUsed;
 
 #ifdef NS3_MPI
 MPI_Request* GrantedTimeWindowMpiInterface::m_requests;
@@ -112,6 +130,12 @@ GrantedTimeWindowMpiInterface::Destroy ()
   delete [] m_requests;
 
   m_pendingTx.clear ();
+  for (uint32_t i = 0; i < m_txBatches.size (); ++i)
+    {
+      delete [] m_txBatches[i];
+    }
+  m_txBatches.clear ();
+  m_txBatchUsed.clear ();
 #endif
 }
 
@@ -173,13 +197,20 @@ GrantedTimeWindowMpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
+  UintegerValue batchSize;
+  g_mpiBatchSize.GetValue (batchSize);
+  m_batchSize = batchSize.Get ();
+  // A batch holds at least one packet, which may be as large as an unbatched message
+  m_rxBufferSize = m_batchSize > 0 ? std::max (m_batchSize, MAX_MPI_MSG_SIZE + 4) : MAX_MPI_MSG_SIZE;
+  m_txBatches.assign (m_size, 0);
+  m_txBatchUsed.assign (m_size, 0);
   // Post a non-blocking receive for all peers
   m_pRxBuffers = new char*[m_size];
   m_requests = new MPI_Request[m_size];
   for (uint32_t i = 0; i < GetSize (); ++i)
     {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
+      m_pRxBuffers[i] = new char[m_rxBufferSize];
+      MPI_Irecv (m_pRxBuffers[i], m_rxBufferSize, MPI_CHAR, MPI_ANY_SOURCE, 0,
                  MPI_COMM_WORLD, &m_requests[i]);
     }
 #else
@@ -193,35 +224,92 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
 
 #ifdef NS3_MPI
-  SentBuffer sendBuf;
-  m_pendingTx.push_back (sendBuf);
-  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
-
   uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t t = rxTime.GetInteger ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
-  // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
 
   // Find the system id for the destination node
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  uint8_t* buffer;
+  if (m_batchSize > 0)
+    {
+      // Each packet of a batch is preceded by its size
+      uint32_t recordSize = 4 + MPI_PACKET_HEADER_SIZE + serializedSize;
+      if (m_txBatchUsed[nodeSysId] > 0 && m_txBatchUsed[nodeSysId] + recordSize > m_batchSize)
+        {
+          FlushBatch (nodeSysId);
+        }
+      if (m_txBatches[nodeSysId] == 0)
+        {
+          m_txBatches[nodeSysId] = new uint8_t[m_rxBufferSize];
+        }
+      NS_ASSERT_MSG (recordSize <= m_rxBufferSize, "Packet too large for an MPI message");
+      buffer = m_txBatches[nodeSysId] + m_txBatchUsed[nodeSysId];
+      uint32_t size = MPI_PACKET_HEADER_SIZE + serializedSize;
+      memcpy (buffer, &size, 4);
+      buffer += 4;
+      m_txBatchUsed[nodeSysId] += recordSize;
+    }
+  else
+    {
+      SentBuffer sendBuf;
+      m_pendingTx.push_back (sendBuf);
+      buffer = new uint8_t[serializedSize + MPI_PACKET_HEADER_SIZE];
+      m_pendingTx.back ().SetBuffer (buffer);
+    }
+
+  // Add the time, dest node and dest device
+  uint64_t t = rxTime.GetInteger ();
+  memcpy (buffer, &t, 8);
+  memcpy (buffer + 8, &node, 4);
+  memcpy (buffer + 12, &dev, 4);
+  // Serialize the packet
+  p->Serialize (buffer + MPI_PACKET_HEADER_SIZE, serializedSize);
+
+  if (m_batchSize == 0)
+    {
+      SentBuffer& sent = m_pendingTx.back ();
+      MPI_Isend (reinterpret_cast<void *> (sent.GetBuffer ()), serializedSize + MPI_PACKET_HEADER_SIZE, MPI_CHAR, nodeSysId,
+                 0, MPI_COMM_WORLD, sent.GetRequest ());
+    }
   m_txCount++;
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
 }
 
+void
+GrantedTimeWindowMpiInterface::FlushBatch (uint32_t rank)
+{
+  NS_LOG_FUNCTION (rank << m_txBatchUsed[rank]);
+
+#ifdef NS3_MPI
+  // The pending send takes the buffer over, the next packet allocates a new one
+  SentBuffer sendBuf;
+  m_pendingTx.push_back (sendBuf);
+  SentBuffer& sent = m_pendingTx.back ();
+  sent.SetBuffer (m_txBatches[rank]);
+  MPI_Isend (reinterpret_cast<void *> (sent.GetBuffer ()), m_txBatchUsed[rank], MPI_CHAR, rank,
+             0, MPI_COMM_WORLD, sent.GetRequest ());
+  m_txBatches[rank] = 0;
+  m_txBatchUsed[rank] = 0;
+#endif
+}
+
+void
+GrantedTimeWindowMpiInterface::FlushBatches ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  for (uint32_t i = 0; i < m_txBatchUsed.size (); ++i)
+    {
+      if (m_txBatchUsed[i] > 0)
+        {
+          FlushBatch (i);
+        }
+    }
+}
+
 void
 GrantedTimeWindowMpiInterface::ReceiveMessages ()
 { 
@@ -242,43 +330,27 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
         }
       int count;
       MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
-
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t time = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
-
-      Time rxTime (time);
 
-      count -= sizeof (time) + sizeof (node) + sizeof (dev);
-
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
-
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
+      uint8_t* data = reinterpret_cast<uint8_t *> (m_pRxBuffers[index]);
+      if (m_batchSize > 0)
         {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
+          // Unpack every packet of the batch
+          uint8_t* end = data + count;
+          while (data < end)
             {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
+              uint32_t size;
+              memcpy (&size, data, 4);
+              ReceivePacket (data + 4, size);
+              data += 4 + size;
             }
         }
-
-      NS_ASSERT (pNode && pMpiRec);
-
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+      else
+        {
+          ReceivePacket (data, count);
+        }
 
       // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
+      MPI_Irecv (m_pRxBuffers[index], m_rxBufferSize, MPI_CHAR, MPI_ANY_SOURCE, 0,
                  MPI_COMM_WORLD, &m_requests[index]);
     }
 #else
@@ -286,6 +358,44 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
 #endif
 }
 
+void
+GrantedTimeWindowMpiInterface::ReceivePacket (uint8_t* data, uint32_t count)
+{
+  m_rxCount++; // Count this receive
+
+  // Get the meta data first
+  uint64_t time;
+  uint32_t node;
+  uint32_t dev;
+  memcpy (&time, data, 8);
+  memcpy (&node, data + 8, 4);
+  memcpy (&dev, data + 12, 4);
+
+  Time rxTime (time);
+
+  Ptr<Packet> p = Create<Packet> (data + MPI_PACKET_HEADER_SIZE, count - MPI_PACKET_HEADER_SIZE, true);
+
+  // Find the correct node/device to schedule receive event
+  Ptr<Node> pNode = NodeList::GetNode (node);
+  Ptr<MpiReceiver> pMpiRec = 0;
+  uint32_t nDevices = pNode->GetNDevices ();
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+      if (pThisDev->GetIfIndex () == dev)
+        {
+          pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+          break;
+        }
+    }
+
+  NS_ASSERT (pNode && pMpiRec);
+
+  // Schedule the rx event
+  Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                  &MpiReceiver::Receive, pMpiRec, p);
+}
+
 void
 GrantedTimeWindowMpiInterface::TestSendComplete ()
 {
@@ -25,6 +25,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
@@ -139,6 +140,11 @@ public:
    * Check for completed sends
    */
   static void TestSendComplete ();
+  /**
+   * Send the batched packets of every remote rank.  Called at each
+   * granted time window boundary, before the LBTS is computed.
+   */
+  static void FlushBatches ();
   /**
    * \return received count in packets
    */
@@ -149,6 +155,18 @@ public:
   static uint32_t GetTxCount ();
 
 private:
+  /**
+   * Schedule the reception of one packet on its destination node and device
+   * \param data the packet metadata followed by the serialized packet
+   * \param count size of data in bytes
+   */
+  static void ReceivePacket (uint8_t* data, uint32_t count);
+  /**
+   * Post the non-blocking send of the batch of a remote rank
+   * \param rank the destination rank
+   */
+  static void FlushBatch (uint32_t rank);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -168,6 +186,18 @@ private:
 
   // List of pending non-blocking sends
   static std::list<SentBuffer> m_pendingTx;
+
+  // Size of a batch in bytes, 0 sends one message per packet
+  static uint32_t m_batchSize;
+
+  // Size of the receive buffers
+  static uint32_t m_rxBufferSize;
+
+  // Batch being filled for each rank, allocated on first use
+  static std::vector<uint8_t*> m_txBatches;
+
+  // Bytes used in the batch of each rank
+  static std::vector<uint32_t> m_txBatchUsed;
 };
 
 } // namespace ns3
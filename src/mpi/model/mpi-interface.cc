@@ -23,10 +23,12 @@
 
 #include <ns3/global-value.h>
 #include <ns3/string.h>
+#include <ns3/uinteger.h>
 #include <ns3/log.h>
 
 #include "null-message-mpi-interface.h"
 #include "granted-time-window-mpi-interface.h"
+#include "shared-memory-interface.h"
 
 NS_LOG_COMPONENT_DEFINE ("MpiInterface");
 
@@ -78,6 +80,11 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   StringValue simulationTypeValue;
   bool useDefault = true;
 
+  // Ranks forked on this host talk through shared memory, whichever the algorithm
+  UintegerValue sharedMemoryRanks;
+  bool sharedMemory = GlobalValue::GetValueByNameFailSafe ("SharedMemoryRanks", sharedMemoryRanks)
+    && sharedMemoryRanks.Get () > 0;
+
   if (GlobalValue::GetValueByNameFailSafe ("SimulatorImplementationType", simulationTypeValue))
     {
       std::string simulationType = simulationTypeValue.Get ();
@@ -86,12 +93,26 @@ MpiInterface::Enable (int* pargc, char*** pargv)
       // Defaults to synchronous.
       if (simulationType.compare ("ns3::NullMessageSimulatorImpl") == 0)
         {
-          g_parallelCommunicationInterface = new NullMessageMpiInterface ();
+          if (sharedMemory)
+            {
+              g_parallelCommunicationInterface = new SharedMemoryInterface ();
+            }
+          else
+            {
+              g_parallelCommunicationInterface = new NullMessageMpiInterface ();
+            }
           useDefault = false;
         }
       else if (simulationType.compare ("ns3::DistributedSimulatorImpl") == 0)
         {
-          g_parallelCommunicationInterface = new GrantedTimeWindowMpiInterface ();
+          if (sharedMemory)
+            {
+              g_parallelCommunicationInterface = new SharedMemoryInterface ();
+            }
+          else
+            {
+              g_parallelCommunicationInterface = new GrantedTimeWindowMpiInterface ();
+            }
           useDefault = false;
         }
     }
@@ -99,7 +120,14 @@ MpiInterface::Enable (int* pargc, char*** pargv)
   // User did not specify a valid parallel simulator; use the default.
   if (useDefault)
     {
-      g_parallelCommunicationInterface = new GrantedTimeWindowMpiInterface ();
+      if (sharedMemory)
+        {
+          g_parallelCommunicationInterface = new SharedMemoryInterface ();
+        }
+      else
+        {
+          g_parallelCommunicationInterface = new GrantedTimeWindowMpiInterface ();
+        }
       GlobalValue::Bind ("SimulatorImplementationType",
                          StringValue ("ns3::DistributedSimulatorImpl"));
       NS_LOG_WARN ("SimulatorImplementationType was set to non-parallel simulator; setting type to ns3::DistributedSimulatorImp");
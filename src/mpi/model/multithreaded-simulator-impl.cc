@@ -0,0 +1,844 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <unistd.h>
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+__thread MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_currentPartition = 0;
+bool MultithreadedSimulatorImpl::m_isRunning = false;
+
+namespace {
+
+/**
+ * Orders the events crossing partitions by the time they were scheduled at,
+ * then by the partition which scheduled them and the order it did, so the
+ * order doesn't depend on how the outgoing lists were gathered.
+ */
+struct ScheduledBefore
+{
+  template <typename T>
+  bool operator () (const T &a, const T &b) const
+  {
+    if (a.scheduledTs != b.scheduledTs)
+      {
+        return a.scheduledTs < b.scheduledTs;
+      }
+    if (a.source != b.source)
+      {
+        return a.source < b.source;
+      }
+    return a.seq < b.seq;
+  }
+};
+
+} // anonymous namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<Object> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The largest number of threads running the partitions, "
+                   "0 for one per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_stop = false;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_uid = 4;
+  // before ::Run is entered, the m_currentUid will be zero
+  m_currentUid = 0;
+  m_currentTs = 0;
+  m_currentContext = 0xffffffff;
+  m_events = 0;
+
+  m_lookAhead = 0;
+  m_windowEnd = 0;
+  m_windows = 0;
+  m_maxThreads = 0;
+  m_threads = 1;
+  m_generation = 0;
+  m_startGeneration = 0;
+  m_nextWorker = 1;
+  m_running = 0;
+  m_exit = false;
+  pthread_mutex_init (&m_destroyMutex, 0);
+  pthread_mutex_init (&m_mutex, 0);
+  pthread_cond_init (&m_startCondition, 0);
+  pthread_cond_init (&m_doneCondition, 0);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+
+  pthread_cond_destroy (&m_doneCondition);
+  pthread_cond_destroy (&m_startCondition);
+  pthread_mutex_destroy (&m_mutex);
+  pthread_mutex_destroy (&m_destroyMutex);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_events = 0;
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      while (!i->events->IsEmpty ())
+        {
+          Scheduler::Event next = i->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      i->events = 0;
+      for (std::vector<Outgoing>::iterator j = i->outgoing.begin (); j != i->outgoing.end (); ++j)
+        {
+          j->ev.impl->Unref ();
+        }
+      i->outgoing.clear ();
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<uint32_t> systems;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      systems.push_back ((*i)->GetSystemId ());
+    }
+  std::sort (systems.begin (), systems.end ());
+  systems.erase (std::unique (systems.begin (), systems.end ()), systems.end ());
+
+  m_partitionOf.assign (NodeList::GetNNodes (), -1);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      m_partitionOf[(*i)->GetId ()] =
+        std::lower_bound (systems.begin (), systems.end (), (*i)->GetSystemId ()) - systems.begin ();
+    }
+
+  m_partitions.resize (systems.size ());
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      // the upper 32 bits keep the packet uids of the partitions apart from
+      // each other and from the ones created outside of the windows
+      i->packetUid = static_cast<uint64_t> (i - m_partitions.begin () + 1) << 32;
+      i->events = m_schedulerFactory.Create<Scheduler> ();
+      // the uids of the events scheduled so far are kept, so their EventIds
+      // stay valid, and every partition goes on from the last one
+      i->uid = m_uid;
+      i->currentUid = m_currentUid;
+      i->currentTs = m_currentTs;
+      i->currentContext = 0xffffffff;
+      i->eventCount = 0;
+    }
+
+  Ptr<Scheduler> global = m_schedulerFactory.Create<Scheduler> ();
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      Partition *partition = GetPartition (next.key.m_context);
+      if (partition == 0)
+        {
+          global->Insert (next);
+        }
+      else
+        {
+          partition->events->Insert (next);
+        }
+    }
+  m_events = global;
+  NS_LOG_LOGIC (m_partitions.size () << " partitions");
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lookAhead = GetMaximumSimulationTime ().GetTimeStep ();
+  // the layer2-p2p module depends on this one, so the channel is looked up
+  // by name; without it no channel can join two partitions
+  TypeId l2p2p;
+  bool haveL2p2p = TypeId::LookupByNameFailSafe ("ns3::Layer2P2PChannel", &l2p2p);
+  for (NodeList::Iterator iter = NodeList::Begin (); iter != NodeList::End (); ++iter)
+    {
+      for (uint32_t i = 0; i < (*iter)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> localNetDevice = (*iter)->GetDevice (i);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+
+          // if all the devices are in the same partition, don't consider it
+          bool remote = false;
+          for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+            {
+              Ptr<Node> node = channel->GetDevice (j)->GetNode ();
+              if (node != 0 && GetPartition (node->GetId ()) != GetPartition ((*iter)->GetId ()))
+                {
+                  remote = true;
+                }
+            }
+          if (!remote)
+            {
+              continue;
+            }
+
+          // only Layer2P2PChannel hands packets over to another partition
+          // without sharing them
+          TypeId tid = channel->GetInstanceTypeId ();
+          if (!haveL2p2p || (tid != l2p2p && !tid.IsChildOf (l2p2p)))
+            {
+              NS_FATAL_ERROR ("A " << tid.GetName ()
+                              << " joins two partitions, only a Layer2P2PChannel can");
+            }
+
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          if (static_cast<uint64_t> (delay.Get ().GetTimeStep ()) < m_lookAhead)
+            {
+              m_lookAhead = delay.Get ().GetTimeStep ();
+            }
+        }
+    }
+  if (m_lookAhead == 0)
+    {
+      NS_FATAL_ERROR ("A link without delay joins two partitions");
+    }
+  NS_LOG_LOGIC ("lookahead " << TimeStep (m_lookAhead));
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context >= m_partitionOf.size () || m_partitionOf[context] < 0)
+    {
+      return 0;
+    }
+  return const_cast<Partition *> (&m_partitions[m_partitionOf[context]]);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  if (partition == 0)
+    {
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_events->Insert (ev);
+    }
+  else
+    {
+      ev.key.m_uid = partition->uid;
+      partition->uid++;
+      partition->events->Insert (ev);
+    }
+  return ev.key.m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+
+  m_schedulerFactory = schedulerFactory;
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+
+  if (m_events != 0)
+    {
+      while (!m_events->IsEmpty ())
+        {
+          Scheduler::Event next = m_events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+    }
+  m_events = scheduler;
+
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!i->events->IsEmpty ())
+        {
+          Scheduler::Event next = i->events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+      i->events = scheduler;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneGlobalEvent (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Scheduler::Event next = m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= m_currentTs);
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  m_currentTs = next.key.m_ts;
+  m_currentContext = next.key.m_context;
+  m_currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *partition)
+{
+  m_currentPartition = partition;
+  Packet::SetUidCounter (&partition->packetUid);
+  while (!partition->events->IsEmpty ()
+         && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+    {
+      Scheduler::Event next = partition->events->RemoveNext ();
+
+      NS_ASSERT (next.key.m_ts >= partition->currentTs);
+
+      partition->currentTs = next.key.m_ts;
+      partition->currentContext = next.key.m_context;
+      partition->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+      partition->eventCount++;
+    }
+  Packet::SetUidCounter (0);
+  m_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::RunPartitions (uint32_t index)
+{
+  for (uint32_t i = index; i < m_partitions.size (); i += m_threads)
+    {
+      RunPartition (&m_partitions[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::DeliverOutgoing (void)
+{
+  std::vector<Outgoing> outgoing;
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      outgoing.insert (outgoing.end (), i->outgoing.begin (), i->outgoing.end ());
+      i->outgoing.clear ();
+    }
+  std::sort (outgoing.begin (), outgoing.end (), ScheduledBefore ());
+  for (std::vector<Outgoing>::const_iterator i = outgoing.begin (); i != outgoing.end (); ++i)
+    {
+      Insert (GetPartition (i->ev.key.m_context), i->ev.key.m_ts, i->ev.key.m_context, i->ev.impl);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Worker (void)
+{
+  pthread_mutex_lock (&m_mutex);
+  uint32_t index = m_nextWorker++;
+  uint64_t generation = m_startGeneration;
+  while (true)
+    {
+      while (m_generation == generation && !m_exit)
+        {
+          pthread_cond_wait (&m_startCondition, &m_mutex);
+        }
+      if (m_exit)
+        {
+          break;
+        }
+      generation = m_generation;
+      pthread_mutex_unlock (&m_mutex);
+
+      RunPartitions (index);
+
+      pthread_mutex_lock (&m_mutex);
+      m_running--;
+      if (m_running == 0)
+        {
+          pthread_cond_signal (&m_doneCondition);
+        }
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+
+void
+MultithreadedSimulatorImpl::StartThreads (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t threads = m_maxThreads;
+  if (threads == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = processors > 0 ? processors : 1;
+    }
+  m_threads = std::max<uint32_t> (1, std::min<uint32_t> (threads, m_partitions.size ()));
+
+  // the calling thread runs the partitions of the first worker
+  m_exit = false;
+  m_startGeneration = m_generation;
+  m_nextWorker = 1;
+  for (uint32_t i = 1; i < m_threads; ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Worker, this));
+      thread->Start ();
+      m_workers.push_back (thread);
+    }
+  NS_LOG_LOGIC (m_threads << " threads");
+}
+
+void
+MultithreadedSimulatorImpl::StopThreads (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  pthread_mutex_lock (&m_mutex);
+  m_exit = true;
+  pthread_cond_broadcast (&m_startCondition);
+  pthread_mutex_unlock (&m_mutex);
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_workers.begin (); i != m_workers.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_workers.clear ();
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (uint64_t end)
+{
+  NS_LOG_FUNCTION (this << end);
+
+  m_windowEnd = end;
+  m_windows++;
+  if (m_threads > 1)
+    {
+      pthread_mutex_lock (&m_mutex);
+      m_running = m_threads - 1;
+      m_generation++;
+      pthread_cond_broadcast (&m_startCondition);
+      pthread_mutex_unlock (&m_mutex);
+    }
+
+  RunPartitions (0);
+
+  if (m_threads > 1)
+    {
+      pthread_mutex_lock (&m_mutex);
+      while (m_running > 0)
+        {
+          pthread_cond_wait (&m_doneCondition, &m_mutex);
+        }
+      pthread_mutex_unlock (&m_mutex);
+    }
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextPartitionTs (void) const
+{
+  uint64_t next = GetMaximumSimulationTime ().GetTimeStep ();
+  for (std::vector<Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!i->events->IsEmpty ())
+        {
+          next = std::min (next, i->events->PeekNext ().key.m_ts);
+        }
+    }
+  return next;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return (m_events->IsEmpty ()
+          && NextPartitionTs () == static_cast<uint64_t> (GetMaximumSimulationTime ().GetTimeStep ()))
+         || m_stop;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_partitions.empty ())
+    {
+      CreatePartitions ();
+    }
+  CalculateLookAhead ();
+  m_isRunning = true;
+  StartThreads ();
+
+  const uint64_t maxTs = GetMaximumSimulationTime ().GetTimeStep ();
+  m_stop = false;
+  while (!m_stop)
+    {
+      uint64_t next = NextPartitionTs ();
+      // events without partition run between the windows, first at their timestamp
+      if (!m_events->IsEmpty () && m_events->PeekNext ().key.m_ts <= next)
+        {
+          ProcessOneGlobalEvent ();
+          continue;
+        }
+      if (next == maxTs)
+        {
+          break;
+        }
+      uint64_t end = m_lookAhead < maxTs - next ? next + m_lookAhead : maxTs;
+      if (!m_events->IsEmpty ())
+        {
+          end = std::min (end, m_events->PeekNext ().key.m_ts);
+        }
+      RunWindow (end);
+      DeliverOutgoing ();
+    }
+
+  StopThreads ();
+  m_isRunning = false;
+  for (std::vector<Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      m_currentTs = std::max (m_currentTs, i->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+
+  Simulator::Schedule (time, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+
+  Partition *current = m_currentPartition;
+  uint64_t now = current ? current->currentTs : m_currentTs;
+  uint32_t context = current ? current->currentContext : m_currentContext;
+  Time tAbsolute = time + TimeStep (now);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (now));
+  uint64_t ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  uint32_t uid = Insert (current ? current : GetPartition (context), ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  Partition *current = m_currentPartition;
+  Partition *target = GetPartition (context);
+  if (current == 0 || current == target)
+    {
+      uint64_t now = current ? current->currentTs : m_currentTs;
+      Insert (target, now + time.GetTimeStep (), context, event);
+      return;
+    }
+
+  Outgoing outgoing;
+  outgoing.ev.impl = event;
+  outgoing.ev.key.m_ts = current->currentTs + time.GetTimeStep ();
+  outgoing.ev.key.m_context = context;
+  outgoing.ev.key.m_uid = 0;
+  outgoing.scheduledTs = current->currentTs;
+  outgoing.source = current - &m_partitions[0];
+  outgoing.seq = current->outgoing.size ();
+  NS_ASSERT_MSG (outgoing.ev.key.m_ts >= m_windowEnd,
+                 "Event for another partition scheduled closer than the lookahead");
+  current->outgoing.push_back (outgoing);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  pthread_mutex_lock (&m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  pthread_mutex_unlock (&m_destroyMutex);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  Partition *current = m_currentPartition;
+  return TimeStep (current ? current->currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      pthread_mutex_lock (&m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      pthread_mutex_unlock (&m_destroyMutex);
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (id.GetContext ());
+  NS_ASSERT_MSG (m_currentPartition == 0 || m_currentPartition == partition,
+                 "Can't remove an event of another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  if (partition == 0)
+    {
+      m_events->Remove (event);
+    }
+  else
+    {
+      partition->events->Remove (event);
+    }
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      bool expired = true;
+      pthread_mutex_lock (&m_destroyMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              expired = false;
+              break;
+            }
+        }
+      pthread_mutex_unlock (&m_destroyMutex);
+      return expired;
+    }
+  // the event is compared with the progress of the partition it belongs to
+  Partition *partition = GetPartition (ev.GetContext ());
+  uint64_t currentTs = partition ? partition->currentTs : m_currentTs;
+  uint32_t currentUid = partition ? partition->currentUid : m_currentUid;
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < currentTs
+      || (ev.GetTs () == currentTs
+          && ev.GetUid () <= currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  /// \todo I am fairly certain other compilers use other non-standard
+  /// post-fixes to indicate 64 bit constants.
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *current = m_currentPartition;
+  return current ? current->currentContext : m_currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitions (void) const
+{
+  return m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetThreads (void) const
+{
+  return m_threads;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetWindows (void) const
+{
+  return m_windows;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEvents (uint32_t partition) const
+{
+  NS_ASSERT (partition < m_partitions.size ());
+  return m_partitions[partition].eventCount;
+}
+
+bool
+MultithreadedSimulatorImpl::IsRunning (void)
+{
+  return m_isRunning;
+}
+
+} // namespace ns3
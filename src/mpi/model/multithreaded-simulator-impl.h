@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+
+#include <pthread.h>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Parallel simulator implementation running the nodes of a single
+ * process on a pool of threads
+ *
+ * The nodes are split into partitions by their SystemId, as they would be
+ * split into ranks by the distributed simulators, so SdnPartitionHelper can
+ * be used to build them.  Every partition has its own event list and is
+ * always run by the same thread.  The simulation advances in windows: a
+ * window starts at the earliest pending event T and ends at T plus the
+ * lookahead, the smallest delay of a Layer2P2PChannel between two
+ * partitions; other channels can't join partitions.  No event of a
+ * window can schedule an event for another partition inside the window, so
+ * the threads run the window without synchronizing and meet at a barrier at
+ * its end.
+ *
+ * Events scheduled for another partition are held by the scheduling
+ * partition until the barrier, then inserted ordered by the time they were
+ * scheduled at, the partition which scheduled them and the order they were
+ * scheduled in.  Events without a node context, such as the ones scheduled
+ * by the main program, run alone on the calling thread between windows,
+ * ahead of the partition events of the same timestamp.  The order of every
+ * event therefore depends on the partitions only, not on the thread count
+ * or on the thread timing, and matches the serial simulator except for
+ * events of the same timestamp on a node which come from both its own and
+ * another partition.  The packets created by a partition take their uids
+ * from a counter of the partition, so they don't depend on the thread
+ * timing either, but differ from the uids of the serial simulator.
+ *
+ * Events of a partition must only touch the nodes of that partition;
+ * models which call into another node directly need both nodes in the same
+ * partition.  Stop called from a partition event stops the simulation at
+ * the end of the window.  Threads outside of the simulator cannot schedule
+ * events while it runs.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return The number of partitions, 0 before the first Run
+   */
+  uint32_t GetPartitions (void) const;
+  /**
+   * \return The number of threads running the partitions during Run
+   */
+  uint32_t GetThreads (void) const;
+  /**
+   * \return The width of the windows
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \return The number of windows run so far
+   */
+  uint64_t GetWindows (void) const;
+  /**
+   * \param partition A partition
+   * \return The number of events the partition has run so far
+   */
+  uint64_t GetEvents (uint32_t partition) const;
+
+  /**
+   * \return True while a MultithreadedSimulatorImpl runs, when models must
+   * not share reference counted data between nodes of different partitions
+   */
+  static bool IsRunning (void);
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * An event scheduled for another partition, held until the end of the window
+   */
+  struct Outgoing
+  {
+    Scheduler::Event ev;     //!< The event, its uid is given on insertion
+    uint64_t scheduledTs;    //!< The time it was scheduled at
+    uint32_t source;         //!< The partition which scheduled it
+    uint32_t seq;            //!< Its rank among the events the source scheduled in the window
+  };
+
+  /**
+   * The state of a partition, only touched by its thread during a window
+   */
+  struct Partition
+  {
+    Ptr<Scheduler> events;
+    std::vector<Outgoing> outgoing;
+    uint32_t uid;
+    uint32_t currentUid;
+    uint64_t currentTs;
+    uint32_t currentContext;
+    uint64_t eventCount;
+    uint64_t packetUid;      //!< The next uid of the packets created by the partition
+  };
+
+  /**
+   * Splits the nodes into partitions and moves the pending events to them
+   */
+  void CreatePartitions (void);
+  void CalculateLookAhead (void);
+  /**
+   * \param context A node id or 0xffffffff
+   * \return The partition of the node, 0 for events which run between windows
+   */
+  Partition * GetPartition (uint32_t context) const;
+  /**
+   * Inserts an event in the event list of a partition, or in the global one
+   */
+  uint32_t Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Runs the events of a partition earlier than the end of the window
+   */
+  void RunPartition (Partition *partition);
+  void ProcessOneGlobalEvent (void);
+  /**
+   * Inserts the events scheduled across partitions during the last window
+   */
+  void DeliverOutgoing (void);
+  void RunWindow (uint64_t end);
+  void StartThreads (void);
+  void StopThreads (void);
+  void Worker (void);
+  /**
+   * Runs the partitions of a thread for the current window
+   */
+  void RunPartitions (uint32_t index);
+  /**
+   * \return The timestamp of the earliest partition event
+   */
+  uint64_t NextPartitionTs (void) const;
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  mutable pthread_mutex_t m_destroyMutex;
+  bool m_stop;
+  ObjectFactory m_schedulerFactory;
+  Ptr<Scheduler> m_events;            //!< Events without partition, and all events before the first Run
+  uint32_t m_uid;
+  uint32_t m_currentUid;
+  uint64_t m_currentTs;
+  uint32_t m_currentContext;
+
+  std::vector<Partition> m_partitions;
+  std::vector<int32_t> m_partitionOf; //!< Partition of every node id, -1 for none
+  uint64_t m_lookAhead;
+  uint64_t m_windowEnd;
+  uint64_t m_windows;
+  uint32_t m_maxThreads;
+  uint32_t m_threads;
+
+  std::vector<Ptr<SystemThread> > m_workers;
+  pthread_mutex_t m_mutex;
+  pthread_cond_t m_startCondition;
+  pthread_cond_t m_doneCondition;
+  uint64_t m_generation;              //!< Incremented to start a window
+  uint64_t m_startGeneration;         //!< Generation the workers start from
+  uint32_t m_nextWorker;              //!< Index of the next worker to start
+  uint32_t m_running;                 //!< Workers still in the window
+  bool m_exit;
+
+  /// The partition run by the calling thread, 0 outside of a window
+  static __thread Partition *m_currentPartition;
+  static bool m_isRunning;            //!< Set from the start to the end of Run
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -231,15 +231,16 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
              0, MPI_COMM_WORLD, (iter->GetRequest ()));
 
-  NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
+  NullMessageSimulatorImpl::GetInstance ()->PacketSent (nodeSysId, guarantee_update);
 
 #endif
 }
 
 void
-NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<RemoteChannelBundle> bundle)
+NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<RemoteChannelBundle> bundle,
+                                          bool demand)
 {
-  NS_LOG_FUNCTION (guarantee_update.GetTimeStep () << bundle);
+  NS_LOG_FUNCTION (guarantee_update.GetTimeStep () << bundle << demand);
 
   NS_ASSERT (g_enabled);
 
@@ -257,7 +258,7 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
   *pTime++ = 0;
   *pTime++ = guarantee_update.GetInteger ();
   uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = 0;
+  *pData++ = demand ? NULL_MESSAGE_DEMAND : 0;
   *pData++ = 0;
 
   // Find the system id for the destination MPI rank
@@ -371,6 +372,11 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
           NS_ASSERT (bundle);
 
           bundle->SetGuaranteeTime (Time (guaranteeUpdate));
+          bundle->NotifyReceived (rxTime == Time (0));
+          if (rxTime == Time (0) && (node & NULL_MESSAGE_DEMAND))
+            {
+              NullMessageSimulatorImpl::GetInstance ()->NullMessageDemanded (bundle);
+            }
 
           // Re-queue the next read
           MPI_Irecv (g_pRxBuffers[index], NULL_MESSAGE_MAX_MPI_MSG_SIZE, MPI_CHAR, status.MPI_SOURCE, 0,
@@ -40,6 +40,12 @@ namespace ns3 {
 class RemoteChannelBundle;
 class Packet;
 
+/**
+ * Flag set in the node field of a Null Message to demand a Null
+ * Message in return
+ */
+const uint32_t NULL_MESSAGE_DEMAND = 1;
+
 /**
  * \ingroup mpi
  *
@@ -143,6 +149,7 @@ public:
   /**
    * \param guaranteeUpdate guarantee update time for the Null Message
    * \bundle the destination bundle for the Null Message.
+   * \param demand ask the remote task for a Null Message in return
    *
    * \brief Send a Null Message to across the specified bundle.  
    *
@@ -161,10 +168,11 @@ public:
    *
    * uint64_t 0 must be zero for Null Message
    * uint64_t guarantee time
-   * uint32_t 0 must be zero for Null Message
+   * uint32_t NULL_MESSAGE_DEMAND or 0
    * uint32_t 0 must be zero for Null Message
    */
-  static void SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle);
+  static void SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle,
+                               bool demand = false);
   /**
    * Non-blocking check for received messages complete.  Will
    * receive all messages that are queued up locally.
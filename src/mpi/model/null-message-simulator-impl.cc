@@ -22,6 +22,7 @@
 #include "null-message-simulator-impl.h"
 
 #include "null-message-mpi-interface.h"
+#include "shared-memory-interface.h"
 #include "remote-channel-bundle-manager.h"
 #include "remote-channel-bundle.h"
 #include "mpi-interface.h"
@@ -32,6 +33,7 @@
 #include <ns3/channel.h>
 #include <ns3/node-container.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
 #include <ns3/ptr.h>
 #include <ns3/pointer.h>
 #include <ns3/assert.h>
@@ -41,6 +43,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 
 NS_LOG_COMPONENT_DEFINE ("NullMessageSimulatorImpl");
 
@@ -60,13 +63,28 @@ NullMessageSimulatorImpl::GetTypeId (void)
                    DoubleValue (1.0),
                    MakeDoubleAccessor (&NullMessageSimulatorImpl::m_schedulerTune),
                    MakeDoubleChecker<double> (0.01,1.0))
+    .AddAttribute ("SuppressNullMessages",
+                   "Skip Null Messages which would not advance the guarantee time of the remote task",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&NullMessageSimulatorImpl::m_suppressNullMessages),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DemandNullMessages",
+                   "Demand Null Messages from the remote tasks holding back the safe time before blocking",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NullMessageSimulatorImpl::m_demandNullMessages),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 NullMessageSimulatorImpl::NullMessageSimulatorImpl ()
 {
-#ifdef NS3_MPI
+#ifndef NS3_MPI
+  if (!SharedMemoryInterface::IsActive ())
+    {
+      NS_FATAL_ERROR ("Can't use Null Message simulator without MPI compiled in");
+    }
+#endif
   NS_LOG_FUNCTION (this);
 
   m_myId = MpiInterface::GetSystemId ();
@@ -86,13 +104,10 @@ NullMessageSimulatorImpl::NullMessageSimulatorImpl ()
   m_events = 0;
 
   m_safeTime = Seconds (0);
+  m_nullMessageOwed = false;
 
   NS_ASSERT (g_instance == 0);
   g_instance = this;
-
-#else
-  NS_FATAL_ERROR ("Can't use Null Message simulator without MPI compiled in");
-#endif
 }
 
 NullMessageSimulatorImpl::~NullMessageSimulatorImpl ()
@@ -200,8 +215,12 @@ NullMessageSimulatorImpl::CalculateLookAhead (void)
         }
     }
 
-  // Completed setup of remote channel bundles.  Setup send and receive buffers.
-  NullMessageMpiInterface::InitializeSendReceiveBuffers ();
+  // Completed setup of remote channel bundles.  Setup send and receive buffers;
+  // the shared memory rings need none.
+  if (!SharedMemoryInterface::IsActive ())
+    {
+      NullMessageMpiInterface::InitializeSendReceiveBuffers ();
+    }
 
   // Initialized to 0 as we don't have a simulation start time.
   m_safeTime = Time (0);
@@ -284,6 +303,39 @@ NullMessageSimulatorImpl::RescheduleNullMessageEvent (Ptr<RemoteChannelBundle> b
                                            this, PeekPointer(bundle)));
 }
 
+void
+NullMessageSimulatorImpl::PacketSent (uint32_t nodeSysId, Time guarantee)
+{
+  NS_LOG_FUNCTION (this << nodeSysId << guarantee.GetTimeStep ());
+
+  Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (nodeSysId);
+  NS_ASSERT (bundle);
+
+  bundle->NotifyPacketSent (guarantee);
+  RescheduleNullMessageEvent (bundle);
+}
+
+void
+NullMessageSimulatorImpl::NullMessageDemanded (Ptr<RemoteChannelBundle> bundle)
+{
+  NS_LOG_FUNCTION (this << bundle);
+
+  bundle->SetNullMessageOwed (true);
+  m_nullMessageOwed = true;
+}
+
+void
+NullMessageSimulatorImpl::SendOwedNullMessages (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The guarantee time is computed from the next event
+  if (m_nullMessageOwed && !m_events->IsEmpty ())
+    {
+      m_nullMessageOwed = RemoteChannelBundleManager::SendOwedNullMessages ();
+    }
+}
+
 void
 NullMessageSimulatorImpl::RescheduleNullMessageEvent (uint32_t nodeSysId)
 {
@@ -317,10 +369,21 @@ NullMessageSimulatorImpl::Run (void)
         }
       else
         {
+          if (m_demandNullMessages)
+            {
+              RemoteChannelBundleManager::DemandNullMessages (nextTime);
+            }
           // Block until packet or Null Message has been received.
           HandleArrivingMessagesBlocking ();
         }
     }
+
+  if (g_log.IsEnabled (LOG_LEVEL_INFO))
+    {
+      std::ostringstream oss;
+      RemoteChannelBundleManager::PrintStatistics (oss);
+      NS_LOG_INFO ("Null Message statistics for rank " << m_myId << std::endl << oss.str ());
+    }
 }
 
 void
@@ -328,9 +391,18 @@ NullMessageSimulatorImpl::HandleArrivingMessagesNonBlocking (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (SharedMemoryInterface::IsActive ())
+    {
+      SharedMemoryInterface::ReceiveMessages (false);
+      CalculateSafeTime ();
+      SendOwedNullMessages ();
+      return;
+    }
+
   NullMessageMpiInterface::ReceiveMessagesNonBlocking ();
 
   CalculateSafeTime ();
+  SendOwedNullMessages ();
 
   // Check for send completes
   NullMessageMpiInterface::TestSendComplete ();
@@ -341,9 +413,18 @@ NullMessageSimulatorImpl::HandleArrivingMessagesBlocking (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (SharedMemoryInterface::IsActive ())
+    {
+      SharedMemoryInterface::ReceiveMessages (true);
+      CalculateSafeTime ();
+      SendOwedNullMessages ();
+      return;
+    }
+
   NullMessageMpiInterface::ReceiveMessagesBlocking ();
 
   CalculateSafeTime ();
+  SendOwedNullMessages ();
 
   // Check for send completes
   NullMessageMpiInterface::TestSendComplete ();
@@ -586,12 +667,27 @@ void NullMessageSimulatorImpl::NullMessageEventHandler(RemoteChannelBundle* bund
 {
   NS_LOG_FUNCTION (this << bundle);
 
-  Time time = Min (Next (), GetSafeTime ()) + bundle->GetDelay ();
-  NullMessageMpiInterface::SendNullMessage (time, bundle);
+  SendNullMessage (bundle, false);
 
   ScheduleNullMessageEvent (bundle);
 }
 
+void
+NullMessageSimulatorImpl::SendNullMessage (RemoteChannelBundle* bundle, bool demand)
+{
+  NS_LOG_FUNCTION (this << bundle << demand);
+
+  Time time = Min (Next (), GetSafeTime ()) + bundle->GetDelay ();
+  if (!demand && m_suppressNullMessages && time <= bundle->GetSentGuaranteeTime ())
+    {
+      // The remote task already knows this guarantee
+      bundle->NotifyNullMessageSuppressed ();
+      return;
+    }
+
+  bundle->Send (time, demand);
+}
+
 
 NullMessageSimulatorImpl*
 NullMessageSimulatorImpl::GetInstance (void)
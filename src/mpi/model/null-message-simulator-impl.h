@@ -82,6 +82,7 @@ public:
 private:
   friend class NullMessageEvent;
   friend class NullMessageMpiInterface;
+  friend class SharedMemoryInterface;
   friend class RemoteChannelBundleManager;
 
   /**
@@ -167,6 +168,39 @@ private:
    */
   void NullMessageEventHandler(RemoteChannelBundle* bundle);
 
+  /**
+   * \param bundle remote channel bundle to send a Null Message to
+   * \param demand ask the remote task for a Null Message in return
+   *
+   * Send a Null Message carrying the current guarantee time.  Unless
+   * it is a demand, the message is suppressed when the guarantee time
+   * has not advanced past the last one sent on the bundle.
+   */
+  void SendNullMessage (RemoteChannelBundle* bundle, bool demand);
+
+  /**
+   * \param nodeSysId SystemID the packet was sent to
+   * \param guarantee guarantee time piggybacked on the packet
+   *
+   * Record the guarantee time carried by a packet and reschedule the
+   * Null Message event of the bundle, which the packet stands in for.
+   */
+  void PacketSent (uint32_t nodeSysId, Time guarantee);
+
+  /**
+   * \param bundle remote channel bundle the demand arrived on
+   *
+   * The remote task is blocked waiting on our guarantee time; answer
+   * with a Null Message as soon as the guarantee time advances.
+   */
+  void NullMessageDemanded (Ptr<RemoteChannelBundle> bundle);
+
+  /**
+   * Answer pending Null Message demands.  Should be called after
+   * message receives.
+   */
+  void SendOwedNullMessages (void);
+
   typedef std::list<EventId> DestroyEvents;
 
   DestroyEvents m_destroyEvents;
@@ -201,6 +235,25 @@ private:
    */
   double m_schedulerTune;
 
+  /*
+   * Skip Null Messages which do not advance the guarantee time
+   * already sent on their bundle.
+   */
+  bool m_suppressNullMessages;
+
+  /*
+   * Demand Null Messages from the remote tasks holding back the safe
+   * time before blocking.  Shortens the blocking of a task waiting on
+   * a long lookahead at the cost of one message per block, so it pays
+   * off with a high SchedulerTune.
+   */
+  bool m_demandNullMessages;
+
+  /*
+   * A remote task demanded a Null Message not sent yet.
+   */
+  bool m_nullMessageOwed;
+
   /*
    * Singleton instance.
    */
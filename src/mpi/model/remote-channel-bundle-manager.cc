@@ -100,6 +100,73 @@ RemoteChannelBundleManager::GetSafeTime (void)
   return safeTime;
 }
 
+void
+RemoteChannelBundleManager::DemandNullMessages (Time time)
+{
+  NS_ASSERT (g_initialized);
+
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      Ptr<RemoteChannelBundle> bundle = kv->second;
+      if (bundle->GetGuaranteeTime () < time && !bundle->IsNullMessageDemanded ())
+        {
+          NullMessageSimulatorImpl::GetInstance ()->SendNullMessage (PeekPointer (bundle), true);
+        }
+    }
+}
+
+bool
+RemoteChannelBundleManager::SendOwedNullMessages (void)
+{
+  NS_ASSERT (g_initialized);
+
+  bool owed = false;
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      Ptr<RemoteChannelBundle> bundle = kv->second;
+      if (bundle->IsNullMessageOwed ())
+        {
+          NullMessageSimulatorImpl::GetInstance ()->SendNullMessage (PeekPointer (bundle), false);
+          owed |= bundle->IsNullMessageOwed ();
+        }
+    }
+
+  return owed;
+}
+
+void
+RemoteChannelBundleManager::PrintStatistics (std::ostream &os)
+{
+  for (RemoteChannelMap::const_iterator kv = g_remoteChannelBundles.begin ();
+       kv != g_remoteChannelBundles.end ();
+       ++kv)
+    {
+      Ptr<RemoteChannelBundle> bundle = kv->second;
+      uint64_t packets = bundle->GetPacketsSent ();
+      os << "rank " << kv->first
+         << " null messages sent " << bundle->GetNullMessagesSent ()
+         << " (demands " << bundle->GetDemandsSent ()
+         << ", suppressed " << bundle->GetNullMessagesSuppressed () << ")"
+         << " received " << bundle->GetNullMessagesReceived ()
+         << ", packets sent " << packets
+         << " received " << bundle->GetPacketsReceived ()
+         << ", null/data ratio ";
+      if (packets > 0)
+        {
+          os << static_cast<double> (bundle->GetNullMessagesSent ()) / packets;
+        }
+      else
+        {
+          os << "-";
+        }
+      os << std::endl;
+    }
+}
+
 void
 RemoteChannelBundleManager::Destroy (void)
 {
@@ -69,6 +69,30 @@ public:
    */
   static Time GetSafeTime (void);
 
+  /**
+   * \param time next local event time
+   *
+   * Demand a Null Message from every remote task whose guarantee time
+   * is before time and which has not been asked already.
+   */
+  static void DemandNullMessages (Time time);
+
+  /**
+   * Send the Null Messages demanded by remote tasks.  A demand is only
+   * answered once the guarantee time has advanced past the last one
+   * sent, otherwise it stays owed.
+   *
+   * \return true if a Null Message is still owed
+   */
+  static bool SendOwedNullMessages (void);
+
+  /**
+   * \param os output stream
+   *
+   * Print the message counters of every remote channel bundle.
+   */
+  static void PrintStatistics (std::ostream &os);
+
   /**
    * Destroy the singleton.
    */
@@ -22,6 +22,7 @@
 #include "remote-channel-bundle.h"
 
 #include "null-message-mpi-interface.h"
+#include "shared-memory-interface.h"
 #include "null-message-simulator-impl.h"
 
 #include <ns3/simulator.h>
@@ -41,14 +42,32 @@ TypeId RemoteChannelBundle::GetTypeId (void)
 RemoteChannelBundle::RemoteChannelBundle ()
   : m_remoteSystemId (-1),
     m_guaranteeTime (0),
-    m_delay (NS_TIME_INFINITY)
+    m_delay (NS_TIME_INFINITY),
+    m_sentGuaranteeTime (0),
+    m_nullMessageDemanded (false),
+    m_nullMessageOwed (false),
+    m_nullMessagesSent (0),
+    m_nullMessagesSuppressed (0),
+    m_demandsSent (0),
+    m_packetsSent (0),
+    m_nullMessagesReceived (0),
+    m_packetsReceived (0)
 {
 }
 
 RemoteChannelBundle::RemoteChannelBundle (const uint32_t remoteSystemId)
   : m_remoteSystemId (remoteSystemId),
     m_guaranteeTime (0),
-    m_delay (NS_TIME_INFINITY)
+    m_delay (NS_TIME_INFINITY),
+    m_sentGuaranteeTime (0),
+    m_nullMessageDemanded (false),
+    m_nullMessageOwed (false),
+    m_nullMessagesSent (0),
+    m_nullMessagesSuppressed (0),
+    m_demandsSent (0),
+    m_packetsSent (0),
+    m_nullMessagesReceived (0),
+    m_packetsReceived (0)
 {
 }
 
@@ -104,16 +123,125 @@ RemoteChannelBundle::GetSize (void) const
 }
 
 void 
-RemoteChannelBundle::Send(Time time)
+RemoteChannelBundle::Send(Time time, bool demand)
 {
-  NullMessageMpiInterface::SendNullMessage (time, this);  
+  if (SharedMemoryInterface::IsActive ())
+    {
+      SharedMemoryInterface::SendNullMessage (time, this, demand);
+    }
+  else
+    {
+      NullMessageMpiInterface::SendNullMessage (time, this, demand);
+    }
+
+  m_sentGuaranteeTime = Max (m_sentGuaranteeTime, time);
+  m_nullMessageOwed = false;
+  m_nullMessagesSent++;
+  if (demand)
+    {
+      m_nullMessageDemanded = true;
+      m_demandsSent++;
+    }
+}
+
+Time
+RemoteChannelBundle::GetSentGuaranteeTime (void) const
+{
+  return m_sentGuaranteeTime;
+}
+
+void
+RemoteChannelBundle::NotifyPacketSent (Time time)
+{
+  // The guarantee time piggybacked on the packet answers a pending demand
+  m_sentGuaranteeTime = Max (m_sentGuaranteeTime, time);
+  m_nullMessageOwed = false;
+  m_packetsSent++;
+}
+
+void
+RemoteChannelBundle::NotifyNullMessageSuppressed (void)
+{
+  m_nullMessagesSuppressed++;
+}
+
+void
+RemoteChannelBundle::NotifyReceived (bool nullMessage)
+{
+  m_nullMessageDemanded = false;
+  if (nullMessage)
+    {
+      m_nullMessagesReceived++;
+    }
+  else
+    {
+      m_packetsReceived++;
+    }
+}
+
+bool
+RemoteChannelBundle::IsNullMessageDemanded (void) const
+{
+  return m_nullMessageDemanded;
+}
+
+bool
+RemoteChannelBundle::IsNullMessageOwed (void) const
+{
+  return m_nullMessageOwed;
+}
+
+void
+RemoteChannelBundle::SetNullMessageOwed (bool owed)
+{
+  m_nullMessageOwed = owed;
+}
+
+uint64_t
+RemoteChannelBundle::GetNullMessagesSent (void) const
+{
+  return m_nullMessagesSent;
+}
+
+uint64_t
+RemoteChannelBundle::GetNullMessagesSuppressed (void) const
+{
+  return m_nullMessagesSuppressed;
+}
+
+uint64_t
+RemoteChannelBundle::GetDemandsSent (void) const
+{
+  return m_demandsSent;
+}
+
+uint64_t
+RemoteChannelBundle::GetPacketsSent (void) const
+{
+  return m_packetsSent;
+}
+
+uint64_t
+RemoteChannelBundle::GetNullMessagesReceived (void) const
+{
+  return m_nullMessagesReceived;
+}
+
+uint64_t
+RemoteChannelBundle::GetPacketsReceived (void) const
+{
+  return m_packetsReceived;
 }
 
 std::ostream& operator<< (std::ostream& out, ns3::RemoteChannelBundle& bundle )
 {
   out << "RemoteChannelBundle Rank = " << bundle.m_remoteSystemId
       << ", GuaranteeTime = "  << bundle.m_guaranteeTime
-      << ", Delay = " << bundle.m_delay << std::endl;
+      << ", Delay = " << bundle.m_delay
+      << ", Null Messages sent/suppressed/received = " << bundle.m_nullMessagesSent
+      << "/" << bundle.m_nullMessagesSuppressed << "/" << bundle.m_nullMessagesReceived
+      << ", Packets sent/received = " << bundle.m_packetsSent << "/" << bundle.m_packetsReceived
+      << std::endl;
   
   for (std::map < uint32_t, Ptr < Channel > > ::const_iterator pair = bundle.m_channels.begin ();
        pair != bundle.m_channels.end ();
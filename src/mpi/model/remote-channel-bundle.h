@@ -102,12 +102,87 @@ public:
 
   /**
    * \param time 
+   * \param demand ask the remote task for a Null Message in return
    *
    * Send Null Message to the remote task associated with this bundle.
    * Message will be delivered at current simulation time + the time
    * passed in.
    */
-  void Send(Time time);
+  void Send(Time time, bool demand = false);
+
+  /**
+   * \return the last guarantee time sent to the remote task, by a
+   * Null Message or piggybacked on a packet
+   */
+  Time GetSentGuaranteeTime (void) const;
+
+  /**
+   * \param time guarantee time carried by a packet sent to the remote task
+   *
+   * Record a guarantee time piggybacked on a packet.
+   */
+  void NotifyPacketSent (Time time);
+
+  /**
+   * Record a Null Message not sent because it would not have advanced
+   * the guarantee time of the remote task.
+   */
+  void NotifyNullMessageSuppressed (void);
+
+  /**
+   * \param nullMessage true for a Null Message, false for a packet
+   *
+   * Record a message received from the remote task.  Any message
+   * updates the guarantee time, so it answers a pending demand.
+   */
+  void NotifyReceived (bool nullMessage);
+
+  /**
+   * \return true if a Null Message has been demanded from the remote
+   * task and no message has arrived from it since
+   */
+  bool IsNullMessageDemanded (void) const;
+
+  /**
+   * \return true if the remote task demanded a Null Message which has
+   * not been sent yet
+   */
+  bool IsNullMessageOwed (void) const;
+
+  /**
+   * \param owed whether a Null Message is owed to the remote task
+   */
+  void SetNullMessageOwed (bool owed);
+
+  /**
+   * \return number of Null Messages sent, demands included
+   */
+  uint64_t GetNullMessagesSent (void) const;
+
+  /**
+   * \return number of Null Messages suppressed
+   */
+  uint64_t GetNullMessagesSuppressed (void) const;
+
+  /**
+   * \return number of Null Messages sent as demands
+   */
+  uint64_t GetDemandsSent (void) const;
+
+  /**
+   * \return number of packets sent
+   */
+  uint64_t GetPacketsSent (void) const;
+
+  /**
+   * \return number of Null Messages received
+   */
+  uint64_t GetNullMessagesReceived (void) const;
+
+  /**
+   * \return number of packets received
+   */
+  uint64_t GetPacketsReceived (void) const;
 
   /**
    * Output for debugging purposes.
@@ -144,6 +219,32 @@ private:
    */
   EventId m_nullEventId;
 
+  /*
+   * Last guarantee time sent to remote_rank; a Null Message not later
+   * than it carries no information.
+   */
+  Time m_sentGuaranteeTime;
+
+  /*
+   * A Null Message was demanded from remote_rank and nothing arrived since.
+   */
+  bool m_nullMessageDemanded;
+
+  /*
+   * remote_rank demanded a Null Message which has not been sent yet.
+   */
+  bool m_nullMessageOwed;
+
+  /*
+   * Message counters.
+   */
+  uint64_t m_nullMessagesSent;
+  uint64_t m_nullMessagesSuppressed;
+  uint64_t m_demandsSent;
+  uint64_t m_packetsSent;
+  uint64_t m_nullMessagesReceived;
+  uint64_t m_packetsReceived;
+
 };
 
 }
@@ -0,0 +1,568 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "shared-memory-interface.h"
+#include "mpi-receiver.h"
+#include "null-message-simulator-impl.h"
+#include "null-message-mpi-interface.h"
+#include "remote-channel-bundle.h"
+#include "remote-channel-bundle-manager.h"
+
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SharedMemoryInterface");
+
+static GlobalValue g_sharedMemoryRanks = GlobalValue ("SharedMemoryRanks",
+                                                      "Number of processes to fork on this host and connect "
+                                                      "through shared memory instead of MPI. 0 uses MPI.",
+                                                      UintegerValue (0),
+                                                      MakeUintegerChecker<uint32_t> ());
+
+static GlobalValue g_sharedMemoryRingSize = GlobalValue ("SharedMemoryRingSize",
+                                                         "Size in bytes of the ring carrying the messages "
+                                                         "from one rank to another.",
+                                                         UintegerValue (1 << 20),
+                                                         MakeUintegerChecker<uint32_t> (8192));
+
+// Message metadata ahead of the serialized packet: rx time, guarantee time, node and device
+const uint32_t SHARED_MEMORY_HEADER_SIZE = 24;
+
+// Ring record kinds; a wrap record skips to the start of the ring
+const uint32_t SHARED_MEMORY_WRAP = 0;
+const uint32_t SHARED_MEMORY_MESSAGE = 1;
+
+// Spins before a waiting rank starts yielding the processor
+const uint32_t SHARED_MEMORY_SPINS = 1024;
+
+/**
+ * Single producer, single consumer ring; the data follows the structure.
+ * Positions only grow, the offset in the data is the position modulo the size.
+ */
+struct SharedMemoryInterface::Ring
+{
+  uint64_t head;      //!< Read position, written by the consumer
+  uint8_t  pad0[56];
+  uint64_t tail;      //!< Write position, written by the producer
+  uint8_t  pad1[56];
+
+  uint8_t* GetData ()
+  {
+    return reinterpret_cast<uint8_t *> (this + 1);
+  }
+};
+
+/**
+ * Start of the shared mapping; the Allgather slots, two rounds of one
+ * slot per rank, follow it, then the rings
+ */
+struct SharedMemoryInterface::Shared
+{
+  uint32_t count;      //!< Ranks arrived at the barrier
+  uint32_t generation; //!< Barriers completed
+  uint8_t  pad[56];
+
+  uint8_t* GetSlot (uint32_t round, uint32_t rank, uint32_t size)
+  {
+    return reinterpret_cast<uint8_t *> (this + 1) + ((round % 2) * size + rank) * SHARED_MEMORY_SLOT_SIZE;
+  }
+};
+
+// Records and rings are aligned so that every field can be accessed in place
+static inline uint32_t
+SharedMemoryAlign (uint32_t count, uint32_t alignment)
+{
+  return (count + alignment - 1) / alignment * alignment;
+}
+
+uint32_t                         SharedMemoryInterface::m_sid = 0;
+uint32_t                         SharedMemoryInterface::m_size = 1;
+bool                             SharedMemoryInterface::m_enabled = false;
+bool                             SharedMemoryInterface::m_nullMessage = false;
+uint32_t                         SharedMemoryInterface::m_rxCount = 0;
+uint32_t                         SharedMemoryInterface::m_txCount = 0;
+uint32_t                         SharedMemoryInterface::m_ringSize = 0;
+size_t                           SharedMemoryInterface::m_mappingSize = 0;
+SharedMemoryInterface::Shared*   SharedMemoryInterface::m_shared = 0;
+uint32_t                         SharedMemoryInterface::m_round = 0;
+std::vector<pid_t>               SharedMemoryInterface::m_children;
+
+void
+SharedMemoryInterface::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+SharedMemoryInterface::GetSystemId ()
+{
+  return m_sid;
+}
+
+uint32_t
+SharedMemoryInterface::GetSize ()
+{
+  return m_size;
+}
+
+bool
+SharedMemoryInterface::IsEnabled ()
+{
+  return m_enabled;
+}
+
+bool
+SharedMemoryInterface::IsActive ()
+{
+  return m_enabled;
+}
+
+uint32_t
+SharedMemoryInterface::GetRxCount ()
+{
+  return m_rxCount;
+}
+
+uint32_t
+SharedMemoryInterface::GetTxCount ()
+{
+  return m_txCount;
+}
+
+void
+SharedMemoryInterface::Enable (int* pargc, char*** pargv)
+{
+  NS_LOG_FUNCTION (this << pargc << pargv);
+
+  UintegerValue ranks;
+  g_sharedMemoryRanks.GetValue (ranks);
+  UintegerValue ringSize;
+  g_sharedMemoryRingSize.GetValue (ringSize);
+  StringValue simulationType;
+  GlobalValue::GetValueByName ("SimulatorImplementationType", simulationType);
+
+  NS_ASSERT_MSG (ranks.Get () > 0, "SharedMemoryRanks must be set to use the shared memory interface");
+  m_size = ranks.Get ();
+  m_ringSize = SharedMemoryAlign (ringSize.Get (), sizeof (Ring));
+  m_nullMessage = simulationType.Get () == "ns3::NullMessageSimulatorImpl";
+
+  size_t ringsOffset = SharedMemoryAlign (sizeof (Shared) + 2 * m_size * SHARED_MEMORY_SLOT_SIZE, sizeof (Ring));
+  m_mappingSize = ringsOffset + static_cast<size_t> (m_size) * m_size * (sizeof (Ring) + m_ringSize);
+
+  // An anonymous shared mapping is inherited by the forked ranks and goes away with them
+  void* mapping = mmap (0, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Cannot map " << m_mappingSize << " bytes of shared memory for " << m_size << " ranks");
+    }
+  m_shared = static_cast<Shared *> (mapping);
+
+  // Do not let the ranks print what is still buffered once more each
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  m_sid = 0;
+  m_children.clear ();
+  for (uint32_t i = 1; i < m_size; ++i)
+    {
+      pid_t pid = fork ();
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("Cannot fork rank " << i);
+        }
+      if (pid == 0)
+        {
+          m_sid = i;
+          m_children.clear ();
+#ifdef __linux__
+          // Do not outlive rank 0
+          prctl (PR_SET_PDEATHSIG, SIGTERM);
+#endif
+          break;
+        }
+      m_children.push_back (pid);
+    }
+
+  m_rxCount = 0;
+  m_txCount = 0;
+  m_round = 0;
+  m_enabled = true;
+  NS_LOG_INFO ("Rank " << m_sid << " of " << m_size << ", " << m_ringSize << " byte rings");
+}
+
+void
+SharedMemoryInterface::Disable ()
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (m_enabled);
+  bool failed = false;
+  for (uint32_t i = 0; i < m_children.size (); ++i)
+    {
+      int status = 0;
+      if (m_children[i] == 0)
+        {
+          // Already reaped while spinning
+          continue;
+        }
+      if (waitpid (m_children[i], &status, 0) < 0 || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          NS_LOG_ERROR ("Rank " << i + 1 << " did not exit cleanly");
+          failed = true;
+        }
+    }
+  m_children.clear ();
+
+  munmap (m_shared, m_mappingSize);
+  m_shared = 0;
+  m_enabled = false;
+
+  if (failed)
+    {
+      NS_FATAL_ERROR ("Some ranks did not exit cleanly");
+    }
+}
+
+SharedMemoryInterface::Ring*
+SharedMemoryInterface::GetTxRing (uint32_t rank)
+{
+  size_t ringsOffset = SharedMemoryAlign (sizeof (Shared) + 2 * m_size * SHARED_MEMORY_SLOT_SIZE, sizeof (Ring));
+  size_t index = static_cast<size_t> (m_sid) * m_size + rank;
+  return reinterpret_cast<Ring *> (reinterpret_cast<uint8_t *> (m_shared) + ringsOffset
+                                   + index * (sizeof (Ring) + m_ringSize));
+}
+
+SharedMemoryInterface::Ring*
+SharedMemoryInterface::GetRxRing (uint32_t rank)
+{
+  size_t ringsOffset = SharedMemoryAlign (sizeof (Shared) + 2 * m_size * SHARED_MEMORY_SLOT_SIZE, sizeof (Ring));
+  size_t index = static_cast<size_t> (rank) * m_size + m_sid;
+  return reinterpret_cast<Ring *> (reinterpret_cast<uint8_t *> (m_shared) + ringsOffset
+                                   + index * (sizeof (Ring) + m_ringSize));
+}
+
+uint8_t*
+SharedMemoryInterface::Reserve (uint32_t rank, uint32_t count)
+{
+  Ring* ring = GetTxRing (rank);
+  uint32_t record = SharedMemoryAlign (8 + count, 8);
+  NS_ABORT_MSG_IF (record > m_ringSize / 2, "Message of " << count << " bytes does not fit the "
+                   << m_ringSize << " byte rings, raise SharedMemoryRingSize");
+
+  uint32_t spins = 0;
+  while (true)
+    {
+      uint64_t tail = ring->tail;
+      uint64_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+      uint32_t offset = tail % m_ringSize;
+      uint32_t contiguous = m_ringSize - offset;
+      uint32_t needed = record + (contiguous < record ? contiguous : 0);
+      if (m_ringSize - (tail - head) >= needed)
+        {
+          uint8_t* data = ring->GetData ();
+          if (contiguous < record)
+            {
+              // Not enough room before the end of the ring, skip to its start
+              uint32_t* wrap = reinterpret_cast<uint32_t *> (data + offset);
+              wrap[0] = 0;
+              wrap[1] = SHARED_MEMORY_WRAP;
+              __atomic_store_n (&ring->tail, tail + contiguous, __ATOMIC_RELEASE);
+              offset = 0;
+            }
+          uint32_t* header = reinterpret_cast<uint32_t *> (data + offset);
+          header[0] = count;
+          header[1] = SHARED_MEMORY_MESSAGE;
+          return data + offset + 8;
+        }
+      // The destination is behind, read what it may be waiting for meanwhile
+      ReceiveMessages (false);
+      Spin (spins++);
+    }
+}
+
+void
+SharedMemoryInterface::Commit (uint32_t rank, uint32_t count)
+{
+  Ring* ring = GetTxRing (rank);
+  __atomic_store_n (&ring->tail, ring->tail + SharedMemoryAlign (8 + count, 8), __ATOMIC_RELEASE);
+}
+
+void
+SharedMemoryInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
+{
+  NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
+
+  NS_ASSERT (m_enabled);
+
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
+
+  uint64_t t = rxTime.GetInteger ();
+  Time guaranteeUpdate;
+  if (m_nullMessage)
+    {
+      guaranteeUpdate = NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId);
+    }
+  uint64_t guarantee = guaranteeUpdate.GetTimeStep ();
+
+  // Serialize the packet straight into the ring
+  uint32_t serializedSize = p->GetSerializedSize ();
+  uint8_t* buffer = Reserve (nodeSysId, SHARED_MEMORY_HEADER_SIZE + serializedSize);
+  std::memcpy (buffer, &t, sizeof (t));
+  std::memcpy (buffer + 8, &guarantee, sizeof (guarantee));
+  std::memcpy (buffer + 16, &node, sizeof (node));
+  std::memcpy (buffer + 20, &dev, sizeof (dev));
+  p->Serialize (buffer + SHARED_MEMORY_HEADER_SIZE, serializedSize);
+  Commit (nodeSysId, SHARED_MEMORY_HEADER_SIZE + serializedSize);
+  m_txCount++;
+
+  if (m_nullMessage)
+    {
+      NullMessageSimulatorImpl::GetInstance ()->PacketSent (nodeSysId, guaranteeUpdate);
+    }
+}
+
+void
+SharedMemoryInterface::SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle,
+                                        bool demand)
+{
+  NS_LOG_FUNCTION (guaranteeUpdate.GetTimeStep () << bundle << demand);
+
+  NS_ASSERT (m_enabled);
+
+  // rx time 0 marks a null message, the node field carries its flags
+  uint64_t t = 0;
+  uint64_t guarantee = guaranteeUpdate.GetInteger ();
+  uint32_t flags = demand ? NULL_MESSAGE_DEMAND : 0;
+  uint32_t none = 0;
+  uint32_t nodeSysId = bundle->GetSystemId ();
+  uint8_t* buffer = Reserve (nodeSysId, SHARED_MEMORY_HEADER_SIZE);
+  std::memcpy (buffer, &t, sizeof (t));
+  std::memcpy (buffer + 8, &guarantee, sizeof (guarantee));
+  std::memcpy (buffer + 16, &flags, sizeof (flags));
+  std::memcpy (buffer + 20, &none, sizeof (none));
+  Commit (nodeSysId, SHARED_MEMORY_HEADER_SIZE);
+}
+
+void
+SharedMemoryInterface::HandleMessage (uint32_t rank, const uint8_t* data, uint32_t count)
+{
+  uint64_t time;
+  uint64_t guarantee;
+  uint32_t node;
+  uint32_t dev;
+  std::memcpy (&time, data, sizeof (time));
+  std::memcpy (&guarantee, data + 8, sizeof (guarantee));
+  std::memcpy (&node, data + 16, sizeof (node));
+  std::memcpy (&dev, data + 20, sizeof (dev));
+
+  Time rxTime (time);
+
+  if (rxTime > Time (0))
+    {
+      m_rxCount++;
+      Ptr<Packet> p = Create<Packet> (data + SHARED_MEMORY_HEADER_SIZE, count - SHARED_MEMORY_HEADER_SIZE, true);
+
+      // Find the correct node/device to schedule receive event
+      Ptr<Node> pNode = NodeList::GetNode (node);
+      Ptr<MpiReceiver> pMpiRec = 0;
+      uint32_t nDevices = pNode->GetNDevices ();
+      for (uint32_t i = 0; i < nDevices; ++i)
+        {
+          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+          if (pThisDev->GetIfIndex () == dev)
+            {
+              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+              break;
+            }
+        }
+
+      NS_ASSERT (pNode && pMpiRec);
+
+      // Schedule the rx event
+      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                      &MpiReceiver::Receive, pMpiRec, p);
+    }
+
+  if (m_nullMessage)
+    {
+      // Update guarantee time for both packet receives and Null Messages.
+      Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (rank);
+      NS_ASSERT (bundle);
+
+      bundle->SetGuaranteeTime (Time (guarantee));
+      bundle->NotifyReceived (rxTime == Time (0));
+      if (rxTime == Time (0) && (node & NULL_MESSAGE_DEMAND))
+        {
+          NullMessageSimulatorImpl::GetInstance ()->NullMessageDemanded (bundle);
+        }
+    }
+}
+
+void
+SharedMemoryInterface::ReceiveMessages (bool blocking)
+{
+  NS_LOG_FUNCTION (blocking);
+
+  NS_ASSERT (m_enabled);
+
+  if (blocking && m_nullMessage && RemoteChannelBundleManager::Size () == 0)
+    {
+      // Not communicating with anyone.
+      return;
+    }
+
+  uint32_t spins = 0;
+  while (true)
+    {
+      bool received = false;
+      for (uint32_t rank = 0; rank < m_size; ++rank)
+        {
+          if (rank == m_sid)
+            {
+              continue;
+            }
+          Ring* ring = GetRxRing (rank);
+          uint64_t head = ring->head;
+          uint64_t tail = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+          if (head == tail)
+            {
+              continue;
+            }
+          uint8_t* data = ring->GetData ();
+          while (head != tail)
+            {
+              uint32_t offset = head % m_ringSize;
+              const uint32_t* header = reinterpret_cast<const uint32_t *> (data + offset);
+              if (header[1] == SHARED_MEMORY_WRAP)
+                {
+                  head += m_ringSize - offset;
+                  continue;
+                }
+              HandleMessage (rank, data + offset + 8, header[0]);
+              head += SharedMemoryAlign (8 + header[0], 8);
+            }
+          __atomic_store_n (&ring->head, head, __ATOMIC_RELEASE);
+          received = true;
+        }
+      if (received || !blocking)
+        {
+          return;
+        }
+      Spin (spins++);
+    }
+}
+
+void
+SharedMemoryInterface::Allgather (const void* send, void* recv, uint32_t size)
+{
+  NS_LOG_FUNCTION (send << recv << size);
+
+  NS_ASSERT (m_enabled);
+  NS_ASSERT_MSG (size <= SHARED_MEMORY_SLOT_SIZE, "Allgather of " << size << " bytes does not fit a slot");
+
+  // Rounds alternate between two sets of slots: a rank cannot write the
+  // slots of round r + 2 before every rank has passed the barrier of
+  // round r + 1, that is before every rank is done reading round r
+  std::memcpy (m_shared->GetSlot (m_round, m_sid, m_size), send, size);
+  Barrier ();
+  for (uint32_t rank = 0; rank < m_size; ++rank)
+    {
+      std::memcpy (static_cast<uint8_t *> (recv) + rank * size, m_shared->GetSlot (m_round, rank, m_size), size);
+    }
+  m_round++;
+}
+
+void
+SharedMemoryInterface::Barrier ()
+{
+  uint32_t generation = __atomic_load_n (&m_shared->generation, __ATOMIC_ACQUIRE);
+  if (__atomic_add_fetch (&m_shared->count, 1, __ATOMIC_ACQ_REL) == m_size)
+    {
+      // Last one in, release the others
+      __atomic_store_n (&m_shared->count, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (&m_shared->generation, generation + 1, __ATOMIC_RELEASE);
+      return;
+    }
+  uint32_t spins = 0;
+  while (__atomic_load_n (&m_shared->generation, __ATOMIC_ACQUIRE) == generation)
+    {
+      // A rank still sending may be waiting for room in a ring to this one
+      ReceiveMessages (false);
+      Spin (spins++);
+    }
+}
+
+void
+SharedMemoryInterface::Spin (uint32_t spins)
+{
+  if (spins < SHARED_MEMORY_SPINS)
+    {
+      return;
+    }
+  sched_yield ();
+  if (m_sid == 0 && spins % SHARED_MEMORY_SPINS == 0)
+    {
+      // A rank done with its simulation may exit while this one still
+      // reads what it sent; one which failed would never send again
+      int status;
+      pid_t pid = waitpid (-1, &status, WNOHANG);
+      if (pid > 0)
+        {
+          std::vector<pid_t>::iterator child = std::find (m_children.begin (), m_children.end (), pid);
+          if (child != m_children.end ())
+            {
+              *child = 0;
+            }
+          if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+            {
+              NS_FATAL_ERROR ("A rank failed before the end of the simulation");
+            }
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef NS3_SHARED_MEMORY_INTERFACE_H
+#define NS3_SHARED_MEMORY_INTERFACE_H
+
+#include <stdint.h>
+#include <vector>
+#include <sys/types.h>
+
+#include "ns3/nstime.h"
+
+#include "parallel-communication-interface.h"
+
+namespace ns3 {
+
+class RemoteChannelBundle;
+class Packet;
+
+/**
+ * size of the Allgather slot of a rank
+ */
+const uint32_t SHARED_MEMORY_SLOT_SIZE = 64;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Parallel communication between processes of a single host
+ *
+ * Enable forks the process into SharedMemoryRanks ranks which share an
+ * anonymous memory mapping.  Every ordered pair of ranks has a single
+ * producer, single consumer ring in it; a packet is serialized straight
+ * into the ring of its destination rank and read back from it, with no
+ * message layer in between.  The same mapping holds the slots and the
+ * barrier used by Allgather.
+ *
+ * The interface serves both parallel simulators: with
+ * ns3::DistributedSimulatorImpl it carries the packets and the LBTS
+ * exchange of the granted time window, with ns3::NullMessageSimulatorImpl
+ * it carries packets and null messages.  It is picked by MpiInterface
+ * instead of the MPI interfaces when SharedMemoryRanks is not 0, and does
+ * not need MPI to be compiled in.
+ *
+ * Enable must be called before the topology is built; every rank then
+ * builds it, as MPI ranks do.  Rank 0 waits for the other ranks in Disable.
+ */
+class SharedMemoryInterface : public ParallelCommunicationInterface
+{
+public:
+  /**
+   * Nothing to release, the mapping lives until Disable
+   */
+  virtual void Destroy ();
+  /**
+   * \return rank of this process
+   */
+  virtual uint32_t GetSystemId ();
+  /**
+   * \return number of ranks
+   */
+  virtual uint32_t GetSize ();
+  /**
+   * \return true once the ranks have been forked
+   */
+  virtual bool IsEnabled ();
+  /**
+   * \param pargc number of command line arguments
+   * \param pargv command line arguments
+   *
+   * Maps the shared memory and forks the ranks
+   */
+  virtual void Enable (int* pargc, char*** pargv);
+  /**
+   * Waits for the other ranks on rank 0, then unmaps the shared memory
+   */
+  virtual void Disable ();
+  /**
+   * \param p packet to send
+   * \param rxTime received time at destination node
+   * \param node destination node
+   * \param dev destination device
+   *
+   * Serialize the packet into the ring of the rank of its destination node
+   */
+  virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * \return true if this interface carries the parallel communication
+   */
+  static bool IsActive ();
+  /**
+   * Read every pending packet and null message
+   *
+   * \param blocking wait until at least one message has been read
+   */
+  static void ReceiveMessages (bool blocking = false);
+  /**
+   * \param guaranteeUpdate guarantee time to send
+   * \param bundle the bundle of the destination rank
+   * \param demand ask the destination for a null message in return
+   *
+   * Send a null message
+   */
+  static void SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle,
+                               bool demand = false);
+  /**
+   * Gather size bytes from every rank, in rank order
+   *
+   * \param send the bytes of this rank
+   * \param recv receives size bytes per rank
+   * \param size at most SHARED_MEMORY_SLOT_SIZE bytes
+   */
+  static void Allgather (const void* send, void* recv, uint32_t size);
+  /**
+   * \return received count in packets
+   */
+  static uint32_t GetRxCount ();
+  /**
+   * \return transmitted count in packets
+   */
+  static uint32_t GetTxCount ();
+
+private:
+  struct Ring;
+  struct Shared;
+
+  /**
+   * \param rank a rank
+   * \return the ring from this rank to rank
+   */
+  static Ring* GetTxRing (uint32_t rank);
+  /**
+   * \param rank a rank
+   * \return the ring from rank to this rank
+   */
+  static Ring* GetRxRing (uint32_t rank);
+  /**
+   * Handle one message read from a ring
+   * \param rank the sending rank
+   * \param data the message metadata followed by the serialized packet
+   * \param count size of data in bytes
+   */
+  static void HandleMessage (uint32_t rank, const uint8_t* data, uint32_t count);
+  /**
+   * Reserve room for a message in the ring of a rank, reading incoming
+   * messages while it is full so that two ranks sending to each other
+   * cannot block each other
+   * \param rank the destination rank
+   * \param count size of the message in bytes
+   * \return where to write the message
+   */
+  static uint8_t* Reserve (uint32_t rank, uint32_t count);
+  /**
+   * Make a reserved message visible to its destination
+   * \param rank the destination rank
+   * \param count size of the message in bytes, as reserved
+   */
+  static void Commit (uint32_t rank, uint32_t count);
+  /**
+   * Wait for every rank to reach the barrier, reading incoming messages meanwhile
+   */
+  static void Barrier ();
+  /**
+   * Called while spinning; yields once spinning has lasted and lets rank 0
+   * notice a rank which died
+   * \param spins number of spins so far
+   */
+  static void Spin (uint32_t spins);
+
+  static uint32_t m_sid;
+  static uint32_t m_size;
+  static bool     m_enabled;
+
+  // Whether the null message simulator drives the interface
+  static bool     m_nullMessage;
+
+  // Total packets received
+  static uint32_t m_rxCount;
+
+  // Total packets sent
+  static uint32_t m_txCount;
+
+  // Bytes of data in each ring
+  static uint32_t m_ringSize;
+
+  // Size of the shared mapping
+  static size_t   m_mappingSize;
+
+  // The shared mapping
+  static Shared*  m_shared;
+
+  // Allgather round, picks the slots written
+  static uint32_t m_round;
+
+  // Processes forked by rank 0
+  static std::vector<pid_t> m_children;
+};
+
+} // namespace ns3
+
+#endif /* NS3_SHARED_MEMORY_INTERFACE_H */
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/packet.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/granted-time-window-mpi-interface.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * A packet received through MPI
+ */
+struct RxRecord
+{
+  int64_t ts;
+  std::vector<uint8_t> data;
+};
+
+void
+MpiRx (std::vector<RxRecord> *trace, Ptr<Packet> p)
+{
+  RxRecord record;
+  record.ts = Simulator::Now ().GetTimeStep ();
+  record.data.resize (p->GetSize ());
+  p->CopyData (&record.data[0], record.data.size ());
+  trace->push_back (record);
+}
+
+/**
+ * \param i the index of a packet
+ * \return the payload of the packet, some larger than a small batch
+ */
+std::vector<uint8_t>
+MakePayload (uint32_t i)
+{
+  std::vector<uint8_t> data (20 + (i * 37) % 400);
+  for (uint32_t j = 0; j < data.size (); ++j)
+    {
+      data[j] = static_cast<uint8_t> (3 * i + j);
+    }
+  return data;
+}
+
+} // anonymous namespace
+
+/**
+ * Sends packets from a single MPI rank to itself, so that they go through
+ * the batches, or the per packet messages, and are unpacked back; MPI can
+ * only be initialized once in a process, so each run is made in a child
+ */
+class GrantedTimeWindowMpiBatchTestCase : public TestCase
+{
+public:
+  /**
+   * \param batchSize The MpiBatchSize of the run
+   */
+  GrantedTimeWindowMpiBatchTestCase (uint32_t batchSize);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Runs the exchange
+   * \return the number of failed checks
+   */
+  uint32_t RunRank (void);
+
+  static const uint32_t PACKETS = 50;
+
+  uint32_t m_batchSize;
+};
+
+GrantedTimeWindowMpiBatchTestCase::GrantedTimeWindowMpiBatchTestCase (uint32_t batchSize)
+  : TestCase (batchSize ? "Check packets batched in MPI messages" : "Check packets sent one per MPI message"),
+    m_batchSize (batchSize)
+{
+}
+
+uint32_t
+GrantedTimeWindowMpiBatchTestCase::RunRank (void)
+{
+  std::vector<RxRecord> trace;
+  Ptr<Node> node = CreateObject<Node> (0);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver> ();
+  receiver->SetReceiveCallback (MakeBoundCallback (&MpiRx, &trace));
+  device->AggregateObject (receiver);
+
+  Config::SetGlobal ("MpiBatchSize", UintegerValue (m_batchSize));
+  ParallelCommunicationInterface* mpi = new GrantedTimeWindowMpiInterface ();
+  mpi->Enable (0, 0);
+
+  uint32_t failures = 0;
+  for (uint32_t i = 0; i < PACKETS; ++i)
+    {
+      std::vector<uint8_t> data = MakePayload (i);
+      mpi->SendPacket (Create<Packet> (&data[0], data.size ()), MicroSeconds (i + 1),
+                       node->GetId (), device->GetIfIndex ());
+    }
+  // What is still batched goes at the end of the window
+  GrantedTimeWindowMpiInterface::FlushBatches ();
+  for (uint32_t spins = 0; GrantedTimeWindowMpiInterface::GetRxCount () < PACKETS && spins < 10000000; ++spins)
+    {
+      GrantedTimeWindowMpiInterface::ReceiveMessages ();
+      GrantedTimeWindowMpiInterface::TestSendComplete ();
+    }
+  Simulator::Run ();
+
+  failures += GrantedTimeWindowMpiInterface::GetTxCount () == PACKETS ? 0 : 1;
+  failures += GrantedTimeWindowMpiInterface::GetRxCount () == PACKETS ? 0 : 1;
+  failures += trace.size () == PACKETS ? 0 : 1;
+  for (uint32_t i = 0; i < trace.size (); ++i)
+    {
+      failures += trace[i].ts == MicroSeconds (i + 1).GetTimeStep () ? 0 : 1;
+      failures += trace[i].data == MakePayload (i) ? 0 : 1;
+    }
+
+  mpi->Destroy ();
+  mpi->Disable ();
+  delete mpi;
+  Simulator::Destroy ();
+  return failures;
+}
+
+void
+GrantedTimeWindowMpiBatchTestCase::DoRun (void)
+{
+  // Do not let the child print what is still buffered once more
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::fflush (0);
+
+  pid_t pid = fork ();
+  NS_TEST_ASSERT_MSG_EQ ((pid >= 0), true, "Cannot fork the MPI rank");
+  if (pid == 0)
+    {
+      _exit (std::min<uint32_t> (RunRank (), 100));
+    }
+
+  int status = 0;
+  waitpid (pid, &status, 0);
+  NS_TEST_ASSERT_MSG_EQ ((WIFEXITED (status) != 0), true, "The MPI rank did not exit");
+  NS_TEST_ASSERT_MSG_EQ (WEXITSTATUS (status), 0, "Packets were lost or changed through MPI");
+}
+
+/**
+ * Runs the test cases of GrantedTimeWindowMpiInterface
+ */
+class GrantedTimeWindowMpiInterfaceTestSuite : public TestSuite
+{
+public:
+  GrantedTimeWindowMpiInterfaceTestSuite ();
+};
+
+GrantedTimeWindowMpiInterfaceTestSuite::GrantedTimeWindowMpiInterfaceTestSuite ()
+  : TestSuite ("mpi-granted-time-window", UNIT)
+{
+#ifdef NS3_MPI
+  AddTestCase (new GrantedTimeWindowMpiBatchTestCase (0), TestCase::QUICK);
+  AddTestCase (new GrantedTimeWindowMpiBatchTestCase (256), TestCase::QUICK);
+#endif
+}
+
+static GrantedTimeWindowMpiInterfaceTestSuite g_grantedTimeWindowMpiInterfaceTestSuite; //!< The test suite
@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/layer2-p2p-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * The hop count and the origin of a packet forwarded around the test topology
+ */
+class HopHeader : public Header
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::MultithreadedSimulatorTestHopHeader")
+      .SetParent<Header> ()
+      .AddConstructor<HopHeader> ()
+    ;
+    return tid;
+  }
+  HopHeader ()
+    : m_hop (0),
+      m_origin (0)
+  {
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 8;
+  }
+  virtual void Serialize (Buffer::Iterator start) const
+  {
+    start.WriteHtonU32 (m_hop);
+    start.WriteHtonU32 (m_origin);
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator start)
+  {
+    m_hop = start.ReadNtohU32 ();
+    m_origin = start.ReadNtohU32 ();
+    return 8;
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "hop=" << m_hop << " origin=" << m_origin;
+  }
+
+  uint32_t m_hop;
+  uint32_t m_origin;
+};
+
+/**
+ * A packet received by a node
+ */
+struct RxRecord
+{
+  int64_t ts;
+  uint32_t device;
+  uint32_t hop;
+  uint32_t origin;
+  uint32_t size;
+  uint64_t uid;
+};
+
+} // anonymous namespace
+
+/**
+ * Runs a Layer2P2P topology split into partitions under a simulator
+ * implementation and checks the receptions are those of the serial simulator
+ */
+class MultithreadedSimulatorCompareTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorCompareTestCase ();
+  virtual void DoRun (void);
+
+private:
+  typedef std::vector<std::vector<RxRecord> > Trace;
+
+  /**
+   * Builds and runs the topology, recording the receptions of every node
+   *
+   * \param implementation The type of the simulator implementation
+   * \param threads The MaxThreads of a MultithreadedSimulatorImpl
+   * \param trace The receptions, one list per node
+   */
+  void RunTopology (std::string implementation, uint32_t threads, Trace &trace);
+  void Send (Ptr<Node> node, uint32_t k);
+  void Forward (Ptr<Node> node, Ptr<Packet> p, uint32_t hop, uint32_t origin);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  /**
+   * \param uids Whether the packet uids must match too
+   */
+  void Compare (const Trace &expected, const Trace &trace, bool uids, std::string what);
+
+  static const uint32_t NODES = 12;
+  static const uint32_t PARTITIONS = 4;
+  static const uint32_t PACKETS = 40;
+  static const uint32_t HOPS = 12;
+
+  Trace *m_trace;   //!< The trace of the run, each list only touched by the thread of its node
+};
+
+MultithreadedSimulatorCompareTestCase::MultithreadedSimulatorCompareTestCase ()
+  : TestCase ("Check the multithreaded simulator receives as the serial one")
+{
+}
+
+void
+MultithreadedSimulatorCompareTestCase::Send (Ptr<Node> node, uint32_t k)
+{
+  Forward (node, Create<Packet> (50 + (k * 13 + node->GetId ()) % 400), 0, node->GetId ());
+}
+
+void
+MultithreadedSimulatorCompareTestCase::Forward (Ptr<Node> node, Ptr<Packet> p, uint32_t hop, uint32_t origin)
+{
+  HopHeader header;
+  header.m_hop = hop;
+  header.m_origin = origin;
+  p->AddHeader (header);
+  Ptr<NetDevice> device = node->GetDevice ((hop * 7 + origin + node->GetId () + p->GetSize ()) % node->GetNDevices ());
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+MultithreadedSimulatorCompareTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                                 uint16_t protocol, const Address &from)
+{
+  Ptr<Packet> p = packet->Copy ();
+  HopHeader header;
+  p->RemoveHeader (header);
+
+  RxRecord record;
+  record.ts = Simulator::Now ().GetTimeStep ();
+  record.device = device->GetIfIndex ();
+  record.hop = header.m_hop;
+  record.origin = header.m_origin;
+  record.size = p->GetSize ();
+  record.uid = packet->GetUid ();
+  (*m_trace)[device->GetNode ()->GetId ()].push_back (record);
+
+  if (header.m_hop < HOPS)
+    {
+      Forward (device->GetNode (), p, header.m_hop + 1, header.m_origin);
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorCompareTestCase::RunTopology (std::string implementation, uint32_t threads, Trace &trace)
+{
+  Simulator::Destroy ();
+  ObjectFactory factory;
+  factory.SetTypeId (implementation);
+  if (implementation == "ns3::MultithreadedSimulatorImpl")
+    {
+      factory.Set ("MaxThreads", UintegerValue (threads));
+    }
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  trace.assign (NODES, std::vector<RxRecord> ());
+  m_trace = &trace;
+
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < NODES; ++i)
+    {
+      nodes.Add (CreateObject<Node> (i % PARTITIONS));
+    }
+  // every node has a link to the next one and one to the fifth next one,
+  // with different delays, so most links join two partitions
+  Layer2P2PHelper layer2;
+  layer2.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  for (uint32_t i = 0; i < NODES; ++i)
+    {
+      layer2.SetChannelAttribute ("Delay", StringValue ("5us"));
+      layer2.Install (nodes.Get (i), nodes.Get ((i + 1) % NODES));
+      layer2.SetChannelAttribute ("Delay", StringValue ("7us"));
+      layer2.Install (nodes.Get (i), nodes.Get ((i + 5) % NODES));
+    }
+  for (uint32_t i = 0; i < NODES; ++i)
+    {
+      for (uint32_t j = 0; j < nodes.Get (i)->GetNDevices (); ++j)
+        {
+          nodes.Get (i)->GetDevice (j)->SetReceiveCallback (
+            MakeCallback (&MultithreadedSimulatorCompareTestCase::Receive, this));
+        }
+      for (uint32_t k = 0; k < PACKETS; ++k)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (3 * k + i % 3),
+                                          &MultithreadedSimulatorCompareTestCase::Send, this, nodes.Get (i), k);
+        }
+    }
+
+  Simulator::Stop (MilliSeconds (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_trace = 0;
+}
+
+void
+MultithreadedSimulatorCompareTestCase::Compare (const Trace &expected, const Trace &trace, bool uids, std::string what)
+{
+  for (uint32_t i = 0; i < NODES; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (trace[i].size (), expected[i].size (), what << ": bad number of receptions at node " << i);
+      for (uint32_t j = 0; j < expected[i].size (); ++j)
+        {
+          const RxRecord &a = expected[i][j];
+          const RxRecord &b = trace[i][j];
+          NS_TEST_ASSERT_MSG_EQ (b.ts, a.ts, what << ": bad time of reception " << j << " at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (b.device, a.device, what << ": bad device of reception " << j << " at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (b.hop, a.hop, what << ": bad packet " << j << " at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (b.origin, a.origin, what << ": bad packet " << j << " at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (b.size, a.size, what << ": bad packet size " << j << " at node " << i);
+          if (uids)
+            {
+              NS_TEST_ASSERT_MSG_EQ (b.uid, a.uid, what << ": bad packet uid " << j << " at node " << i);
+            }
+        }
+    }
+}
+
+void
+MultithreadedSimulatorCompareTestCase::DoRun (void)
+{
+  Trace serial;
+  RunTopology ("ns3::DefaultSimulatorImpl", 0, serial);
+  uint32_t receptions = 0;
+  for (uint32_t i = 0; i < NODES; ++i)
+    {
+      receptions += serial[i].size ();
+    }
+  NS_TEST_ASSERT_MSG_EQ ((receptions > NODES * PACKETS), true, "The packets must be forwarded");
+
+  Trace single;
+  RunTopology ("ns3::MultithreadedSimulatorImpl", 1, single);
+  Compare (serial, single, false, "1 thread");
+
+  // the packet uids come from counters of the partitions: they differ from
+  // the serial ones, but not with the number of threads
+  Trace multiple;
+  RunTopology ("ns3::MultithreadedSimulatorImpl", PARTITIONS, multiple);
+  Compare (serial, multiple, false, "4 threads");
+  Compare (single, multiple, true, "4 threads");
+}
+
+/**
+ * Runs the test cases of MultithreadedSimulatorImpl
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("mpi-multithreaded", UNIT)
+{
+  AddTestCase (new MultithreadedSimulatorCompareTestCase, TestCase::QUICK);
+}
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite; //!< The test suite
@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/simple-channel.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/shared-memory-interface.h"
+#include "ns3/remote-channel-bundle.h"
+#include "ns3/remote-channel-bundle-manager.h"
+
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace {
+
+void
+Nothing (void)
+{
+}
+
+/**
+ * Reads from the other rank until count Null Messages came from it
+ * \param bundle The bundle of the other rank
+ * \param count The Null Messages expected
+ */
+void
+ReceiveNullMessages (Ptr<RemoteChannelBundle> bundle, uint64_t count)
+{
+  while (bundle->GetNullMessagesReceived () < count)
+    {
+      SharedMemoryInterface::ReceiveMessages (true);
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * Runs the null message simulator on two ranks forked on this host and
+ * follows the guarantee time and the demands each bundle keeps track of
+ */
+class RemoteChannelBundleNullMessageTestCase : public TestCase
+{
+public:
+  RemoteChannelBundleNullMessageTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Checks a condition, on rank 0 through the test framework and on the
+   * other rank by counting the failures it reports at the end
+   */
+  void Check (bool condition, std::string message);
+
+  uint32_t m_rank;
+  uint32_t m_failures;
+};
+
+RemoteChannelBundleNullMessageTestCase::RemoteChannelBundleNullMessageTestCase ()
+  : TestCase ("Check remote channel bundles track guarantees, suppressions and demands"),
+    m_rank (0),
+    m_failures (0)
+{
+}
+
+void
+RemoteChannelBundleNullMessageTestCase::Check (bool condition, std::string message)
+{
+  if (m_rank == 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (condition, true, message);
+    }
+  else
+    {
+      m_failures += condition ? 0 : 1;
+    }
+}
+
+void
+RemoteChannelBundleNullMessageTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::NullMessageSimulatorImpl"));
+  Config::SetGlobal ("SharedMemoryRanks", UintegerValue (2));
+  MpiInterface::Enable (0, 0);
+  m_rank = MpiInterface::GetSystemId ();
+
+  // One 1us channel to the other rank, and an event 1s ahead so that the
+  // guarantee of a Null Message is its delay past the safe time, 0
+  Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Add (1 - m_rank);
+  bundle->AddChannel (CreateObject<SimpleChannel> (), MicroSeconds (1));
+  Simulator::Schedule (Seconds (1), &Nothing);
+  RemoteChannelBundleManager::InitializeNullMessageEvents ();
+  Check (bundle->GetSentGuaranteeTime () == MicroSeconds (1), "The first Null Message carries the delay");
+  Check (bundle->GetNullMessagesSent () == 1, "The first Null Message is sent");
+
+  if (m_rank == 1)
+    {
+      bundle->Send (MicroSeconds (2), true);
+      Check (bundle->IsNullMessageDemanded (), "A sent demand is pending until a reply");
+      Check (bundle->GetDemandsSent () == 1, "The demand must be counted");
+    }
+
+  uint32_t failures[2];
+  SharedMemoryInterface::Allgather (&m_failures, failures, sizeof (m_failures));
+
+  if (m_rank == 0)
+    {
+      ReceiveNullMessages (bundle, 2);
+      Check (bundle->GetGuaranteeTime () == MicroSeconds (2), "The demand carries a guarantee too");
+      Check (bundle->IsNullMessageOwed (), "A received demand is owed");
+
+      bundle->Send (MicroSeconds (5));
+      Check (bundle->GetSentGuaranteeTime () == MicroSeconds (5), "A Null Message advances the sent guarantee");
+      Check (!bundle->IsNullMessageOwed (), "A Null Message pays what is owed");
+
+      bundle->SetNullMessageOwed (true);
+      bundle->NotifyPacketSent (MicroSeconds (8));
+      Check (bundle->GetSentGuaranteeTime () == MicroSeconds (8), "A packet advances the sent guarantee");
+      Check (!bundle->IsNullMessageOwed (), "A piggybacked guarantee pays what is owed");
+      bundle->NotifyPacketSent (MicroSeconds (3));
+      Check (bundle->GetSentGuaranteeTime () == MicroSeconds (8), "The sent guarantee never goes back");
+      Check (bundle->GetPacketsSent () == 2, "The packets must be counted");
+
+      // The guarantee now is 1us, which the other rank already has
+      bundle->SetNullMessageOwed (true);
+      RemoteChannelBundleManager::SendOwedNullMessages ();
+      Check (bundle->GetNullMessagesSuppressed () == 1, "A Null Message not advancing the guarantee is suppressed");
+      Check (bundle->GetNullMessagesSent () == 2, "A suppressed Null Message is not sent");
+      Check (bundle->IsNullMessageOwed (), "A suppressed Null Message still owes the demand");
+    }
+
+  SharedMemoryInterface::Allgather (&m_failures, failures, sizeof (m_failures));
+
+  if (m_rank == 1)
+    {
+      ReceiveNullMessages (bundle, 2);
+      Check (!bundle->IsNullMessageDemanded (), "A reply answers the demand");
+      Check (bundle->GetGuaranteeTime () == MicroSeconds (5), "The last Null Message sets the guarantee");
+    }
+
+  SharedMemoryInterface::Allgather (&m_failures, failures, sizeof (m_failures));
+  if (m_rank != 0)
+    {
+      _exit (0);
+    }
+  NS_TEST_EXPECT_MSG_EQ (failures[1], 0, "Rank 1 saw failures");
+
+  Simulator::Destroy ();
+  MpiInterface::Disable ();
+  Config::SetGlobal ("SharedMemoryRanks", UintegerValue (0));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+/**
+ * Runs the test cases of RemoteChannelBundle
+ */
+class RemoteChannelBundleTestSuite : public TestSuite
+{
+public:
+  RemoteChannelBundleTestSuite ();
+};
+
+RemoteChannelBundleTestSuite::RemoteChannelBundleTestSuite ()
+  : TestSuite ("mpi-remote-channel-bundle", UNIT)
+{
+  AddTestCase (new RemoteChannelBundleNullMessageTestCase, TestCase::QUICK);
+}
+
+static RemoteChannelBundleTestSuite g_remoteChannelBundleTestSuite; //!< The test suite
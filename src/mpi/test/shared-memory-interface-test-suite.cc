@@ -0,0 +1,286 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/packet.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/shared-memory-interface.h"
+
+#include <vector>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * A packet received by rank 0
+ */
+struct RxRecord
+{
+  int64_t ts;
+  std::vector<uint8_t> data;
+};
+
+void
+MpiRx (std::vector<RxRecord> *trace, Ptr<Packet> p)
+{
+  RxRecord record;
+  record.ts = Simulator::Now ().GetTimeStep ();
+  record.data.resize (p->GetSize ());
+  p->CopyData (&record.data[0], record.data.size ());
+  trace->push_back (record);
+}
+
+/**
+ * \param i the index of a packet
+ * \return the payload of the packet
+ */
+std::vector<uint8_t>
+MakePayload (uint32_t i)
+{
+  std::vector<uint8_t> data (500 + 7 * i);
+  for (uint32_t j = 0; j < data.size (); ++j)
+    {
+      data[j] = static_cast<uint8_t> (i + j);
+    }
+  return data;
+}
+
+/**
+ * Forks two ranks on the small rings; the child ranks report their
+ * failures through a last Allgather and exit without returning to the
+ * test framework
+ */
+class ForkedRanks
+{
+public:
+  ForkedRanks (uint32_t ringSize)
+    : m_failures (0)
+  {
+    Config::SetGlobal ("SharedMemoryRanks", UintegerValue (2));
+    Config::SetGlobal ("SharedMemoryRingSize", UintegerValue (ringSize));
+    Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+    m_interface.Enable (0, 0);
+  }
+  uint32_t GetRank ()
+  {
+    return m_interface.GetSystemId ();
+  }
+  SharedMemoryInterface& GetInterface ()
+  {
+    return m_interface;
+  }
+  void Check (bool condition)
+  {
+    m_failures += condition ? 0 : 1;
+  }
+  /**
+   * Ends the run of a child rank, or waits for the child on rank 0
+   * \return the failures seen by the child
+   */
+  uint32_t Finish ()
+  {
+    uint32_t failures[2];
+    SharedMemoryInterface::Allgather (&m_failures, failures, sizeof (m_failures));
+    if (GetRank () != 0)
+      {
+        _exit (0);
+      }
+    m_interface.Disable ();
+    Config::SetGlobal ("SharedMemoryRanks", UintegerValue (0));
+    Config::SetGlobal ("SharedMemoryRingSize", UintegerValue (1 << 20));
+    return failures[1];
+  }
+
+private:
+  SharedMemoryInterface m_interface;
+  uint32_t m_failures;
+};
+
+} // anonymous namespace
+
+/**
+ * Sends enough packets from rank 1 to rank 0 to wrap the smallest ring
+ * many times over, and checks rank 0 schedules each of them once, in
+ * order and intact
+ */
+class SharedMemoryRingWrapTestCase : public TestCase
+{
+public:
+  SharedMemoryRingWrapTestCase ();
+  virtual void DoRun (void);
+
+private:
+  static const uint32_t RING_SIZE = 8192;
+  static const uint32_t PACKETS = 64;
+};
+
+SharedMemoryRingWrapTestCase::SharedMemoryRingWrapTestCase ()
+  : TestCase ("Check packets survive the wrap of the shared memory rings")
+{
+}
+
+void
+SharedMemoryRingWrapTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+
+  // Both ranks build the node of rank 0, as they would build a topology
+  std::vector<RxRecord> trace;
+  Ptr<Node> node = CreateObject<Node> (0);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver> ();
+  receiver->SetReceiveCallback (MakeBoundCallback (&MpiRx, &trace));
+  device->AggregateObject (receiver);
+
+  ForkedRanks ranks (RING_SIZE);
+  uint32_t bytes = 0;
+  if (ranks.GetRank () == 1)
+    {
+      for (uint32_t i = 0; i < PACKETS; ++i)
+        {
+          std::vector<uint8_t> data = MakePayload (i);
+          bytes += data.size ();
+          ranks.GetInterface ().SendPacket (Create<Packet> (&data[0], data.size ()),
+                                            MicroSeconds (i + 1), node->GetId (), device->GetIfIndex ());
+        }
+      ranks.Check (bytes > 4 * RING_SIZE);
+      ranks.Check (SharedMemoryInterface::GetTxCount () == PACKETS);
+    }
+
+  // Rank 0 reaches the barrier long before rank 1, which is left waiting
+  // for room in the ring; the barrier must read meanwhile
+  uint32_t sent[2];
+  SharedMemoryInterface::Allgather (&bytes, sent, sizeof (bytes));
+
+  if (ranks.GetRank () == 0)
+    {
+      while (SharedMemoryInterface::GetRxCount () < PACKETS)
+        {
+          SharedMemoryInterface::ReceiveMessages (true);
+        }
+      Simulator::Run ();
+    }
+  uint32_t failures = ranks.Finish ();
+
+  NS_TEST_EXPECT_MSG_EQ (failures, 0, "Rank 1 must send every packet");
+  NS_TEST_EXPECT_MSG_GT (sent[1], 4 * RING_SIZE, "The packets must wrap the ring");
+  NS_TEST_EXPECT_MSG_EQ (SharedMemoryInterface::GetRxCount (), PACKETS, "Every packet must be read once");
+  NS_TEST_ASSERT_MSG_EQ (trace.size (), PACKETS, "Every packet must be received once");
+  for (uint32_t i = 0; i < PACKETS; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (trace[i].ts, MicroSeconds (i + 1).GetTimeStep (), "Packet " << i << " time");
+      NS_TEST_EXPECT_MSG_EQ ((trace[i].data == MakePayload (i)), true, "Packet " << i << " bytes");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Runs many Allgather rounds back to back, so that a rank writes the
+ * slots of the next round while the other still reads the current one
+ */
+class SharedMemoryAllgatherTestCase : public TestCase
+{
+public:
+  SharedMemoryAllgatherTestCase ();
+  virtual void DoRun (void);
+
+private:
+  static const uint32_t ROUNDS = 2000;
+};
+
+SharedMemoryAllgatherTestCase::SharedMemoryAllgatherTestCase ()
+  : TestCase ("Check Allgather rounds alternate their slots")
+{
+}
+
+void
+SharedMemoryAllgatherTestCase::DoRun (void)
+{
+  ForkedRanks ranks (8192);
+  uint32_t rank = ranks.GetRank ();
+  uint32_t wrong = 0;
+  for (uint32_t round = 0; round < ROUNDS; ++round)
+    {
+      uint32_t send[2] = { round, rank * ROUNDS + round };
+      uint32_t recv[4];
+      SharedMemoryInterface::Allgather (send, recv, sizeof (send));
+      for (uint32_t r = 0; r < 2; ++r)
+        {
+          if (recv[2 * r] != round || recv[2 * r + 1] != r * ROUNDS + round)
+            {
+              wrong++;
+            }
+        }
+      if (round % 97 == rank)
+        {
+          // Let the other rank run ahead into the next round
+          usleep (100);
+        }
+    }
+
+  // A round filling a whole slot
+  uint8_t slot[SHARED_MEMORY_SLOT_SIZE];
+  uint8_t slots[2 * SHARED_MEMORY_SLOT_SIZE];
+  for (uint32_t i = 0; i < SHARED_MEMORY_SLOT_SIZE; ++i)
+    {
+      slot[i] = static_cast<uint8_t> (rank * SHARED_MEMORY_SLOT_SIZE + i);
+    }
+  SharedMemoryInterface::Allgather (slot, slots, SHARED_MEMORY_SLOT_SIZE);
+  for (uint32_t i = 0; i < 2 * SHARED_MEMORY_SLOT_SIZE; ++i)
+    {
+      if (slots[i] != static_cast<uint8_t> (i))
+        {
+          wrong++;
+        }
+    }
+  ranks.Check (wrong == 0);
+
+  uint32_t failures = ranks.Finish ();
+  NS_TEST_EXPECT_MSG_EQ (wrong, 0, "Rank 0 must gather every round");
+  NS_TEST_EXPECT_MSG_EQ (failures, 0, "Rank 1 must gather every round");
+}
+
+/**
+ * Runs the test cases of SharedMemoryInterface, forking two ranks on this host
+ */
+class SharedMemoryInterfaceTestSuite : public TestSuite
+{
+public:
+  SharedMemoryInterfaceTestSuite ();
+};
+
+SharedMemoryInterfaceTestSuite::SharedMemoryInterfaceTestSuite ()
+  : TestSuite ("mpi-shared-memory", UNIT)
+{
+  AddTestCase (new SharedMemoryRingWrapTestCase, TestCase::QUICK);
+  AddTestCase (new SharedMemoryAllgatherTestCase, TestCase::QUICK);
+}
+
+static SharedMemoryInterfaceTestSuite g_sharedMemoryInterfaceTestSuite; //!< The test suite
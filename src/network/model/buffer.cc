@@ -21,6 +21,8 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
+#include <pthread.h>
+
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
@@ -52,46 +54,264 @@ namespace ns3 {
 
 uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+/* The memory of Buffer::Data comes from size-classed pools.  Class c holds
+ * 64 << c bytes of data; larger buffers use the global allocator.  Blocks
+ * are carved from 64KB slabs and recycled through a free list per class and
+ * per thread, so allocations take no lock.  A thread keeps at most
+ * BUFFER_POOL_MAX_CACHED free blocks per class and moves batches beyond that
+ * to a shared depot, where the other threads find them before carving new
+ * slabs: this bounds the memory when packets are created by one thread and
+ * released by another, as the MPI and multithreaded engines do.  The caches
+ * of a thread go back to the depot when it exits.
+ *
+ * All the state is plain data initialized to zero, so the pools work before
+ * any constructor has run.  The slabs are released by the static destructor
+ * once no block is in use anymore; buffers released after that go straight
+ * to the global allocator.
+ */
+namespace {
+
+const uint32_t BUFFER_POOL_MIN_SHIFT = 6;
+const uint32_t BUFFER_POOL_CLASSES = 8;
+const uint32_t BUFFER_POOL_MAX_SIZE = 1 << (BUFFER_POOL_MIN_SHIFT + BUFFER_POOL_CLASSES - 1);
+const uint32_t BUFFER_POOL_SLAB_SIZE = 65536;
+// room left in front of the blocks of a slab to chain the slabs
+const uint32_t BUFFER_POOL_SLAB_HEADER = 16;
+// blocks moved at once between a thread and the depot
+const uint32_t BUFFER_POOL_BATCH = 32;
+const uint32_t BUFFER_POOL_MAX_CACHED = 4 * BUFFER_POOL_BATCH;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+struct FreeList
+{
+  FreeBlock *head;
+  uint32_t size;
+};
+
+struct BufferPoolCache
+{
+  FreeList lists[BUFFER_POOL_CLASSES];
+  // the blocks at the bottom of a list which were never used
+  uint32_t fresh[BUFFER_POOL_CLASSES];
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t large;
+  uint64_t frees;
+  BufferPoolCache *next;
+};
+
+struct BufferPoolCounters
+{
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t large;
+  uint64_t frees;
+};
+
+enum BufferPoolState
+{
+  BUFFER_POOL_ACTIVE = 0,
+  BUFFER_POOL_DESTROYED
+};
+
+// the depot, the slabs, the registry of caches and the counters of the
+// threads which exited are guarded by the lock
+volatile int g_bufferPoolLock = 0;
+FreeList g_bufferPoolDepot[BUFFER_POOL_CLASSES];
+uint8_t *g_bufferPoolSlabs = 0;
+BufferPoolCache *g_bufferPoolCaches = 0;
+BufferPoolCounters g_bufferPoolExited;
+BufferPoolState g_bufferPoolState = BUFFER_POOL_ACTIVE;
+pthread_once_t g_bufferPoolOnce = PTHREAD_ONCE_INIT;
+pthread_key_t g_bufferPoolKey;
+bool g_bufferPoolKeyCreated = false;
+__thread BufferPoolCache *g_bufferPoolCache = 0;
+
+void
+LockBufferPool (void)
+{
+  while (__sync_lock_test_and_set (&g_bufferPoolLock, 1))
+    {
+    }
+}
+
+void
+UnlockBufferPool (void)
+{
+  __sync_lock_release (&g_bufferPoolLock);
+}
+
+uint32_t
+GetBufferPoolClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while ((1U << (BUFFER_POOL_MIN_SHIFT + sizeClass)) < size)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+/**
+ * Move up to count blocks from the top of a list to the depot, the lock must be held
+ */
+void
+FlushBufferPoolList (FreeList &list, uint32_t sizeClass, uint32_t count)
+{
+  FreeList &depot = g_bufferPoolDepot[sizeClass];
+  while (count > 0 && list.head != 0)
+    {
+      FreeBlock *block = list.head;
+      list.head = block->next;
+      list.size--;
+      block->next = depot.head;
+      depot.head = block;
+      depot.size++;
+      count--;
+    }
+}
+
+void
+ReleaseBufferPoolCache (void *p)
+{
+  BufferPoolCache *cache = static_cast<BufferPoolCache *> (p);
+  LockBufferPool ();
+  for (uint32_t i = 0; i < BUFFER_POOL_CLASSES; ++i)
+    {
+      FlushBufferPoolList (cache->lists[i], i, cache->lists[i].size);
+    }
+  for (BufferPoolCache **i = &g_bufferPoolCaches; *i != 0; i = &(*i)->next)
+    {
+      if (*i == cache)
+        {
+          *i = cache->next;
+          break;
+        }
+    }
+  g_bufferPoolExited.hits += cache->hits;
+  g_bufferPoolExited.misses += cache->misses;
+  g_bufferPoolExited.large += cache->large;
+  g_bufferPoolExited.frees += cache->frees;
+  UnlockBufferPool ();
+  g_bufferPoolCache = 0;
+  delete cache;
+}
+
+void
+CreateBufferPoolKey (void)
+{
+  pthread_key_create (&g_bufferPoolKey, &ReleaseBufferPoolCache);
+  g_bufferPoolKeyCreated = true;
+}
+
+BufferPoolCache *
+GetBufferPoolCache (void)
+{
+  BufferPoolCache *cache = g_bufferPoolCache;
+  if (cache == 0)
+    {
+      cache = new BufferPoolCache ();
+      pthread_once (&g_bufferPoolOnce, &CreateBufferPoolKey);
+      pthread_setspecific (g_bufferPoolKey, cache);
+      LockBufferPool ();
+      cache->next = g_bufferPoolCaches;
+      g_bufferPoolCaches = cache;
+      UnlockBufferPool ();
+      g_bufferPoolCache = cache;
+    }
+  return cache;
+}
+
+/**
+ * Fill the empty list of a class with a batch from the depot, or with a new slab
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+void
+RefillBufferPoolList (BufferPoolCache *cache, uint32_t sizeClass, uint32_t blockSize)
+{
+  FreeList &list = cache->lists[sizeClass];
+  FreeList &depot = g_bufferPoolDepot[sizeClass];
+  NS_ASSERT (list.head == 0);
+  LockBufferPool ();
+  if (depot.head != 0)
+    {
+      while (list.size < BUFFER_POOL_BATCH && depot.head != 0)
+        {
+          FreeBlock *block = depot.head;
+          depot.head = block->next;
+          depot.size--;
+          block->next = list.head;
+          list.head = block;
+          list.size++;
+        }
+      UnlockBufferPool ();
+      cache->fresh[sizeClass] = 0;
+      return;
+    }
+  UnlockBufferPool ();
+
+  uint32_t blocks = std::max<uint32_t> (1, (BUFFER_POOL_SLAB_SIZE - BUFFER_POOL_SLAB_HEADER) / blockSize);
+  uint8_t *slab = new uint8_t [BUFFER_POOL_SLAB_HEADER + blocks * blockSize];
+  for (uint32_t i = blocks; i > 0; --i)
+    {
+      FreeBlock *block = reinterpret_cast<FreeBlock *> (slab + BUFFER_POOL_SLAB_HEADER + (i - 1) * blockSize);
+      block->next = list.head;
+      list.head = block;
+    }
+  list.size = blocks;
+  cache->fresh[sizeClass] = blocks;
+
+  LockBufferPool ();
+  *reinterpret_cast<uint8_t **> (slab) = g_bufferPoolSlabs;
+  g_bufferPoolSlabs = slab;
+  UnlockBufferPool ();
+}
+
+} // anonymous namespace
+
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  LockBufferPool ();
+  uint64_t allocated = g_bufferPoolExited.hits + g_bufferPoolExited.misses;
+  uint64_t freed = g_bufferPoolExited.frees;
+  for (BufferPoolCache *i = g_bufferPoolCaches; i != 0; i = i->next)
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      allocated += i->hits + i->misses;
+      freed += i->frees;
+    }
+  if (allocated != freed)
+    {
+      // blocks of the slabs are still in use
+      UnlockBufferPool ();
+      return;
+    }
+  while (g_bufferPoolSlabs != 0)
+    {
+      uint8_t *slab = g_bufferPoolSlabs;
+      g_bufferPoolSlabs = *reinterpret_cast<uint8_t **> (slab);
+      delete [] slab;
+    }
+  // threads exiting from now on must not release the caches deleted below
+  if (g_bufferPoolKeyCreated)
+    {
+      pthread_key_delete (g_bufferPoolKey);
+      g_bufferPoolKeyCreated = false;
+    }
+  while (g_bufferPoolCaches != 0)
+    {
+      BufferPoolCache *cache = g_bufferPoolCaches;
+      g_bufferPoolCaches = cache->next;
+      delete cache;
     }
+  g_bufferPoolCache = 0;
+  g_bufferPoolState = BUFFER_POOL_DESTROYED;
+  UnlockBufferPool ();
 }
 
 void
@@ -99,19 +319,26 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (data->m_size > BUFFER_POOL_MAX_SIZE
+      || g_bufferPoolState == BUFFER_POOL_DESTROYED)
     {
       Buffer::Deallocate (data);
+      return;
     }
-  else
+  BufferPoolCache *cache = GetBufferPoolCache ();
+  uint32_t sizeClass = GetBufferPoolClass (data->m_size);
+  FreeList &list = cache->lists[sizeClass];
+  FreeBlock *block = reinterpret_cast<FreeBlock *> (data);
+  block->next = list.head;
+  list.head = block;
+  list.size++;
+  cache->frees++;
+  if (list.size > BUFFER_POOL_MAX_CACHED)
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      LockBufferPool ();
+      FlushBufferPoolList (list, sizeClass, BUFFER_POOL_BATCH);
+      UnlockBufferPool ();
+      cache->fresh[sizeClass] = std::min (cache->fresh[sizeClass], list.size);
     }
 }
 
@@ -119,29 +346,68 @@ Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
+  if (dataSize > BUFFER_POOL_MAX_SIZE
+      || g_bufferPoolState == BUFFER_POOL_DESTROYED)
     {
-      while (!g_freeList->empty ()) 
+      if (g_bufferPoolState != BUFFER_POOL_DESTROYED)
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
+          GetBufferPoolCache ()->large++;
         }
+      return Buffer::Allocate (dataSize);
+    }
+  BufferPoolCache *cache = GetBufferPoolCache ();
+  uint32_t sizeClass = GetBufferPoolClass (dataSize);
+  uint32_t capacity = 1U << (BUFFER_POOL_MIN_SHIFT + sizeClass);
+  FreeList &list = cache->lists[sizeClass];
+  if (list.head == 0)
+    {
+      // blocks are rounded to 16 bytes to keep the free list links aligned
+      RefillBufferPoolList (cache, sizeClass,
+                            (sizeof (struct Buffer::Data) - 1 + capacity + 15) & ~15U);
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
+  FreeBlock *block = list.head;
+  list.head = block->next;
+  list.size--;
+  if (list.size < cache->fresh[sizeClass])
+    {
+      cache->fresh[sizeClass]--;
+      cache->misses++;
+    }
+  else
+    {
+      cache->hits++;
+    }
+  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (block);
+  data->m_size = capacity;
+  data->m_count = 1;
   return data;
 }
+
+uint64_t
+Buffer::GetPoolHits (void)
+{
+  LockBufferPool ();
+  uint64_t hits = g_bufferPoolExited.hits;
+  for (BufferPoolCache *i = g_bufferPoolCaches; i != 0; i = i->next)
+    {
+      hits += i->hits;
+    }
+  UnlockBufferPool ();
+  return hits;
+}
+
+uint64_t
+Buffer::GetPoolMisses (void)
+{
+  LockBufferPool ();
+  uint64_t misses = g_bufferPoolExited.misses + g_bufferPoolExited.large;
+  for (BufferPoolCache *i = g_bufferPoolCaches; i != 0; i = i->next)
+    {
+      misses += i->misses + i->large;
+    }
+  UnlockBufferPool ();
+  return misses;
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +423,18 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+uint64_t
+Buffer::GetPoolHits (void)
+{
+  return 0;
+}
+
+uint64_t
+Buffer::GetPoolMisses (void)
+{
+  return 0;
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -244,7 +522,13 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  // leave room for the headers packets usually get, so that AddAtStart
+  // does not have to regrow the data of every new packet
+#ifdef BUFFER_FREE_LIST
+  m_data = Buffer::Create (std::min (g_recommendedStart, BUFFER_POOL_MAX_SIZE));
+#else
+  m_data = Buffer::Create (g_recommendedStart);
+#endif
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
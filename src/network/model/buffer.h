@@ -38,9 +38,13 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by leaving room in front of new Buffers for the largest
+ * headers ever added, which is learned at runtime.
+ *
+ * The underlying data is allocated from pools of size classes
+ * (powers of two from 64 to 8192 bytes), carved from slabs and
+ * recycled through per-thread free lists; see GetPoolHits and
+ * GetPoolMisses.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -657,6 +661,18 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \returns the number of buffer data allocations, by all threads,
+   * served by a recycled block of the pools
+   */
+  static uint64_t GetPoolHits (void);
+  /**
+   * \returns the number of buffer data allocations, by all threads,
+   * which needed new memory: a block of a new slab, or a data too
+   * large for the pools
+   */
+  static uint64_t GetPoolMisses (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -798,15 +814,11 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
+  /// Local static destructor structure, releases the slabs of the pools
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
@@ -58,6 +58,10 @@ public:
   ~ByteTagListDataFreeList ();
 } g_freeList; //!< Container for struct ByteTagListData
 static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+/* Guards g_freeList and g_maxSize against threads allocating concurrently */
+static volatile int g_freeListLock = 0;
+#define LOCK_FREE_LIST() while (__sync_lock_test_and_set (&g_freeListLock, 1)) {}
+#define UNLOCK_FREE_LIST() __sync_lock_release (&g_freeListLock)
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -358,6 +362,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
+  LOCK_FREE_LIST ();
   while (!g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
@@ -365,6 +370,7 @@ ByteTagList::Allocate (uint32_t size)
       NS_ASSERT (data != 0);
       if (data->size >= size)
         {
+          UNLOCK_FREE_LIST ();
           data->count = 1;
           data->dirty = 0;
           return data;
@@ -372,7 +378,9 @@ ByteTagList::Allocate (uint32_t size)
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint32_t maxSize = g_maxSize;
+  UNLOCK_FREE_LIST ();
+  uint8_t *buffer = new uint8_t [std::max (size, maxSize) + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
   data->size = size;
@@ -388,21 +396,22 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
   data->count--;
+  LOCK_FREE_LIST ();
+  g_maxSize = std::max (g_maxSize, data->size);
   if (data->count == 0)
     {
       if (g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
+          UNLOCK_FREE_LIST ();
           uint8_t *buffer = (uint8_t *)data;
           delete [] buffer;
+          return;
         }
-      else
-        {
-          g_freeList.push_back (data);
-        }
+      g_freeList.push_back (data);
     }
+  UNLOCK_FREE_LIST ();
 }
 
 #else /* USE_FREE_LIST */
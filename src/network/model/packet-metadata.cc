@@ -37,6 +37,11 @@ bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
 PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+/* Guards m_freeList and m_maxSize, packets are also created by the worker
+ * threads of MultithreadedSimulatorImpl. */
+static volatile int g_freeListLock = 0;
+#define LOCK_FREE_LIST() while (__sync_lock_test_and_set (&g_freeListLock, 1)) {}
+#define UNLOCK_FREE_LIST() __sync_lock_release (&g_freeListLock)
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -572,6 +577,7 @@ PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
   NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
+  LOCK_FREE_LIST ();
   if (size > m_maxSize)
     {
       m_maxSize = size;
@@ -582,6 +588,7 @@ PacketMetadata::Create (uint32_t size)
       m_freeList.pop_back ();
       if (data->m_size >= size) 
         {
+          UNLOCK_FREE_LIST ();
           NS_LOG_LOGIC ("create found size="<<data->m_size);
           data->m_count = 1;
           return data;
@@ -589,8 +596,10 @@ PacketMetadata::Create (uint32_t size)
       PacketMetadata::Deallocate (data);
       NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
     }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  uint32_t maxSize = m_maxSize;
+  UNLOCK_FREE_LIST ();
+  NS_LOG_LOGIC ("create alloc size="<<maxSize);
+  return PacketMetadata::Allocate (maxSize);
 }
 
 void
@@ -602,16 +611,19 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
       PacketMetadata::Deallocate (data);
       return;
     } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
+  LOCK_FREE_LIST ();
+  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   if (m_freeList.size () > 1000 ||
       data->m_size < m_maxSize) 
     {
+      UNLOCK_FREE_LIST ();
       PacketMetadata::Deallocate (data);
     } 
   else 
     {
       m_freeList.push_back (data);
+      UNLOCK_FREE_LIST ();
     }
 }
 
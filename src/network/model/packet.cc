@@ -29,6 +29,7 @@ NS_LOG_COMPONENT_DEFINE ("Packet");
 namespace ns3 {
 
 uint32_t Packet::m_globalUid = 0;
+__thread uint64_t *Packet::m_uidCounter = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -137,10 +138,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -179,10 +179,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +204,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -562,6 +560,23 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::SetUidCounter (uint64_t *counter)
+{
+  m_uidCounter = counter;
+}
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  if (m_uidCounter != 0)
+    {
+      // the owner of the counter keeps it apart from the global uids
+      return (*m_uidCounter)++;
+    }
+  return static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | __sync_fetch_and_add (&m_globalUid, 1);
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
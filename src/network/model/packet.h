@@ -503,6 +503,17 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Makes the packets created by the calling thread take their uid
+   * from a counter of its own.
+   *
+   * The multithreaded simulator gives every partition a counter, so the
+   * uids do not depend on the order the threads create packets in.
+   *
+   * \param counter the next uid to give, incremented on every packet, or
+   * 0 to go back to the global counter
+   */
+  static void SetUidCounter (uint64_t *counter);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -671,6 +682,12 @@ private:
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  /**
+   * \brief Allocates the uid of a new packet.
+   * \returns the uid
+   */
+  static uint64_t AllocateUid (void);
+
   Buffer m_buffer;                //!< the packet buffer (it's actual contents)
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
@@ -680,6 +697,7 @@ private:
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static __thread uint64_t *m_uidCounter; //!< Counter of the calling thread, 0 for the global one
 };
 
 /**
@@ -323,6 +323,66 @@ BufferTest::DoRun (void)
   free (cBuf);
 }
 //-----------------------------------------------------------------------------
+class BufferPoolTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferPoolTest ();
+};
+
+BufferPoolTest::BufferPoolTest ()
+  : TestCase ("Buffer data pools") {
+}
+
+void
+BufferPoolTest::DoRun (void)
+{
+  // sizes of every class, on and around their bounds, and one too large
+  uint32_t sizes[] = { 1, 64, 65, 200, 1500, 4096, 8192, 9000 };
+  uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+
+  // the layout of new buffers adapts during the first rounds, so the pools
+  // take a few rounds to hold all the data one round needs; after that only
+  // the three data larger than the pools miss
+  uint64_t roundMisses = 0;
+  uint32_t round = 0;
+  for (; round < 20 && roundMisses != 3; round++)
+    {
+      uint64_t hits = Buffer::GetPoolHits ();
+      uint64_t misses = Buffer::GetPoolMisses ();
+      std::vector<Buffer> buffers;
+      for (uint32_t j = 0; j < nSizes; j++)
+        {
+          Buffer buffer;
+          buffer.AddAtStart (sizes[j]);
+          Buffer::Iterator i = buffer.Begin ();
+          for (uint32_t k = 0; k < sizes[j]; k++)
+            {
+              i.WriteU8 (static_cast<uint8_t> (k + j));
+            }
+          // grow the data past its class
+          buffer.AddAtEnd (sizes[j]);
+          buffers.push_back (buffer);
+        }
+      for (uint32_t j = 0; j < nSizes; j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (buffers[j].GetSize (), 2 * sizes[j], "Bad buffer size");
+          Buffer::Iterator i = buffers[j].Begin ();
+          for (uint32_t k = 0; k < sizes[j]; k++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (i.ReadU8 (), static_cast<uint8_t> (k + j), "Bad buffer content");
+            }
+        }
+      NS_TEST_ASSERT_MSG_GT (Buffer::GetPoolHits () + Buffer::GetPoolMisses (), hits + misses,
+                             "Allocations not counted");
+      if (round > 0)
+        {
+          NS_TEST_ASSERT_MSG_GT (Buffer::GetPoolHits (), hits, "Pool not reused");
+        }
+      roundMisses = Buffer::GetPoolMisses () - misses;
+    }
+  NS_TEST_ASSERT_MSG_EQ (roundMisses, 3, "Released data not reused");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -333,6 +393,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferPoolTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
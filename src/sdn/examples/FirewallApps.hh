@@ -57,45 +57,28 @@ public:
           }
       }
     
-    virtual void event_callback(ControllerEvent* ev) {
-        uint8_t ofversion = ev->ofconn->get_version();
+    /* The blacklist is only read once built, so the check runs on the worker threads too */
+    virtual void event_work(ControllerEvent* ev) {
+        MultiLearningSwitch::event_work(ev);
+        PacketInWork* work = (PacketInWork*) ev->work_data;
+        if (work != NULL && work->valid) {
+            work->drop = blacklist.find(std::make_pair(work->src, work->dst)) != blacklist.end();
+        }
+    }
 
+    virtual void event_callback(ControllerEvent* ev) {
         if (ev->get_type() == EVENT_PACKET_IN) {
-            L2TABLE* l2table = get_l2table(ev->ofconn);
-            if (l2table == NULL) {
-                return;
-            }
-            uint64_t dst = 0, src = 0;
-            uint16_t ethType = 0;
-            PacketInEvent* pi = static_cast<PacketInEvent*>(ev);
-            void* ofpip = NULL;
-            if (ofversion == fluid_msg::of10::OFP_VERSION) {
-                fluid_msg::of10::PacketIn *ofpi = new fluid_msg::of10::PacketIn();
-                ofpip = ofpi;
-                ofpi->unpack(pi->data);
-                //data = (uint8_t*) ofpi->data();
-                memcpy(((uint8_t*)&dst + 2), (uint8_t*) ofpi->data(), 6);
-                memcpy(((uint8_t*)&src + 2), (uint8_t*) ofpi->data() + 6, 6);
-                memcpy(((uint8_t*)&ethType), (uint8_t*) ofpi->data() + 12, 2);
-            }
-            else if (ofversion == fluid_msg::of13::OFP_VERSION) {
-                fluid_msg::of13::PacketIn *ofpi = new fluid_msg::of13::PacketIn();
-                ofpip = ofpi;
-                ofpi->unpack(pi->data);
-                //data = (uint8_t*) ofpi->data();
-                memcpy(((uint8_t*) &dst + 2), (uint8_t*) ofpi->data(), 6);
-                memcpy(((uint8_t*) &src + 2), (uint8_t*) ofpi->data() + 6, 6);
-                if (ofpi->match().in_port() == NULL) {
-                    return;
+            PacketInWork* work = get_work(ev);
+            if (work->drop) {
+                //Make a pathway with no action so we'll drop the packet
+                if (work->ofpi10 != NULL) {
+                    install_flow_mod_no_action10(*work->ofpi10, ev->ofconn, work->src, work->dst);
                 }
-            }
-            //Check the firewall
-            PathwaySet::iterator packetInPathway = blacklist.find(std::make_pair(src, dst));
-            if(packetInPathway != blacklist.end())
-            {
-              install_flow_mod_no_action10(*((fluid_msg::of10::PacketIn*) ofpip), ev->ofconn, src, dst);
-              //Make a pathway with no action so we'll drop the packet
-              return;
+                else {
+                    install_flow_mod_no_action13(*work->ofpi13, ev->ofconn, work->src, work->dst);
+                }
+                release_work(ev);
+                return;
             }
         }
         MultiLearningSwitch::event_callback(ev);
@@ -124,6 +107,29 @@ public:
         ofconn->send(buffer, fm.length());
         fluid_msg::OFMsg::free_buffer(buffer);
     }
+
+    void install_flow_mod_no_action13(fluid_msg::of13::PacketIn &pi, Ptr<SdnConnection> ofconn, uint64_t src, uint64_t dst) {
+        fluid_msg::of13::FlowMod fm;
+        fm.xid(pi.xid());
+        fm.cookie(123);
+        fm.cookie_mask(0xffffffffffffffff);
+        fm.table_id(0);
+        fm.command(fluid_msg::of13::OFPFC_ADD);
+        fm.idle_timeout(50);
+        fm.hard_timeout(100);
+        fm.priority(100);
+        fm.buffer_id(pi.buffer_id());
+        fm.out_port(0);
+        fm.out_group(0);
+        fm.flags(0);
+        fluid_msg::of13::EthSrc fsrc(((uint8_t*) &src) + 2);
+        fluid_msg::of13::EthDst fdst(((uint8_t*) &dst) + 2);
+        fm.add_oxm_field(fsrc);
+        fm.add_oxm_field(fdst);
+        uint8_t* buffer = fm.pack();
+        ofconn->send(buffer, fm.length());
+        fluid_msg::OFMsg::free_buffer(buffer);
+    }
 };
 
 #endif
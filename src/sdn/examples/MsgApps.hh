@@ -8,71 +8,106 @@
 
 using namespace ns3;
 
+/**
+ * The decoded PacketIn event_work leaves in work_data
+ */
+struct PacketInWork {
+    PacketInWork() : ofpi10(NULL), ofpi13(NULL), src(0), dst(0), in_port(0), valid(false), drop(false) { }
+    ~PacketInWork() {
+        delete ofpi10;
+        delete ofpi13;
+    }
+    fluid_msg::of10::PacketIn *ofpi10; //Set on OpenFlow 1.0 connections
+    fluid_msg::of13::PacketIn *ofpi13; //Set on OpenFlow 1.3 connections
+    uint64_t src;
+    uint64_t dst;
+    uint32_t in_port;
+    bool valid; //False if the PacketIn carries no in_port
+    bool drop;  //Set by subclasses to drop the flow instead of learning it
+};
+
 class MultiLearningSwitch: public BaseLearningSwitch {
 public:
+    /* Decoding the PacketIn only reads the event, so it runs on the worker threads */
+    virtual void event_work(ControllerEvent* ev) {
+        if (ev->get_type() != EVENT_PACKET_IN) {
+            return;
+        }
+        uint8_t ofversion = ev->ofconn->get_version();
+        PacketInEvent* pi = static_cast<PacketInEvent*>(ev);
+        PacketInWork* work = new PacketInWork();
+        if (ofversion == fluid_msg::of10::OFP_VERSION) {
+            work->ofpi10 = new fluid_msg::of10::PacketIn();
+            work->ofpi10->unpack(pi->data);
+            memcpy(((uint8_t*) &work->dst + 2), (uint8_t*) work->ofpi10->data(), 6);
+            memcpy(((uint8_t*) &work->src + 2), (uint8_t*) work->ofpi10->data() + 6, 6);
+            work->in_port = work->ofpi10->in_port();
+            work->valid = true;
+        }
+        else if (ofversion == fluid_msg::of13::OFP_VERSION) {
+            work->ofpi13 = new fluid_msg::of13::PacketIn();
+            work->ofpi13->unpack(pi->data);
+            memcpy(((uint8_t*) &work->dst + 2), (uint8_t*) work->ofpi13->data(), 6);
+            memcpy(((uint8_t*) &work->src + 2), (uint8_t*) work->ofpi13->data() + 6, 6);
+            if (work->ofpi13->match().in_port() != NULL) {
+                work->in_port = work->ofpi13->match().in_port()->value();
+                work->valid = true;
+            }
+        }
+        ev->work_data = work;
+    }
+
+    /* The work of a PacketIn, done inline if event_work did not run */
+    PacketInWork* get_work(ControllerEvent* ev) {
+        if (ev->work_data == NULL) {
+            event_work(ev);
+        }
+        return (PacketInWork*) ev->work_data;
+    }
+
+    /* Frees the work of an event handled without passing it on */
+    void release_work(ControllerEvent* ev) {
+        delete (PacketInWork*) ev->work_data;
+        ev->work_data = NULL;
+    }
+
     virtual void event_callback(ControllerEvent* ev) {
         uint8_t ofversion = ev->ofconn->get_version();
 
         if (ev->get_type() == EVENT_PACKET_IN) {
-            L2TABLE* l2table = get_l2table(ev->ofconn);
-            if (l2table == NULL) {
+            PacketInWork* work = get_work(ev);
+            ev->work_data = NULL;
+            SdnL2Table* l2table = get_l2table(ev->ofconn);
+            if (l2table == NULL || !work->valid) {
+                delete work;
                 return;
             }
-            uint64_t dst = 0, src = 0;
-            uint16_t ethType = 0;
-            PacketInEvent* pi = static_cast<PacketInEvent*>(ev);
-
-            void* ofpip = NULL;
-            uint16_t in_port = fluid_msg::of10::OFPP_NONE;
-            if (ofversion == fluid_msg::of10::OFP_VERSION) {
-                fluid_msg::of10::PacketIn *ofpi = new fluid_msg::of10::PacketIn();
-                ofpip = ofpi;
-                ofpi->unpack(pi->data);
-                memcpy(((uint8_t*) &dst + 2), (uint8_t*) ofpi->data(), 6);
-                memcpy(((uint8_t*) &src + 2), (uint8_t*) ofpi->data() + 6, 6);
-                memcpy(((uint8_t*)&ethType), (uint8_t*) ofpi->data() + 12, 2);
-                in_port = ofpi->in_port();
-            }
-            else if (ofversion == fluid_msg::of13::OFP_VERSION) {
-                fluid_msg::of13::PacketIn *ofpi = new fluid_msg::of13::PacketIn();
-                ;
-                ofpip = ofpi;
-                ofpi->unpack(pi->data);
-                memcpy(((uint8_t*) &dst + 2), (uint8_t*) ofpi->data(), 6);
-                memcpy(((uint8_t*) &src + 2), (uint8_t*) ofpi->data() + 6, 6);
-                if (ofpi->match().in_port() == NULL) {
-                    return;
-                }
-                in_port = ofpi->match().in_port()->value();
-            }
 
             // Learn the source
-            (*l2table)[src] = in_port;
+            l2table->Learn(work->src, work->in_port);
 
             // Try to find the destination
-            L2TABLE::iterator it = l2table->find(dst);
-            if (it == l2table->end()) {
+            uint32_t out_port;
+            if (!l2table->Lookup(work->dst, out_port)) {
                 if (ofversion == fluid_msg::of10::OFP_VERSION) {
-                    flood10(*((fluid_msg::of10::PacketIn*) ofpip), ev->ofconn);
-                    delete (fluid_msg::of10::PacketIn*) ofpip;
+                    flood10(*work->ofpi10, ev->ofconn);
                 }
                 else if (ofversion == fluid_msg::of13::OFP_VERSION) {
-                    flood13(*((fluid_msg::of13::PacketIn*) ofpip), ev->ofconn, in_port);
-                    delete (fluid_msg::of13::PacketIn*) ofpip;
+                    flood13(*work->ofpi13, ev->ofconn, work->in_port);
                 }
+                delete work;
                 return;
             }
 
             if (ofversion == fluid_msg::of10::OFP_VERSION) {
-                install_flow_mod10(*((fluid_msg::of10::PacketIn*) ofpip), ev->ofconn, src,
-                    dst, it->second);
-                delete (fluid_msg::of10::PacketIn*) ofpip;
+                install_flow_mod10(*work->ofpi10, ev->ofconn, work->src,
+                    work->dst, out_port);
             }
             else if (ofversion == fluid_msg::of13::OFP_VERSION) {
-                install_flow_mod13(*((fluid_msg::of13::PacketIn*) ofpip), ev->ofconn, src,
-                    dst, it->second);
-                delete (fluid_msg::of13::PacketIn*) ofpip;
+                install_flow_mod13(*work->ofpi13, ev->ofconn, work->src,
+                    work->dst, out_port);
             }
+            delete work;
         }
         else if (ev->get_type() == EVENT_SWITCH_UP) {
             BaseLearningSwitch::event_callback(ev);
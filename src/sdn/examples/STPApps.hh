@@ -192,16 +192,15 @@ public:
 
         else if (ev->get_type() == EVENT_PACKET_IN) {
           STPSwitch* thisSwitch = findSTPSwitch(switches,ev->ofconn);
-          PacketInEvent* pi = static_cast<PacketInEvent*>(ev);
-          fluid_msg::of10::PacketIn *ofpi = new fluid_msg::of10::PacketIn();
-          uint64_t dst = 0, src = 0;
-          ofpi->unpack(pi->data);
-          memcpy(((uint8_t*) &dst + 2), (uint8_t*) ofpi->data(), 6);
+          //Decoded by event_work
+          PacketInWork* work = get_work(ev);
+          fluid_msg::of10::PacketIn *ofpi = work->ofpi10;
+          if(ofpi == NULL){
+            MultiLearningSwitch::event_callback(ev);
+            return;
+          }
+          uint64_t dst = work->dst;
           fluid_msg::EthAddress dstAddress ((uint8_t*)&dst + 2);
-          memcpy(((uint8_t*) &src + 2), (uint8_t*) ofpi->data() + 6, 6);
-          fluid_msg::EthAddress srcAddress ((uint8_t*)&src + 2);
-          uint16_t ethType = 0;
-          memcpy(((uint8_t*)&ethType), (uint8_t*) ofpi->data() + 12, 2);
           if(dstAddress == lldpAddress){ //If we received a discovery packet
             uint64_t dpid = 0; //Get the DPID src from the packet
             memcpy(&dpid, (uint8_t*) ofpi->data() + 14,sizeof(uint64_t));
@@ -233,6 +232,7 @@ public:
               }
               // Remove port from vector of host candidates for this particular connection              
             }
+            release_work(ev);
             return;
           }
           else if(thisSwitch && findlinkInTopology(thisSwitch,ofpi->in_port()) == currentTopology.end()) { //If not in topology
@@ -242,11 +242,14 @@ public:
               return;
               }
             //Is the source a switch we know about?
-            L2TABLE* knownhosts = get_l2table(ev->ofconn);
-            L2TABLE::iterator hostsIterator = get_l2table(ev->ofconn)->find(dst);
-            if(hostsIterator != knownhosts->end()){
+            SdnL2Table* knownhosts = get_l2table(ev->ofconn);
+            uint32_t hostPort;
+            if(knownhosts && knownhosts->Lookup(dst, hostPort)){
               MultiLearningSwitch::event_callback(ev);
             }
+            else{
+              release_work(ev);
+            }
             return;
           }
           //Else if it is in the topology, then we're ok
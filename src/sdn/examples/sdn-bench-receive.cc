@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* Network topology
+ *
+ *  l0---          c0          ---r0
+ *       \       /    \       /
+ *   .    \     /      \     /    .
+ *   .     s0----......----sn     .
+ *   .    /                  \    .
+ *       /                    \
+ *  ln---                      ---rn
+ *
+ * Every left host sends a constant rate UDP stream to the right host with the
+ * same index. The same simulation is run with the switches in regular and in
+ * fast receive mode, and the frames received by the switches are reported per
+ * wall clock second and per switch for both.
+ */
+#include <sys/time.h>
+
+#include "ns3/core-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/layer2-p2p-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/network-module.h"
+
+#include "ns3/SdnController.h"
+#include "ns3/SdnSwitch.h"
+#include "ns3/SdnSwitch13.h"
+#include "ns3/SdnListener.h"
+
+#include "MsgApps.hh"
+
+using namespace ns3;
+
+typedef struct timeval TIMER_TYPE;
+#define TIMER_NOW(_t) gettimeofday (&_t,NULL);
+#define TIMER_SECONDS(_t) ((double)(_t).tv_sec + (_t).tv_usec * 1e-6)
+#define TIMER_DIFF(_t1, _t2) (TIMER_SECONDS (_t1) - TIMER_SECONDS (_t2))
+
+NS_LOG_COMPONENT_DEFINE ("sdn-bench-receive");
+
+static uint64_t g_switchFrames = 0; //!< Frames received by the switch ports
+
+static void
+CountSwitchFrame (Ptr<const Packet> packet)
+{
+  g_switchFrames++;
+}
+
+/**
+ * Builds the topology, runs it and reports the receive rate of the switches
+ * \param fastReceive Whether the switches use the fast receive path
+ */
+static void
+RunBenchmark (bool fastReceive, bool of13, uint32_t numSwitches, uint32_t numHosts,
+              std::string rate, uint32_t packetSize, double stopTime)
+{
+  g_switchFrames = 0;
+  Config::SetDefault ("ns3::SdnSwitch::FastReceive", BooleanValue (fastReceive));
+  Config::SetDefault ("ns3::SdnSwitch13::FastReceive", BooleanValue (fastReceive));
+
+  NodeContainer controllerNodes, switchNodes, leftNodes, rightNodes;
+  controllerNodes.Create (1);
+  switchNodes.Create (numSwitches);
+  leftNodes.Create (numHosts);
+  rightNodes.Create (numHosts);
+
+  Layer2P2PHelper layer2P2P;
+  layer2P2P.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  layer2P2P.SetChannelAttribute ("Delay", StringValue ("10us"));
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  NetDeviceContainer hostDevices, switchDevices, controllerDevices;
+  std::vector<NetDeviceContainer> leftLinks, rightLinks, controllerLinks;
+  for (uint32_t i = 0; i < numHosts; ++i)
+    {
+      leftLinks.push_back (layer2P2P.Install (leftNodes.Get (i), switchNodes.Get (0)));
+      rightLinks.push_back (layer2P2P.Install (switchNodes.Get (numSwitches - 1), rightNodes.Get (i)));
+      switchDevices.Add (leftLinks.back ().Get (1));
+      switchDevices.Add (rightLinks.back ().Get (0));
+    }
+  for (uint32_t i = 1; i < numSwitches; ++i)
+    {
+      NetDeviceContainer link = layer2P2P.Install (switchNodes.Get (i - 1), switchNodes.Get (i));
+      switchDevices.Add (link);
+    }
+  for (uint32_t i = 0; i < numSwitches; ++i)
+    {
+      controllerLinks.push_back (pointToPoint.Install (switchNodes.Get (i), controllerNodes.Get (0)));
+    }
+  for (NetDeviceContainer::Iterator i = switchDevices.Begin (); i != switchDevices.End (); ++i)
+    {
+      (*i)->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&CountSwitchFrame));
+    }
+
+  InternetStackHelper internet;
+  internet.Install (controllerNodes);
+  internet.Install (switchNodes);
+  internet.Install (leftNodes);
+  internet.Install (rightNodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.0.0.0");
+  std::vector<Ipv4InterfaceContainer> rightAddresses;
+  for (uint32_t i = 0; i < numHosts; ++i)
+    {
+      ipv4.Assign (leftLinks[i]);
+      rightAddresses.push_back (ipv4.Assign (rightLinks[i]));
+    }
+  for (uint32_t i = 0; i < numSwitches; ++i)
+    {
+      std::ostringstream oss;
+      oss << "192." << i + 168 << ".0.0";
+      ipv4.SetBase (oss.str ().c_str (), "255.255.0.0");
+      ipv4.Assign (controllerLinks[i]);
+    }
+
+  uint16_t port = 50000;
+  for (uint32_t i = 0; i < numHosts; ++i)
+    {
+      OnOffHelper source ("ns3::UdpSocketFactory",
+                          InetSocketAddress (rightAddresses[i].GetAddress (1), port));
+      source.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+      source.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+      source.SetAttribute ("DataRate", StringValue (rate));
+      source.SetAttribute ("PacketSize", UintegerValue (packetSize));
+      ApplicationContainer sourceApp = source.Install (leftNodes.Get (i));
+      sourceApp.Start (Seconds (1.0 + numSwitches * 0.1));
+    }
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  sink.Install (rightNodes).Start (Seconds (0.0));
+
+  Ptr<SdnController> controller = CreateObject<SdnController> (CreateObject<MultiLearningSwitch> ());
+  controller->SetStartTime (Seconds (0.0));
+  controllerNodes.Get (0)->AddApplication (controller);
+  for (uint32_t i = 0; i < numSwitches; ++i)
+    {
+      Ptr<Application> sdnS;
+      if (of13)
+        {
+          sdnS = CreateObject<SdnSwitch13> ();
+        }
+      else
+        {
+          sdnS = CreateObject<SdnSwitch> ();
+        }
+      sdnS->SetStartTime (Seconds (i * 0.1));
+      switchNodes.Get (i)->AddApplication (sdnS);
+    }
+
+  TIMER_TYPE t0, t1;
+  Simulator::Stop (Seconds (stopTime));
+  TIMER_NOW (t0);
+  Simulator::Run ();
+  TIMER_NOW (t1);
+  Simulator::Destroy ();
+
+  double wall = TIMER_DIFF (t1, t0);
+  std::cout << (fastReceive ? "fast" : "regular") << "\t" << numSwitches << "\t"
+            << g_switchFrames << "\t" << wall << "\t"
+            << g_switchFrames / wall / numSwitches << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  bool of13 = false;
+  uint32_t numSwitches = 8;
+  uint32_t numHosts = 4;
+  uint32_t packetSize = 512;
+  std::string rate = "50Mbps";
+  double stopTime = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("of13", "Use OpenFlow 1.3 switches instead of OpenFlow 1.0 ones", of13);
+  cmd.AddValue ("numSwitches", "Number of switches in the chain", numSwitches);
+  cmd.AddValue ("numHosts", "Number of hosts on each end of the chain", numHosts);
+  cmd.AddValue ("rate", "Sending rate of each host", rate);
+  cmd.AddValue ("packetSize", "Size of the UDP payloads", packetSize);
+  cmd.AddValue ("stopTime", "Simulation time in seconds", stopTime);
+  cmd.Parse (argc, argv);
+
+  NS_ASSERT_MSG (numSwitches > 0, "At least one switch is needed.");
+
+  std::cout << "MODE\tSWITCHES\tFRAMES\tWALL\tPPS_PER_SWITCH" << std::endl;
+  RunBenchmark (false, of13, numSwitches, numHosts, rate, packetSize, stopTime);
+  RunBenchmark (true, of13, numSwitches, numHosts, rate, packetSize, stopTime);
+  return 0;
+}
@@ -41,6 +41,7 @@
 #include "ns3/SdnController.h"
 #include "ns3/SdnSwitch.h"
 #include "ns3/SdnListener.h"
+#include "ns3/sdn-partition-helper.h"
 
 #include "MsgApps.hh"
 #include "FirewallApps.hh"
@@ -88,6 +89,7 @@ main (int argc, char *argv[])
   uint32_t numHosts    = 1;
   uint32_t numSwitches = 2;
   bool nullmsg = false;
+  bool partition = false;
 
   std::ostringstream oss;
 
@@ -104,6 +106,7 @@ main (int argc, char *argv[])
 //  cmd.AddValue ("numSwitches", "Number of switches", numSwitches);
   cmd.AddValue ("numHosts", "Number of hosts per end switch", numHosts);
   cmd.AddValue ("nullmsg", "Enable the use of null-message synchronization", nullmsg);
+  cmd.AddValue ("partition", "Assign the nodes to the logical processors with SdnPartitionHelper", partition);
 
   cmd.Parse (argc,argv);
 
@@ -147,8 +150,8 @@ main (int argc, char *argv[])
   uint32_t systemCount = MpiInterface::GetSize ();
 
   // Check for valid distributed parameters.
-  // Must have 3 and only 3 Logical Processors (LPs)
-  if (systemCount != 3)
+  // Must have 3 and only 3 Logical Processors (LPs), unless partitioned automatically
+  if (!partition && systemCount != 3)
     {
       std::cout << "This simulation requires 3 and only 3 logical processors." << std::endl;
       return 1;
@@ -165,6 +168,31 @@ main (int argc, char *argv[])
     }
   rightNodes.Create (numHosts, 1);
 
+  if (partition)
+    {
+      NS_LOG_INFO ("Partition nodes.");
+      SdnPartitionHelper partitioner;
+      for (uint32_t j = 0; j < numHosts; ++j)
+        {
+          partitioner.AddLink (leftNodes.Get (j), switchNodes.Get (0), MilliSeconds (5));
+          partitioner.AddLink (switchNodes.Get (numSwitches-1), rightNodes.Get (j), MilliSeconds (5));
+        }
+      for (uint32_t j = 1; j < numSwitches; ++j)
+        {
+          partitioner.AddLink (switchNodes.Get (j-1), switchNodes.Get (j), MilliSeconds (5));
+        }
+      for (uint32_t j = 0; j < numSwitches; ++j)
+        {
+          partitioner.AddControlLink (switchNodes.Get (j), controllerNode.Get (0), MilliSeconds (5));
+        }
+      partitioner.Partition (NodeContainer (NodeContainer (controllerNode, leftNodes), switchNodes, rightNodes),
+                             systemCount);
+      if (systemId == 0)
+        {
+          partitioner.Print (std::cout);
+        }
+    }
+
   NS_LOG_INFO ("Create channels.");
   Layer2P2PHelper layer2P2P;
   layer2P2P.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
@@ -309,7 +337,7 @@ main (int argc, char *argv[])
 	  // Set the amount of data to send in bytes.  Zero is unlimited.
 	  source.SetAttribute ("MaxBytes", UintegerValue (maxBytes));
 
-	  if (systemId == 0)
+	  if (leftNodes.Get (i)->GetSystemId () == systemId)
 	    {
 	      sourceApp = source.Install (leftNodes.Get (i));
 	      sourceApp.Start (Seconds (randTime->GetValue()));
@@ -333,7 +361,7 @@ main (int argc, char *argv[])
 	      source2.SetAttribute ("Count", UintegerValue (1));
 
 	      ApplicationContainer sourceAppL2R;
-	      if (systemId == 0)
+	      if (leftNodes.Get (i)->GetSystemId () == systemId)
 	        {
 		  sourceAppL2R = source1.Install (leftNodes.Get (i));
 		  if ((i == 0) && (j == 0))
@@ -350,7 +378,7 @@ main (int argc, char *argv[])
 	      ApplicationContainer sourceAppL2L;
 	      if (i != j)
 		{
-		  if (systemId == 0)
+		  if (leftNodes.Get (i)->GetSystemId () == systemId)
 		    {
 		      sourceAppL2L = source2.Install (leftNodes.Get (i));
 		      sourceAppL2L.Start (Seconds (REALLY_BIG_TIME));
@@ -359,7 +387,7 @@ main (int argc, char *argv[])
 		}
 
 	      ApplicationContainer sourceAppR2L;
-	      if (systemId == 1)
+	      if (rightNodes.Get (i)->GetSystemId () == systemId)
 	        {
 		  sourceAppR2L = source2.Install (rightNodes.Get (i));
 		  sourceAppR2L.Start (Seconds (REALLY_BIG_TIME));
@@ -369,7 +397,7 @@ main (int argc, char *argv[])
 	      ApplicationContainer sourceAppR2R;
 	      if (i != j)
 		{
-		  if (systemId == 1)
+		  if (rightNodes.Get (i)->GetSystemId () == systemId)
 		    {
 		      sourceAppR2R = source1.Install (rightNodes.Get (i));
 		      sourceAppR2R.Start (Seconds (REALLY_BIG_TIME));
@@ -389,7 +417,7 @@ main (int argc, char *argv[])
 	  source.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
 	  source.SetAttribute ("MaxBytes", UintegerValue (51200));
 
-	  if (systemId == 0)
+	  if (leftNodes.Get (i)->GetSystemId () == systemId)
 	    {
 	      sourceApp = source.Install (leftNodes.Get (i));
 	      sourceApp.Start (Seconds (randTime->GetValue()));
@@ -402,16 +430,16 @@ main (int argc, char *argv[])
 // Create a PacketSinkApplication and install it on right nodes
 //
   ApplicationContainer sinkApps;
-  if (systemId == 1)
+  PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                         InetSocketAddress (Ipv4Address::GetAny (), port));
+  for (uint32_t i = 0; i < numHosts; ++i)
     {
-      PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                             InetSocketAddress (Ipv4Address::GetAny (), port));
-      for (uint32_t i = 0; i < numHosts; ++i)
+      if (rightNodes.Get (i)->GetSystemId () == systemId)
         {
           sinkApps.Add(sink.Install (rightNodes.Get (i)));
         }
-      sinkApps.Start (Seconds (0.0));
     }
+  sinkApps.Start (Seconds (0.0));
 
 //
 // Install Switch.
@@ -420,7 +448,7 @@ for (uint32_t j = 0; j < numSwitches; ++j)
   {
     Ptr<SdnSwitch> sdnS = CreateObject<SdnSwitch> ();
     sdnS->SetStartTime (Seconds (0.0));
-    if (systemId == j)
+    if (switchNodes.Get (j)->GetSystemId () == systemId)
       switchNodes.Get (j)->AddApplication (sdnS);
   }
 
@@ -440,7 +468,7 @@ for (uint32_t j = 0; j < numSwitches; ++j)
   //Ptr<Firewall> sdnListener = CreateObject<Firewall> (firewallText);
   Ptr<SdnController> sdnC0 = CreateObject<SdnController> (sdnListener);
   sdnC0->SetStartTime (Seconds (0.0));
-  if (systemId == 2)
+  if (controllerNode.Get (0)->GetSystemId () == systemId)
       controllerNode.Get(0)->AddApplication (sdnC0);
 
 //
@@ -469,7 +497,7 @@ for (uint32_t j = 0; j < numSwitches; ++j)
   double simTime = Simulator::Now().GetSeconds();
   double d1 = TIMER_DIFF (t1, t0) + TIMER_DIFF (t2, t1);
 
-  if (systemId == 1)
+  if (rightNodes.Get (0)->GetSystemId () == systemId)
     {
       std::cout << numSwitches << "\t" << numHosts << "\t" << simTime << "\t" << d1;
       std::cout << "\t" << totalRx;
@@ -0,0 +1,408 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/mpi-interface.h"
+#include "sdn-partition-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnPartitionHelper");
+
+/**
+ * Orders clusters from the heaviest to the lightest, keeping the node order on ties
+ */
+struct SdnPartitionClusterOrder
+{
+  const std::vector<double> *weights;
+
+  bool operator() (uint32_t a, uint32_t b) const
+  {
+    return (*weights)[a] > (*weights)[b];
+  }
+};
+
+SdnPartitionHelper::SdnPartitionHelper ()
+  : m_imbalance (0.1),
+    m_systems (0)
+{
+}
+
+void
+SdnPartitionHelper::AddLink (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Link link;
+  link.a = a;
+  link.b = b;
+  link.delay = delay;
+  link.u = 0;
+  link.v = 0;
+  m_links.push_back (link);
+}
+
+void
+SdnPartitionHelper::AddControlLink (Ptr<Node> sw, Ptr<Node> controller, Time delay)
+{
+  Link link;
+  link.a = sw;
+  link.b = controller;
+  link.delay = delay;
+  link.u = 0;
+  link.v = 0;
+  m_controlLinks.push_back (link);
+}
+
+void
+SdnPartitionHelper::SetWeight (Ptr<Node> node, double weight)
+{
+  NS_ASSERT_MSG (weight >= 0, "A node cannot have a negative weight");
+  m_weights[node->GetId ()] = weight;
+}
+
+void
+SdnPartitionHelper::SetImbalance (double imbalance)
+{
+  NS_ASSERT_MSG (imbalance >= 0, "The imbalance cannot be negative");
+  m_imbalance = imbalance;
+}
+
+uint32_t
+SdnPartitionHelper::Find (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+bool
+SdnPartitionHelper::Pack (std::vector<uint32_t> &parent, const std::vector<double> &weights,
+                          double limit, std::vector<uint32_t> &rank) const
+{
+  uint32_t n = weights.size ();
+
+  // Number the clusters in the order of their first node
+  std::vector<uint32_t> cluster (n);
+  std::vector<uint32_t> clusterOfRoot (n, n);
+  std::vector<double> clusterWeight;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t root = Find (parent, i);
+      if (clusterOfRoot[root] == n)
+        {
+          clusterOfRoot[root] = clusterWeight.size ();
+          clusterWeight.push_back (0);
+        }
+      cluster[i] = clusterOfRoot[root];
+      clusterWeight[cluster[i]] += weights[i];
+    }
+  uint32_t clusters = clusterWeight.size ();
+
+  // Links left between clusters, a cluster is drawn to the ranks its neighbours are on
+  std::vector< std::vector<uint32_t> > neighbours (clusters);
+  for (uint32_t l = 0; l < m_links.size () + m_controlLinks.size (); ++l)
+    {
+      const Link &link = l < m_links.size () ? m_links[l] : m_controlLinks[l - m_links.size ()];
+      if (cluster[link.u] != cluster[link.v])
+        {
+          neighbours[cluster[link.u]].push_back (cluster[link.v]);
+          neighbours[cluster[link.v]].push_back (cluster[link.u]);
+        }
+    }
+
+  // Clusters are first placed in breadth first order, so that a rank fills up with
+  // clusters linked to each other. If that does not balance, the heaviest are placed first
+  std::vector<uint32_t> order;
+  std::vector<bool> visited (clusters, false);
+  while (order.size () < clusters)
+    {
+      uint32_t seed = clusters;
+      for (uint32_t c = 0; c < clusters; ++c)
+        {
+          if (!visited[c] && (seed == clusters || clusterWeight[c] > clusterWeight[seed]))
+            {
+              seed = c;
+            }
+        }
+      visited[seed] = true;
+      order.push_back (seed);
+      for (uint32_t head = order.size () - 1; head < order.size (); ++head)
+        {
+          uint32_t c = order[head];
+          for (uint32_t j = 0; j < neighbours[c].size (); ++j)
+            {
+              if (!visited[neighbours[c][j]])
+                {
+                  visited[neighbours[c][j]] = true;
+                  order.push_back (neighbours[c][j]);
+                }
+            }
+        }
+    }
+
+  std::vector<uint32_t> clusterRank;
+  std::vector<double> load;
+  std::vector<uint32_t> affinity (m_systems);
+  bool balanced = false;
+  for (uint32_t pass = 0; pass < 2 && !balanced; ++pass)
+    {
+      if (pass == 1)
+        {
+          SdnPartitionClusterOrder byWeight;
+          byWeight.weights = &clusterWeight;
+          std::stable_sort (order.begin (), order.end (), byWeight);
+        }
+      clusterRank.assign (clusters, m_systems);
+      load.assign (m_systems, 0);
+      balanced = true;
+      for (uint32_t k = 0; k < clusters; ++k)
+        {
+          uint32_t c = order[k];
+          std::fill (affinity.begin (), affinity.end (), 0);
+          for (uint32_t j = 0; j < neighbours[c].size (); ++j)
+            {
+              uint32_t r = clusterRank[neighbours[c][j]];
+              if (r < m_systems)
+                {
+                  affinity[r]++;
+                }
+            }
+
+          uint32_t best = m_systems;
+          uint32_t lightest = 0;
+          for (uint32_t r = 0; r < m_systems; ++r)
+            {
+              if (load[r] < load[lightest])
+                {
+                  lightest = r;
+                }
+              if (load[r] + clusterWeight[c] > limit * (1 + 1e-9))
+                {
+                  continue;
+                }
+              if (best == m_systems || affinity[r] > affinity[best]
+                  || (affinity[r] == affinity[best] && load[r] < load[best]))
+                {
+                  best = r;
+                }
+            }
+          if (best == m_systems)
+            {
+              best = lightest;
+              balanced = false;
+            }
+          clusterRank[c] = best;
+          load[best] += clusterWeight[c];
+        }
+    }
+
+  rank.resize (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      rank[i] = clusterRank[cluster[i]];
+    }
+  return balanced;
+}
+
+void
+SdnPartitionHelper::Partition (NodeContainer nodes, uint32_t systems)
+{
+  NS_LOG_FUNCTION (this << systems);
+  NS_ASSERT_MSG (systems > 0, "Cannot partition into zero systems");
+  m_systems = systems;
+
+  uint32_t n = nodes.GetN ();
+  std::map<uint32_t, uint32_t> index;
+  std::vector<double> weights (n);
+  double total = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      NS_ASSERT_MSG (node->GetNDevices () == 0,
+                     "Node " << node->GetId () << " already has devices, partition before installing channels");
+      index[node->GetId ()] = i;
+      std::map<uint32_t, double>::const_iterator w = m_weights.find (node->GetId ());
+      weights[i] = w == m_weights.end () ? 1 : w->second;
+      total += weights[i];
+    }
+
+  // Resolve the link ends and collect the candidate thresholds, largest first
+  std::vector<Time> thresholds;
+  for (uint32_t l = 0; l < m_links.size () + m_controlLinks.size (); ++l)
+    {
+      Link &link = l < m_links.size () ? m_links[l] : m_controlLinks[l - m_links.size ()];
+      std::map<uint32_t, uint32_t>::const_iterator u = index.find (link.a->GetId ());
+      std::map<uint32_t, uint32_t>::const_iterator v = index.find (link.b->GetId ());
+      NS_ASSERT_MSG (u != index.end () && v != index.end (),
+                     "Link " << link.a->GetId () << "-" << link.b->GetId () << " has an end outside the partitioned nodes");
+      link.u = u->second;
+      link.v = v->second;
+      thresholds.push_back (link.delay);
+    }
+  thresholds.push_back (Time::Max ());
+  std::sort (thresholds.begin (), thresholds.end ());
+  thresholds.erase (std::unique (thresholds.begin (), thresholds.end ()), thresholds.end ());
+
+  double limit = total / systems * (1 + m_imbalance);
+  std::vector<uint32_t> parent (n);
+  std::vector<uint32_t> rank;
+  Time threshold;
+  for (uint32_t t = thresholds.size (); t-- > 0; )
+    {
+      // Every link shorter than the threshold stays inside a rank
+      threshold = thresholds[t];
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          parent[i] = i;
+        }
+      for (uint32_t l = 0; l < m_links.size () + m_controlLinks.size (); ++l)
+        {
+          const Link &link = l < m_links.size () ? m_links[l] : m_controlLinks[l - m_links.size ()];
+          if (link.delay < threshold)
+            {
+              uint32_t ru = Find (parent, link.u);
+              uint32_t rv = Find (parent, link.v);
+              parent[std::max (ru, rv)] = std::min (ru, rv);
+            }
+        }
+      if (Pack (parent, weights, limit, rank))
+        {
+          break;
+        }
+      // With nothing contracted, a single node is heavier than a rank can be; keep going
+      // with the least bad packing
+    }
+  NS_LOG_INFO ("Links shorter than " << threshold << " kept inside a rank");
+
+  // Keep switches with their controller while it does not break the balance
+  for (uint32_t l = 0; l < m_controlLinks.size (); ++l)
+    {
+      const Link &link = m_controlLinks[l];
+      uint32_t ru = Find (parent, link.u);
+      uint32_t rv = Find (parent, link.v);
+      if (ru == rv)
+        {
+          continue;
+        }
+      std::vector<uint32_t> merged (parent);
+      merged[std::max (ru, rv)] = std::min (ru, rv);
+      std::vector<uint32_t> mergedRank;
+      if (Pack (merged, weights, limit, mergedRank))
+        {
+          parent.swap (merged);
+          rank.swap (mergedRank);
+        }
+      else
+        {
+          NS_LOG_INFO ("Switch " << link.a->GetId () << " cannot share the rank of controller " << link.b->GetId ());
+        }
+    }
+
+  m_lookAhead.assign (systems, Time::Max ());
+  m_systemWeight.assign (systems, 0);
+  m_systemNodes.assign (systems, 0);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      nodes.Get (i)->SetAttribute ("SystemId", UintegerValue (rank[i]));
+      m_systemWeight[rank[i]] += weights[i];
+      m_systemNodes[rank[i]]++;
+    }
+  for (uint32_t l = 0; l < m_links.size () + m_controlLinks.size (); ++l)
+    {
+      const Link &link = l < m_links.size () ? m_links[l] : m_controlLinks[l - m_links.size ()];
+      uint32_t ru = rank[link.u];
+      uint32_t rv = rank[link.v];
+      if (ru != rv)
+        {
+          m_lookAhead[ru] = std::min (m_lookAhead[ru], link.delay);
+          m_lookAhead[rv] = std::min (m_lookAhead[rv], link.delay);
+        }
+    }
+  for (uint32_t r = 0; r < systems; ++r)
+    {
+      NS_LOG_INFO ("System " << r << ": " << m_systemNodes[r] << " nodes, weight "
+                   << m_systemWeight[r] << ", lookahead " << m_lookAhead[r]);
+    }
+}
+
+void
+SdnPartitionHelper::Partition (NodeContainer nodes)
+{
+  Partition (nodes, MpiInterface::IsEnabled () ? MpiInterface::GetSize () : 1);
+}
+
+Time
+SdnPartitionHelper::GetLookAhead (uint32_t systemId) const
+{
+  NS_ASSERT_MSG (systemId < m_systems, "No such system in the partition");
+  return m_lookAhead[systemId];
+}
+
+Time
+SdnPartitionHelper::GetLookAhead (void) const
+{
+  Time lookAhead = Time::Max ();
+  for (uint32_t r = 0; r < m_systems; ++r)
+    {
+      lookAhead = std::min (lookAhead, m_lookAhead[r]);
+    }
+  return lookAhead;
+}
+
+double
+SdnPartitionHelper::GetWeight (uint32_t systemId) const
+{
+  NS_ASSERT_MSG (systemId < m_systems, "No such system in the partition");
+  return m_systemWeight[systemId];
+}
+
+uint32_t
+SdnPartitionHelper::GetNNodes (uint32_t systemId) const
+{
+  NS_ASSERT_MSG (systemId < m_systems, "No such system in the partition");
+  return m_systemNodes[systemId];
+}
+
+void
+SdnPartitionHelper::Print (std::ostream &os) const
+{
+  for (uint32_t r = 0; r < m_systems; ++r)
+    {
+      os << "System " << r << ": " << m_systemNodes[r] << " nodes, weight " << m_systemWeight[r]
+         << ", lookahead ";
+      if (m_lookAhead[r] == Time::Max ())
+        {
+          os << "unbounded";
+        }
+      else
+        {
+          os << m_lookAhead[r].GetSeconds () << "s";
+        }
+      os << std::endl;
+    }
+}
+
+} //End namespace ns3
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef SDN_PARTITION_HELPER_H
+#define SDN_PARTITION_HELPER_H
+
+//Stdlib packages
+#include <map>
+#include <vector>
+#include <ostream>
+//ns3 utilities
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnPartitionHelper
+ *
+ * \brief Assigns the system ids of the nodes of a distributed simulation
+ *
+ * The helper is given the links the topology is going to have, with their delays, and
+ * picks a rank for every node so that the smallest delay of a link crossing two ranks,
+ * which bounds the lookahead of the granted time window, is as large as possible while
+ * the weight of every rank stays within the allowed imbalance. It works in three steps:
+ * - Every link shorter than a threshold is contracted, its two ends have to share a rank.
+ *   The largest threshold whose clusters can still be packed into the ranks is kept.
+ * - Each switch is merged with its controller, as long as the packing stays balanced.
+ * - Clusters are packed in breadth first order from the heaviest one, so that linked
+ *   clusters fill a rank together, each on the rank it has the most links to among the
+ *   ranks it fits in, and the least loaded one otherwise. Only when that leaves a rank
+ *   over the limit are they packed again, heaviest first.
+ *
+ * Partitioning sets the SystemId attribute of the nodes, so it has to run before any
+ * channel is installed between them, and with the same input on every rank.
+ */
+class SdnPartitionHelper
+{
+public:
+  SdnPartitionHelper ();
+  /**
+   * \brief Declares a data link of the topology
+   * \param a One end of the link
+   * \param b The other end of the link
+   * \param delay The propagation delay of the link
+   */
+  void AddLink (Ptr<Node> a, Ptr<Node> b, Time delay);
+  /**
+   * \brief Declares the control connection of a switch, which is kept on the rank of its
+   * controller when the balance allows it
+   * \param sw The switch node
+   * \param controller The controller node
+   * \param delay The propagation delay of the control link
+   */
+  void AddControlLink (Ptr<Node> sw, Ptr<Node> controller, Time delay);
+  /**
+   * \brief Sets the load of a node, for instance the events it is expected to handle
+   * \param node The node
+   * \param weight Its relative weight, nodes weigh 1 by default
+   */
+  void SetWeight (Ptr<Node> node, double weight);
+  /**
+   * \brief Sets how much heavier than the average a rank may get
+   * \param imbalance Allowed excess over the average weight, 0.1 by default
+   */
+  void SetImbalance (double imbalance);
+  /**
+   * \brief Assigns every node of the container to one of systems ranks
+   * \param nodes The nodes to partition, every node named by a link must be in it
+   * \param systems The number of ranks
+   */
+  void Partition (NodeContainer nodes, uint32_t systems);
+  /**
+   * \brief Assigns every node of the container to one of the ranks of the MPI interface
+   * \param nodes The nodes to partition
+   */
+  void Partition (NodeContainer nodes);
+  /**
+   * \param systemId A rank
+   * \return The smallest delay of the links between the rank and another one, that is
+   * the lookahead it will get, Time::Max () if it has none
+   */
+  Time GetLookAhead (uint32_t systemId) const;
+  /**
+   * \return The smallest lookahead of all ranks
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \param systemId A rank
+   * \return The summed weight of the nodes assigned to the rank
+   */
+  double GetWeight (uint32_t systemId) const;
+  /**
+   * \param systemId A rank
+   * \return The number of nodes assigned to the rank
+   */
+  uint32_t GetNNodes (uint32_t systemId) const;
+  /**
+   * \brief Prints the nodes, weight and lookahead of every rank
+   * \param os The output stream
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /**
+   * A declared link, its ends resolved to indexes in the partitioned container
+   */
+  struct Link
+  {
+    Ptr<Node> a;    //!< One end
+    Ptr<Node> b;    //!< The other end
+    Time delay;     //!< Propagation delay
+    uint32_t u;     //!< Index of a in the container
+    uint32_t v;     //!< Index of b in the container
+  };
+
+  /**
+   * \brief Finds the cluster of a node, halving the path on the way
+   * \param parent The cluster forest
+   * \param i A node index
+   * \return The index of the root of its cluster
+   */
+  static uint32_t Find (std::vector<uint32_t> &parent, uint32_t i);
+  /**
+   * \brief Packs the clusters of a forest into the ranks
+   * \param parent The cluster forest
+   * \param weights The weight of every node
+   * \param limit The weight a rank should not exceed
+   * \param rank Receives the rank of every node
+   * \return True if no rank exceeds limit
+   */
+  bool Pack (std::vector<uint32_t> &parent, const std::vector<double> &weights,
+             double limit, std::vector<uint32_t> &rank) const;
+
+  std::vector<Link> m_links;            //!< Data links
+  std::vector<Link> m_controlLinks;     //!< Switch to controller links
+  std::map<uint32_t, double> m_weights; //!< Node weights by node id, 1 if absent
+  double m_imbalance;                   //!< Allowed excess over the average weight
+  uint32_t m_systems;                   //!< Number of ranks of the last partition
+  std::vector<Time> m_lookAhead;        //!< Lookahead of every rank
+  std::vector<double> m_systemWeight;   //!< Weight of every rank
+  std::vector<uint32_t> m_systemNodes;  //!< Node count of every rank
+};
+
+} //End namespace ns3
+#endif
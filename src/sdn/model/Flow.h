@@ -33,6 +33,9 @@
 #include "ns3/packet.h"
 #include "ns3/event-id.h"
 
+//Sdn classes
+#include "SdnFlowKey.h"
+
 using namespace ns3;
 
 #define NANOTOSECS 1000000000
@@ -55,9 +58,7 @@ public:
  *
  */
   Flow ()
-  : nw_src_mask (0xffffffff),
-    nw_dst_mask (0xffffffff),
-    match (),
+  : match (),
     actions ()
   {
     install_time_nsec = Simulator::Now().GetNanoSeconds();
@@ -78,11 +79,20 @@ public:
   */
   fluid_msg::of10::FlowStats* convertToFlowStats(); //Conversion function to make stats
   /**
+  * \brief Compiles match into compiled. Must be called whenever match changes
+  */
+  void compileMatch();
+  /**
   * \brief Non-Strict match on a packet
   * \return boolean match
   */
   static bool pkt_match (const Flow& flow, const fluid_msg::of10::Match &pkt_match);
   /**
+  * \brief Non-Strict match on a packet key
+  * \return boolean match
+  */
+  static bool pkt_match (const Flow& flow, const SdnFlowKey &key);
+  /**
   * \brief Strict match on a packet
   * \return boolean match
   */
@@ -109,11 +119,10 @@ public:
   uint64_t cookie_;              //!< A controller specified cookie unique per each flow
   uint64_t packet_count_;        //!< A count of packets handled by this flow
   uint64_t byte_count_;          //!< A count of bytes in the packets handled by this flow
-  uint32_t nw_src_mask;          //!< A subnet mask of source IP addresses. Specified as 111 ----- 100
-  uint32_t nw_dst_mask;          //!< A subnet mask of destination IP addresses. Specified as 111 ----- 100
   EventId idle_timeout_event;    //!< An NS3 event to fire a timeout if the idle time is reached
   EventId hard_timeout_event;    //!< An NS3 event to fire a timeout if the hard time is reached
   fluid_msg::of10::Match match;  //!< A libfluid match object of packets features we match
+  SdnFlowMatch compiled;         //!< match compiled into a flat value/mask pair, used for all the comparisons
   fluid_msg::ActionList actions; //!< A libfluid ActionList (vector of actions) to apply to a packet. Only applies if the match is correct
   
 
@@ -33,6 +33,9 @@
 #include "ns3/packet.h"
 #include "ns3/event-id.h"
 
+//Sdn classes
+#include "SdnFlowKey.h"
+
 using namespace ns3;
 
 #define NANOTOSECS 1000000000
@@ -55,12 +58,14 @@ public:
  *
  */
   Flow13 ()
-  : nw_src_mask (0xffffffff),
-    nw_dst_mask (0xffffffff),
-    match (),
+  : match (),
     actions ()
   {
     install_time_nsec = Simulator::Now().GetNanoSeconds();
+    last_used_nsec = install_time_nsec;
+    id_ = 0;
+    prev_ = NULL;
+    next_ = NULL;
   }
   /**
   * \brief Grabs the total time alive in seconds
@@ -78,11 +83,20 @@ public:
   */
   fluid_msg::of13::FlowStats* convertToFlowStats(); //Conversion function to make stats
   /**
+  * \brief Compiles match into compiled. Must be called whenever match changes
+  */
+  void compileMatch();
+  /**
   * \brief Non-Strict match on a packet
   * \return boolean match
   */
   static bool pkt_match (const Flow13& flow, const fluid_msg::of13::Match &pkt_match);
   /**
+  * \brief Non-Strict match on a packet key
+  * \return boolean match
+  */
+  static bool pkt_match (const Flow13& flow, const SdnFlowKey &key);
+  /**
   * \brief Strict match on a packet
   * \return boolean match
   */
@@ -110,11 +124,12 @@ public:
   uint64_t cookie_;              //!< A controller specified cookie unique per each flow
   uint64_t packet_count_;        //!< A count of packets handled by this flow
   uint64_t byte_count_;          //!< A count of bytes in the packets handled by this flow
-  uint32_t nw_src_mask;          //!< A subnet mask of source IP addresses. Specified as 111 ----- 100
-  uint32_t nw_dst_mask;          //!< A subnet mask of destination IP addresses. Specified as 111 ----- 100
-  EventId idle_timeout_event;    //!< An NS3 event to fire a timeout if the idle time is reached
-  EventId hard_timeout_event;    //!< An NS3 event to fire a timeout if the hard time is reached
+  uint64_t id_;                  //!< Stable identifier of the flow within its table: pool slot and slot generation
+  uint64_t last_used_nsec;       //!< Simulator time the flow last matched a packet in nanoseconds
+  Flow13 *prev_;                 //!< Previous flow in the priority index of the table
+  Flow13 *next_;                 //!< Next flow in the priority index of the table
   fluid_msg::of13::Match match;  //!< A libfluid match object of packets features we match
+  SdnFlowMatch compiled;         //!< match compiled into a flat value/mask pair, used for all the comparisons
   fluid_msg::of13::InstructionSet instructions;
   fluid_msg::ActionList actions; //!< A libfluid ActionList (vector of actions) to apply to a packet. Only applies if the match is correct
   
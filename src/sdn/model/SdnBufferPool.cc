@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "SdnBufferPool.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnBufferPool");
+
+SdnBufferPool::SdnBufferPool ()
+  : m_slotBits (0),
+    m_oldest (0),
+    m_newest (0),
+    m_free (0),
+    m_size (0),
+    m_timeout (Seconds (1))
+{
+}
+
+void
+SdnBufferPool::SetCapacity (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  NS_ASSERT_MSG (capacity < (1U << 31), "Buffer pool too large for 32-bit buffer ids");
+  m_slots.clear ();
+  m_slots.resize (capacity);
+  m_slotBits = 0;
+  while ((1U << m_slotBits) < capacity)
+    {
+      m_slotBits++;
+    }
+  // Every slot starts on the free list, the store order list is empty
+  for (uint32_t i = 0; i < capacity; ++i)
+    {
+      m_slots[i].generation = 0;
+      m_slots[i].next = i + 1;
+    }
+  m_free = 0;
+  m_oldest = m_newest = capacity;
+  m_size = 0;
+}
+
+uint32_t
+SdnBufferPool::GetCapacity (void) const
+{
+  return m_slots.size ();
+}
+
+void
+SdnBufferPool::SetTimeout (Time timeout)
+{
+  m_timeout = timeout;
+}
+
+Time
+SdnBufferPool::GetTimeout (void) const
+{
+  return m_timeout;
+}
+
+uint32_t
+SdnBufferPool::Store (Ptr<Packet> packet, uint32_t inPort)
+{
+  NS_LOG_FUNCTION (this << packet << inPort);
+  uint32_t end = m_slots.size ();
+  if (end == 0)
+    {
+      return SDN_NO_BUFFER;
+    }
+  Time now = Simulator::Now ();
+  while (m_oldest != end && m_slots[m_oldest].stored + m_timeout <= now)
+    {
+      NS_LOG_LOGIC ("Evicting buffered packet of slot " << m_oldest << ", timed out");
+      Release (m_oldest);
+    }
+  if (m_free == end)
+    {
+      NS_LOG_LOGIC ("Evicting buffered packet of slot " << m_oldest << ", pool full");
+      Release (m_oldest);
+    }
+
+  uint32_t slot = m_free;
+  Slot &s = m_slots[slot];
+  m_free = s.next;
+  s.packet = packet;
+  s.stored = now;
+  s.inPort = inPort;
+  s.prev = m_newest;
+  s.next = end;
+  if (m_newest != end)
+    {
+      m_slots[m_newest].next = slot;
+    }
+  else
+    {
+      m_oldest = slot;
+    }
+  m_newest = slot;
+  m_size++;
+
+  uint32_t id = (s.generation << m_slotBits) | slot;
+  if (id == SDN_NO_BUFFER)
+    {
+      // Never hand out OFP_NO_BUFFER, skip to the next generation
+      s.generation++;
+      id = (s.generation << m_slotBits) | slot;
+    }
+  return id;
+}
+
+uint32_t
+SdnBufferPool::Resolve (uint32_t id) const
+{
+  uint32_t end = m_slots.size ();
+  if (id == SDN_NO_BUFFER || end == 0)
+    {
+      return end;
+    }
+  uint32_t slot = id & ((1U << m_slotBits) - 1);
+  if (slot >= end || !m_slots[slot].packet ||
+      ((m_slots[slot].generation << m_slotBits) | slot) != id)
+    {
+      return end;
+    }
+  return slot;
+}
+
+Ptr<Packet>
+SdnBufferPool::Find (uint32_t id) const
+{
+  uint32_t slot = Resolve (id);
+  return slot < m_slots.size () ? m_slots[slot].packet : 0;
+}
+
+Ptr<Packet>
+SdnBufferPool::Take (uint32_t id)
+{
+  uint32_t inPort;
+  return Take (id, inPort);
+}
+
+Ptr<Packet>
+SdnBufferPool::Take (uint32_t id, uint32_t &inPort)
+{
+  NS_LOG_FUNCTION (this << id);
+  uint32_t slot = Resolve (id);
+  if (slot == m_slots.size ())
+    {
+      return 0;
+    }
+  Ptr<Packet> packet = m_slots[slot].packet;
+  inPort = m_slots[slot].inPort;
+  Release (slot);
+  return packet;
+}
+
+uint32_t
+SdnBufferPool::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+SdnBufferPool::Release (uint32_t slot)
+{
+  uint32_t end = m_slots.size ();
+  Slot &s = m_slots[slot];
+  if (s.prev != end)
+    {
+      m_slots[s.prev].next = s.next;
+    }
+  else
+    {
+      m_oldest = s.next;
+    }
+  if (s.next != end)
+    {
+      m_slots[s.next].prev = s.prev;
+    }
+  else
+    {
+      m_newest = s.prev;
+    }
+  s.packet = 0;
+  s.generation++;
+  s.next = m_free;
+  m_free = slot;
+  m_size--;
+}
+
+} //End namespace ns3
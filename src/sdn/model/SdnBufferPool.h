@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_BUFFER_POOL_H
+#define SDN_BUFFER_POOL_H
+
+//Stdlib packages
+#include <vector>
+//ns3 utilities
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#define SDN_NO_BUFFER 0xffffffff //!< OFP_NO_BUFFER, the buffer id of a packet that was not buffered
+
+namespace ns3 {
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnBufferPool
+ *
+ * \brief Fixed-capacity pool of the packets a switch sent to the controller in a PacketIn
+ *
+ * A buffer id is the index of the slot holding the packet in its low bits and the
+ * generation of the slot in its high bits. Each reuse of a slot bumps its generation, so
+ * an id the controller kept past the release of its packet no longer resolves. Slots are
+ * kept in store order: a packet older than the timeout is evicted on the next store, and
+ * when the pool is full the oldest packet makes room for the new one.
+ */
+class SdnBufferPool
+{
+public:
+  SdnBufferPool ();
+  /**
+   * \brief Resizes the pool, dropping every buffered packet
+   * \param capacity The number of slots. 0 disables buffering
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \return The number of slots of the pool
+   */
+  uint32_t GetCapacity (void) const;
+  /**
+   * \brief Sets how long a packet stays buffered before it may be evicted
+   * \param timeout The buffering time
+   */
+  void SetTimeout (Time timeout);
+  /**
+   * \return The buffering time
+   */
+  Time GetTimeout (void) const;
+  /**
+   * \brief Buffers a packet
+   * \param packet The packet, kept as is
+   * \param inPort The switch port the packet arrived on
+   * \return Its buffer id, SDN_NO_BUFFER if buffering is disabled
+   */
+  uint32_t Store (Ptr<Packet> packet, uint32_t inPort = 0);
+  /**
+   * \brief Looks up a buffered packet, leaving it in the pool
+   * \param id The buffer id
+   * \return The packet, 0 if the id is unknown, released or evicted
+   */
+  Ptr<Packet> Find (uint32_t id) const;
+  /**
+   * \brief Takes a buffered packet out of the pool, releasing its slot
+   * \param id The buffer id
+   * \return The packet, 0 if the id is unknown, released or evicted
+   */
+  Ptr<Packet> Take (uint32_t id);
+  /**
+   * \brief Takes a buffered packet out of the pool, along with the port it arrived on
+   * \param id The buffer id
+   * \param inPort Set to the port given to Store, if the packet is found
+   * \return The packet, 0 if the id is unknown, released or evicted
+   */
+  Ptr<Packet> Take (uint32_t id, uint32_t &inPort);
+  /**
+   * \return The number of buffered packets
+   */
+  uint32_t GetSize (void) const;
+
+private:
+  /**
+   * A slot of the pool
+   */
+  struct Slot
+  {
+    Ptr<Packet> packet; //!< The buffered packet, 0 if the slot is free
+    Time stored;        //!< When the packet was buffered
+    uint32_t inPort;    //!< The port the packet arrived on
+    uint32_t generation; //!< Bumped on each reuse of the slot
+    uint32_t prev;      //!< Previous slot in store order, or in the free list
+    uint32_t next;      //!< Next slot in store order, or in the free list
+  };
+  /**
+   * \brief Resolves a buffer id to its slot
+   * \return The slot index, m_slots.size () if the id does not name a buffered packet
+   */
+  uint32_t Resolve (uint32_t id) const;
+  /**
+   * \brief Empties a slot and puts it on the free list
+   */
+  void Release (uint32_t slot);
+
+  std::vector<Slot> m_slots; //!< The slots
+  uint32_t m_slotBits;       //!< Low bits of a buffer id holding the slot index
+  uint32_t m_oldest;         //!< Head of the store order list
+  uint32_t m_newest;         //!< Tail of the store order list
+  uint32_t m_free;           //!< Head of the free list
+  uint32_t m_size;           //!< Number of buffered packets
+  Time m_timeout;            //!< Buffering time before a packet may be evicted
+};
+
+} //End namespace ns3
+#endif
@@ -0,0 +1,406 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "SdnClassifier13.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnClassifier13");
+
+NS_OBJECT_ENSURE_REGISTERED (SdnClassifier13);
+NS_OBJECT_ENSURE_REGISTERED (SdnLinearClassifier13);
+NS_OBJECT_ENSURE_REGISTERED (SdnTupleSpaceClassifier13);
+
+TypeId
+SdnClassifier13::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SdnClassifier13")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+SdnClassifier13::SdnClassifier13 ()
+  : m_sequence (0)
+{
+}
+
+SdnClassifier13::~SdnClassifier13 ()
+{
+}
+
+SdnClassifier13::Entry
+SdnClassifier13::MakeEntry (Flow13 *flow)
+{
+  Entry entry;
+  entry.flow = flow;
+  entry.sequence = m_sequence++;
+  entry.priority = flow->priority_;
+  entry.value = flow->compiled.value;
+  entry.mask = flow->compiled.mask;
+  entry.first = flow->compiled.first;
+  entry.last = flow->compiled.last;
+  return entry;
+}
+
+void
+SdnClassifier13::InsertBatch (const std::vector<Flow13*> &flows)
+{
+  for (std::vector<Flow13*>::const_iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      Insert (*i);
+    }
+}
+
+bool
+SdnClassifier13::Matches (const SdnFlowKey &key, const Entry &entry)
+{
+  return (entry.mask.fields & ~key.fields) == 0
+         && key.MaskedEquals (entry.value, entry.mask, entry.first, entry.last);
+}
+
+/* Linear classifier */
+
+TypeId
+SdnLinearClassifier13::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SdnLinearClassifier13")
+    .SetParent<SdnClassifier13> ()
+    .AddConstructor<SdnLinearClassifier13> ()
+  ;
+  return tid;
+}
+
+SdnLinearClassifier13::SdnLinearClassifier13 ()
+{
+}
+
+SdnLinearClassifier13::~SdnLinearClassifier13 ()
+{
+}
+
+void
+SdnLinearClassifier13::Insert (Flow13 *flow)
+{
+  Entry entry = MakeEntry (flow);
+  m_entries.insert (std::upper_bound (m_entries.begin (), m_entries.end (), entry, &SdnClassifier13::Precedes), entry);
+}
+
+void
+SdnLinearClassifier13::InsertBatch (const std::vector<Flow13*> &flows)
+{
+  for (std::vector<Flow13*>::const_iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      m_entries.push_back (MakeEntry (*i));
+    }
+  // Sequence numbers break every tie, a plain sort gives the same order as inserting one by one
+  std::sort (m_entries.begin (), m_entries.end (), &SdnClassifier13::Precedes);
+}
+
+void
+SdnLinearClassifier13::Remove (Flow13 *flow)
+{
+  for (std::vector<Entry>::iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      if (i->flow == flow)
+        {
+          m_entries.erase (i);
+          return;
+        }
+    }
+}
+
+Flow13*
+SdnLinearClassifier13::Lookup (const SdnFlowKey &key)
+{
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      if (Matches (key, *i))
+        {
+          return i->flow;
+        }
+    }
+  return NULL;
+}
+
+std::vector<Flow13*>
+SdnLinearClassifier13::LookupAll (const SdnFlowKey &key)
+{
+  std::vector<Flow13*> flows;
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      if (Matches (key, *i))
+        {
+          flows.push_back (i->flow);
+        }
+    }
+  return flows;
+}
+
+void
+SdnLinearClassifier13::Clear (void)
+{
+  m_entries.clear ();
+}
+
+uint32_t
+SdnLinearClassifier13::GetSize (void) const
+{
+  return m_entries.size ();
+}
+
+/* Tuple space search classifier */
+
+TypeId
+SdnTupleSpaceClassifier13::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SdnTupleSpaceClassifier13")
+    .SetParent<SdnClassifier13> ()
+    .AddConstructor<SdnTupleSpaceClassifier13> ()
+  ;
+  return tid;
+}
+
+SdnTupleSpaceClassifier13::SdnTupleSpaceClassifier13 ()
+  : m_size (0)
+{
+}
+
+SdnTupleSpaceClassifier13::~SdnTupleSpaceClassifier13 ()
+{
+  Clear ();
+}
+
+uint32_t
+SdnTupleSpaceClassifier13::FindTuple (const SdnFlowKey &mask) const
+{
+  for (uint32_t i = 0; i < m_tuples.size (); ++i)
+    {
+      if (memcmp (&m_tuples[i]->mask, &mask, sizeof (SdnFlowKey)) == 0)
+        {
+          return i;
+        }
+    }
+  return m_tuples.size ();
+}
+
+void
+SdnTupleSpaceClassifier13::SortTuples (void)
+{
+  // Only one tuple changed since the last call, so an insertion pass is enough
+  for (uint32_t i = 1; i < m_tuples.size (); ++i)
+    {
+      Tuple *tuple = m_tuples[i];
+      uint32_t j = i;
+      while (j > 0 && tuple->maxPriority > m_tuples[j - 1]->maxPriority)
+        {
+          m_tuples[j] = m_tuples[j - 1];
+          --j;
+        }
+      m_tuples[j] = tuple;
+    }
+}
+
+void
+SdnTupleSpaceClassifier13::InsertEntry (const Entry &entry)
+{
+  uint32_t index = FindTuple (entry.mask);
+  Tuple *tuple;
+  if (index == m_tuples.size ())
+    {
+      tuple = new Tuple ();
+      tuple->mask = entry.mask;
+      tuple->first = entry.first;
+      tuple->last = entry.last;
+      tuple->maxPriority = entry.priority;
+      tuple->size = 0;
+      m_tuples.push_back (tuple);
+      NS_LOG_DEBUG ("New tuple, " << m_tuples.size () << " tuples in use");
+    }
+  else
+    {
+      tuple = m_tuples[index];
+    }
+
+  std::vector<Entry> &bucket = tuple->buckets[entry.value.MaskedHash (tuple->mask, tuple->first, tuple->last)];
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), entry, &SdnClassifier13::Precedes), entry);
+  tuple->priorities[entry.priority]++;
+  tuple->maxPriority = tuple->priorities.rbegin ()->first;
+  tuple->size++;
+  m_size++;
+}
+
+void
+SdnTupleSpaceClassifier13::Insert (Flow13 *flow)
+{
+  InsertEntry (MakeEntry (flow));
+  SortTuples ();
+}
+
+void
+SdnTupleSpaceClassifier13::InsertBatch (const std::vector<Flow13*> &flows)
+{
+  for (std::vector<Flow13*>::const_iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      InsertEntry (MakeEntry (*i));
+    }
+  // Many tuples may have moved, sort them once rather than after every insertion
+  std::stable_sort (m_tuples.begin (), m_tuples.end (), &SdnTupleSpaceClassifier13::HigherPriority);
+}
+
+void
+SdnTupleSpaceClassifier13::Remove (Flow13 *flow)
+{
+  uint32_t index = FindTuple (flow->compiled.mask);
+  if (index == m_tuples.size ())
+    {
+      return;
+    }
+  Tuple *tuple = m_tuples[index];
+  Buckets::iterator bucket = tuple->buckets.find (flow->compiled.value.MaskedHash (tuple->mask, tuple->first, tuple->last));
+  if (bucket == tuple->buckets.end ())
+    {
+      return;
+    }
+  for (std::vector<Entry>::iterator i = bucket->second.begin (); i != bucket->second.end (); ++i)
+    {
+      if (i->flow != flow)
+        {
+          continue;
+        }
+      if (--tuple->priorities[i->priority] == 0)
+        {
+          tuple->priorities.erase (i->priority);
+        }
+      bucket->second.erase (i);
+      if (bucket->second.empty ())
+        {
+          tuple->buckets.erase (bucket);
+        }
+      m_size--;
+      if (--tuple->size == 0)
+        {
+          delete tuple;
+          m_tuples.erase (m_tuples.begin () + index);
+        }
+      else
+        {
+          tuple->maxPriority = tuple->priorities.rbegin ()->first;
+          SortTuples ();
+        }
+      return;
+    }
+}
+
+Flow13*
+SdnTupleSpaceClassifier13::Lookup (const SdnFlowKey &key)
+{
+  const Entry *best = NULL;
+  for (std::vector<Tuple*>::const_iterator t = m_tuples.begin (); t != m_tuples.end (); ++t)
+    {
+      const Tuple *tuple = *t;
+      if (best && tuple->maxPriority < best->priority)
+        {
+          // Tuples are sorted, none of the remaining ones can do better
+          break;
+        }
+      if ((tuple->mask.fields & ~key.fields) != 0)
+        {
+          continue;
+        }
+      Buckets::const_iterator bucket = tuple->buckets.find (key.MaskedHash (tuple->mask, tuple->first, tuple->last));
+      if (bucket == tuple->buckets.end ())
+        {
+          continue;
+        }
+      // Bucket entries are sorted with Precedes, the first verified one is the best of this tuple
+      for (std::vector<Entry>::const_iterator i = bucket->second.begin (); i != bucket->second.end (); ++i)
+        {
+          if (key.MaskedEquals (i->value, tuple->mask, tuple->first, tuple->last))
+            {
+              if (!best || Precedes (*i, *best))
+                {
+                  best = &(*i);
+                }
+              break;
+            }
+        }
+    }
+  return best ? best->flow : NULL;
+}
+
+std::vector<Flow13*>
+SdnTupleSpaceClassifier13::LookupAll (const SdnFlowKey &key)
+{
+  std::vector<Entry> entries;
+  for (std::vector<Tuple*>::const_iterator t = m_tuples.begin (); t != m_tuples.end (); ++t)
+    {
+      const Tuple *tuple = *t;
+      if ((tuple->mask.fields & ~key.fields) != 0)
+        {
+          continue;
+        }
+      Buckets::const_iterator bucket = tuple->buckets.find (key.MaskedHash (tuple->mask, tuple->first, tuple->last));
+      if (bucket == tuple->buckets.end ())
+        {
+          continue;
+        }
+      for (std::vector<Entry>::const_iterator i = bucket->second.begin (); i != bucket->second.end (); ++i)
+        {
+          if (key.MaskedEquals (i->value, tuple->mask, tuple->first, tuple->last))
+            {
+              entries.push_back (*i);
+            }
+        }
+    }
+  std::sort (entries.begin (), entries.end (), &SdnClassifier13::Precedes);
+  std::vector<Flow13*> flows;
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      flows.push_back (i->flow);
+    }
+  return flows;
+}
+
+void
+SdnTupleSpaceClassifier13::Clear (void)
+{
+  for (std::vector<Tuple*>::iterator t = m_tuples.begin (); t != m_tuples.end (); ++t)
+    {
+      delete *t;
+    }
+  m_tuples.clear ();
+  m_size = 0;
+}
+
+uint32_t
+SdnTupleSpaceClassifier13::GetSize (void) const
+{
+  return m_size;
+}
+
+uint32_t
+SdnTupleSpaceClassifier13::GetNTuples (void) const
+{
+  return m_tuples.size ();
+}
+
+} //End namespace ns3
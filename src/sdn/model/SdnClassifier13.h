@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_CLASSIFIER13_H
+#define SDN_CLASSIFIER13_H
+
+//Stdlib packages
+#include <vector>
+#include <map>
+//ns3 utilities
+#include "ns3/object.h"
+#include "ns3/type-id.h"
+#include "ns3/sgi-hashmap.h"
+//Sdn classes
+#include "Flow13.h"
+#include "SdnFlowKey.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnClassifier13
+ *
+ * \brief Packet classifier sitting behind an SdnFlowTable13
+ *
+ * The classifier indexes the flows of one table by their compiled match and answers
+ * which flow a packet key hits. Among the matching flows the one with the highest
+ * priority wins, ties going to the flow that was inserted first. The classifier does
+ * not own the flows, the table guarantees a flow outlives its classifier entry.
+ */
+class SdnClassifier13 : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SdnClassifier13 ();
+  virtual ~SdnClassifier13 ();
+  /**
+   * \brief Indexes a flow
+   * \param flow The flow to index. Must stay at the same address until removed
+   */
+  virtual void Insert (Flow13 *flow) = 0;
+  /**
+   * \brief Indexes several flows at once
+   *
+   * Same result as inserting them one by one in order. Classifiers override it when
+   * their index can be rebuilt once for the whole batch.
+   * \param flows The flows to index, in insertion order
+   */
+  virtual void InsertBatch (const std::vector<Flow13*> &flows);
+  /**
+   * \brief Removes a flow from the index
+   * \param flow The flow previously passed to Insert
+   */
+  virtual void Remove (Flow13 *flow) = 0;
+  /**
+   * \brief Finds the flow a packet hits
+   * \param key The key extracted from the packet
+   * \return The highest priority matching flow, NULL on a table miss
+   */
+  virtual Flow13* Lookup (const SdnFlowKey &key) = 0;
+  /**
+   * \brief Finds every flow matching a packet
+   * \param key The key extracted from the packet
+   * \return The matching flows, highest priority first
+   */
+  virtual std::vector<Flow13*> LookupAll (const SdnFlowKey &key) = 0;
+  /**
+   * \brief Removes all the flows from the index
+   */
+  virtual void Clear (void) = 0;
+  /**
+   * \return The number of indexed flows
+   */
+  virtual uint32_t GetSize (void) const = 0;
+
+protected:
+  /**
+   * An indexed flow together with its compiled match
+   */
+  struct Entry
+  {
+    Flow13 *flow;        //!< The indexed flow
+    uint64_t sequence;   //!< Insertion order, used to break priority ties
+    uint16_t priority;   //!< Priority of the flow
+    SdnFlowKey value;    //!< Compiled match values, already masked
+    SdnFlowKey mask;     //!< Compiled match mask
+    uint8_t first;       //!< First word with mask bits set
+    uint8_t last;        //!< Last word with mask bits set
+  };
+  /**
+   * \brief Builds the entry of a flow
+   * \param flow The flow to compile
+   * \return A new entry with the next insertion sequence number
+   */
+  Entry MakeEntry (Flow13 *flow);
+  /**
+   * \brief Checks a packet key against an entry
+   * \param key The packet key
+   * \param entry The entry to check
+   * \return True if every field of the entry is present in the key and matches
+   */
+  static bool Matches (const SdnFlowKey &key, const Entry &entry);
+  /**
+   * \brief Orders entries by priority (highest first), then insertion order
+   */
+  static bool Precedes (const Entry &lhs, const Entry &rhs)
+  {
+    return lhs.priority > rhs.priority || (lhs.priority == rhs.priority && lhs.sequence < rhs.sequence);
+  }
+
+  uint64_t m_sequence; //!< Next insertion sequence number
+};
+
+/**
+ * \ingroup sdn
+ *
+ * \brief Reference classifier checking every flow in priority order
+ *
+ * Same cost as the original flow table scan. Kept to compare results against
+ * SdnTupleSpaceClassifier13.
+ */
+class SdnLinearClassifier13 : public SdnClassifier13
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SdnLinearClassifier13 ();
+  virtual ~SdnLinearClassifier13 ();
+
+  virtual void Insert (Flow13 *flow);
+  virtual void InsertBatch (const std::vector<Flow13*> &flows);
+  virtual void Remove (Flow13 *flow);
+  virtual Flow13* Lookup (const SdnFlowKey &key);
+  virtual std::vector<Flow13*> LookupAll (const SdnFlowKey &key);
+  virtual void Clear (void);
+  virtual uint32_t GetSize (void) const;
+
+private:
+  std::vector<Entry> m_entries; //!< All entries, sorted with Precedes
+};
+
+/**
+ * \ingroup sdn
+ *
+ * \brief Tuple space search classifier
+ *
+ * Flows sharing the same set of fields and masks form a tuple. Each tuple is an
+ * exact-match hash table over the masked packet key, so a lookup costs one hash
+ * probe per tuple instead of one comparison per flow. Tuples are kept sorted by
+ * the highest priority they hold and the search stops as soon as no remaining
+ * tuple can beat the best match found so far.
+ */
+class SdnTupleSpaceClassifier13 : public SdnClassifier13
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SdnTupleSpaceClassifier13 ();
+  virtual ~SdnTupleSpaceClassifier13 ();
+
+  virtual void Insert (Flow13 *flow);
+  virtual void InsertBatch (const std::vector<Flow13*> &flows);
+  virtual void Remove (Flow13 *flow);
+  virtual Flow13* Lookup (const SdnFlowKey &key);
+  virtual std::vector<Flow13*> LookupAll (const SdnFlowKey &key);
+  virtual void Clear (void);
+  virtual uint32_t GetSize (void) const;
+  /**
+   * \return The number of distinct tuples (masks) currently in use
+   */
+  uint32_t GetNTuples (void) const;
+
+private:
+  typedef sgi::hash_map<uint32_t, std::vector<Entry> > Buckets;
+
+  /**
+   * All the flows compiled to the same mask
+   */
+  struct Tuple
+  {
+    SdnFlowKey mask;                         //!< Mask shared by every flow of the tuple
+    uint8_t first;                           //!< First word with mask bits set
+    uint8_t last;                            //!< Last word with mask bits set
+    uint16_t maxPriority;                    //!< Highest priority among the flows of the tuple
+    uint32_t size;                           //!< Number of flows in the tuple
+    std::map<uint16_t, uint32_t> priorities; //!< Number of flows per priority, to maintain maxPriority
+    Buckets buckets;                         //!< Flows keyed by the hash of their masked value
+  };
+
+  /**
+   * \brief Finds the tuple of a mask
+   * \param mask The mask to look for
+   * \return The index of the tuple in m_tuples, or m_tuples.size () if none exists
+   */
+  uint32_t FindTuple (const SdnFlowKey &mask) const;
+  /**
+   * \brief Adds an entry to its tuple, creating the tuple if needed, without restoring the tuple order
+   * \param entry The entry to add
+   */
+  void InsertEntry (const Entry &entry);
+  /**
+   * \brief Restores the ordering of m_tuples by decreasing maxPriority
+   */
+  void SortTuples (void);
+  /**
+   * \brief Orders tuples by decreasing maxPriority
+   */
+  static bool HigherPriority (const Tuple *lhs, const Tuple *rhs)
+  {
+    return lhs->maxPriority > rhs->maxPriority;
+  }
+
+  std::vector<Tuple*> m_tuples; //!< Tuples sorted by decreasing maxPriority
+  uint32_t m_size;              //!< Number of flows over all tuples
+};
+
+} //End namespace ns3
+#endif
@@ -17,6 +17,8 @@
  *          Michael Riley <mriley7@gatech.edu>
  */
 
+#include <algorithm>
+#include <cstring>
 #include "SdnConnection.h"
   #include "ns3/packet-bcolor-tag.h"
   #include "ns3/packet-gcolor-tag.h"
@@ -75,6 +77,14 @@ SdnConnection::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
 
+  m_txFlushEvent.Cancel ();
+  if (m_socket)
+    {
+      m_socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+    }
+  m_txPacket = 0;
+  m_txSizes.clear ();
+  m_txFrames.clear ();
   Object::DoDispose ();
 }
 
@@ -84,6 +94,15 @@ SdnConnection::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::SdnConnection")
     .SetParent<Object> ()
     .AddConstructor<SdnConnection> ()
+    .AddAttribute ("TxCoalescingWindow",
+                   "How long a message waits in the transmit queue so that later ones leave with it. "
+                   "Zero coalesces everything sent at the same simulation time.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SdnConnection::m_txWindow),
+                   MakeTimeChecker (Seconds (0)))
+    .AddTraceSource ("TxFlush",
+                     "A flush of the transmit queue, with its number of messages and bytes",
+                     MakeTraceSourceAccessor (&SdnConnection::m_txFlushTrace))
   ;
   return tid;
 }
@@ -91,8 +110,11 @@ SdnConnection::GetTypeId (void)
 SdnConnection::SdnConnection (Ptr<Socket> socket)
 : m_sent (0),
   m_recv (0),
+  m_flushes (0),
   m_socket (socket),
-  m_device(0)
+  m_device(0),
+  m_rxHead (0),
+  m_rxTail (0)
 {
   NS_LOG_FUNCTION (this << socket);
 
@@ -102,16 +124,18 @@ SdnConnection::SdnConnection (Ptr<Socket> socket)
   this->set_version (0);
   this->m_applicationData = NULL;
 
-  this->m_lastSendTime = Seconds(0.0);
-  this->m_consecutivePause = 0;
+  this->m_txVersion = 0;
 }
 
 SdnConnection::SdnConnection (Ptr<NetDevice> device,
                               Ptr<Socket> socket)
 : m_sent (0),
   m_recv (0),
+  m_flushes (0),
   m_socket (socket),
-  m_device(device)
+  m_device(device),
+  m_rxHead (0),
+  m_rxTail (0)
 {
   NS_LOG_FUNCTION (this << socket);
 
@@ -121,15 +145,17 @@ SdnConnection::SdnConnection (Ptr<NetDevice> device,
   this->set_version (0);
   this->m_applicationData = NULL;
 
-  this->m_lastSendTime = Seconds(0.0);
-  this->m_consecutivePause = 0;
+  this->m_txVersion = 0;
 }
 
 SdnConnection::SdnConnection ()
 : m_sent (0),
   m_recv (0),
+  m_flushes (0),
   m_socket (0),
-  m_device(0)
+  m_device(0),
+  m_rxHead (0),
+  m_rxTail (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -139,8 +165,7 @@ SdnConnection::SdnConnection ()
   this->set_version (0);
   this->m_applicationData = NULL;
 
-  this->m_lastSendTime = Seconds(0.0);
-  this->m_consecutivePause = 0;
+  this->m_txVersion = 0;
 }
 
 SdnConnection::~SdnConnection ()
@@ -230,12 +255,6 @@ SdnConnection::send (void* data, size_t len, uint8_t version )
   return send (packet, version);
 }
 
-void
-SdnConnection::StaggerSend (Ptr<Packet> p, uint8_t version)
-{
-    send (p, version);
-}
-
 uint32_t
 SdnConnection::send (fluid_msg::OFMsg* msg)
 {
@@ -257,55 +276,24 @@ SdnConnection::send (fluid_msg::OFMsg* msg)
 uint32_t
 SdnConnection::send(Ptr<Packet> p, uint8_t version )
 {
-    Time currentTime = Simulator::Now ();
-    Ptr<Packet> copyPacket = p->Copy ();
-
-    RColorTag rcolor;
-    GColorTag gcolor;
-    BColorTag bcolor;
+  NS_LOG_FUNCTION (this << p);
 
-    if (version == 1){
-        rcolor.SetRColorValue(255);
-        copyPacket->AddPacketTag(rcolor);
-        gcolor.SetGColorValue(0);
-        copyPacket->AddPacketTag(gcolor);
-        bcolor.SetBColorValue(255);
-        copyPacket->AddPacketTag(bcolor);
-    }
-    else if (version == 4){
-        rcolor.SetRColorValue(0);
-        copyPacket->AddPacketTag(rcolor);
-        gcolor.SetGColorValue(255);
-        copyPacket->AddPacketTag(gcolor);
-        bcolor.SetBColorValue(255);
-        copyPacket->AddPacketTag(bcolor);
+  if (m_txPacket && version != m_txVersion)
+    {
+      // A batch carries the colors of a single version, the rest of a batch
+      // the socket had no room for keeps them
+      flush ();
     }
-    else{
-        rcolor.SetRColorValue(255);
-        copyPacket->AddPacketTag(rcolor);
-        gcolor.SetGColorValue(255);
-        copyPacket->AddPacketTag(gcolor);
-        bcolor.SetBColorValue(0);
-        copyPacket->AddPacketTag(bcolor);
+  if (!m_txPacket)
+    {
+      m_txPacket = Create<Packet> ();
+      m_txVersion = version;
     }
-
- 
-    if (currentTime == m_lastSendTime)
-      {
-        m_consecutivePause++;
-        Simulator::ScheduleWithContext (m_id, MicroSeconds (m_consecutivePause),
-        	&SdnConnection::StaggerSend, this, copyPacket, version);
-        return copyPacket->GetSize ();
-      }
-    else
-      {
-	NS_LOG_DEBUG ("Sending packet on socket of size " << copyPacket->GetSize ()
-		<<  " from connection id=" << get_id ());
-        m_lastSendTime = Simulator::Now ();
-        m_consecutivePause = 0;
-        ++m_sent;
-        return m_socket->Send(copyPacket);
-      }
+  m_txPacket->AddAtEnd (p);
+  m_txSizes.push_back (p->GetSize ());
+  ++m_sent;
+  ScheduleFlush ();
+  return p->GetSize ();
 }
 
 uint32_t
@@ -324,35 +312,202 @@ SdnConnection::sendOnNetDevice (Ptr<Packet> p)
 
   ++m_sent;
 
-  NS_LOG_DEBUG ("Sending packet on netdevice of size " << p->GetSize() << 
-                " from connection id=" << get_id ());
-
-  Address src, dst;
-  uint16_t protocol_number;
-  Ptr<Packet> pktToSend = filter (p, &src, &dst, &protocol_number);
-  
   NS_ASSERT_MSG (get_device(), "Attempting to send on NetDevice without a NetDevice");
 
-  Time currentTime = Simulator::Now ();
-  if (currentTime == m_lastSendTime)
+  m_txFrames.push_back (p);
+  if (m_txWindow.IsZero ())
     {
-      m_consecutivePause++;
-      Simulator::ScheduleWithContext (m_id, TimeStep (m_consecutivePause),
-	      &SdnConnection::StaggerSendOnNetDevice, this, p);
-      return p->GetSize();
+      // The device queue already takes frames sent back to back in one event as a burst
+      flush ();
     }
   else
     {
-      m_lastSendTime = Simulator::Now ();
-      m_consecutivePause = 0;
-      return get_device()->SendFrom(pktToSend, src, dst, protocol_number);
+      ScheduleFlush ();
+    }
+  return p->GetSize();
+}
+
+void
+SdnConnection::flush ()
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t messages = m_txFrames.size ();
+  uint32_t bytes = 0;
+  if (m_txPacket)
+    {
+      // A TCP socket rejects a whole packet larger than its free buffer, so
+      // only what fits is sent and the rest waits for HandleSend
+      uint32_t size = m_txPacket->GetSize ();
+      uint32_t sent = std::min (size, m_socket->GetTxAvailable ());
+      Ptr<Packet> packet = sent < size ? m_txPacket->CreateFragment (0, sent) : m_txPacket;
+      if (sent > 0)
+        {
+          AddColorTags (packet, m_txVersion);
+          NS_LOG_DEBUG ("Sending " << sent << " of " << size << " queued bytes on socket from connection id="
+                        << get_id ());
+          if (m_socket->Send (packet) < 0)
+            {
+              sent = 0;
+            }
+        }
+      bytes += sent;
+      if (sent == size)
+        {
+          messages += m_txSizes.size ();
+          m_txSizes.clear ();
+          m_txPacket = 0;
+        }
+      else
+        {
+          m_txPacket->RemoveAtStart (sent);
+          while (sent >= m_txSizes.front ())
+            {
+              sent -= m_txSizes.front ();
+              m_txSizes.pop_front ();
+              ++messages;
+            }
+          m_txSizes.front () -= sent;
+          NS_LOG_DEBUG ("Socket full, " << m_txPacket->GetSize () << " bytes left queued on connection id="
+                        << get_id ());
+          m_socket->SetSendCallback (MakeCallback (&SdnConnection::HandleSend, this));
+        }
+    }
+  for (std::vector< Ptr<Packet> >::iterator i = m_txFrames.begin (); i != m_txFrames.end (); ++i)
+    {
+      NS_LOG_DEBUG ("Sending packet on netdevice of size " << (*i)->GetSize() <<
+                    " from connection id=" << get_id ());
+      Address src, dst;
+      uint16_t protocol_number;
+      Ptr<Packet> pktToSend = filter (*i, &src, &dst, &protocol_number);
+      if (pktToSend)
+        {
+          bytes += pktToSend->GetSize ();
+          get_device()->SendFrom(pktToSend, src, dst, protocol_number);
+        }
+    }
+  m_txFrames.clear ();
+  if (messages > 0)
+    {
+      ++m_flushes;
+      m_txFlushTrace (messages, bytes);
+    }
+}
+
+void
+SdnConnection::ScheduleFlush ()
+{
+  if (!m_txFlushEvent.IsRunning ())
+    {
+      m_txFlushEvent = Simulator::Schedule (m_txWindow, &SdnConnection::flush, this);
     }
 }
 
 void
-SdnConnection::StaggerSendOnNetDevice (Ptr<Packet> p)
+SdnConnection::HandleSend (Ptr<Socket> socket, uint32_t available)
 {
-    sendOnNetDevice (p);
+  NS_LOG_FUNCTION (this << socket << available);
+
+  if (m_txPacket && available > 0 && !m_txFlushEvent.IsRunning ())
+    {
+      flush ();
+    }
+}
+
+void
+SdnConnection::AddColorTags (Ptr<Packet> p, uint8_t version)
+{
+  RColorTag rcolor;
+  GColorTag gcolor;
+  BColorTag bcolor;
+
+  if (version == 1){
+      rcolor.SetRColorValue(255);
+      p->AddPacketTag(rcolor);
+      gcolor.SetGColorValue(0);
+      p->AddPacketTag(gcolor);
+      bcolor.SetBColorValue(255);
+      p->AddPacketTag(bcolor);
+  }
+  else if (version == 4){
+      rcolor.SetRColorValue(0);
+      p->AddPacketTag(rcolor);
+      gcolor.SetGColorValue(255);
+      p->AddPacketTag(gcolor);
+      bcolor.SetBColorValue(255);
+      p->AddPacketTag(bcolor);
+  }
+  else{
+      rcolor.SetRColorValue(255);
+      p->AddPacketTag(rcolor);
+      gcolor.SetGColorValue(255);
+      p->AddPacketTag(gcolor);
+      bcolor.SetBColorValue(0);
+      p->AddPacketTag(bcolor);
+  }
+}
+
+void
+SdnConnection::receive (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  uint32_t size = p->GetSize ();
+  if (size == 0)
+    {
+      return;
+    }
+  if (m_rxHead == m_rxTail)
+    {
+      // Everything has been dispatched, start over at the front
+      m_rxHead = m_rxTail = 0;
+    }
+  if (m_rxTail + size > m_rxBuffer.size ())
+    {
+      // Move the partial message left over to the front, then grow if still short
+      if (m_rxHead > 0)
+        {
+          memmove (&m_rxBuffer[0], &m_rxBuffer[m_rxHead], m_rxTail - m_rxHead);
+          m_rxTail -= m_rxHead;
+          m_rxHead = 0;
+        }
+      if (m_rxTail + size > m_rxBuffer.size ())
+        {
+          m_rxBuffer.resize (std::max<size_t> (std::max<size_t> (m_rxTail + size, 2 * m_rxBuffer.size ()),
+                                               SDN_RX_BUFFER_SIZE));
+        }
+    }
+  p->CopyData (&m_rxBuffer[m_rxTail], size);
+  m_rxTail += size;
+}
+
+uint8_t*
+SdnConnection::next_message (uint16_t &length)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t available = m_rxTail - m_rxHead;
+  if (available < OF_HEADER_LENGTH)
+    {
+      return NULL;
+    }
+  uint8_t *data = &m_rxBuffer[m_rxHead];
+  length = (data[2] << 8) | data[3];
+  if (length < OF_HEADER_LENGTH)
+    {
+      // Framing is lost for good, nothing after this header can be trusted
+      NS_LOG_ERROR ("Bad OpenFlow message length " << length << " on connection id=" << get_id ()
+                    << ", dropping " << available << " buffered bytes");
+      m_rxHead = m_rxTail = 0;
+      return NULL;
+    }
+  if (available < length)
+    {
+      return NULL;
+    }
+  m_rxHead += length;
+  ++m_recv;
+  return data;
 }
 
 Ptr<Packet>
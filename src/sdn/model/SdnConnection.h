@@ -28,6 +28,7 @@
 #include "ns3/ethernet-header.h"
 #include "ns3/ethernet-trailer.h"
 #include "ns3/llc-snap-header.h"
+#include "ns3/traced-callback.h"
 
 //NS3 utilities
 #include "ns3/log.h"
@@ -39,10 +40,13 @@
 
 //C++ Libraries
 #include <vector>
+#include <deque>
 #include <map>
 
 //Openflow global definitions
 #define OFVERSION 0x01 //Openflow version 10
+#define OF_HEADER_LENGTH 8 //!< Length of the common OpenFlow header
+#define SDN_RX_BUFFER_SIZE 65536 //!< Initial size of the receive buffer of a connection
 
 namespace ns3 {
 
@@ -176,11 +180,6 @@ public:
   */
   uint32_t send (void* data, size_t len, uint8_t version = 0);
 
-  /**
-  * \brief Stagger sending of packets to account for difference in real time versus simulation time in controller applications
-  * \param p Smart pointer to packet
-  */
-  void StaggerSend (Ptr<Packet> p, uint8_t verion=0);
   /**
   * \brief Send an OFMsg to through the connection/Net Device.
   * \param msg A libfluid defined OFMsg that is predefined
@@ -188,9 +187,10 @@ public:
   */
   uint32_t send (fluid_msg::OFMsg* msg);
   /**
-  * \brief Send an OFMsg to through the connection/Net Device.
-  * \param msg A libfluid defined OFMsg that is predefined
-  * \return Number of bytes sent. See ns3::Socket
+  * \brief Queue a packet for the socket. Everything queued within the coalescing
+  * window goes out in a single socket Send
+  * \param p Smart pointer to packet
+  * \return Number of bytes queued
   */
   uint32_t send (Ptr<Packet> p, uint8_t version = 0);
   /**
@@ -207,10 +207,31 @@ public:
   uint32_t sendOnNetDevice (Ptr<Packet> p);
   
   /**
-  * \brief Stagger sending of packets to account for simultaneous packet sends
-  * \param packet Packet to send
+  * \brief Sends everything in the transmit queue, socket messages as a single Send
+  * and device frames back to back
+  *
+  * The socket takes no more than its free transmit buffer, the rest of the socket
+  * messages stays queued until the socket reports free space again.
   */
-  void StaggerSendOnNetDevice (Ptr<Packet> p);
+  void flush ();
+
+  /**
+   * \brief Appends the bytes of a packet read from the socket to the receive buffer
+   *
+   * The socket delivers a byte stream, so a packet may hold several OpenFlow messages
+   * or only part of one. Complete messages are then taken out with next_message.
+   * \param p Packet read from the socket
+   */
+  void receive (Ptr<Packet> p);
+  /**
+   * \brief Takes the next complete OpenFlow message out of the receive buffer
+   *
+   * Messages are delimited by the length field of their OpenFlow header. The message
+   * is not copied: the returned pointer stays valid until the next call to receive.
+   * \param length Set to the length of the message
+   * \return Pointer to the first byte of the message, NULL if no complete message is buffered
+   */
+  uint8_t* next_message (uint16_t &length);
 
   /**
    * At times, the controller may want switches to send packets that it
@@ -267,6 +288,7 @@ public:
 
   uint32_t m_sent; //!< amount of packets sent on connection
   uint32_t m_recv; //!< amount of packets receieved on connection
+  uint32_t m_flushes; //!< amount of transmit queue flushes on connection
 
 private:
   Ptr<Socket> m_socket; //!< IPv4 Socket
@@ -280,8 +302,30 @@ private:
 
   std::vector< Ptr<SdnTimedCallback> > m_timedCallbacks;
 
-  Time		m_lastSendTime; //!< Last time a packet was sent from this connection
-  uint64_t	m_consecutivePause; //!< Consecutive timestep stagger for simultaneous message sends
+  /**
+   * \brief Marks a socket packet with the color of its OpenFlow version for the visualizer
+   */
+  void AddColorTags (Ptr<Packet> p, uint8_t version);
+  /**
+   * \brief Schedules the flush of the transmit queue at the end of the coalescing window
+   */
+  void ScheduleFlush ();
+  /**
+   * \brief Resumes a flush the transmit buffer of the socket was too small for
+   */
+  void HandleSend (Ptr<Socket> socket, uint32_t available);
+
+  Time m_txWindow; //!< How long messages wait in the transmit queue for later ones
+  Ptr<Packet> m_txPacket; //!< Socket messages queued so far, concatenated
+  std::deque<uint32_t> m_txSizes; //!< Sizes of the messages in m_txPacket, the first one possibly partly sent
+  uint8_t m_txVersion; //!< OpenFlow version of the messages in m_txPacket
+  std::vector< Ptr<Packet> > m_txFrames; //!< Device frames queued so far
+  EventId m_txFlushEvent; //!< Pending flush of the transmit queue
+  TracedCallback<uint32_t, uint32_t> m_txFlushTrace; //!< Messages and bytes of each flush
+
+  std::vector<uint8_t> m_rxBuffer; //!< Bytes received from the socket, not yet dispatched
+  uint32_t m_rxHead; //!< Offset of the first undispatched byte in m_rxBuffer
+  uint32_t m_rxTail; //!< Offset past the last received byte in m_rxBuffer
 };
 
 } // namespace ns3
@@ -17,6 +17,7 @@
  *          Michael Riley <mriley7@gatech.edu>
  */
 
+#include <algorithm>
 #include "SdnController.h"
 #include "ns3/mpi-interface.h"
 
@@ -34,19 +35,43 @@ SdnController::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::SdnController")
     .SetParent<Application> ()
     .AddConstructor<SdnController> ()
+    .AddAttribute ("EventProcessingTime",
+                   "Time the controller spends on each event it hands to the listener. "
+                   "Events are served one batch at a time, so a busy controller delays later batches.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SdnController::m_eventProcessingTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("BatchProcessingTime",
+                   "Fixed time the controller spends on each batch of events, on top of EventProcessingTime.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SdnController::m_batchProcessingTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("Workers",
+                   "Number of threads running SdnListener::event_work, events of one connection "
+                   "always going to the same thread. 0 works on events inline.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SdnController::m_workers),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("EventBatch",
+                     "A batch of events delivered to the listener, with its size and its delay since the read",
+                     MakeTraceSourceAccessor (&SdnController::m_eventBatchTrace))
   ;
   return tid;
 }
 
 SdnController::SdnController (Ptr<SdnListener> listener)
 : ofsc (fluid_base::OFServerSettings ()),
-  event_listener (listener)
+  event_listener (listener),
+  m_unbatched (0),
+  m_workers (0)
 {
   NS_LOG_FUNCTION (this);
 }
 
 SdnController::SdnController ()
-: ofsc (fluid_base::OFServerSettings ())
+: ofsc (fluid_base::OFServerSettings ()),
+  m_unbatched (0),
+  m_workers (0)
 {
   NS_LOG_FUNCTION (this);
   event_listener = CreateObject<BaseLearningSwitch> ();
@@ -62,6 +87,8 @@ SdnController::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
 
+  ClearEvents ();
+
   if (MpiInterface::IsEnabled() && MpiInterface::GetSystemId () != GetNode ()->GetSystemId ())
     {
       std::cerr << MpiInterface::GetSystemId () << " " << GetNode ()->GetSystemId ()
@@ -90,12 +117,20 @@ SdnController::StartApplication (void)
     MakeCallback (&SdnController::HandlePeerClose, this),
     MakeCallback (&SdnController::HandlePeerError, this));
   NS_ASSERT (socket->Listen() == 0);
+
+  if (m_workers > 0)
+    {
+      m_workerPool.Start (m_workers, PeekPointer (event_listener));
+    }
 }
 
 void
 SdnController::StopApplication (void)
 {
   NS_LOG_FUNCTION (this);
+
+  // Jobs already submitted are finished before the threads are joined
+  m_workerPool.Stop ();
 }
 
 void
@@ -149,79 +184,72 @@ SdnController::HandleRead (Ptr<Socket> socket)
                        InetSocketAddress::ConvertFrom (from).GetPort ());
         }
 
-      packet->RemoveAllPacketTags ();
-      packet->RemoveAllByteTags ();
-
       NS_LOG_DEBUG ("Controller recv " << packet->GetSize () << " bytes");
+      c->receive (packet);
 
-      uint8_t buffer[packet->GetSize ()];
-      packet->CopyData (buffer,packet->GetSize ());
-      fluid_msg::OFMsg* message = new fluid_msg::OFMsg (buffer);
-      if (c->get_state () == fluid_base::OFConnection::STATE_HANDSHAKE)
+      // Dispatch every complete message in place, a packet may carry several of them
+      uint8_t* buffer;
+      uint16_t length;
+      while ((buffer = c->next_message (length)))
         {
-          if (ofsc.handshake () && message->type () == fluid_msg::of10::OFPT_HELLO)
+          fluid_msg::OFMsg message (buffer);
+          uint8_t type = buffer[1];
+          if (c->get_state () == fluid_base::OFConnection::STATE_HANDSHAKE)
             {
-              fluid_msg::of10::Hello* helloMessage = new fluid_msg::of10::Hello ();
-              helloMessage->unpack(buffer);
-              
-              if (OFHandle_Hello_Reply (socket, message)) return;
+              if (ofsc.handshake () && type == fluid_msg::of10::OFPT_HELLO)
+                {
+                  if (OFHandle_Hello_Reply (socket, &message))
+                    {
+                      ScheduleBatch ();
+                      return;
+                    }
+                }
+              else if (type == fluid_msg::of10::OFPT_FEATURES_REPLY)
+                {
+                  OFHandle_Features_Reply (socket, &message);
+
+                  // With the connection established, report SwitchUpEvent to the SdnListener.
+                  NS_LOG_INFO( Simulator::Now ().GetSeconds () << " SWITCH_UP_EVENT" );
+                  QueueEvent (c, EVENT_SWITCH_UP, buffer, length);
+                }
+              else
+                {
+                  if ( OFHandle_Errors (socket,
+                                        message.xid(),
+                                        fluid_msg::of10::OFPET_HELLO_FAILED,
+                                        fluid_msg::of10::OFPHFC_INCOMPATIBLE) )
+                    {
+                      ScheduleBatch ();
+                      return;
+                    }
+                }
             }
-          else if (message->type () == fluid_msg::of10::OFPT_FEATURES_REPLY)
+          else if (c->get_state () == fluid_base::OFConnection::STATE_RUNNING)
             {
-              fluid_msg::of10::FeaturesReply* featuresReply = new fluid_msg::of10::FeaturesReply ();
-              featuresReply->unpack(buffer);
-              OFHandle_Features_Reply (socket, featuresReply);
-
-              // With the connection established, report SwitchUpEvent to the SdnListener.
-              NS_LOG_INFO( Simulator::Now ().GetSeconds () << " SWITCH_UP_EVENT" );
-              SwitchUpEvent* sue = new SwitchUpEvent (c, (void*)featuresReply->pack(), featuresReply->length());
-              Simulator::ScheduleNow ( &SdnListener::event_callback, event_listener, sue);
+              if (type == fluid_msg::of10::OFPT_PACKET_IN)
+                {
+                  QueueEvent (c, EVENT_PACKET_IN, buffer, length);
+                }
+              else if (type == fluid_msg::of10::OFPT_FLOW_REMOVED)
+                {
+                  QueueEvent (c, EVENT_FLOW_REMOVED, buffer, length);
+                }
+              else if (type == fluid_msg::of10::OFPT_PORT_STATUS)
+                {
+                  QueueEvent (c, EVENT_PORT_STATUS, buffer, length);
+                }
+              else if (type == fluid_msg::of10::OFPT_STATS_REPLY)
+                {
+                  QueueEvent (c, EVENT_STATS_REPLY, buffer, length);
+                }
             }
           else
             {
-              if ( OFHandle_Errors (socket,
-                                    message->xid(),
-                                    fluid_msg::of10::OFPET_HELLO_FAILED,
-                                    fluid_msg::of10::OFPHFC_INCOMPATIBLE) ) return;
-            }
-        }
-      else if (c->get_state () == fluid_base::OFConnection::STATE_RUNNING)
-        {
-          if (message->type () == fluid_msg::of10::OFPT_PACKET_IN)
-            {
-              fluid_msg::of10::PacketIn* packetIn = new fluid_msg::of10::PacketIn ();
-              packetIn->unpack(buffer);
-              PacketInEvent* pie = new PacketInEvent (c, (void*)packetIn->pack(), packetIn->length());
-              Simulator::ScheduleNow ( &SdnListener::event_callback, event_listener, pie);
-            }
-          else if (message->type () == fluid_msg::of10::OFPT_FLOW_REMOVED)
-            {
-              fluid_msg::of10::FlowRemoved* flowRemoved = new fluid_msg::of10::FlowRemoved ();
-              flowRemoved->unpack(buffer);
-              FlowRemovedEvent* fre = new FlowRemovedEvent (c, (void*)flowRemoved->pack(), flowRemoved->length());
-              Simulator::ScheduleNow ( &SdnListener::event_callback, event_listener, fre);
-            }
-          else if (message->type () == fluid_msg::of10::OFPT_PORT_STATUS)
-            {
-              fluid_msg::of10::PortStatus* portStat = new fluid_msg::of10::PortStatus ();
-              portStat->unpack(buffer);
-              PortStatusEvent* pse = new PortStatusEvent (c, (void*)portStat->pack(), portStat->length());
-              Simulator::ScheduleNow ( &SdnListener::event_callback, event_listener, pse);
-            }
-          else if (message->type () == fluid_msg::of10::OFPT_STATS_REPLY)
-            {
-              fluid_msg::of10::StatsReply* statsReply = new fluid_msg::of10::StatsReply ();
-              statsReply->unpack(buffer);
-              StatsReplyEvent* sre = new StatsReplyEvent (c, (void*)statsReply->pack(), statsReply->length());
-              Simulator::ScheduleNow ( &SdnListener::event_callback, event_listener, sre);
+              c->set_state (fluid_base::OFConnection::STATE_DOWN);
             }
         }
-      else
-        {
-          c->set_state (fluid_base::OFConnection::STATE_DOWN);
-        }
-      delete (message);
     }
+  ScheduleBatch ();
 }
 
 int
@@ -287,4 +315,178 @@ SdnController::NegotiateVersion (fluid_msg::OFMsg* msg)
   return msg->version () == fluid_msg::of10::OFP_VERSION;
 }
 
+/**
+ * Points the data of a pooled event at its storage
+ */
+template <class T>
+static void
+SetEventData (ControllerEvent* event, uint8_t* data, size_t len)
+{
+  T* e = static_cast<T*> (event);
+  e->data = data;
+  e->len = len;
+}
+
+void
+SdnController::QueueEvent (Ptr<SdnConnection> c, uint32_t type, const uint8_t* buffer, uint16_t length)
+{
+  NS_LOG_FUNCTION (this << c << type << length);
+  NS_ASSERT (type < EVENT_TYPES);
+
+  QueuedEvent* queued;
+  std::vector<QueuedEvent*> &pool = m_eventPool[type];
+  if (pool.empty ())
+    {
+      queued = new QueuedEvent;
+      switch (type)
+        {
+        case EVENT_PACKET_IN:
+          queued->event = new PacketInEvent (c, NULL, 0);
+          break;
+        case EVENT_SWITCH_DOWN:
+          queued->event = new SwitchDownEvent (c);
+          break;
+        case EVENT_SWITCH_UP:
+          queued->event = new SwitchUpEvent (c, NULL, 0);
+          break;
+        case EVENT_FLOW_REMOVED:
+          queued->event = new FlowRemovedEvent (c, NULL, 0);
+          break;
+        case EVENT_PORT_STATUS:
+          queued->event = new PortStatusEvent (c, NULL, 0);
+          break;
+        default:
+          queued->event = new StatsReplyEvent (c, NULL, 0);
+          break;
+        }
+    }
+  else
+    {
+      queued = pool.back ();
+      pool.pop_back ();
+      queued->event->ofconn = c;
+    }
+
+  if (buffer)
+    {
+      // Storage only ever grows, so a recycled event rarely allocates
+      queued->storage.assign (buffer, buffer + length);
+      uint8_t* data = &queued->storage[0];
+      switch (type)
+        {
+        case EVENT_PACKET_IN:
+          SetEventData<PacketInEvent> (queued->event, data, length);
+          break;
+        case EVENT_SWITCH_UP:
+          SetEventData<SwitchUpEvent> (queued->event, data, length);
+          break;
+        case EVENT_FLOW_REMOVED:
+          SetEventData<FlowRemovedEvent> (queued->event, data, length);
+          break;
+        case EVENT_PORT_STATUS:
+          SetEventData<PortStatusEvent> (queued->event, data, length);
+          break;
+        case EVENT_STATS_REPLY:
+          SetEventData<StatsReplyEvent> (queued->event, data, length);
+          break;
+        }
+    }
+  queued->done = false;
+  if (m_workerPool.GetSize () > 0)
+    {
+      m_workerPool.Submit (c->get_id (), queued);
+    }
+  m_eventQueue.push_back (queued);
+  m_unbatched++;
+}
+
+void
+SdnController::ScheduleBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_unbatched == 0)
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  Time start = std::max (now, m_busyUntil);
+  m_busyUntil = start + m_batchProcessingTime + m_eventProcessingTime * m_unbatched;
+
+  EventBatch batch;
+  batch.size = m_unbatched;
+  batch.arrival = now;
+  batch.dispatch = Simulator::Schedule (m_busyUntil - now, &SdnController::DispatchBatch, this);
+  m_batches.push_back (batch);
+  m_unbatched = 0;
+}
+
+void
+SdnController::DispatchBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_batches.empty ());
+
+  EventBatch batch = m_batches.front ();
+  m_batches.pop_front ();
+  m_eventBatchTrace (batch.size, Simulator::Now () - batch.arrival);
+
+  m_batch.clear ();
+  for (uint32_t i = 0; i < batch.size; ++i)
+    {
+      QueuedEvent* queued = m_eventQueue[i];
+      if (m_workerPool.GetSize () > 0)
+        {
+          m_workerPool.Wait (queued);
+        }
+      else if (!queued->done)
+        {
+          event_listener->event_work (queued->event);
+          queued->done = true;
+        }
+      m_batch.push_back (queued->event);
+    }
+  event_listener->event_batch_callback (m_batch);
+
+  // Reads only ever append to the queue, the batch is still at its front
+  for (uint32_t i = 0; i < batch.size; ++i)
+    {
+      QueuedEvent* queued = m_eventQueue.front ();
+      m_eventQueue.pop_front ();
+      queued->event->ofconn = 0;
+      queued->event->work_data = NULL;
+      m_eventPool[queued->event->get_type ()].push_back (queued);
+    }
+  m_batch.clear ();
+}
+
+void
+SdnController::ClearEvents (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_workerPool.Stop ();
+  for (std::deque<EventBatch>::iterator i = m_batches.begin (); i != m_batches.end (); ++i)
+    {
+      i->dispatch.Cancel ();
+    }
+  m_batches.clear ();
+  for (std::deque<QueuedEvent*>::iterator i = m_eventQueue.begin (); i != m_eventQueue.end (); ++i)
+    {
+      delete (*i)->event;
+      delete *i;
+    }
+  m_eventQueue.clear ();
+  m_unbatched = 0;
+  for (uint32_t type = 0; type < EVENT_TYPES; ++type)
+    {
+      for (std::vector<QueuedEvent*>::iterator i = m_eventPool[type].begin (); i != m_eventPool[type].end (); ++i)
+        {
+          delete (*i)->event;
+          delete *i;
+        }
+      m_eventPool[type].clear ();
+    }
+}
+
 } // ns3 namespace
@@ -25,6 +25,7 @@
 #include "SdnConnection.h"
 #include "SdnListener.h"
 #include "SdnSwitch.h"
+#include "SdnWorkerPool.h"
 
 //NS3 objects
 #include "ns3/core-module.h"
@@ -58,6 +59,8 @@
 
 //C++ Libraries
 #include <map>
+#include <deque>
+#include <vector>
 
 //Openflow global definitions
 #define OFVERSION 0x01 //Openflow version 10
@@ -125,9 +128,64 @@ private:
    * \return True if versions are compatible, false otherwise
    */
   bool NegotiateVersion (fluid_msg::OFMsg* message);
+  /**
+   * An event waiting in the controller queue, with the storage its data lives in
+   */
+  struct QueuedEvent : public SdnWorkerPool::Job
+  {
+    std::vector<uint8_t> storage; //!< Copy of the message the event data points to
+  };
+  /**
+   * A batch of events decoded from one read
+   */
+  struct EventBatch
+  {
+    uint32_t size;    //!< Number of events, at the front of m_eventQueue
+    Time arrival;     //!< Simulation time the batch was read
+    EventId dispatch; //!< The delivery of the batch to the listener
+  };
+  /**
+   * \brief Appends an event to the batch of the current read
+   *
+   * The event and its storage come from the pool of its type, the message is copied as is,
+   * which is what unpacking and packing it again used to produce.
+   * \param c The connection the message was received on
+   * \param type One of the EVENT_* types
+   * \param buffer The raw OpenFlow message, NULL for events without data
+   * \param length The length of the message
+   */
+  void QueueEvent (Ptr<SdnConnection> c, uint32_t type, const uint8_t* buffer, uint16_t length);
+  /**
+   * \brief Closes the batch of the current read and schedules its delivery
+   *
+   * The controller serves batches one at a time, in order. A batch costs BatchProcessingTime
+   * plus EventProcessingTime per event, and waits for the batches ahead of it to be served.
+   */
+  void ScheduleBatch (void);
+  /**
+   * \brief Delivers the batch at the front of the queue to the listener and recycles its events
+   */
+  void DispatchBatch (void);
+  /**
+   * \brief Joins the worker threads and drops every queued event
+   */
+  void ClearEvents (void);
+
   std::map<Ptr<Socket>, Ptr<SdnConnection> > m_switchMap; //!< A map of socket objects we receive data from to SdnConnections to encapsulate the connection
   fluid_base::OFServerSettings ofsc;
   Ptr<SdnListener> event_listener; //!< The listener that defines the controller behavior when handling most SdnSwitch messages
+
+  Time m_eventProcessingTime; //!< Service time of one event
+  Time m_batchProcessingTime; //!< Fixed service time of a batch
+  Time m_busyUntil;           //!< Time the controller is done serving the batches already scheduled
+  std::deque<QueuedEvent*> m_eventQueue;     //!< Events waiting for delivery, in arrival order
+  std::deque<EventBatch> m_batches;          //!< Scheduled batches, in delivery order
+  uint32_t m_unbatched;                      //!< Events at the back of m_eventQueue not yet in a batch
+  std::vector<QueuedEvent*> m_eventPool[EVENT_TYPES]; //!< Recycled events, by type
+  std::vector<ControllerEvent*> m_batch;     //!< The batch being delivered to the listener
+  TracedCallback<uint32_t, Time> m_eventBatchTrace; //!< Size and read-to-delivery delay of each batch
+  uint32_t m_workers;          //!< Number of worker threads, 0 to work on events inline
+  SdnWorkerPool m_workerPool;  //!< Threads running event_work, started with the application
   
 public:
   /**
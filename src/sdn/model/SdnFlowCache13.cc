@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include "ns3/log.h"
+#include "SdnFlowCache13.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnFlowCache13");
+
+void
+SdnFlowCache13::Entry::Reset (uint64_t gen)
+{
+  generation = gen;
+  lookups.clear ();
+  applied.clear ();
+  outPorts.clear ();
+}
+
+SdnFlowCache13::SdnFlowCache13 ()
+  : m_mask (0),
+    m_generation (1)
+{
+}
+
+void
+SdnFlowCache13::SetSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  uint32_t slots = 0;
+  if (size > 0)
+    {
+      slots = 1;
+      while (slots < size)
+        {
+          slots <<= 1;
+        }
+    }
+  m_entries.clear ();
+  m_entries.resize (slots);
+  for (std::vector<Entry>::iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      i->generation = 0;
+    }
+  m_mask = slots > 0 ? slots - 1 : 0;
+}
+
+uint32_t
+SdnFlowCache13::GetSize (void) const
+{
+  return m_entries.size ();
+}
+
+const SdnFlowCache13::Entry*
+SdnFlowCache13::Find (const SdnFlowKey &key) const
+{
+  if (m_entries.empty ())
+    {
+      return NULL;
+    }
+  const Entry &entry = m_entries[key.Hash () & m_mask];
+  if (entry.generation == m_generation && entry.key.Equals (key))
+    {
+      return &entry;
+    }
+  return NULL;
+}
+
+void
+SdnFlowCache13::Store (Entry &entry)
+{
+  if (m_entries.empty () || entry.generation != m_generation)
+    {
+      return;
+    }
+  Entry &slot = m_entries[entry.key.Hash () & m_mask];
+  slot.generation = entry.generation;
+  slot.key = entry.key;
+  slot.lookups.swap (entry.lookups);
+  slot.applied.swap (entry.applied);
+  slot.outPorts.swap (entry.outPorts);
+}
+
+void
+SdnFlowCache13::Invalidate (void)
+{
+  m_generation++;
+}
+
+uint64_t
+SdnFlowCache13::GetGeneration (void) const
+{
+  return m_generation;
+}
+
+} //End namespace ns3
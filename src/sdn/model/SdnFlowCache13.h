@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_FLOW_CACHE13_H
+#define SDN_FLOW_CACHE13_H
+
+//Stdlib packages
+#include <vector>
+//Sdn classes
+#include "Flow13.h"
+#include "SdnFlowKey.h"
+
+namespace ns3 {
+
+class SdnFlowTable13;
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnFlowCache13
+ *
+ * \brief Exact-match microflow cache sitting in front of the flow tables of an SdnSwitch13
+ *
+ * Each entry remembers, for one packet key (in_port included), what the pipeline did with
+ * it: the flow hit in every table it went through, the ports output by APPLY_ACTIONS on
+ * the way and the ports of the final action set. The next packet with the same key replays
+ * that instead of walking the tables again.
+ *
+ * The cache is direct mapped, a new key simply replaces whatever was in its slot. Entries
+ * are tagged with the generation they were recorded in; any change to the flows, groups or
+ * ports of the switch bumps the generation, which invalidates every entry at once.
+ */
+class SdnFlowCache13
+{
+public:
+  /**
+   * A flow table visited by the cached key, with the flow the key hit in it
+   */
+  struct Lookup
+  {
+    SdnFlowTable13 *table; //!< The visited table
+    Flow13 *flow;          //!< The flow hit in the table, NULL on a table miss
+  };
+  /**
+   * The recorded pipeline outcome of one packet key
+   */
+  struct Entry
+  {
+    uint64_t generation;                           //!< Generation the entry was recorded in, 0 if empty
+    SdnFlowKey key;                                //!< The exact packet key
+    std::vector<Lookup> lookups;                   //!< Tables visited, in order
+    std::vector< std::vector<uint32_t> > applied;  //!< Ports output by each APPLY_ACTIONS, in order
+    std::vector<uint32_t> outPorts;                //!< Ports of the final action set
+    /**
+     * \brief Empties the entry so a new outcome can be recorded in it
+     * \param gen The current generation of the cache
+     */
+    void Reset (uint64_t gen);
+  };
+
+  SdnFlowCache13 ();
+  /**
+   * \brief Resizes the cache, dropping every entry
+   * \param size The number of slots, rounded up to a power of two. 0 disables the cache
+   */
+  void SetSize (uint32_t size);
+  /**
+   * \return The number of slots of the cache
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \brief Looks up a packet key
+   * \param key The key extracted from the packet
+   * \return The valid entry recorded for this exact key, NULL on a miss
+   */
+  const Entry* Find (const SdnFlowKey &key) const;
+  /**
+   * \brief Stores a recorded entry in the slot of its key
+   *
+   * The entry is dropped if the cache was invalidated while it was being recorded.
+   * \param entry The entry to store, its contents are moved into the cache
+   */
+  void Store (Entry &entry);
+  /**
+   * \brief Invalidates every entry
+   */
+  void Invalidate (void);
+  /**
+   * \return The current generation, to pass to Entry::Reset
+   */
+  uint64_t GetGeneration (void) const;
+
+private:
+  std::vector<Entry> m_entries; //!< The slots, indexed by the key hash
+  uint32_t m_mask;              //!< Number of slots minus one
+  uint64_t m_generation;        //!< Current generation, never 0
+};
+
+} //End namespace ns3
+#endif
@@ -0,0 +1,586 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include "SdnFlowKey.h"
+
+namespace ns3 {
+
+// Byte offset and wire length of each OXM basic field inside SdnFlowKey::words.
+// The fields most flows match on (ports, Ethernet, IPv4, L4) sit in the first words.
+static const uint8_t g_fieldOffset[SDN_FLOWKEY_FIELDS] = {
+  0,   // OFPXMT_OFB_IN_PORT
+  4,   // OFPXMT_OFB_IN_PHY_PORT
+  8,   // OFPXMT_OFB_METADATA
+  16,  // OFPXMT_OFB_ETH_DST
+  22,  // OFPXMT_OFB_ETH_SRC
+  28,  // OFPXMT_OFB_ETH_TYPE
+  30,  // OFPXMT_OFB_VLAN_VID
+  32,  // OFPXMT_OFB_VLAN_PCP
+  33,  // OFPXMT_OFB_IP_DSCP
+  34,  // OFPXMT_OFB_IP_ECN
+  35,  // OFPXMT_OFB_IP_PROTO
+  36,  // OFPXMT_OFB_IPV4_SRC
+  40,  // OFPXMT_OFB_IPV4_DST
+  44,  // OFPXMT_OFB_TCP_SRC
+  46,  // OFPXMT_OFB_TCP_DST
+  44,  // OFPXMT_OFB_UDP_SRC
+  46,  // OFPXMT_OFB_UDP_DST
+  44,  // OFPXMT_OFB_SCTP_SRC
+  46,  // OFPXMT_OFB_SCTP_DST
+  48,  // OFPXMT_OFB_ICMPV4_TYPE
+  49,  // OFPXMT_OFB_ICMPV4_CODE
+  50,  // OFPXMT_OFB_ARP_OP
+  52,  // OFPXMT_OFB_ARP_SPA
+  56,  // OFPXMT_OFB_ARP_TPA
+  60,  // OFPXMT_OFB_ARP_SHA
+  66,  // OFPXMT_OFB_ARP_THA
+  72,  // OFPXMT_OFB_IPV6_SRC
+  88,  // OFPXMT_OFB_IPV6_DST
+  104, // OFPXMT_OFB_IPV6_FLABEL
+  108, // OFPXMT_OFB_ICMPV6_TYPE
+  109, // OFPXMT_OFB_ICMPV6_CODE
+  112, // OFPXMT_OFB_IPV6_ND_TARGET
+  128, // OFPXMT_OFB_IPV6_ND_SLL
+  134, // OFPXMT_OFB_IPV6_ND_TLL
+  140, // OFPXMT_OFB_MPLS_LABEL
+  144, // OFPXMT_OFB_MPLS_TC
+  145, // OFPXMT_OFB_MPLS_BOS
+  148, // OFPXMT_OFB_PBB_ISID
+  152, // OFPXMT_OFB_TUNNEL_ID
+  160  // OFPXMT_OFB_IPV6_EXTHDR
+};
+
+static const uint8_t g_fieldLength[SDN_FLOWKEY_FIELDS] = {
+  4, 4, 8, 6, 6, 2, 2, 1, 1, 1,
+  1, 4, 4, 2, 2, 2, 2, 2, 2, 1,
+  1, 2, 4, 4, 6, 6, 16, 16, 4, 1,
+  1, 16, 6, 6, 4, 1, 1, 3, 8, 2
+};
+
+uint8_t
+SdnFlowKey::FieldOffset (uint8_t field)
+{
+  return g_fieldOffset[field];
+}
+
+uint8_t
+SdnFlowKey::FieldLength (uint8_t field)
+{
+  return g_fieldLength[field];
+}
+
+void
+SdnFlowKey::SetField (uint8_t field, const uint8_t *data)
+{
+  memcpy (Bytes () + g_fieldOffset[field], data, g_fieldLength[field]);
+  fields |= (1ULL << field);
+}
+
+void
+SdnFlowKey::SetField8 (uint8_t field, uint8_t value)
+{
+  Bytes ()[g_fieldOffset[field]] = value;
+  fields |= (1ULL << field);
+}
+
+void
+SdnFlowKey::SetField16 (uint8_t field, uint16_t value)
+{
+  uint8_t *data = Bytes () + g_fieldOffset[field];
+  data[0] = value >> 8;
+  data[1] = value & 0xff;
+  fields |= (1ULL << field);
+}
+
+void
+SdnFlowKey::SetField32 (uint8_t field, uint32_t value)
+{
+  // Fields narrower than 32 bits on the wire (PBB_ISID) keep their low-order bytes
+  uint8_t length = g_fieldLength[field];
+  uint8_t *data = Bytes () + g_fieldOffset[field];
+  for (uint8_t i = 0; i < length; ++i)
+    {
+      data[i] = (value >> (8 * (length - 1 - i))) & 0xff;
+    }
+  fields |= (1ULL << field);
+}
+
+void
+SdnFlowKey::SetField64 (uint8_t field, uint64_t value)
+{
+  uint8_t *data = Bytes () + g_fieldOffset[field];
+  for (uint8_t i = 0; i < 8; ++i)
+    {
+      data[i] = (value >> (8 * (7 - i))) & 0xff;
+    }
+  fields |= (1ULL << field);
+}
+
+uint32_t
+SdnFlowKey::GetField32 (uint8_t field) const
+{
+  uint32_t value = 0;
+  const uint8_t *data = Bytes () + g_fieldOffset[field];
+  for (uint8_t i = 0; i < g_fieldLength[field] && i < 4; ++i)
+    {
+      value = (value << 8) | data[i];
+    }
+  return value;
+}
+
+void
+SdnFlowKey::SetIPv4 (uint8_t field, fluid_msg::IPAddress address)
+{
+  uint32_t ip = address.getIPv4 ();
+  SetField (field, (const uint8_t *)&ip);
+}
+
+bool
+SdnFlowKey::MaskRange (const SdnFlowKey &mask, uint8_t &first, uint8_t &last)
+{
+  first = 0;
+  last = 0;
+  bool found = false;
+  for (uint8_t i = 0; i < SDN_FLOWKEY_WORDS; ++i)
+    {
+      if (mask.words[i])
+        {
+          if (!found)
+            {
+              first = i;
+              found = true;
+            }
+          last = i;
+        }
+    }
+  return found;
+}
+
+// Helpers writing one OXM TLV into the value/mask pair. Exact fields get an all-ones mask.
+static void
+CompileInt (uint8_t field, uint64_t fieldValue, uint64_t fieldMask, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  fieldValue &= fieldMask;
+  switch (SdnFlowKey::FieldLength (field))
+    {
+    case 1:
+      value.SetField8 (field, (uint8_t)fieldValue);
+      mask.SetField8 (field, (uint8_t)fieldMask);
+      break;
+    case 2:
+      value.SetField16 (field, (uint16_t)fieldValue);
+      mask.SetField16 (field, (uint16_t)fieldMask);
+      break;
+    case 3:
+    case 4:
+      value.SetField32 (field, (uint32_t)fieldValue);
+      mask.SetField32 (field, (uint32_t)fieldMask);
+      break;
+    default:
+      value.SetField64 (field, fieldValue);
+      mask.SetField64 (field, fieldMask);
+      break;
+    }
+}
+
+template <class T>
+static void
+CompileExactInt (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  CompileInt (tlv->field (), (uint64_t)oxm->value (), ~0ULL, value, mask);
+}
+
+template <class T>
+static void
+CompileMaskedInt (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  uint64_t fieldMask = oxm->has_mask () ? (uint64_t)oxm->mask () : ~0ULL;
+  CompileInt (tlv->field (), (uint64_t)oxm->value (), fieldMask, value, mask);
+}
+
+static void
+CompileBytes (uint8_t field, const uint8_t *data, const uint8_t *bitmask, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  uint8_t bytes[16];
+  uint8_t masks[16];
+  for (uint8_t i = 0; i < SdnFlowKey::FieldLength (field); ++i)
+    {
+      masks[i] = bitmask ? bitmask[i] : 0xff;
+      bytes[i] = data[i] & masks[i];
+    }
+  value.SetField (field, bytes);
+  mask.SetField (field, masks);
+}
+
+template <class T>
+static void
+CompileExactEth (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  fluid_msg::EthAddress address = oxm->value ();
+  CompileBytes (tlv->field (), address.get_data (), NULL, value, mask);
+}
+
+template <class T>
+static void
+CompileMaskedEth (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  fluid_msg::EthAddress address = oxm->value ();
+  if (oxm->has_mask ())
+    {
+      fluid_msg::EthAddress bitmask = oxm->mask ();
+      CompileBytes (tlv->field (), address.get_data (), bitmask.get_data (), value, mask);
+    }
+  else
+    {
+      CompileBytes (tlv->field (), address.get_data (), NULL, value, mask);
+    }
+}
+
+template <class T>
+static void
+CompileMaskedIPv4 (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  // libfluid keeps IPv4 addresses as a uint32_t laid out in network byte order
+  T *oxm = dynamic_cast<T *> (tlv);
+  uint32_t address = oxm->value ().getIPv4 ();
+  if (oxm->has_mask ())
+    {
+      uint32_t bitmask = oxm->mask ().getIPv4 ();
+      CompileBytes (tlv->field (), (const uint8_t *)&address, (const uint8_t *)&bitmask, value, mask);
+    }
+  else
+    {
+      CompileBytes (tlv->field (), (const uint8_t *)&address, NULL, value, mask);
+    }
+}
+
+static void
+CopyIPv6 (fluid_msg::IPAddress address, uint8_t *bytes)
+{
+  for (uint8_t i = 0; i < 16; ++i)
+    {
+      bytes[i] = address.getIPv6 ()[i];
+    }
+}
+
+template <class T>
+static void
+CompileExactIPv6 (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  uint8_t address[16];
+  CopyIPv6 (oxm->value (), address);
+  CompileBytes (tlv->field (), address, NULL, value, mask);
+}
+
+template <class T>
+static void
+CompileMaskedIPv6 (fluid_msg::of13::OXMTLV *tlv, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  T *oxm = dynamic_cast<T *> (tlv);
+  uint8_t address[16];
+  CopyIPv6 (oxm->value (), address);
+  if (oxm->has_mask ())
+    {
+      uint8_t bitmask[16];
+      CopyIPv6 (oxm->mask (), bitmask);
+      CompileBytes (tlv->field (), address, bitmask, value, mask);
+    }
+  else
+    {
+      CompileBytes (tlv->field (), address, NULL, value, mask);
+    }
+}
+
+void
+SdnFlowKey::Compile (fluid_msg::of13::Match &match, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  value.Clear ();
+  mask.Clear ();
+  for (uint8_t field = 0; field < SDN_FLOWKEY_FIELDS; ++field)
+    {
+      fluid_msg::of13::OXMTLV *tlv = match.oxm_field (field);
+      if (!tlv || tlv->class_ () != fluid_msg::of13::OFPXMC_OPENFLOW_BASIC)
+        {
+          continue;
+        }
+      switch (field)
+        {
+        case fluid_msg::of13::OFPXMT_OFB_IN_PORT:
+          CompileExactInt<fluid_msg::of13::InPort> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IN_PHY_PORT:
+          CompileExactInt<fluid_msg::of13::InPhyPort> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_METADATA:
+          CompileMaskedInt<fluid_msg::of13::Metadata> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ETH_DST:
+          CompileMaskedEth<fluid_msg::of13::EthDst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ETH_SRC:
+          CompileMaskedEth<fluid_msg::of13::EthSrc> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ETH_TYPE:
+          CompileExactInt<fluid_msg::of13::EthType> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_VLAN_VID:
+          CompileMaskedInt<fluid_msg::of13::VLANVid> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_VLAN_PCP:
+          CompileExactInt<fluid_msg::of13::VLANPcp> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IP_DSCP:
+          CompileExactInt<fluid_msg::of13::IPDSCP> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IP_ECN:
+          CompileExactInt<fluid_msg::of13::IPECN> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IP_PROTO:
+          CompileExactInt<fluid_msg::of13::IPProto> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV4_SRC:
+          CompileMaskedIPv4<fluid_msg::of13::IPv4Src> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV4_DST:
+          CompileMaskedIPv4<fluid_msg::of13::IPv4Dst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_TCP_SRC:
+          CompileExactInt<fluid_msg::of13::TCPSrc> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_TCP_DST:
+          CompileExactInt<fluid_msg::of13::TCPDst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_UDP_SRC:
+          CompileExactInt<fluid_msg::of13::UDPSrc> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_UDP_DST:
+          CompileExactInt<fluid_msg::of13::UDPDst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_SCTP_SRC:
+          CompileExactInt<fluid_msg::of13::SCTPSrc> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_SCTP_DST:
+          CompileExactInt<fluid_msg::of13::SCTPDst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ICMPV4_TYPE:
+          CompileExactInt<fluid_msg::of13::ICMPv4Type> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ICMPV4_CODE:
+          CompileExactInt<fluid_msg::of13::ICMPv4Code> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ARP_OP:
+          CompileExactInt<fluid_msg::of13::ARPOp> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ARP_SPA:
+          CompileMaskedIPv4<fluid_msg::of13::ARPSPA> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ARP_TPA:
+          CompileMaskedIPv4<fluid_msg::of13::ARPTPA> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ARP_SHA:
+          CompileMaskedEth<fluid_msg::of13::ARPSHA> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ARP_THA:
+          CompileMaskedEth<fluid_msg::of13::ARPTHA> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_SRC:
+          CompileMaskedIPv6<fluid_msg::of13::IPv6Src> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_DST:
+          CompileMaskedIPv6<fluid_msg::of13::IPv6Dst> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_FLABEL:
+          CompileMaskedInt<fluid_msg::of13::IPV6Flabel> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ICMPV6_TYPE:
+          CompileExactInt<fluid_msg::of13::ICMPv6Type> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_ICMPV6_CODE:
+          CompileExactInt<fluid_msg::of13::ICMPv6Code> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_ND_TARGET:
+          CompileExactIPv6<fluid_msg::of13::IPv6NDTarget> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_ND_SLL:
+          CompileExactEth<fluid_msg::of13::IPv6NDSLL> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_ND_TLL:
+          CompileExactEth<fluid_msg::of13::IPv6NDTLL> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_MPLS_LABEL:
+          CompileExactInt<fluid_msg::of13::MPLSLabel> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_MPLS_TC:
+          CompileExactInt<fluid_msg::of13::MPLSTC> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_MPLS_BOS:
+          CompileExactInt<fluid_msg::of13::MPLSBOS> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_PBB_ISID:
+          CompileMaskedInt<fluid_msg::of13::PBBIsid> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_TUNNEL_ID:
+          CompileMaskedInt<fluid_msg::of13::TUNNELId> (tlv, value, mask);
+          break;
+        case fluid_msg::of13::OFPXMT_OFB_IPV6_EXTHDR:
+          CompileMaskedInt<fluid_msg::of13::IPv6Exthdr> (tlv, value, mask);
+          break;
+        default:
+          break;
+        }
+    }
+}
+
+void
+SdnFlowKey::Compile (fluid_msg::of13::Match &match, SdnFlowKey &key)
+{
+  SdnFlowKey mask;
+  Compile (match, key, mask);
+}
+
+void
+SdnFlowKey::ToMatch (fluid_msg::of13::Match &match) const
+{
+  // The values are already in wire format, write them out as an OXM match and let
+  // libfluid parse it instead of building each TLV class by hand
+  uint8_t buffer[4 + 4 * SDN_FLOWKEY_FIELDS + sizeof (words) + 8];
+  uint16_t length = 4;
+  for (uint8_t field = 0; field < SDN_FLOWKEY_FIELDS; ++field)
+    {
+      if (!HasField (field))
+        {
+          continue;
+        }
+      uint8_t fieldLength = g_fieldLength[field];
+      buffer[length] = fluid_msg::of13::OFPXMC_OPENFLOW_BASIC >> 8;
+      buffer[length + 1] = fluid_msg::of13::OFPXMC_OPENFLOW_BASIC & 0xff;
+      buffer[length + 2] = field << 1;
+      buffer[length + 3] = fieldLength;
+      memcpy (buffer + length + 4, Bytes () + g_fieldOffset[field], fieldLength);
+      length += 4 + fieldLength;
+    }
+  buffer[0] = fluid_msg::of13::OFPMT_OXM >> 8;
+  buffer[1] = fluid_msg::of13::OFPMT_OXM & 0xff;
+  buffer[2] = length >> 8;
+  buffer[3] = length & 0xff;
+  memset (buffer + length, 0, (8 - length % 8) % 8);
+  match.unpack (buffer);
+}
+
+// OpenFlow 1.0 fields: the whole field is either exact or wildcarded
+static void
+CompileOf10Int (uint8_t field, uint64_t fieldValue, bool wildcarded, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  CompileInt (field, fieldValue, wildcarded ? 0 : ~0ULL, value, mask);
+}
+
+static void
+CompileOf10Eth (uint8_t field, fluid_msg::EthAddress address, bool wildcarded, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  static const uint8_t none[6] = { 0, 0, 0, 0, 0, 0 };
+  CompileBytes (field, address.get_data (), wildcarded ? none : NULL, value, mask);
+}
+
+static void
+CompileOf10IPv4 (uint8_t field, fluid_msg::IPAddress address, uint32_t wildcardBits, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  // The wildcards hold the number of low-order bits to ignore, 32 and above meaning all of them
+  uint32_t prefix = wildcardBits >= 32 ? 0 : 0xffffffff << wildcardBits;
+  uint8_t bitmask[4];
+  for (uint8_t i = 0; i < 4; ++i)
+    {
+      bitmask[i] = (prefix >> (8 * (3 - i))) & 0xff;
+    }
+  uint32_t ip = address.getIPv4 ();
+  CompileBytes (field, (const uint8_t *)&ip, bitmask, value, mask);
+}
+
+static void
+CompileOf10 (fluid_msg::of10::Match &match, uint32_t wildcards, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  value.Clear ();
+  mask.Clear ();
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_IN_PORT, match.in_port (), wildcards & fluid_msg::of10::OFPFW_IN_PORT, value, mask);
+  CompileOf10Eth (fluid_msg::of13::OFPXMT_OFB_ETH_SRC, match.dl_src (), wildcards & fluid_msg::of10::OFPFW_DL_SRC, value, mask);
+  CompileOf10Eth (fluid_msg::of13::OFPXMT_OFB_ETH_DST, match.dl_dst (), wildcards & fluid_msg::of10::OFPFW_DL_DST, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_VLAN_VID, match.dl_vlan (), wildcards & fluid_msg::of10::OFPFW_DL_VLAN, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_VLAN_PCP, match.dl_vlan_pcp (), wildcards & fluid_msg::of10::OFPFW_DL_VLAN_PCP, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_ETH_TYPE, match.dl_type (), wildcards & fluid_msg::of10::OFPFW_DL_TYPE, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_IP_DSCP, match.nw_tos (), wildcards & fluid_msg::of10::OFPFW_NW_TOS, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_IP_PROTO, match.nw_proto (), wildcards & fluid_msg::of10::OFPFW_NW_PROTO, value, mask);
+  CompileOf10IPv4 (fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, match.nw_src (),
+                   (wildcards & fluid_msg::of10::OFPFW_NW_SRC_MASK) >> fluid_msg::of10::OFPFW_NW_SRC_SHIFT, value, mask);
+  CompileOf10IPv4 (fluid_msg::of13::OFPXMT_OFB_IPV4_DST, match.nw_dst (),
+                   (wildcards & fluid_msg::of10::OFPFW_NW_DST_MASK) >> fluid_msg::of10::OFPFW_NW_DST_SHIFT, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_TCP_SRC, match.tp_src (), wildcards & fluid_msg::of10::OFPFW_TP_SRC, value, mask);
+  CompileOf10Int (fluid_msg::of13::OFPXMT_OFB_TCP_DST, match.tp_dst (), wildcards & fluid_msg::of10::OFPFW_TP_DST, value, mask);
+  // No prerequisites in OpenFlow 1.0, absent packet fields read as zero
+  value.fields = 0;
+  mask.fields = 0;
+}
+
+void
+SdnFlowKey::Compile (fluid_msg::of10::Match &match, SdnFlowKey &value, SdnFlowKey &mask)
+{
+  CompileOf10 (match, match.wildcards (), value, mask);
+}
+
+void
+SdnFlowKey::Compile (fluid_msg::of10::Match &match, SdnFlowKey &key)
+{
+  SdnFlowKey mask;
+  CompileOf10 (match, 0, key, mask);
+}
+
+bool
+SdnFlowMatch::Equals (const SdnFlowMatch &a, const SdnFlowMatch &b)
+{
+  if (a.mask.fields != b.mask.fields || a.first != b.first || a.last != b.last)
+    {
+      return false;
+    }
+  uint64_t diff = 0;
+  for (uint8_t i = a.first; i <= a.last; ++i)
+    {
+      diff |= (a.mask.words[i] ^ b.mask.words[i]) | (a.value.words[i] ^ b.value.words[i]);
+    }
+  return diff == 0;
+}
+
+bool
+SdnFlowMatch::Covers (const SdnFlowMatch &a, const SdnFlowMatch &b)
+{
+  if ((a.mask.fields & ~b.mask.fields) != 0)
+    {
+      return false;
+    }
+  uint64_t diff = 0;
+  for (uint8_t i = a.first; i <= a.last; ++i)
+    {
+      diff |= (a.mask.words[i] & ~b.mask.words[i]) | ((b.value.words[i] & a.mask.words[i]) ^ a.value.words[i]);
+    }
+  return diff == 0;
+}
+
+} //End namespace ns3
@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_FLOW_KEY_H
+#define SDN_FLOW_KEY_H
+
+#include <stdint.h>
+#include <string.h>
+
+//libfluid packages
+#include <fluid/of10/of10match.hh>
+#include <fluid/of13/of13match.hh>
+
+namespace ns3 {
+
+#define SDN_FLOWKEY_FIELDS 40 //!< Number of OpenFlow 1.3 OXM basic fields
+#define SDN_FLOWKEY_WORDS  21 //!< Number of 64-bit words holding the packed field values
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnFlowKey
+ *
+ * \brief Flat, fixed-layout representation of the header fields a flow can match on
+ *
+ * Every OpenFlow 1.3 OXM basic field has a fixed byte offset inside words, where its
+ * value is stored in network byte order, and a bit in fields marking it as present.
+ * A flow is compiled into a value/mask pair of keys, a packet into a single key, so a
+ * lookup reduces to a few masked 64-bit compares over the words covered by the mask.
+ * TCP, UDP and SCTP ports share the same bytes since a packet only carries one of them.
+ */
+struct SdnFlowKey
+{
+  uint64_t fields;                   //!< Bitmap of present fields, bit n is OXM field n
+  uint64_t words[SDN_FLOWKEY_WORDS]; //!< Packed field values in network byte order
+
+  SdnFlowKey ()
+  {
+    Clear ();
+  }
+  /**
+   * \brief Resets the key to an empty one with no fields present
+   */
+  void Clear (void)
+  {
+    memset (this, 0, sizeof (SdnFlowKey));
+  }
+  /**
+   * \brief Raw byte view of the packed field values
+   * \return Pointer to the first byte of words
+   */
+  uint8_t* Bytes (void)
+  {
+    return reinterpret_cast<uint8_t *> (words);
+  }
+  const uint8_t* Bytes (void) const
+  {
+    return reinterpret_cast<const uint8_t *> (words);
+  }
+  /**
+   * \brief Checks whether a field is present in the key
+   * \param field The OXM field id
+   * \return True if the field has been set
+   */
+  bool HasField (uint8_t field) const
+  {
+    return (fields & (1ULL << field)) != 0;
+  }
+  /**
+   * \brief Stores a field in the key and marks it as present
+   * \param field The OXM field id
+   * \param data FieldLength (field) bytes in network byte order
+   */
+  void SetField (uint8_t field, const uint8_t *data);
+  void SetField8 (uint8_t field, uint8_t value);
+  void SetField16 (uint8_t field, uint16_t value);
+  void SetField32 (uint8_t field, uint32_t value);
+  void SetField64 (uint8_t field, uint64_t value);
+  /**
+   * \brief Reads a field of at most 32 bits
+   * \param field The OXM field id
+   * \return The value in host byte order
+   */
+  uint32_t GetField32 (uint8_t field) const;
+  /**
+   * \brief Stores an IPv4 address as libfluid holds it, already in network byte order
+   * \param field The OXM field id, IPV4_SRC, IPV4_DST, ARP_SPA or ARP_TPA
+   * \param address The address, from a match or a set field action
+   */
+  void SetIPv4 (uint8_t field, fluid_msg::IPAddress address);
+  /**
+   * \brief Byte offset of a field inside words
+   * \param field The OXM field id
+   * \return The offset in bytes
+   */
+  static uint8_t FieldOffset (uint8_t field);
+  /**
+   * \brief Length of a field as it appears on the wire
+   * \param field The OXM field id
+   * \return The length in bytes
+   */
+  static uint8_t FieldLength (uint8_t field);
+  /**
+   * \brief Compiles a libfluid match into a value/mask pair of keys
+   *
+   * The mask has all bits of an exact field set and the OXM mask of a masked field,
+   * the value is already and-ed with the mask. Both carry the same fields bitmap.
+   * \param match The libfluid match to compile
+   * \param value The key receiving the field values
+   * \param mask The key receiving the field masks
+   */
+  static void Compile (fluid_msg::of13::Match &match, SdnFlowKey &value, SdnFlowKey &mask);
+  /**
+   * \brief Compiles the fields of a packet match, every present field being exact
+   * \param match The libfluid match built from the packet
+   * \param key The key receiving the field values
+   */
+  static void Compile (fluid_msg::of13::Match &match, SdnFlowKey &key);
+  /**
+   * \brief Builds the libfluid match of a packet key, every present field being exact
+   *
+   * Used for the match of a PacketIn, so the packet does not need parsing again.
+   * \param match The match receiving one OXM field per field present in the key
+   */
+  void ToMatch (fluid_msg::of13::Match &match) const;
+  /**
+   * \brief Compiles an OpenFlow 1.0 match into a value/mask pair of keys
+   *
+   * OpenFlow 1.0 fields are stored in the slots of their OXM counterparts (nw_tos in
+   * IP_DSCP, tp_src/tp_dst in the shared L4 port slots). OpenFlow 1.0 has no field
+   * prerequisites, so no field bit is set and a wildcarded field simply has a zero mask.
+   * \param match The libfluid match to compile
+   * \param value The key receiving the field values
+   * \param mask The key receiving the field masks
+   */
+  static void Compile (fluid_msg::of10::Match &match, SdnFlowKey &value, SdnFlowKey &mask);
+  /**
+   * \brief Compiles the fields of an OpenFlow 1.0 packet match, ignoring its wildcards
+   * \param match The libfluid match built from the packet
+   * \param key The key receiving the field values
+   */
+  static void Compile (fluid_msg::of10::Match &match, SdnFlowKey &key);
+  /**
+   * \brief Hashes the key bits selected by a mask
+   * \param mask The mask selecting which bits contribute
+   * \param first First word of the mask with bits set
+   * \param last Last word of the mask with bits set
+   * \return A 32-bit hash of (key & mask) over [first, last]
+   */
+  uint32_t MaskedHash (const SdnFlowKey &mask, uint8_t first, uint8_t last) const
+  {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint8_t i = first; i <= last; ++i)
+      {
+        hash ^= words[i] & mask.words[i];
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+      }
+    return (uint32_t)(hash ^ (hash >> 32));
+  }
+  /**
+   * \brief Hashes the whole key, present fields bitmap included
+   * \return A 32-bit hash of every word of the key
+   */
+  uint32_t Hash (void) const
+  {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ fields;
+    for (uint8_t i = 0; i < SDN_FLOWKEY_WORDS; ++i)
+      {
+        hash ^= words[i];
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+      }
+    return (uint32_t)(hash ^ (hash >> 32));
+  }
+  /**
+   * \brief Compares two keys field for field
+   * \param other The key to compare with
+   * \return True if both keys have the same fields and values
+   */
+  bool Equals (const SdnFlowKey &other) const
+  {
+    uint64_t diff = fields ^ other.fields;
+    for (uint8_t i = 0; i < SDN_FLOWKEY_WORDS; ++i)
+      {
+        diff |= words[i] ^ other.words[i];
+      }
+    return diff == 0;
+  }
+  /**
+   * \brief Compares the key against a masked value over a word range
+   * \param value A key already and-ed with mask
+   * \param mask The mask selecting which bits are compared
+   * \param first First word of the mask with bits set
+   * \param last Last word of the mask with bits set
+   * \return True if (key & mask) == value over [first, last]
+   */
+  bool MaskedEquals (const SdnFlowKey &value, const SdnFlowKey &mask, uint8_t first, uint8_t last) const
+  {
+    uint64_t diff = 0;
+    for (uint8_t i = first; i <= last; ++i)
+      {
+        diff |= (words[i] & mask.words[i]) ^ value.words[i];
+      }
+    return diff == 0;
+  }
+  /**
+   * \brief Finds the range of words a mask has bits set in
+   * \param mask The mask to inspect
+   * \param first Set to the first non-zero word
+   * \param last Set to the last non-zero word
+   * \return False if the mask is all zero (a table-miss style wildcard)
+   */
+  static bool MaskRange (const SdnFlowKey &mask, uint8_t &first, uint8_t &last);
+};
+
+/**
+ * \ingroup sdn
+ *
+ * \brief The match of an installed flow, compiled once into a value/mask pair of keys
+ *
+ * Matching a packet or comparing two flows then only takes masked word compares over
+ * the words the mask covers.
+ */
+struct SdnFlowMatch
+{
+  SdnFlowKey value; //!< Field values, already and-ed with mask
+  SdnFlowKey mask;  //!< Field masks, a set bit must match
+  uint8_t first;    //!< First word of mask with bits set
+  uint8_t last;     //!< Last word of mask with bits set
+
+  SdnFlowMatch ()
+    : first (0),
+      last (0)
+  {
+  }
+  /**
+   * \brief Compiles a libfluid match
+   * \param match The OpenFlow 1.3 match to compile
+   */
+  void Compile (fluid_msg::of13::Match &match)
+  {
+    SdnFlowKey::Compile (match, value, mask);
+    SdnFlowKey::MaskRange (mask, first, last);
+  }
+  /**
+   * \brief Compiles a libfluid match
+   * \param match The OpenFlow 1.0 match to compile
+   */
+  void Compile (fluid_msg::of10::Match &match)
+  {
+    SdnFlowKey::Compile (match, value, mask);
+    SdnFlowKey::MaskRange (mask, first, last);
+  }
+  /**
+   * \brief Checks a packet key against the match
+   * \param key The packet key
+   * \return True if every field of the match is present in the key and matches
+   */
+  bool Matches (const SdnFlowKey &key) const
+  {
+    return (mask.fields & ~key.fields) == 0 && key.MaskedEquals (value, mask, first, last);
+  }
+  /**
+   * \brief Strict comparison, used by OFPFC_*_STRICT and overlap checks
+   * \return True if both matches have the same fields, masks and values
+   */
+  static bool Equals (const SdnFlowMatch &a, const SdnFlowMatch &b);
+  /**
+   * \brief Non-strict comparison
+   * \return True if every packet matched by b is also matched by a, that is every
+   * field of a is in b with a mask no wider than b's and the same masked value
+   */
+  static bool Covers (const SdnFlowMatch &a, const SdnFlowMatch &b);
+  /**
+   * \brief Hashes the compiled match, consistent with Equals
+   * \return A 32-bit hash of the value and mask
+   */
+  uint32_t Hash (void) const
+  {
+    return value.Hash () ^ (mask.Hash () * 0x9e3779b1U);
+  }
+};
+
+} //End namespace ns3
+#endif
@@ -19,10 +19,31 @@
 
 #include "SdnFlowTable.h"
 #include "SdnSwitch.h"
+#include "SdnPacketParser.h"
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("SdnFlowTable");
 
+/**
+ * \return True if the packet of an OpenFlow 1.0 key is IPv4, the only one nw_* actions apply to
+ */
+static bool
+IsIpv4 (const SdnFlowKey &key)
+{
+  const uint8_t *type = key.Bytes () + SdnFlowKey::FieldOffset (fluid_msg::of13::OFPXMT_OFB_ETH_TYPE);
+  return type[0] == 0x08 && type[1] == 0x00;
+}
+
+/**
+ * \return True if the packet of an OpenFlow 1.0 key has TCP or UDP ports, the only ones tp_* actions apply to
+ */
+static bool
+HasPorts (const SdnFlowKey &key)
+{
+  uint8_t proto = key.Bytes ()[SdnFlowKey::FieldOffset (fluid_msg::of13::OFPXMT_OFB_IP_PROTO)];
+  return IsIpv4 (key) && (proto == 6 || proto == 17);
+}
+
 SdnFlowTable::SdnFlowTable (Ptr<SdnSwitch> parentSwitch)
 {
   m_parentSwitch = parentSwitch;
@@ -43,16 +64,17 @@ SdnFlowTable::flows ()
 std::vector<uint16_t>
 SdnFlowTable::handlePacket (Ptr<Packet> pkt, uint16_t inPort)
 {
-  DestructHeader (pkt);
-  fluid_msg::of10::Match inputFields = getPacketFields (inPort);
-  std::set<Flow, cmp_priority>::iterator flow_rule = m_flow_table_rules.begin ();
+  SdnFlowKey extracted;
+  SdnPacketParser::ExtractOf10 (pkt, inPort, extracted);
+  // Flows match on the fields the packet came in with, set field actions edit this copy
+  SdnFlowKey key = extracted;
   std::vector<uint16_t> outPorts;
   for (std::set<Flow, cmp_priority>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
     {
       m_lookup_count++;
-      Flow tempFlow = *i;
-      if (Flow::pkt_match (tempFlow,inputFields))
+      if (Flow::pkt_match (*i,extracted))
         {
+          Flow tempFlow = *i;
           m_matched_count++;
           tempFlow.packet_count_++;
           tempFlow.byte_count_ += pkt->GetSize ();
@@ -62,12 +84,12 @@ SdnFlowTable::handlePacket (Ptr<Packet> pkt, uint16_t inPort)
               fluid_msg::Action* action = *j;
               if (action->type () == fluid_msg::of10::OFPAT_OUTPUT)
                 {
-                  uint16_t outPort = handleAction (pkt,action);
+                  uint16_t outPort = handleAction (pkt,action,key);
                   outPorts.push_back(outPort);
                 }
               else
                 {
-                  handleAction (pkt,action);
+                  handleAction (pkt,action,key);
                 }
             }
           if (tempFlow.idle_timeout_ != 0)
@@ -77,84 +99,21 @@ SdnFlowTable::handlePacket (Ptr<Packet> pkt, uint16_t inPort)
             }
         }
     }
-  RestructHeader (pkt);
+  SdnPacketParser::RewriteOf10 (pkt, extracted, key);
   return outPorts;
 }
 
-//Need to rewrite to make header objects that serialize the iterator, then use their attributes.
-fluid_msg::of10::Match
-SdnFlowTable::getPacketFields (uint16_t inPort)
-{
-  fluid_msg::of10::Match match;
-  match.in_port (inPort);
-  if (!m_tcpHeader.isEmpty) //TCP case
-    {
-      match.tp_src (m_tcpHeader.header.GetSourcePort ());
-      match.tp_dst (m_tcpHeader.header.GetDestinationPort ());
-    }
-  if (!m_udpHeader.isEmpty) //UDP case
-    {
-      match.tp_src (m_udpHeader.header.GetSourcePort ());
-      match.tp_dst (m_udpHeader.header.GetDestinationPort ());
-    }
-  if (!m_ipv4Header.isEmpty) //IPv4 case
-    {
-      match.nw_tos (m_ipv4Header.header.GetTos ()); //zero out the last 2 bits that are ignored by the ToS
-      if (!match.nw_proto ())
-        {
-          match.nw_proto (m_ipv4Header.header.GetProtocol ());
-        }
-      match.nw_src (fluid_msg::IPAddress (m_ipv4Header.header.GetSource ().Get ()));
-      match.nw_dst (fluid_msg::IPAddress (m_ipv4Header.header.GetDestination ().Get ()));
-
-      if ((m_ipv4Header.header.GetProtocol () == 1) && (!m_icmpv4Header.isEmpty))
-	{
-	  match.tp_src (m_icmpv4Header.header.GetType ());
-	  match.tp_dst (m_icmpv4Header.header.GetCode ());
-	}
-    }
-  if (!m_ipv6Header.isEmpty) //IPv6 case
-    {
-      uint8_t sourceBuffer[16];
-      m_ipv6Header.header.GetSourceAddress ().GetBytes (sourceBuffer);
-      match.nw_src (fluid_msg::IPAddress (sourceBuffer));
-      uint8_t destinationBuffer[16];
-      m_ipv6Header.header.GetDestinationAddress ().GetBytes (destinationBuffer);
-      match.nw_dst (fluid_msg::IPAddress (destinationBuffer));
-    }
-  if (!m_arpHeader.isEmpty) //Arp case
-    {
-      match.nw_proto ((uint8_t)(m_arpHeader.header.IsRequest () ? ArpHeader::ARP_TYPE_REQUEST : ArpHeader::ARP_TYPE_REPLY));
-
-      match.nw_src (fluid_msg::IPAddress (m_arpHeader.header.GetSourceIpv4Address ().Get ()));
-      match.nw_dst (fluid_msg::IPAddress (m_arpHeader.header.GetDestinationIpv4Address ().Get ()));
-    }
-  if (!m_ethHeader.isEmpty) //IPv6 case
-    {
-      uint8_t srcAddr[6];
-      m_ethHeader.header.GetSource ().CopyTo (srcAddr);
-      uint8_t dstAddr[6];
-      m_ethHeader.header.GetDestination ().CopyTo (dstAddr);
-      match.dl_src (fluid_msg::EthAddress (srcAddr));
-      match.dl_dst (fluid_msg::EthAddress (dstAddr));
-      match.dl_type(m_ethHeader.header.GetLengthType ());
-
-      //No VLAN header accessor yet
-      match.dl_vlan (0);
-    }
-  return match;
-}
-
 std::vector<Flow>
 SdnFlowTable::matchingFlows (fluid_msg::of10::Match match)
 {
   std::vector<Flow> matchingFlows;
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
   for (std::set<Flow, cmp_priority>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
     {
-      Flow tempFlow = *i;
-      if (Flow::pkt_match (tempFlow,match))
+      if (Flow::pkt_match (*i,key))
         {
-          matchingFlows.push_back (tempFlow);
+          matchingFlows.push_back (*i);
         }
     }
   return matchingFlows;
@@ -163,7 +122,7 @@ SdnFlowTable::matchingFlows (fluid_msg::of10::Match match)
 //ACTION HANDLERS
 
 uint16_t
-SdnFlowTable::handleAction (Ptr<Packet> pkt,fluid_msg::Action* action)
+SdnFlowTable::handleAction (Ptr<Packet> pkt,fluid_msg::Action* action,SdnFlowKey &key)
 {
   uint16_t outPort = fluid_msg::of10::OFPP_NONE;
   switch ((uint32_t)action->type ())
@@ -177,61 +136,61 @@ SdnFlowTable::handleAction (Ptr<Packet> pkt,fluid_msg::Action* action)
     case fluid_msg::of10::OFPAT_SET_VLAN_VID:
       {
         fluid_msg::of10::SetVLANVIDAction* specAction = (fluid_msg::of10::SetVLANVIDAction*)action;
-        handleSetVlanIDAction (pkt,specAction);
+        handleSetVlanIDAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_VLAN_PCP:
       {
         fluid_msg::of10::SetVLANPCPAction* specAction = (fluid_msg::of10::SetVLANPCPAction*)action;
-        handleSetVlanPCPAction (pkt,specAction);
+        handleSetVlanPCPAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_STRIP_VLAN:
       {
         fluid_msg::of10::StripVLANAction* specAction = (fluid_msg::of10::StripVLANAction*)action;
-        handleStripVLANAction (pkt,specAction);
+        handleStripVLANAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_DL_SRC:
       {
         fluid_msg::of10::SetDLSrcAction* specAction = (fluid_msg::of10::SetDLSrcAction*)action;
-        handleSetDLSrcAction (pkt,specAction);
+        handleSetDLSrcAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_DL_DST:
       {
         fluid_msg::of10::SetDLDstAction* specAction = (fluid_msg::of10::SetDLDstAction*)action;
-        handleSetDLDstAction (pkt,specAction);
+        handleSetDLDstAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_NW_SRC:
       {
         fluid_msg::of10::SetNWSrcAction* specAction = (fluid_msg::of10::SetNWSrcAction*)action;
-        handleSetNWSrcAction (pkt,specAction);
+        handleSetNWSrcAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_NW_DST:
       {
         fluid_msg::of10::SetNWDstAction* specAction = (fluid_msg::of10::SetNWDstAction*)action;
-        handleSetNWDstAction (pkt,specAction);
+        handleSetNWDstAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_NW_TOS:
       {
         fluid_msg::of10::SetNWTOSAction* specAction = (fluid_msg::of10::SetNWTOSAction*)action;
-        handleSetNWTOSAction (pkt,specAction);
+        handleSetNWTOSAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_TP_SRC:
       {
         fluid_msg::of10::SetTPSrcAction* specAction = (fluid_msg::of10::SetTPSrcAction*)action;
-        handleSetTPSrcAction (pkt,specAction);
+        handleSetTPSrcAction (key,specAction);
         break;
       }
     case fluid_msg::of10::OFPAT_SET_TP_DST:
       {
         fluid_msg::of10::SetTPDstAction* specAction = (fluid_msg::of10::SetTPDstAction*)action;
-        handleSetTPDstAction (pkt,specAction);
+        handleSetTPDstAction (key,specAction);
         break;
       }
     }
@@ -249,206 +208,78 @@ SdnFlowTable::handleOutputAction (Ptr<Packet> pkt,fluid_msg::of10::OutputAction*
 }
 
 void
-SdnFlowTable::handleSetVlanIDAction (Ptr<Packet>pkt,fluid_msg::of10::SetVLANVIDAction* action)
+SdnFlowTable::handleSetVlanIDAction (SdnFlowKey &key,fluid_msg::of10::SetVLANVIDAction* action)
 {
   //
 }
 
 void
-SdnFlowTable::handleSetVlanPCPAction (Ptr<Packet>pkt,fluid_msg::of10::SetVLANPCPAction* action)
+SdnFlowTable::handleSetVlanPCPAction (SdnFlowKey &key,fluid_msg::of10::SetVLANPCPAction* action)
 {
   //
 }
 
 void
-SdnFlowTable::handleStripVLANAction (Ptr<Packet>pkt,fluid_msg::of10::StripVLANAction* action)
+SdnFlowTable::handleStripVLANAction (SdnFlowKey &key,fluid_msg::of10::StripVLANAction* action)
 {
   //
 }
 
 void
-SdnFlowTable::handleSetDLSrcAction (Ptr<Packet>pkt,fluid_msg::of10::SetDLSrcAction* action)
+SdnFlowTable::handleSetDLSrcAction (SdnFlowKey &key,fluid_msg::of10::SetDLSrcAction* action)
 {
-  m_ethHeader.header.SetSource (Mac48Address (action->dl_addr ().to_string ().c_str ()));
+  key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_SRC, action->dl_addr ().get_data ());
 }
 
 void
-SdnFlowTable::handleSetDLDstAction (Ptr<Packet>pkt,fluid_msg::of10::SetDLDstAction* action)
+SdnFlowTable::handleSetDLDstAction (SdnFlowKey &key,fluid_msg::of10::SetDLDstAction* action)
 {
-  m_ethHeader.header.SetDestination (Mac48Address (action->dl_addr ().to_string ().c_str ()));
+  key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_DST, action->dl_addr ().get_data ());
 }
 
 void
-SdnFlowTable::handleSetNWSrcAction (Ptr<Packet>pkt,fluid_msg::of10::SetNWSrcAction* action)
+SdnFlowTable::handleSetNWSrcAction (SdnFlowKey &key,fluid_msg::of10::SetNWSrcAction* action)
 {
-  if (!m_ipv4Header.isEmpty)
-    {
-      m_ipv4Header.header.SetSource (Ipv4Address (action->nw_addr ().getIPv4 ()));
-    }
-  if (!m_ipv6Header.isEmpty)
+  if (IsIpv4 (key))
     {
-      m_ipv6Header.header.SetSourceAddress (Ipv6Address (action->nw_addr ().getIPv6 ()));
+      key.SetIPv4 (fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, action->nw_addr ());
     }
 }
 
 void
-SdnFlowTable::handleSetNWDstAction (Ptr<Packet>pkt,fluid_msg::of10::SetNWDstAction* action)
+SdnFlowTable::handleSetNWDstAction (SdnFlowKey &key,fluid_msg::of10::SetNWDstAction* action)
 {
-  if (!m_ipv4Header.isEmpty)
-    {
-      m_ipv4Header.header.SetDestination (Ipv4Address (action->nw_addr ().getIPv4 ()));
-    }
-  if (!m_ipv6Header.isEmpty)
+  if (IsIpv4 (key))
     {
-      m_ipv6Header.header.SetDestinationAddress (Ipv6Address (action->nw_addr ().getIPv6 ()));
+      key.SetIPv4 (fluid_msg::of13::OFPXMT_OFB_IPV4_DST, action->nw_addr ());
     }
 }
 
 void
-SdnFlowTable::handleSetNWTOSAction (Ptr<Packet>pkt,fluid_msg::of10::SetNWTOSAction* action)
+SdnFlowTable::handleSetNWTOSAction (SdnFlowKey &key,fluid_msg::of10::SetNWTOSAction* action)
 {
-  if (!m_ipv4Header.isEmpty)
+  if (IsIpv4 (key))
     {
-      m_ipv4Header.header.SetTos (action->nw_tos ());
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_DSCP, action->nw_tos () & 0xfc);
     }
 }
 
 void
-SdnFlowTable::handleSetTPSrcAction (Ptr<Packet>pkt,fluid_msg::of10::SetTPSrcAction* action)
+SdnFlowTable::handleSetTPSrcAction (SdnFlowKey &key,fluid_msg::of10::SetTPSrcAction* action)
 {
-  if (!m_tcpHeader.isEmpty)
+  if (HasPorts (key))
     {
-      m_tcpHeader.header.SetSourcePort (action->tp_port ()); //Seems broken here. Check the fluid_msg action
-    }
-  if (!m_udpHeader.isEmpty)
-    {
-      m_udpHeader.header.SetSourcePort (action->tp_port ()); //Seems broken here. Check the fluid_msg action
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_SRC, action->tp_port ());
     }
 }
 
 void
-SdnFlowTable::handleSetTPDstAction (Ptr<Packet>pkt,fluid_msg::of10::SetTPDstAction* action)
-{
-  if (!m_tcpHeader.isEmpty)
-    {
-      m_tcpHeader.header.SetDestinationPort (action->tp_port ()); //Seems broken here. Check the fluid_msg action
-    }
-  if (!m_udpHeader.isEmpty)
-    {
-      m_udpHeader.header.SetDestinationPort (action->tp_port ()); //Seems broken here. Check the fluid_msg action
-    }
-}
-
-//Utility methods to deconstruct/reconstruct headers
-Ptr<Packet>
-SdnFlowTable::DestructHeader (Ptr<Packet> pkt)
+SdnFlowTable::handleSetTPDstAction (SdnFlowKey &key,fluid_msg::of10::SetTPDstAction* action)
 {
-  PacketMetadata metadata (pkt->GetUid (),pkt->GetSize ());
-  PacketMetadata::ItemIterator iterator = pkt->BeginItem ();
-  PacketMetadata::Item item;
-  while (iterator.HasNext ())
-    {
-      item = iterator.Next ();
-      if (item.type != PacketMetadata::Item::HEADER)
-        {
-          continue;
-        }
-      else if (item.tid.GetName () == "ns3::TcpHeader" && pkt->PeekHeader (m_tcpHeader.header))
-        {
-          pkt->RemoveHeader (m_tcpHeader.header);
-          m_tcpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::UdpHeader" && pkt->PeekHeader (m_udpHeader.header))
-        {
-          pkt->RemoveHeader (m_udpHeader.header);
-          m_udpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv4Header" && pkt->PeekHeader (m_ipv4Header.header))
-        {
-          pkt->RemoveHeader (m_ipv4Header.header);
-          m_ipv4Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Icmpv4Header" && pkt->PeekHeader (m_icmpv4Header.header))
-        {
-          pkt->RemoveHeader (m_icmpv4Header.header);
-          m_icmpv4Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv6Header" && pkt->PeekHeader (m_ipv6Header.header))
-        {
-          pkt->RemoveHeader (m_ipv6Header.header);
-          m_ipv6Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Icmpv6Header" && pkt->PeekHeader (m_icmpv6Header.header))
-        {
-          pkt->RemoveHeader (m_icmpv6Header.header);
-          m_icmpv6Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::ArpHeader"  && pkt->PeekHeader (m_arpHeader.header))
-        {
-          pkt->RemoveHeader (m_arpHeader.header);
-          m_arpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::EthernetHeader" && pkt->PeekHeader (m_ethHeader.header))
-        {
-          pkt->RemoveHeader (m_ethHeader.header);
-          m_ethHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::LlcSnapHeader")
-        {
-        }
-    }
-  return pkt;
-}
-
-//Does the opposite, re-adds the headers we need
-void
-SdnFlowTable::RestructHeader (Ptr<Packet> pkt)
-{
-  if (!m_udpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_udpHeader.header);
-    }
-  if (!m_tcpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_tcpHeader.header);
-    }
-  if (!m_icmpv6Header.isEmpty)
-    {
-      pkt->AddHeader (m_icmpv6Header.header);
-    }
-  if (!m_icmpv4Header.isEmpty)
-    {
-      pkt->AddHeader (m_icmpv4Header.header);
-    }
-  if (!m_ipv6Header.isEmpty)
-    {
-      pkt->AddHeader (m_ipv6Header.header);
-    }
-  if (!m_ipv4Header.isEmpty)
-    {
-      pkt->AddHeader (m_ipv4Header.header);
-    }
-  if (!m_arpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_arpHeader.header);
-    }
-  if (!m_ethHeader.isEmpty)
+  if (HasPorts (key))
     {
-      pkt->AddHeader (m_ethHeader.header);
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_DST, action->tp_port ());
     }
-  //Clear out headers so they're useful for the next read
-  m_ethHeader.header = EthernetHeader ();
-  m_ethHeader.isEmpty = true;
-  m_ipv4Header.header = Ipv4Header ();
-  m_ipv4Header.isEmpty = true;
-  m_ipv6Header.header = Ipv6Header ();
-  m_ipv6Header.isEmpty = true;
-  m_arpHeader.header = ArpHeader ();
-  m_arpHeader.isEmpty = true;
-  m_tcpHeader.header = TcpHeader ();
-  m_tcpHeader.isEmpty = true;
-  m_udpHeader.header = UdpHeader ();
-  m_udpHeader.isEmpty = true;
 }
 
 fluid_msg::of10::TableStats*
@@ -489,8 +320,7 @@ SdnFlowTable::addFlow (fluid_msg::of10::FlowMod* message)
 
   newFlow.match = message->match ();
   newFlow.match.dl_vlan (0); // Hack since ns-3 doesn't currently support VLAN
-  newFlow.nw_src_mask = 0xFFFFFFF >> (32 - ((newFlow.match.wildcards () & fluid_msg::of10::OFPFW_NW_SRC_MASK) >> fluid_msg::of10::OFPFW_NW_SRC_SHIFT) - 1);
-  newFlow.nw_dst_mask = 0xFFFFFFF >> (32 - ((newFlow.match.wildcards () & fluid_msg::of10::OFPFW_NW_DST_MASK) >> fluid_msg::of10::OFPFW_NW_DST_SHIFT) - 1);
+  newFlow.compileMatch ();
   newFlow.actions = message->actions ();
 
   if ((message->flags () & fluid_msg::of10::OFPFF_CHECK_OVERLAP) && conflictingEntry (newFlow))
@@ -514,10 +344,13 @@ Flow
 SdnFlowTable::modifyFlow (fluid_msg::of10::FlowMod* message)
 {
   NS_LOG_DEBUG ("Modifying flow on switch at time" << Simulator::Now ().GetSeconds ());
+  fluid_msg::of10::Match match = message->match ();
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
   for (std::set<Flow, cmp_priority>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
     {
       Flow flow = *i;
-      if (flow.priority_ == message->priority () && Flow::pkt_match (flow,message->match ()))
+      if (flow.priority_ == message->priority () && Flow::pkt_match (flow,key))
         {
           flow.actions = message->actions ();
           flow.cookie_ = message->cookie ();
@@ -541,10 +374,13 @@ void
 SdnFlowTable::deleteFlow (fluid_msg::of10::FlowMod* message)
 {
   NS_LOG_DEBUG ("Deleting flow on switch at time" << Simulator::Now ().GetSeconds ());
+  fluid_msg::of10::Match match = message->match ();
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
   for (std::set<Flow, cmp_priority>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
     {
       Flow flow = *i;
-      if (flow.priority_ == message->priority () && Flow::pkt_match (flow,message->match ()))
+      if (flow.priority_ == message->priority () && Flow::pkt_match (flow,key))
         {
           if (flow.idle_timeout_ != 0)
             {
@@ -100,11 +100,15 @@ public:
   fluid_msg::of10::TableStats* convertToTableStats();
   /**
    * \brief Applies an action to a packet. Main entry point to other more specific action handlers
+   *
+   * Set field actions only edit the key, SdnPacketParser::RewriteOf10 writes the edited
+   * fields into the packet once all the actions have been applied.
    * \param pkt The packet to modify
-   * \action The action to apply to the packet
+   * \param action The action to apply to the packet
+   * \param key The key of the packet, holding the edits of the previous actions
    * \return An outport if one is set. OFPP_NONE otherwise
    */
-  uint16_t handleAction(Ptr<Packet> pkt,fluid_msg::Action* action);
+  uint16_t handleAction(Ptr<Packet> pkt,fluid_msg::Action* action,SdnFlowKey &key);
   /**
    * \brief Finds a vector of flows in the table that will match to this specific match
    * \param match The match object that describes what we're looking for from the flows
@@ -151,22 +155,6 @@ private:
   std::set<Flow, cmp_priority> m_flow_table_rules; //!< The actual set of all flows in the flow table. Sorted by priority
   uint8_t m_tableid;                               //!< Unique ID for flow tables
   uint32_t m_wildcards;                            //!< Wildcard rules for matches to ignore. NOT IMPLEMENTED
-  template <class T> struct TempHeader { TempHeader() : isEmpty(true), header() {} bool isEmpty = true; T header; };
-  TempHeader<EthernetHeader>  m_ethHeader;         //!< Private EthernetHeader for grabbing information out of the packet
-  TempHeader<Ipv4Header> m_ipv4Header;             //!< Private Ipv4Header for grabbing information out of the packet
-  TempHeader<Icmpv4Header> m_icmpv4Header;         //!< Private Icmpv4Header for grabbing information out of the packet
-  TempHeader<Ipv6Header> m_ipv6Header;             //!< Private Ipv6Header for grabbing information out of the packet
-  TempHeader<Icmpv6Header> m_icmpv6Header;         //!< Private Icmpv6Header for grabbing information out of the packet
-  TempHeader<ArpHeader>  m_arpHeader;              //!< Private ArpHeader for grabbing information out of the packet
-  TempHeader<TcpHeader>  m_tcpHeader;              //!< Private TcpHeader for grabbing information out of the packet
-  TempHeader<UdpHeader>  m_udpHeader;              //!< Private UdpHeader for grabbing information out of the packet
-  /**
-   * \brief Creates a match object from the tempheader information 
-   * \param inPort This field needs to go in the match in addition to the packet fields, but it is not
-   * 			readily available from the packet information.
-   * \return A match object matching whatever information could be discerned from the current packet
-   */
-  fluid_msg::of10::Match getPacketFields (uint16_t inPort);
   /**
    * \brief Action handler for an output action
    * \param pkt The packet being modified from the action
@@ -175,75 +163,64 @@ private:
   uint16_t handleOutputAction (Ptr<Packet> pkt,fluid_msg::of10::OutputAction*    action);
   /**
    * \brief Action handler for a Set VLAN ID action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set VLAN ID action being executed
    */
-  void handleSetVlanIDAction (Ptr<Packet>pkt,fluid_msg::of10::SetVLANVIDAction* action);
+  void handleSetVlanIDAction (SdnFlowKey &key,fluid_msg::of10::SetVLANVIDAction* action);
   /**
    * \brief Action handler for a Set VLAN PCP action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set VLAN PC action being executed
    */
-  void handleSetVlanPCPAction (Ptr<Packet>pkt,fluid_msg::of10::SetVLANPCPAction* action);
+  void handleSetVlanPCPAction (SdnFlowKey &key,fluid_msg::of10::SetVLANPCPAction* action);
   /**
    * \brief Action handler for a Strip VLAN action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Strip VLAN action being executed
    */
-  void handleStripVLANAction (Ptr<Packet>pkt,fluid_msg::of10::StripVLANAction*  action);
+  void handleStripVLANAction (SdnFlowKey &key,fluid_msg::of10::StripVLANAction*  action);
   /**
    * \brief Action handler for a Set DL Source action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set DL Source action being executed
    */
-  void handleSetDLSrcAction  (Ptr<Packet>pkt,fluid_msg::of10::SetDLSrcAction*   action);
+  void handleSetDLSrcAction  (SdnFlowKey &key,fluid_msg::of10::SetDLSrcAction*   action);
   /**
    * \brief Action handler for a Set DL Destination action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set DL Destination action being executed
    */
-  void handleSetDLDstAction  (Ptr<Packet>pkt,fluid_msg::of10::SetDLDstAction*   action);
+  void handleSetDLDstAction  (SdnFlowKey &key,fluid_msg::of10::SetDLDstAction*   action);
   /**
    * \brief Action handler for a Set Network Source action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set Network Source action being executed
    */
-  void handleSetNWSrcAction  (Ptr<Packet>pkt,fluid_msg::of10::SetNWSrcAction*   action);
+  void handleSetNWSrcAction  (SdnFlowKey &key,fluid_msg::of10::SetNWSrcAction*   action);
   /**
    * \brief Action handler for a Set Network Destination action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set Network Destination action being executed
    */
-  void handleSetNWDstAction  (Ptr<Packet>pkt,fluid_msg::of10::SetNWDstAction*   action);
+  void handleSetNWDstAction  (SdnFlowKey &key,fluid_msg::of10::SetNWDstAction*   action);
   /**
    * \brief Action handler for a Set Network Terms Of Service action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set Network Terms Of Service action being executed
    */
-  void handleSetNWTOSAction  (Ptr<Packet>pkt,fluid_msg::of10::SetNWTOSAction*   action);
+  void handleSetNWTOSAction  (SdnFlowKey &key,fluid_msg::of10::SetNWTOSAction*   action);
   /**
    * \brief Action handler for a Set Transport Source action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set Transport Source action being executed
    */
-  void handleSetTPSrcAction  (Ptr<Packet>pkt,fluid_msg::of10::SetTPSrcAction*   action);
+  void handleSetTPSrcAction  (SdnFlowKey &key,fluid_msg::of10::SetTPSrcAction*   action);
   /**
    * \brief Action handler for a Set Transport Destination action
-   * \param pkt The packet being modified from the action
+   * \param key The key of the packet being modified from the action
    * \param action The Set Transport Destination action being executed
    */
-  void handleSetTPDstAction  (Ptr<Packet>pkt,fluid_msg::of10::SetTPDstAction*   action);
-  /**
-   * \brief Removes the TempHeaders from an actual packet so we can use them for analysis
-   * \param pkt The packet containing the headers we're interested in
-   * \return The Packet with the relevant headers removed
-   */
-  Ptr<Packet> DestructHeader (Ptr<Packet> pkt);
-  /**
-   * \brief Add the TempHeaders back onto a packet. Should always be called soon after DestructHeader
-   * \param pkt The destructed packet ready to be reconstructed
-   */
-  void RestructHeader (Ptr<Packet> pkt);
+  void handleSetTPDstAction  (SdnFlowKey &key,fluid_msg::of10::SetTPDstAction*   action);
   /**
    * \brief Idle Time Out Event hook. Gets invoked whenever a flow has reached it's idle time without any activity.
    */
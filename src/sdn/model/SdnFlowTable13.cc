@@ -17,8 +17,10 @@
  *          Michael Riley <mriley7@gatech.edu>
  */
 
+#include <algorithm>
 #include "SdnFlowTable13.h"
 #include "SdnSwitch13.h"
+#include "SdnPacketParser.h"
 
 namespace ns3 {
 
@@ -37,6 +39,17 @@ TypeId SdnFlowTable13::GetTypeId (void)
   return tid;
 }
 
+SdnFlowTable13::SdnFlowTable13 ()
+{
+  m_max_entries = 0;
+  m_active_count = 0;
+  m_lookup_count = 0;
+  m_matched_count = 0;
+  m_tableid = 0;
+  m_flowHead = NULL;
+  m_classifier = CreateObject<SdnTupleSpaceClassifier13> ();
+}
+
 SdnFlowTable13::SdnFlowTable13 (Ptr<SdnSwitch13> parentSwitch)
 {
   m_parentSwitch = parentSwitch;
@@ -45,6 +58,16 @@ SdnFlowTable13::SdnFlowTable13 (Ptr<SdnSwitch13> parentSwitch)
   m_lookup_count = 0;
   m_matched_count = 0;
   m_tableid = 0;
+  m_flowHead = NULL;
+  m_classifier = CreateObject<SdnTupleSpaceClassifier13> ();
+}
+
+SdnFlowTable13::~SdnFlowTable13 ()
+{
+  for (std::vector<Flow13*>::iterator i = m_flowPool.begin (); i != m_flowPool.end (); ++i)
+    {
+      delete *i;
+    }
 }
 
 Ptr<SdnFlowTable13>
@@ -61,252 +84,189 @@ SdnFlowTable13::addTablesForNewSwitch(Ptr<SdnSwitch13> parent)
 	return g_flowTables[datapathId].at(0);
 }
 
-std::set<Flow13, cmp_priority13>
+std::vector<Flow13*>
 SdnFlowTable13::flows ()
 {
-  return m_flow_table_rules;
+  std::vector<Flow13*> flows;
+  for (Flow13 *flow = m_flowHead; flow != NULL; flow = flow->next_)
+    {
+      flows.push_back (flow);
+    }
+  return flows;
 }
 
-//Returns the out port. If not, return OFPP_NONE
-fluid_msg::ActionSet*
-SdnFlowTable13::handlePacket (Ptr<Packet> pkt, fluid_msg::ActionSet *action_set, uint32_t inPort)
+Flow13*
+SdnFlowTable13::findFlow (uint64_t flowId)
 {
-  DestructHeader (pkt);
-  fluid_msg::of13::Match inputFields = getPacketFields (inPort);
-  std::set<Flow13, cmp_priority13>::iterator flow_rule = m_flow_table_rules.begin ();
-  std::vector<uint32_t> outPorts;
-  for (std::set<Flow13, cmp_priority13>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
+  uint32_t slot = (uint32_t)flowId;
+  if (slot >= m_flowPool.size () || (uint32_t)(flowId >> 32) != m_flowGenerations[slot]
+      || m_flowPool[slot]->id_ != flowId)
     {
-      m_lookup_count++;
-      Flow13 tempFlow = *i;
-      if (Flow13::pkt_match (tempFlow,inputFields))
-        {
-          m_matched_count++;
-          tempFlow.packet_count_++;
-          tempFlow.byte_count_ += pkt->GetSize ();
-          std::set<fluid_msg::of13::Instruction*, fluid_msg::of13::comp_inst_set_order> instruction_list = tempFlow.instructions.instruction_set ();
-          for (std::set<fluid_msg::of13::Instruction*, fluid_msg::of13::comp_inst_set_order>::iterator j = instruction_list.begin ();
-        		  j != instruction_list.end (); j++)
-          {
-        	  fluid_msg::of13::Instruction* instruction = *j;
-        	  // Required by OpenFlow 1.3.0
-        	  if (instruction->type () == fluid_msg::of13::OFPIT_GOTO_TABLE)
-        	  {
-        		  // Try the next specified table
-        		  fluid_msg::of13::GoToTable *gotoTable = dynamic_cast<fluid_msg::of13::GoToTable *> (instruction);
-        		  return g_flowTables[m_parentSwitch->getDatapathID()].at(gotoTable->table_id ())->handlePacket(pkt, action_set, inPort);
-        	  }
-        	  // Required by OpenFlow 1.3.0
-        	  else if (instruction->type () == fluid_msg::of13::OFPIT_WRITE_ACTIONS)
-        	  {
-        		  fluid_msg::of13::WriteActions *writeAction = dynamic_cast<fluid_msg::of13::WriteActions *> (instruction);
-        		  fluid_msg::ActionSet newActionSet = writeAction->actions();
-        		  for (std::set<fluid_msg::Action*, fluid_msg::comp_action_set_order>::iterator k = newActionSet.action_set ().begin ();
-        				  k != newActionSet.action_set ().end (); k++)
-				  {
-        			  fluid_msg::Action* action = *k;
-        			  action_set->add_action(action);
-				  }
-        	  }
-        	  // Additional instructions are optional for OpenFlow 1.3.0
-        	  else if (instruction->type () == fluid_msg::of13::OFPIT_METER)
-        	  {
-
-        	  }
-        	  else if (instruction->type () == fluid_msg::of13::OFPIT_APPLY_ACTIONS)
-        	  {
-        		  RestructHeader(pkt);
-        		  fluid_msg::of13::ApplyActions* applyAction = dynamic_cast<fluid_msg::of13::ApplyActions*> (instruction);
-        		  fluid_msg::ActionList actions(applyAction->actions());
-                  std::vector<uint32_t> outPorts = handleActions(pkt, &actions);
-
-                  if (!outPorts.empty())
-                  {
-                	  m_parentSwitch->HandlePorts (pkt, outPorts, inPort);
-                  }
-                  DestructHeader(pkt);
-        	  }
-        	  else if (instruction->type () == fluid_msg::of13::OFPIT_CLEAR_ACTIONS)
-        	  {
-
-        	  }
-        	  else if (instruction->type () == fluid_msg::of13::OFPIT_WRITE_METADATA)
-        	  {
-
-        	  }
-
-          }
-          if (tempFlow.idle_timeout_ != 0)
-            {
-              tempFlow.idle_timeout_event.Cancel ();
-              tempFlow.idle_timeout_event = Simulator::Schedule (Seconds (tempFlow.idle_timeout_),&SdnFlowTable13::IdleTimeOutEvent,this,tempFlow);
-            }
-        }
+      return NULL;
     }
-  RestructHeader (pkt);
-  return action_set;
+  return m_flowPool[slot];
 }
 
-//Need to rewrite to make header objects that serialize the iterator, then use their attributes.
-fluid_msg::of13::Match
-SdnFlowTable13::getPacketFields (uint32_t inPort)
+Flow13*
+SdnFlowTable13::allocateFlow (void)
 {
- 	 fluid_msg::of13::Match match;
- 
- 	  fluid_msg::of13::InPort *InPort_oxmtlv = dynamic_cast<fluid_msg::of13::InPort *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IN_PORT));
- 	  InPort_oxmtlv->value(inPort);
- 	  match.add_oxm_field(InPort_oxmtlv);
-
-	  fluid_msg::of13::InPhyPort *InPhyPort_oxmtlv = dynamic_cast<fluid_msg::of13::InPhyPort *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IN_PHY_PORT));
-	  InPhyPort_oxmtlv->value(inPort);
-	  match.add_oxm_field(InPhyPort_oxmtlv);
- 
- 	  if (!m_tcpHeader.isEmpty) //TCP case
- 	    {
- 	      fluid_msg::of13::TCPDst *Dst_oxmtlv = dynamic_cast<fluid_msg::of13::TCPDst *>(fluid_msg::of13::Match::make_oxm_tlv (fluid_msg::of13::OFPXMT_OFB_TCP_DST));
- 	      Dst_oxmtlv -> value(m_tcpHeader.header.GetDestinationPort());
- 	      match.add_oxm_field(Dst_oxmtlv);
- 
- 	      fluid_msg::of13::TCPSrc *Src_oxmtlv = dynamic_cast<fluid_msg::of13::TCPSrc *>(fluid_msg::of13::Match::make_oxm_tlv (fluid_msg::of13::OFPXMT_OFB_TCP_SRC));
- 	      Src_oxmtlv -> value(m_tcpHeader.header.GetSourcePort());
- 	      match.add_oxm_field(Src_oxmtlv);
- 	    }
- 	  if (!m_udpHeader.isEmpty) //UDP case
- 	    {
- 	      fluid_msg::of13::UDPDst *Dst_oxmtlv = dynamic_cast<fluid_msg::of13::UDPDst *>(fluid_msg::of13::Match::make_oxm_tlv (fluid_msg::of13::OFPXMT_OFB_UDP_DST));
- 	      Dst_oxmtlv -> value(m_udpHeader.header.GetDestinationPort());
- 	      match.add_oxm_field(Dst_oxmtlv);
- 
- 	      fluid_msg::of13::UDPSrc *Src_oxmtlv = dynamic_cast<fluid_msg::of13::UDPSrc *>(fluid_msg::of13::Match::make_oxm_tlv (fluid_msg::of13::OFPXMT_OFB_UDP_SRC));
- 	      Src_oxmtlv -> value(m_udpHeader.header.GetSourcePort());
- 	      match.add_oxm_field(Src_oxmtlv);
- 	    }
- 
- 	  if (!m_ipv4Header.isEmpty) //IPv4 case
- 	    {
- 		  fluid_msg::of13::IPDSCP *Dscp_oxmtlv = dynamic_cast<fluid_msg::of13::IPDSCP *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IP_DSCP));
- 		  Dscp_oxmtlv->value(m_ipv4Header.header.GetDscp());
- 		  match.add_oxm_field(Dscp_oxmtlv);
- 
- 		  fluid_msg::of13::IPECN *Ecn_oxmtlv = dynamic_cast<fluid_msg::of13::IPECN *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IP_ECN));
- 		  Ecn_oxmtlv->value(m_ipv4Header.header.GetEcn());
- 		  match.add_oxm_field(Ecn_oxmtlv);
- 
- 	      if (!match.ip_proto ())
- 	        {
- 	    	  fluid_msg::of13::IPProto *IPpro_oxmtlv = dynamic_cast<fluid_msg::of13::IPProto *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IP_PROTO));
- 	    	  Ecn_oxmtlv->value(m_ipv4Header.header.GetProtocol());
- 	    	  match.add_oxm_field(IPpro_oxmtlv);
- 	        }
- 
- 		  fluid_msg::of13::IPv4Src *Src_oxmtlv = dynamic_cast<fluid_msg::of13::IPv4Src *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IPV4_SRC));
- 		  Src_oxmtlv->value(m_ipv4Header.header.GetSource().Get());
- 		  match.add_oxm_field(Src_oxmtlv);
- 
- 		  fluid_msg::of13::IPv4Dst *Dst_oxmtlv = dynamic_cast<fluid_msg::of13::IPv4Dst *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IPV4_DST));
- 		  Dst_oxmtlv->value(fluid_msg::IPAddress(m_ipv4Header.header.GetDestination().Get()));
- 		  match.add_oxm_field(Dst_oxmtlv);
- 
- 
- 	      if ((m_ipv4Header.header.GetProtocol () == 1) && (!m_icmpv4Header.isEmpty))
- 		    {
- 	    	  fluid_msg::of13::ICMPv4Type *Type_oxmtlv = dynamic_cast<fluid_msg::of13::ICMPv4Type *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ICMPV4_TYPE));
- 	    	  Type_oxmtlv->value(m_icmpv4Header.header.GetType ());
- 	    	  match.add_oxm_field(Type_oxmtlv);
- 
- 	    	  fluid_msg::of13::ICMPv4Code *Code_oxmtlv = dynamic_cast<fluid_msg::of13::ICMPv4Code *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ICMPV4_CODE));
- 	    	  Type_oxmtlv->value(m_icmpv4Header.header.GetCode ());
- 	    	  match.add_oxm_field(Code_oxmtlv);
- 		    }
- 	    }
- 	  if (!m_ipv6Header.isEmpty) //IPv6 case
- 	    {
- 	      uint8_t sourceBuffer[16];
- 	      m_ipv6Header.header.GetSourceAddress ().GetBytes (sourceBuffer);
- 		  fluid_msg::of13::IPv6Src *Src_oxmtlv = dynamic_cast<fluid_msg::of13::IPv6Src *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IPV6_SRC));
- 		  Src_oxmtlv->value(fluid_msg::IPAddress(sourceBuffer));
- 		  match.add_oxm_field(Src_oxmtlv);
- 
- 	      uint8_t destinationBuffer[16];
- 	      m_ipv6Header.header.GetDestinationAddress ().GetBytes (destinationBuffer);
- 		  fluid_msg::of13::IPv6Dst *Dst_oxmtlv = dynamic_cast<fluid_msg::of13::IPv6Dst *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IPV6_DST));
- 		  Dst_oxmtlv->value(fluid_msg::IPAddress(destinationBuffer));
- 		  match.add_oxm_field(Dst_oxmtlv);
- 
- 		  fluid_msg::of13::IPV6Flabel *Flabel_oxmtlv = dynamic_cast<fluid_msg::of13::IPV6Flabel *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_IPV6_FLABEL));
- 		  Flabel_oxmtlv->value(m_ipv6Header.header.GetFlowLabel());
- 		  match.add_oxm_field(Flabel_oxmtlv);
- 	    }
- 	  if (!m_arpHeader.isEmpty) //Arp case
- 	    {
- 
- 		  fluid_msg::of13::ARPOp *Op_oxmtlv = dynamic_cast<fluid_msg::of13::ARPOp *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ARP_OP));
- 		  Op_oxmtlv->value((uint16_t)m_arpHeader.header.IsRequest () ? ArpHeader::ARP_TYPE_REQUEST: ArpHeader::ARP_TYPE_REPLY);
- 		  match.add_oxm_field(Op_oxmtlv); //????
- 
- 	      //match.nw_proto ((uint8_t)(m_arpHeader.header.IsRequest () ? ArpHeader::ARP_TYPE_REQUEST : ArpHeader::ARP_TYPE_REPLY));
- 
- 		  fluid_msg::of13::ARPSPA *SPA_oxmtlv = dynamic_cast<fluid_msg::of13::ARPSPA *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ARP_SPA));
- 		  SPA_oxmtlv->value(fluid_msg::IPAddress(m_arpHeader.header.GetSourceIpv4Address().Get()));
- 		  match.add_oxm_field(SPA_oxmtlv);
- 
- 		  fluid_msg::of13::ARPTPA *TPA_oxmtlv = dynamic_cast<fluid_msg::of13::ARPTPA *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ARP_TPA));
- 		  TPA_oxmtlv->value(fluid_msg::IPAddress(m_arpHeader.header.GetDestinationIpv4Address().Get()));
- 		  match.add_oxm_field(TPA_oxmtlv);
- 
- 		  uint8_t srcAddr[6];
- 		  m_arpHeader.header.GetSourceHardwareAddress().CopyTo(srcAddr);
- 		  fluid_msg::of13::ARPSHA *SHA_oxmtlv = dynamic_cast<fluid_msg::of13::ARPSHA *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ARP_SHA));
- 		  SHA_oxmtlv->value(fluid_msg::EthAddress(srcAddr));
- 		  match.add_oxm_field(SHA_oxmtlv);
- 
- 		  uint8_t dstAddr[6];
- 		  m_arpHeader.header.GetDestinationHardwareAddress().CopyTo(dstAddr);
- 		  fluid_msg::of13::ARPTHA *THA_oxmtlv = dynamic_cast<fluid_msg::of13::ARPTHA *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ARP_THA));
- 		  THA_oxmtlv->value(fluid_msg::EthAddress(dstAddr));
- 		  match.add_oxm_field(THA_oxmtlv);
- 
- 	    }
- 	  if (!m_ethHeader.isEmpty) //Ethernet case
- 	    {
- 	      uint8_t srcAddr[6];
- 	      m_ethHeader.header.GetSource ().CopyTo (srcAddr);
- 	      uint8_t dstAddr[6];
- 	      m_ethHeader.header.GetDestination ().CopyTo (dstAddr);
- 
- 		  fluid_msg::of13::EthSrc *Src_oxmtlv = dynamic_cast<fluid_msg::of13::EthSrc *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ETH_SRC));
- 		  Src_oxmtlv->value(fluid_msg::EthAddress(srcAddr));
- 		  match.add_oxm_field(Src_oxmtlv);
- 
- 		  fluid_msg::of13::EthDst *Dst_oxmtlv = dynamic_cast<fluid_msg::of13::EthDst *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ETH_DST));
- 		  Dst_oxmtlv->value(fluid_msg::EthAddress(dstAddr));
- 		  match.add_oxm_field(Dst_oxmtlv);
- 
- 		  fluid_msg::of13::EthType *Type_oxmtlv = dynamic_cast<fluid_msg::of13::EthType *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_ETH_TYPE));
- 		  Type_oxmtlv->value(m_ethHeader.header.GetLengthType ());
- 		  match.add_oxm_field(Type_oxmtlv);
- 
- 	      //No VLAN header accessor yet
- 		  fluid_msg::of13::VLANVid *Vid_oxmtlv = dynamic_cast<fluid_msg::of13::VLANVid *>(fluid_msg::of13::Match::make_oxm_tlv(fluid_msg::of13::OFPXMT_OFB_VLAN_VID));
- 		  Vid_oxmtlv->value(0);
- 		  match.add_oxm_field(Vid_oxmtlv);
- 	    }
- 	  return match;
+  uint32_t slot;
+  if (m_freeFlowSlots.empty ())
+    {
+      slot = m_flowPool.size ();
+      m_flowPool.push_back (new Flow13 ());
+      m_flowGenerations.push_back (1);
+    }
+  else
+    {
+      slot = m_freeFlowSlots.back ();
+      m_freeFlowSlots.pop_back ();
+      *m_flowPool[slot] = Flow13 ();
+    }
+  Flow13 *flow = m_flowPool[slot];
+  flow->id_ = ((uint64_t)m_flowGenerations[slot] << 32) | slot;
+  return flow;
 }
 
-std::vector<Flow13>
-SdnFlowTable13::matchingFlows (fluid_msg::of13::Match match)
+void
+SdnFlowTable13::linkFlow (Flow13 *flow)
 {
-  std::vector<Flow13> matchingFlows;
-  for (std::set<Flow13, cmp_priority13>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
+  // Goes after the last flow of the same priority, or else of the closest higher priority
+  std::map<uint16_t, Flow13*>::iterator tail = m_priorityTails.lower_bound (flow->priority_);
+  Flow13 *prev = NULL;
+  if (tail != m_priorityTails.end ())
     {
-      Flow13 tempFlow = *i;
-      if (Flow13::pkt_match (tempFlow,match))
-        {
-          matchingFlows.push_back (tempFlow);
-        }
+      prev = tail->second;
+    }
+  flow->prev_ = prev;
+  flow->next_ = prev ? prev->next_ : m_flowHead;
+  if (flow->next_)
+    {
+      flow->next_->prev_ = flow;
+    }
+  if (prev)
+    {
+      prev->next_ = flow;
+    }
+  else
+    {
+      m_flowHead = flow;
+    }
+  m_priorityTails[flow->priority_] = flow;
+}
+
+void
+SdnFlowTable13::SetClassifierType (ClassifierType type)
+{
+  if (type == LINEAR_CLASSIFIER)
+    {
+      m_classifier = CreateObject<SdnLinearClassifier13> ();
+    }
+  else
+    {
+      m_classifier = CreateObject<SdnTupleSpaceClassifier13> ();
+    }
+  // The priority index keeps equal priority flows oldest first, which preserves their tie order
+  for (Flow13 *flow = m_flowHead; flow != NULL; flow = flow->next_)
+    {
+      m_classifier->Insert (flow);
+    }
+}
+
+void
+SdnFlowTable13::recordLookup (Flow13 *flow, Ptr<Packet> pkt)
+{
+  m_lookup_count++;
+  if (flow == NULL)
+    {
+      return;
     }
-  return matchingFlows;
+  m_matched_count++;
+  flow->packet_count_++;
+  flow->byte_count_ += pkt->GetSize ();
+  // The timeout wheel reads this when the idle timer comes due, nothing to reschedule here
+  flow->last_used_nsec = Simulator::Now ().GetNanoSeconds ();
+}
+
+//Returns the out port. If not, return OFPP_NONE
+fluid_msg::ActionSet*
+SdnFlowTable13::handlePacket (Ptr<Packet> pkt, fluid_msg::ActionSet *action_set, uint32_t inPort,
+                              const SdnFlowKey &key, SdnFlowCache13::Entry *record)
+{
+  Flow13 *match = m_classifier->Lookup (key);
+  recordLookup (match, pkt);
+  if (record)
+    {
+      SdnFlowCache13::Lookup lookup = { this, match };
+      record->lookups.push_back (lookup);
+    }
+  if (match == NULL)
+    {
+      return action_set;
+    }
+
+  std::set<fluid_msg::of13::Instruction*, fluid_msg::of13::comp_inst_set_order> instruction_list = match->instructions.instruction_set ();
+  for (std::set<fluid_msg::of13::Instruction*, fluid_msg::of13::comp_inst_set_order>::iterator j = instruction_list.begin ();
+		  j != instruction_list.end (); j++)
+  {
+	  fluid_msg::of13::Instruction* instruction = *j;
+	  // Required by OpenFlow 1.3.0
+	  if (instruction->type () == fluid_msg::of13::OFPIT_GOTO_TABLE)
+	  {
+		  // Try the next specified table
+		  fluid_msg::of13::GoToTable *gotoTable = dynamic_cast<fluid_msg::of13::GoToTable *> (instruction);
+		  return g_flowTables[m_parentSwitch->getDatapathID()].at(gotoTable->table_id ())->handlePacket(pkt, action_set, inPort, key, record);
+	  }
+	  // Required by OpenFlow 1.3.0
+	  else if (instruction->type () == fluid_msg::of13::OFPIT_WRITE_ACTIONS)
+	  {
+		  fluid_msg::of13::WriteActions *writeAction = dynamic_cast<fluid_msg::of13::WriteActions *> (instruction);
+		  fluid_msg::ActionSet newActionSet = writeAction->actions();
+		  for (std::set<fluid_msg::Action*, fluid_msg::comp_action_set_order>::iterator k = newActionSet.action_set ().begin ();
+				  k != newActionSet.action_set ().end (); k++)
+		  {
+			  fluid_msg::Action* action = *k;
+			  action_set->add_action(action);
+		  }
+	  }
+	  // Additional instructions are optional for OpenFlow 1.3.0
+	  else if (instruction->type () == fluid_msg::of13::OFPIT_METER)
+	  {
+
+	  }
+	  else if (instruction->type () == fluid_msg::of13::OFPIT_APPLY_ACTIONS)
+	  {
+		  fluid_msg::of13::ApplyActions* applyAction = dynamic_cast<fluid_msg::of13::ApplyActions*> (instruction);
+		  fluid_msg::ActionList actions(applyAction->actions());
+		  std::vector<uint32_t> outPorts = handleActions(pkt, &actions);
+
+		  if (!outPorts.empty())
+		  {
+			  if (record)
+			    {
+			      record->applied.push_back (outPorts);
+			    }
+			  m_parentSwitch->HandlePorts (pkt, outPorts, inPort);
+		  }
+	  }
+	  else if (instruction->type () == fluid_msg::of13::OFPIT_CLEAR_ACTIONS)
+	  {
+
+	  }
+	  else if (instruction->type () == fluid_msg::of13::OFPIT_WRITE_METADATA)
+	  {
+
+	  }
+  }
+  return action_set;
+}
+
+std::vector<Flow13*>
+SdnFlowTable13::matchingFlows (fluid_msg::of13::Match match)
+{
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
+  return m_classifier->LookupAll (key);
 }
 
 //ACTION HANDLERS
@@ -414,136 +374,6 @@ SdnFlowTable13::handleGroupAction (Ptr<Packet> pkt,fluid_msg::of13::GroupAction*
   return outPorts;
 }
 
-//Utility methods to deconstruct/reconstruct headers
-Ptr<Packet>
-SdnFlowTable13::DestructHeader (Ptr<Packet> pkt)
-{
-  PacketMetadata metadata (pkt->GetUid (),pkt->GetSize ());
-  PacketMetadata::ItemIterator iterator = pkt->BeginItem ();
-  PacketMetadata::Item item;
-  while (iterator.HasNext ())
-    {
-      item = iterator.Next ();
-      if (item.type != PacketMetadata::Item::HEADER)
-        {
-          continue;
-        }
-      else if (item.tid.GetName () == "ns3::TcpHeader" && pkt->PeekHeader (m_tcpHeader.header))
-        {
-          pkt->RemoveHeader (m_tcpHeader.header);
-          m_tcpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::UdpHeader" && pkt->PeekHeader (m_udpHeader.header))
-        {
-          pkt->RemoveHeader (m_udpHeader.header);
-          m_udpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv4Header" && pkt->PeekHeader (m_ipv4Header.header))
-        {
-          pkt->RemoveHeader (m_ipv4Header.header);
-          m_ipv4Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Icmpv4Header" && pkt->PeekHeader (m_icmpv4Header.header))
-        {
-          pkt->RemoveHeader (m_icmpv4Header.header);
-          m_icmpv4Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv6Header" && pkt->PeekHeader (m_ipv6Header.header))
-        {
-          pkt->RemoveHeader (m_ipv6Header.header);
-          m_ipv6Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv6ExtensionHeader" && pkt->PeekHeader (m_ipv6ExtHeader.header))
-        {
-          pkt->RemoveHeader (m_ipv6ExtHeader.header);
-          m_ipv6ExtHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Ipv6OptionHeader" && pkt->PeekHeader (m_ipv6OptHeader.header))
-        {
-          pkt->RemoveHeader (m_ipv6OptHeader.header);
-          m_ipv6OptHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::Icmpv6Header" && pkt->PeekHeader (m_icmpv6Header.header))
-        {
-          pkt->RemoveHeader (m_icmpv6Header.header);
-          m_icmpv6Header.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::ArpHeader"  && pkt->PeekHeader (m_arpHeader.header))
-        {
-          pkt->RemoveHeader (m_arpHeader.header);
-          m_arpHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::EthernetHeader" && pkt->PeekHeader (m_ethHeader.header))
-        {
-          pkt->RemoveHeader (m_ethHeader.header);
-          m_ethHeader.isEmpty = false;
-        }
-      else if (item.tid.GetName () == "ns3::LlcSnapHeader")
-        {
-        }
-    }
-  return pkt;
-}
-
-//Does the opposite, re-adds the headers we need
-void
-SdnFlowTable13::RestructHeader (Ptr<Packet> pkt)
-{
-  if (!m_udpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_udpHeader.header);
-    }
-  if (!m_tcpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_tcpHeader.header);
-    }
-  if (!m_icmpv6Header.isEmpty)
-    {
-      pkt->AddHeader (m_icmpv6Header.header);
-    }
-  if (!m_ipv6OptHeader.isEmpty)
-    {
-      pkt->AddHeader (m_ipv6OptHeader.header);
-    }
-  if (!m_ipv6ExtHeader.isEmpty)
-    {
-      pkt->AddHeader (m_ipv6ExtHeader.header);
-    }
-  if (!m_icmpv4Header.isEmpty)
-    {
-      pkt->AddHeader (m_icmpv4Header.header);
-    }
-  if (!m_ipv6Header.isEmpty)
-    {
-      pkt->AddHeader (m_ipv6Header.header);
-    }
-  if (!m_ipv4Header.isEmpty)
-    {
-      pkt->AddHeader (m_ipv4Header.header);
-    }
-  if (!m_arpHeader.isEmpty)
-    {
-      pkt->AddHeader (m_arpHeader.header);
-    }
-  if (!m_ethHeader.isEmpty)
-    {
-      pkt->AddHeader (m_ethHeader.header);
-    }
-  //Clear out headers so they're useful for the next read
-  m_ethHeader.header = EthernetHeader ();
-  m_ethHeader.isEmpty = true;
-  m_ipv4Header.header = Ipv4Header ();
-  m_ipv4Header.isEmpty = true;
-  m_ipv6Header.header = Ipv6Header ();
-  m_ipv6Header.isEmpty = true;
-  m_arpHeader.header = ArpHeader ();
-  m_arpHeader.isEmpty = true;
-  m_tcpHeader.header = TcpHeader ();
-  m_tcpHeader.isEmpty = true;
-  m_udpHeader.header = UdpHeader ();
-  m_udpHeader.isEmpty = true;
-}
-
 fluid_msg::of13::TableStats*
 SdnFlowTable13::convertToTableStats (uint8_t whichTable)
 {
@@ -560,9 +390,9 @@ SdnFlowTable13::convertToTableStats (uint8_t whichTable)
 
 //Checks if this flow will conflict with a current flow of the same priority
 bool
-SdnFlowTable13::conflictingEntry (Flow13 flow)
+SdnFlowTable13::conflictingEntry (const Flow13 &flow)
 {
-  for (std::set<Flow13, cmp_priority13>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
+  for (Flow13 *i = m_flowHead; i != NULL; i = i->next_)
     {
       if (Flow13::strict_match (flow,*i))
         {
@@ -572,94 +402,153 @@ SdnFlowTable13::conflictingEntry (Flow13 flow)
   return false;
 }
 
-Flow13
-SdnFlowTable13::addFlow (fluid_msg::of13::FlowMod* message)
+void
+SdnFlowTable13::fillFlow (Flow13 *flow, fluid_msg::of13::FlowMod* message)
 {
-  NS_LOG_DEBUG ("Adding new flow on switch at time" << Simulator::Now ().GetSeconds ());
-  Flow13 newFlow = Flow13 ();
-  newFlow.length_ = message->length ();
-  newFlow.table_id_ = message->table_id ();
-  newFlow.priority_ = message->priority ();
-  newFlow.idle_timeout_ = message->idle_timeout ();
-  newFlow.hard_timeout_ = message->hard_timeout ();
-  newFlow.cookie_ = message->cookie ();
-  newFlow.packet_count_ = 0;
-  newFlow.byte_count_ = 0;
-
-  newFlow.match = message->match ();
-  newFlow.instructions = message->instructions ();
+  flow->length_ = message->length ();
+  flow->table_id_ = message->table_id ();
+  flow->priority_ = message->priority ();
+  flow->idle_timeout_ = message->idle_timeout ();
+  flow->hard_timeout_ = message->hard_timeout ();
+  flow->cookie_ = message->cookie ();
+  flow->packet_count_ = 0;
+  flow->byte_count_ = 0;
+
+  flow->match = message->match ();
+  flow->instructions = message->instructions ();
+  flow->compileMatch ();
   //newFlow.match.dl_vlan (0); // Hack since ns-3 doesn't currently support VLAN
   //newFlow.actions = message->actions ();
+}
 
-  if ((message->flags () & fluid_msg::of13::OFPFF_CHECK_OVERLAP) && conflictingEntry (newFlow))
+Flow13*
+SdnFlowTable13::addFlow (fluid_msg::of13::FlowMod* message)
+{
+  NS_LOG_DEBUG ("Adding new flow on switch at time" << Simulator::Now ().GetSeconds ());
+  Flow13 *newFlow = allocateFlow ();
+  fillFlow (newFlow, message);
+
+  // The new flow is not linked yet, the check cannot find it
+  for (Flow13 *flow = m_flowHead; flow != NULL; flow = flow->next_)
     {
-      return Flow13 ();
+      if (Flow13::strict_match (*newFlow,*flow))
+        {
+          if (message->flags () & fluid_msg::of13::OFPFF_CHECK_OVERLAP)
+            {
+              releaseFlow (newFlow);
+              return NULL;
+            }
+          // As per OpenFlow, an identical flow is replaced
+          eraseFlow (flow);
+          break;
+        }
     }
-  if (!(message->flags () & fluid_msg::of13::OFPFF_CHECK_OVERLAP) && conflictingEntry (newFlow))
+  linkFlow (newFlow);
+  m_classifier->Insert (newFlow);
+  m_active_count++;
+  scheduleTimeout (*newFlow);
+  return newFlow;
+}
+
+std::vector<bool>
+SdnFlowTable13::addFlows (const std::vector<fluid_msg::of13::FlowMod*> &messages)
+{
+  NS_LOG_DEBUG ("Adding " << messages.size () << " new flows on switch at time" << Simulator::Now ().GetSeconds ());
+  std::vector<bool> added (messages.size (), false);
+
+  // A single pass over the table indexes the installed flows for the conflict checks
+  typedef sgi::hash_map<uint32_t, std::vector<Flow13*> > ConflictIndex;
+  ConflictIndex index;
+  for (Flow13 *flow = m_flowHead; flow != NULL; flow = flow->next_)
     {
-      deleteFlow (message);
+      index[flow->compiled.Hash () ^ flow->priority_].push_back (flow);
     }
-  if (newFlow.idle_timeout_ != 0)
+
+  std::vector<Flow13*> batch;
+  for (uint32_t i = 0; i < messages.size (); ++i)
     {
-      newFlow.idle_timeout_event = Simulator::Schedule (Seconds (newFlow.idle_timeout_),&SdnFlowTable13::IdleTimeOutEvent,this,newFlow);
+      Flow13 *newFlow = allocateFlow ();
+      fillFlow (newFlow, messages[i]);
+      std::vector<Flow13*> &bucket = index[newFlow->compiled.Hash () ^ newFlow->priority_];
+      std::vector<Flow13*>::iterator conflict = bucket.begin ();
+      while (conflict != bucket.end () && !Flow13::strict_match (*newFlow, **conflict))
+        {
+          ++conflict;
+        }
+      if (conflict != bucket.end ())
+        {
+          if (messages[i]->flags () & fluid_msg::of13::OFPFF_CHECK_OVERLAP)
+            {
+              releaseFlow (newFlow);
+              continue;
+            }
+          // As per OpenFlow, an identical flow is replaced, even one from earlier in the batch
+          std::vector<Flow13*>::iterator staged = std::find (batch.begin (), batch.end (), *conflict);
+          if (staged != batch.end ())
+            {
+              batch.erase (staged);
+              releaseFlow (*conflict);
+            }
+          else
+            {
+              eraseFlow (*conflict);
+            }
+          bucket.erase (conflict);
+        }
+      bucket.push_back (newFlow);
+      batch.push_back (newFlow);
+      added[i] = true;
     }
-  if (newFlow.hard_timeout_ != 0)
+
+  for (std::vector<Flow13*>::iterator i = batch.begin (); i != batch.end (); ++i)
     {
-      newFlow.hard_timeout_event = Simulator::Schedule (Seconds (newFlow.hard_timeout_),&SdnFlowTable13::HardTimeOutEvent,this,newFlow);
+      linkFlow (*i);
+      m_active_count++;
+      scheduleTimeout (**i);
     }
-  m_flow_table_rules.insert (newFlow);
-  m_active_count++;
-  return newFlow;
+  m_classifier->InsertBatch (batch);
+  return added;
 }
 
-Flow13
+Flow13*
 SdnFlowTable13::modifyFlow (fluid_msg::of13::FlowMod* message)
 {
   NS_LOG_DEBUG ("Modifying flow on switch at time" << Simulator::Now ().GetSeconds ());
-  for (std::set<Flow13, cmp_priority13>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
+  fluid_msg::of13::Match match = message->match ();
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
+  for (Flow13 *flow = m_flowHead; flow != NULL; flow = flow->next_)
     {
-      Flow13 flow = *i;
-      if (flow.priority_ == message->priority () && Flow13::pkt_match (flow,message->match ()))
+      if (flow->priority_ == message->priority () && Flow13::pkt_match (*flow,key))
         {
-          flow.instructions = message->instructions ();
-          flow.cookie_ = message->cookie ();
-          if (flow.idle_timeout_ != 0)
-            {
-              flow.idle_timeout_event.Cancel ();
-              flow.idle_timeout_event = Simulator::Schedule (Seconds (flow.idle_timeout_),&SdnFlowTable13::IdleTimeOutEvent,this,flow);
-            }
-          if (flow.hard_timeout_ != 0)
-            {
-              flow.hard_timeout_event.Cancel ();
-              flow.hard_timeout_event = Simulator::Schedule (Seconds (flow.hard_timeout_),&SdnFlowTable13::HardTimeOutEvent,this,flow);
-            }
+          // The match is unchanged, so is the classifier entry
+          flow->instructions = message->instructions ();
+          flow->cookie_ = message->cookie ();
+          // As per OpenFlow, modifying a flow leaves its timeouts running
           return flow;
         }
     }
-  return Flow13 ();
+  return NULL;
 }
 
 void
 SdnFlowTable13::deleteFlow (fluid_msg::of13::FlowMod* message)
 {
   NS_LOG_DEBUG ("Deleting flow on switch at time" << Simulator::Now ().GetSeconds ());
-  for (std::set<Flow13, cmp_priority13>::iterator i = m_flow_table_rules.begin (); i != m_flow_table_rules.end (); i++)
+  fluid_msg::of13::Match match = message->match ();
+  SdnFlowKey key;
+  SdnFlowKey::Compile (match, key);
+  Flow13 *flow = m_flowHead;
+  while (flow != NULL)
     {
-      Flow13 flow = *i;
-      if (flow.priority_ == message->priority () && Flow13::pkt_match (flow,message->match ()))
+      Flow13 *next = flow->next_;
+      if (flow->priority_ == message->priority () && Flow13::pkt_match (*flow,key))
         {
-          if (flow.idle_timeout_ != 0)
-            {
-              flow.idle_timeout_event.Cancel ();
-            }
-          if (flow.hard_timeout_ != 0)
-            {
-              flow.hard_timeout_event.Cancel ();
-            }
-          m_flow_table_rules.erase (flow);
+          // Pending timers of the flow find its id gone and are dropped
+          eraseFlow (flow);
         }
+      flow = next;
     }
-  m_active_count--;
 }
 
 Ptr<SdnGroup13>
@@ -709,25 +598,103 @@ SdnFlowTable13::deleteGroup (fluid_msg::of13::GroupMod* message)
 }
 
 void
-SdnFlowTable13::IdleTimeOutEvent (Flow13 flow)
+SdnFlowTable13::releaseFlow (Flow13 *flow)
 {
-  NS_LOG_DEBUG ("Idle timeout event of flow at time " << Simulator::Now ().GetSeconds ());
-  TimeOutEvent (flow, fluid_msg::of13::OFPRR_IDLE_TIMEOUT);
+  uint32_t slot = (uint32_t)flow->id_;
+  m_flowGenerations[slot]++;
+  // Drop the match and instructions now rather than when the slot is reused
+  *flow = Flow13 ();
+  m_freeFlowSlots.push_back (slot);
+}
+
+void
+SdnFlowTable13::eraseFlow (Flow13 *flow)
+{
+  m_classifier->Remove (flow);
+  std::map<uint16_t, Flow13*>::iterator tail = m_priorityTails.find (flow->priority_);
+  if (tail->second == flow)
+    {
+      if (flow->prev_ && flow->prev_->priority_ == flow->priority_)
+        {
+          tail->second = flow->prev_;
+        }
+      else
+        {
+          m_priorityTails.erase (tail);
+        }
+    }
+  if (flow->prev_)
+    {
+      flow->prev_->next_ = flow->next_;
+    }
+  else
+    {
+      m_flowHead = flow->next_;
+    }
+  if (flow->next_)
+    {
+      flow->next_->prev_ = flow->prev_;
+    }
+  m_active_count--;
+  releaseFlow (flow);
 }
 
 void
-SdnFlowTable13::HardTimeOutEvent (Flow13 flow)
+SdnFlowTable13::scheduleTimeout (const Flow13 &flow)
 {
-  NS_LOG_DEBUG ("Hard timeout event of flow at time " << Simulator::Now ().GetSeconds ());
-  TimeOutEvent (flow, fluid_msg::of13::OFPRR_HARD_TIMEOUT);
+  uint64_t deadline = 0;
+  if (flow.idle_timeout_ != 0)
+    {
+      deadline = flow.last_used_nsec + flow.idle_timeout_ * (uint64_t)NANOTOSECS;
+    }
+  if (flow.hard_timeout_ != 0)
+    {
+      uint64_t hardDeadline = flow.install_time_nsec + flow.hard_timeout_ * (uint64_t)NANOTOSECS;
+      if (deadline == 0 || hardDeadline < deadline)
+        {
+          deadline = hardDeadline;
+        }
+    }
+  if (deadline != 0)
+    {
+      m_parentSwitch->ScheduleFlowTimeout (this, flow.id_, NanoSeconds (deadline));
+    }
 }
 
 void
-SdnFlowTable13::TimeOutEvent (Flow13 flow, uint8_t reason)
+SdnFlowTable13::checkTimeouts (uint64_t flowId)
 {
-  m_flow_table_rules.erase (flow);
-  m_parentSwitch->SendFlowRemovedMessageToController (flow,reason);
+  Flow13 *flow = findFlow (flowId);
+  if (flow == NULL)
+    {
+      // Deleted since the timer was set
+      return;
+    }
+  uint64_t now = Simulator::Now ().GetNanoSeconds ();
+  uint8_t reason;
+  if (flow->hard_timeout_ != 0 && now >= flow->install_time_nsec + flow->hard_timeout_ * (uint64_t)NANOTOSECS)
+    {
+      NS_LOG_DEBUG ("Hard timeout event of flow at time " << Simulator::Now ().GetSeconds ());
+      reason = fluid_msg::of13::OFPRR_HARD_TIMEOUT;
+    }
+  else if (flow->idle_timeout_ != 0 && now >= flow->last_used_nsec + flow->idle_timeout_ * (uint64_t)NANOTOSECS)
+    {
+      NS_LOG_DEBUG ("Idle timeout event of flow at time " << Simulator::Now ().GetSeconds ());
+      reason = fluid_msg::of13::OFPRR_IDLE_TIMEOUT;
+    }
+  else
+    {
+      // Used since the timer was set, wait for the next deadline
+      scheduleTimeout (*flow);
+      return;
+    }
+
+  flow->duration_sec_ = flow->getDurationSec ();
+  flow->duration_nsec_ = flow->getDurationNSec ();
   //Send a flow removed message back to controller
+  m_parentSwitch->SendFlowRemovedMessageToController (*flow, reason);
+  eraseFlow (flow);
+  m_parentSwitch->InvalidateFlowCache ();
 }
 
 } //End ns3 namespace
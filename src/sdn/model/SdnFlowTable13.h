@@ -21,6 +21,7 @@
 #define FLOW_TABLE13_H
 //Stdlib packages
 #include <map>
+#include <vector>
 #include <stack>
 //ns3 utilities
 #include "ns3/ptr.h"
@@ -44,20 +45,12 @@
 #include "Flow13.h"
 #include "SdnGroup13.h"
 #include "SdnCommon.h"
+#include "SdnClassifier13.h"
+#include "SdnFlowCache13.h"
 
 namespace ns3 {
 
 class SdnSwitch13;
-/**
- * A comparators for flows. Sort via priority
- */
-struct cmp_priority13
-{
-  bool operator() (const Flow13 &lhs, const Flow13 &rhs) const
-  {
-    return lhs.priority_ <= rhs.priority_;
-  }
-};
 
 /**
  * \ingroup sdn
@@ -71,8 +64,18 @@ struct cmp_priority13
 class SdnFlowTable13 : public Object
 {
 public:
-  SdnFlowTable13() {}
+  /**
+   * Packet classifiers a table can use to find the flow a packet hits
+   */
+  enum ClassifierType
+  {
+    LINEAR_CLASSIFIER,     //!< Priority ordered scan over every flow
+    TUPLE_SPACE_CLASSIFIER //!< One hash probe per distinct match mask
+  };
+
+  SdnFlowTable13();
   SdnFlowTable13(Ptr<SdnSwitch13> parentSwitch);
+  virtual ~SdnFlowTable13();
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -84,9 +87,26 @@ public:
   /**
    * \brief reads a packet and commits the actions given the flows in the flow table
    * \param pkt The packet to read
-   * \return The ports  the switch must outport the packet from. If no outport is discerned, the vector will be empty
+   * \param action_set The action set accumulated by the previous tables
+   * \param inPort The port the packet arrived on
+   * \param key The key extracted from the packet
+   * \param record If not NULL, receives the tables visited and the APPLY_ACTIONS outputs
+   * \return The action set to execute once the pipeline is done
    */
-  fluid_msg::ActionSet* handlePacket (Ptr<Packet> pkt, fluid_msg::ActionSet *action_set, uint32_t inPort);
+  fluid_msg::ActionSet* handlePacket (Ptr<Packet> pkt, fluid_msg::ActionSet *action_set, uint32_t inPort,
+                                      const SdnFlowKey &key, SdnFlowCache13::Entry *record = NULL);
+  /**
+   * \brief Accounts for one lookup in the table: table and flow counters, idle timeout refresh
+   * \param flow The flow the packet hit, NULL on a table miss
+   * \param pkt The packet looked up
+   */
+  void recordLookup (Flow13 *flow, Ptr<Packet> pkt);
+  /**
+   * \brief Timeout wheel hook. Expires a flow whose idle or hard deadline has passed, notifying the
+   * controller, or schedules its next check if it was used meanwhile
+   * \param flowId The id of the flow the timer was set for
+   */
+  void checkTimeouts (uint64_t flowId);
   /**
    * \brief Getter for tableID
    * \return tableID
@@ -115,25 +135,34 @@ public:
    * \param match The match object that describes what we're looking for from the flows
    * \return A vector of all matching flows
    */
-  std::vector<Flow13> matchingFlows(fluid_msg::of13::Match match);
+  std::vector<Flow13*> matchingFlows(fluid_msg::of13::Match match);
   /**
    * \brief A check to find whether a flow will conflict with any allready in the flow table
    * \param flow The possibly offending new flow
    * \return True if the new flow conflicts, false otherwise
    */
-  bool conflictingEntry(Flow13 flow);
+  bool conflictingEntry(const Flow13 &flow);
   /**
    * \brief Adds a new flow into the table
    * \param message The flowmod message that defines the new flow to add
-   * \return The newly created flow
+   * \return The newly created flow, NULL if it overlaps an existing one and overlaps were checked
    */
-  Flow13 addFlow(fluid_msg::of13::FlowMod* message);
+  Flow13* addFlow(fluid_msg::of13::FlowMod* message);
+  /**
+   * \brief Adds a batch of new flows into the table
+   *
+   * Same outcome as calling addFlow on each message in order, but the table is scanned
+   * once for conflicts and the classifier indexes the whole batch at once.
+   * \param messages The flowmod messages, all OFPFC_ADD
+   * \return For each message, false if its flow overlapped an existing one and was not added
+   */
+  std::vector<bool> addFlows(const std::vector<fluid_msg::of13::FlowMod*> &messages);
   /**
    * \brief Modifies a flow in the table
    * \param message The flowmod message that defines the modified flow
-   * \return The modified flow
+   * \return The modified flow, NULL if none matched
    */
-  Flow13 modifyFlow(fluid_msg::of13::FlowMod* message);
+  Flow13* modifyFlow(fluid_msg::of13::FlowMod* message);
   //Flow modifyFlowStrict(fluid_msg::of10::FlowMod* message);
     /**
    * \brief Deletes a flow in the table
@@ -160,9 +189,20 @@ public:
   void deleteGroup(fluid_msg::of13::GroupMod* message);
   /**
    * \brief Getter for all the flows in the table
-   * \return m_table_flow_rules
+   * \return The flows, highest priority first
+   */
+  std::vector<Flow13*> flows();
+  /**
+   * \brief Finds a flow by its stable id
+   * \param flowId The id_ of the flow
+   * \return The flow, NULL if it has been removed since
    */
-  std::set<Flow13, cmp_priority13> flows();
+  Flow13* findFlow(uint64_t flowId);
+  /**
+   * \brief Replaces the packet classifier, re-indexing the flows already in the table
+   * \param type The classifier to use from now on
+   */
+  void SetClassifierType (ClassifierType type);
   //stat entries
   uint32_t m_max_entries;   //!< A count of all flow entries in the table
   uint32_t m_active_count;  //!< A count of all active flow entries in the table 
@@ -171,39 +211,13 @@ public:
   std::map<uint32_t, Ptr<SdnGroup13> > m_groupTable;
 private:
   Ptr<SdnSwitch13> m_parentSwitch;                   //!< The owning SdnSwitch of this table
-  std::set<Flow13, cmp_priority13> m_flow_table_rules; //!< The actual set of all flows in the flow table. Sorted by priority
+  std::vector<Flow13*> m_flowPool;                 //!< Every flow entry allocated by the table, indexed by slot. Entries never move
+  std::vector<uint32_t> m_flowGenerations;         //!< Generation of each slot, bumped when its flow is removed
+  std::vector<uint32_t> m_freeFlowSlots;           //!< Slots of m_flowPool free for reuse
+  Flow13 *m_flowHead;                              //!< First flow of the priority index: by decreasing priority, oldest first
+  std::map<uint16_t, Flow13*> m_priorityTails;     //!< Last flow of each priority in the priority index
+  Ptr<SdnClassifier13> m_classifier;               //!< Index over the flows used to classify packets
   uint8_t m_tableid;                               //!< Unique ID for flow tables
-  template <class T> struct TempHeader { TempHeader() : isEmpty(true), header() {} bool isEmpty; T header; };
-  TempHeader<EthernetHeader>  m_ethHeader;         //!< Private EthernetHeader for grabbing information out of the packet
-  TempHeader<Ipv4Header> m_ipv4Header;             //!< Private Ipv4Header for grabbing information out of the packet
-  TempHeader<Icmpv4Header> m_icmpv4Header;         //!< Private Icmpv4Header for grabbing information out of the packet
-  TempHeader<Ipv6Header> m_ipv6Header;             //!< Private Ipv6Header for grabbing information out of the packet
-  TempHeader<Ipv6ExtensionHeader> m_ipv6ExtHeader; //!< Private Ipv6Header for grabbing information out of the packet
-  TempHeader<Ipv6OptionHeader> m_ipv6OptHeader;    //!< Private Ipv6Header for grabbing information out of the packet
-  TempHeader<Icmpv6Header> m_icmpv6Header;         //!< Private Icmpv6Header for grabbing information out of the packet
-  TempHeader<ArpHeader>  m_arpHeader;              //!< Private ArpHeader for grabbing information out of the packet
-  TempHeader<TcpHeader>  m_tcpHeader;              //!< Private TcpHeader for grabbing information out of the packet
-  TempHeader<UdpHeader>  m_udpHeader;              //!< Private UdpHeader for grabbing information out of the packet
-public:
-  /**
-   * \brief Creates a match object from the tempheader information 
-   * \param inPort This field needs to go in the match in addition to the packet fields, but it is not
-   * 			readily available from the packet information.
-   * \return A match object matching whatever information could be discerned from the current packet
-   */
-  fluid_msg::of13::Match getPacketFields (uint32_t inPort);
-  /**
-   * \brief Removes the TempHeaders from an actual packet so we can use them for analysis
-   * \param pkt The packet containing the headers we're interested in
-   * \return The Packet with the relevant headers removed
-   */
-  Ptr<Packet> DestructHeader (Ptr<Packet> pkt);
-  /**
-   * \brief Add the TempHeaders back onto a packet. Should always be called soon after DestructHeader
-   * \param pkt The destructed packet ready to be reconstructed
-   */
-  void RestructHeader (Ptr<Packet> pkt);
-private:
   /**
    * \brief Action handler for an output action
    * \param pkt The packet being modified from the action
@@ -218,17 +232,36 @@ private:
   std::vector<uint32_t> handleGroupAction (Ptr<Packet> pkt,fluid_msg::of13::GroupAction* action);
 
   /**
-   * \brief Idle Time Out Event hook. Gets invoked whenever a flow has reached it's idle time without any activity.
+   * \brief Sets up a flow entry from a flowmod message, compiling its match
+   * \param flow The entry to fill
+   * \param message The OFPFC_ADD flowmod message
+   */
+  void fillFlow (Flow13 *flow, fluid_msg::of13::FlowMod* message);
+  /**
+   * \brief Takes a flow entry from the pool, reusing a free slot if any
+   * \return A default constructed flow carrying its new id
+   */
+  Flow13* allocateFlow (void);
+  /**
+   * \brief Inserts a flow in the priority index, after the flows of the same priority
+   * \param flow A flow taken from the pool
+   */
+  void linkFlow (Flow13 *flow);
+  /**
+   * \brief Removes a flow from the table, its priority index and its classifier, then returns it to the pool
+   * \param flow The flow to remove
    */
-  void IdleTimeOutEvent(Flow13 flow);
+  void eraseFlow (Flow13 *flow);
   /**
-   * \brief Hard Time Out Event hook. Gets invoked whenever a flow has reached it's hard time
+   * \brief Returns an unlinked flow to the pool, invalidating its id
+   * \param flow A flow taken from the pool
    */
-  void HardTimeOutEvent(Flow13 flow);
+  void releaseFlow (Flow13 *flow);
   /**
-   * \brief Generic timeout. Deletes a flow and asks the owning switch to send a notification to the controller
+   * \brief Asks the owning switch to check the flow at its next idle or hard deadline
+   * \param flow A flow of the table. Nothing is scheduled if it has no timeouts
    */
-  void TimeOutEvent(Flow13 flow, uint8_t reason);
+  void scheduleTimeout (const Flow13 &flow);
 };
 
 } //End namespace ns3
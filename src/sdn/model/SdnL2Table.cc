@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "SdnL2Table.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnL2Table");
+
+/**
+ * Orders entries from the least to the most recently seen
+ */
+struct SdnL2TableSeenOrder
+{
+  template <class T>
+  bool operator() (const T &a, const T &b) const
+  {
+    return a.seen < b.seen;
+  }
+};
+
+SdnL2Table::SdnL2Table ()
+  : m_capacity (0),
+    m_aging (Seconds (0))
+{
+  Clear ();
+}
+
+void
+SdnL2Table::SetCapacity (uint32_t capacity)
+{
+  m_capacity = capacity;
+  Clear ();
+}
+
+uint32_t
+SdnL2Table::GetCapacity (void) const
+{
+  return m_capacity;
+}
+
+void
+SdnL2Table::SetAgingTime (Time aging)
+{
+  m_aging = aging;
+}
+
+Time
+SdnL2Table::GetAgingTime (void) const
+{
+  return m_aging;
+}
+
+uint32_t
+SdnL2Table::Probe (uint64_t mac) const
+{
+  uint32_t slot = Home (mac);
+  while (m_entries[slot].mac != mac && m_entries[slot].mac != SDN_L2_EMPTY)
+    {
+      slot = (slot + 1) & m_mask;
+    }
+  return slot;
+}
+
+bool
+SdnL2Table::IsAged (const Entry &entry, Time now) const
+{
+  return m_aging.IsStrictlyPositive () && entry.seen + m_aging <= now;
+}
+
+void
+SdnL2Table::Learn (uint64_t mac, uint32_t port)
+{
+  Time now = Simulator::Now ();
+  uint32_t slot = Probe (mac);
+  if (m_entries[slot].mac == mac)
+    {
+      m_entries[slot].port = port;
+      m_entries[slot].seen = now;
+      return;
+    }
+
+  if (m_capacity > 0 && m_size >= m_capacity)
+    {
+      if (Expire () == 0)
+        {
+          Evict (std::max (m_capacity / 8, 1U));
+        }
+      slot = Probe (mac);
+    }
+  // Keep the load under three quarters so probe sequences stay short
+  if ((m_size + 1) * 4 > (m_mask + 1) * 3)
+    {
+      std::vector<Entry> entries;
+      entries.swap (m_entries);
+      Rebuild (entries, (m_mask + 1) * 2);
+      slot = Probe (mac);
+    }
+  m_entries[slot].mac = mac;
+  m_entries[slot].port = port;
+  m_entries[slot].seen = now;
+  m_size++;
+}
+
+bool
+SdnL2Table::Lookup (uint64_t mac, uint32_t &port) const
+{
+  const Entry &entry = m_entries[Probe (mac)];
+  if (entry.mac != mac || IsAged (entry, Simulator::Now ()))
+    {
+      return false;
+    }
+  port = entry.port;
+  return true;
+}
+
+bool
+SdnL2Table::Remove (uint64_t mac)
+{
+  uint32_t hole = Probe (mac);
+  if (m_entries[hole].mac != mac)
+    {
+      return false;
+    }
+  // Shift back the entries of the probe sequence that could no longer be reached
+  for (uint32_t slot = (hole + 1) & m_mask; m_entries[slot].mac != SDN_L2_EMPTY; slot = (slot + 1) & m_mask)
+    {
+      uint32_t home = Home (m_entries[slot].mac);
+      if (((slot - home) & m_mask) >= ((slot - hole) & m_mask))
+        {
+          m_entries[hole] = m_entries[slot];
+          hole = slot;
+        }
+    }
+  m_entries[hole].mac = SDN_L2_EMPTY;
+  m_size--;
+  return true;
+}
+
+uint32_t
+SdnL2Table::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_aging.IsStrictlyPositive ())
+    {
+      return 0;
+    }
+  Time now = Simulator::Now ();
+  std::vector<Entry> entries;
+  entries.reserve (m_size);
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      if (i->mac != SDN_L2_EMPTY && !IsAged (*i, now))
+        {
+          entries.push_back (*i);
+        }
+    }
+  uint32_t expired = m_size - entries.size ();
+  if (expired > 0)
+    {
+      Rebuild (entries, m_mask + 1);
+    }
+  return expired;
+}
+
+uint32_t
+SdnL2Table::Evict (uint32_t count)
+{
+  NS_LOG_FUNCTION (this << count);
+
+  count = std::min (count, m_size);
+  if (count == 0)
+    {
+      return 0;
+    }
+  std::vector<Entry> entries;
+  entries.reserve (m_size);
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+    {
+      if (i->mac != SDN_L2_EMPTY)
+        {
+          entries.push_back (*i);
+        }
+    }
+  std::nth_element (entries.begin (), entries.begin () + count, entries.end (), SdnL2TableSeenOrder ());
+  entries.erase (entries.begin (), entries.begin () + count);
+  Rebuild (entries, m_mask + 1);
+  return count;
+}
+
+void
+SdnL2Table::Clear (void)
+{
+  Rebuild (std::vector<Entry> (), SDN_L2_MIN_SLOTS);
+}
+
+uint32_t
+SdnL2Table::GetSize (void) const
+{
+  return m_size;
+}
+
+void
+SdnL2Table::Rebuild (const std::vector<Entry> &entries, uint32_t slots)
+{
+  Entry empty;
+  empty.mac = SDN_L2_EMPTY;
+  empty.port = 0;
+  m_entries.assign (slots, empty);
+  m_mask = slots - 1;
+  m_size = 0;
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      if (i->mac != SDN_L2_EMPTY)
+        {
+          m_entries[Probe (i->mac)] = *i;
+          m_size++;
+        }
+    }
+}
+
+} //End namespace ns3
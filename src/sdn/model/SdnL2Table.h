@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef SDN_L2_TABLE_H
+#define SDN_L2_TABLE_H
+
+//Stdlib packages
+#include <vector>
+//ns3 utilities
+#include "ns3/nstime.h"
+
+#define SDN_L2_EMPTY     0xffffffffffffffffULL //!< Key of an empty slot, never a 48-bit MAC address
+#define SDN_L2_MIN_SLOTS 64                    //!< Number of slots of a new table
+
+namespace ns3 {
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnL2Table
+ *
+ * \brief MAC learning table of one switch, as kept by a learning controller
+ *
+ * Entries live in a flat open-addressing table with linear probing, keyed by the MAC
+ * address in the low 48 bits of a uint64_t, and grow it up to the capacity. Each entry
+ * remembers when its address was last seen: an entry older than the aging time no longer
+ * resolves, and a table at capacity first drops every aged entry, then the least recently
+ * seen eighth of them, so it is not swept on every new address.
+ */
+class SdnL2Table
+{
+public:
+  SdnL2Table ();
+  /**
+   * \brief Bounds the number of entries, dropping every entry
+   * \param capacity The largest number of entries. 0 leaves the table unbounded
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \return The largest number of entries, 0 if unbounded
+   */
+  uint32_t GetCapacity (void) const;
+  /**
+   * \brief Sets how long an address stays known after it was last seen
+   * \param aging The aging time. 0 never ages entries out
+   */
+  void SetAgingTime (Time aging);
+  /**
+   * \return The aging time
+   */
+  Time GetAgingTime (void) const;
+  /**
+   * \brief Records that an address was seen on a port at the current simulation time
+   * \param mac The MAC address
+   * \param port The port it was seen on
+   */
+  void Learn (uint64_t mac, uint32_t port);
+  /**
+   * \brief Looks up the port of an address
+   * \param mac The MAC address
+   * \param port Set to the port the address was last seen on
+   * \return False if the address is unknown or aged out
+   */
+  bool Lookup (uint64_t mac, uint32_t &port) const;
+  /**
+   * \brief Forgets an address
+   * \param mac The MAC address
+   * \return False if the address was unknown
+   */
+  bool Remove (uint64_t mac);
+  /**
+   * \brief Drops every aged out entry
+   * \return The number of dropped entries
+   */
+  uint32_t Expire (void);
+  /**
+   * \brief Drops the least recently seen entries
+   * \param count The number of entries to drop
+   * \return The number of dropped entries
+   */
+  uint32_t Evict (uint32_t count);
+  /**
+   * \brief Drops every entry
+   */
+  void Clear (void);
+  /**
+   * \return The number of entries, aged out ones included
+   */
+  uint32_t GetSize (void) const;
+
+private:
+  /**
+   * A slot of the table
+   */
+  struct Entry
+  {
+    uint64_t mac;  //!< The address, SDN_L2_EMPTY if the slot is free
+    Time seen;     //!< When the address was last seen
+    uint32_t port; //!< The port it was seen on
+  };
+  /**
+   * \return The home slot of an address
+   */
+  uint32_t Home (uint64_t mac) const
+  {
+    return (uint32_t)((mac * 0x9e3779b97f4a7c15ULL) >> 32) & m_mask;
+  }
+  /**
+   * \return The slot holding an address, or the free slot ending its probe sequence
+   */
+  uint32_t Probe (uint64_t mac) const;
+  /**
+   * \brief Rehashes the given entries into an empty table of the given number of slots
+   */
+  void Rebuild (const std::vector<Entry> &entries, uint32_t slots);
+  /**
+   * \return Whether an entry has aged out at the given time
+   */
+  bool IsAged (const Entry &entry, Time now) const;
+
+  std::vector<Entry> m_entries; //!< The slots, a power of two of them
+  uint32_t m_mask;              //!< Number of slots minus one
+  uint32_t m_size;              //!< Number of used slots
+  uint32_t m_capacity;          //!< Largest number of entries, 0 if unbounded
+  Time m_aging;                 //!< Aging time, 0 if entries never age
+};
+
+} //End namespace ns3
+#endif
@@ -47,6 +47,17 @@ SdnListener::DoDispose (void)
   Object::DoDispose ();
 }
 
+void
+SdnListener::event_batch_callback (std::vector<ControllerEvent*> &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+
+  for (std::vector<ControllerEvent*>::iterator i = events.begin (); i != events.end (); ++i)
+    {
+      event_callback (*i);
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED (BaseLearningSwitch);
 
 TypeId BaseLearningSwitch::GetTypeId (void)
@@ -54,11 +65,24 @@ TypeId BaseLearningSwitch::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::BaseLearningSwitch")
     .SetParent<SdnListener> ()
     .AddConstructor<BaseLearningSwitch> ()
+    .AddAttribute ("L2TableCapacity",
+                   "Largest number of MAC addresses learnt per switch, the least recently seen "
+                   "being evicted past it. 0 leaves the tables unbounded.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&BaseLearningSwitch::m_l2Capacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("L2AgingTime",
+                   "How long a learnt MAC address stays known after it was last seen. 0 never ages addresses out.",
+                   TimeValue (Seconds (300)),
+                   MakeTimeAccessor (&BaseLearningSwitch::m_l2Aging),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
 BaseLearningSwitch::BaseLearningSwitch ()
+  : m_l2Capacity (65536),
+    m_l2Aging (Seconds (300))
 {
   NS_LOG_FUNCTION (this);
 }
@@ -67,12 +91,11 @@ BaseLearningSwitch::~BaseLearningSwitch ()
 {
   NS_LOG_FUNCTION (this);
 
-  while (!l2tables.empty ())
+  for (std::vector<SdnL2Table*>::iterator i = l2tables.begin (); i != l2tables.end (); ++i)
     {
-      L2TABLE* l2table = *l2tables.begin ();
-      l2tables.erase (l2tables.begin ());
-      delete l2table;
+      delete *i;
     }
+  l2tables.clear ();
 }
 
 void
@@ -82,12 +105,13 @@ BaseLearningSwitch::DoDispose (void)
   SdnListener::DoDispose ();
 }
 
-L2TABLE*
+SdnL2Table*
 BaseLearningSwitch::get_l2table (Ptr<SdnConnection> ofconn)
 {
   NS_LOG_FUNCTION (this << ofconn);
 
-  L2TABLE* l2table = (L2TABLE*)ofconn->get_application_data ();
+  uint32_t id = ofconn->get_id ();
+  SdnL2Table* l2table = id < l2tables.size () ? l2tables[id] : NULL;
 
   if (l2table == NULL)
     {
@@ -106,18 +130,25 @@ BaseLearningSwitch::event_callback (ControllerEvent* ev)
 
   if (ev->get_type () == EVENT_SWITCH_UP)
     {
-      L2TABLE* l2table = new L2TABLE ();
-
-      ev->ofconn->set_application_data (l2table);
-      l2tables.push_back (l2table);
+      uint32_t id = ev->ofconn->get_id ();
+      if (id >= l2tables.size ())
+        {
+          l2tables.resize (id + 1, NULL);
+        }
+      if (l2tables[id] == NULL)
+        {
+          l2tables[id] = new SdnL2Table ();
+        }
+      l2tables[id]->SetCapacity (m_l2Capacity);
+      l2tables[id]->SetAgingTime (m_l2Aging);
       NS_LOG_INFO("Adding L2 entries for connection id=" << ev->ofconn->get_id());
     }
   else if (ev->get_type () == EVENT_SWITCH_DOWN)
     {
-      L2TABLE* l2table = (L2TABLE*) ev->ofconn->get_application_data ();
+      SdnL2Table* l2table = get_l2table (ev->ofconn);
       if (l2table != NULL)
         {
-          l2table->clear ();
+          l2table->Clear ();
           NS_LOG_INFO("Deleting L2 entries for connection id=" << ev->ofconn->get_id());
         }
     }
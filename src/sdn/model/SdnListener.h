@@ -22,6 +22,7 @@
 
 //Sdn Common library
 #include "SdnConnection.h"
+#include "SdnL2Table.h"
 
 //NS3 objects
 #include "ns3/ptr.h"
@@ -33,6 +34,7 @@
 
 //C++ libraries
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -42,11 +44,10 @@ namespace ns3 {
 #define EVENT_FLOW_REMOVED 3
 #define EVENT_PORT_STATUS  4
 #define EVENT_STATS_REPLY  5
+#define EVENT_TYPES        6 //!< Number of event types
 
 class SdnConnection;
 
-typedef std::map<uint64_t, uint16_t> L2TABLE;
-
 /**
  * \ingroup sdn
  * \defgroup ControllerEvent
@@ -59,6 +60,7 @@ public:
   {
     this->ofconn = ofconn;
     this->type = type;
+    this->work_data = NULL;
   }
   virtual ~ControllerEvent ()
   {
@@ -73,6 +75,7 @@ public:
   }
 
   Ptr<SdnConnection> ofconn; //!< SdnConnection used to send event
+  void* work_data;           //!< Left by SdnListener::event_work for event_callback, which owns it
 
 private:
   int type; //!< Type of event sent
@@ -230,6 +233,24 @@ public:
    * \brief Inheritable function that handles our variety of controller events. The main reason to inherit SdnListener
    */
   virtual void event_callback (ControllerEvent* ev) { }
+  /**
+   * \brief Inheritable function for the expensive, simulator independent part of handling an event
+   *
+   * Runs before the event reaches event_callback, on a worker thread of the controller when
+   * its Workers attribute is set and inline otherwise. Events of one connection are worked on
+   * in order, events of different connections concurrently, so this may only read the event
+   * and state private to its connection, must not schedule, send or copy Ptrs, and can hand
+   * its result over in ev->work_data.
+   */
+  virtual void event_work (ControllerEvent* ev) { }
+  /**
+   * \brief Handles every event the controller decoded from one read, in arrival order
+   *
+   * The default hands each event to event_callback. The events and their data belong to
+   * the controller and are reused once this returns, so nothing may keep pointers to them.
+   * \param events The events of the batch
+   */
+  virtual void event_batch_callback (std::vector<ControllerEvent*> &events);
 };
 /**
  * \ingroup SdnListener
@@ -246,7 +267,9 @@ protected:
   virtual void DoDispose (void);
 
 private:
-  std::list<L2TABLE*> l2tables; //!< The 
+  std::vector<SdnL2Table*> l2tables; //!< The learning table of each switch, indexed by connection id, NULL before its switch is up
+  uint32_t m_l2Capacity;             //!< Capacity of a new learning table
+  Time m_l2Aging;                    //!< Aging time of a new learning table
 
 public:
   /**
@@ -259,9 +282,9 @@ public:
   ~BaseLearningSwitch (void);
   /**
    * \brief Get an L2Table based on the SdnConnection we're receiving data from
-   * \return A L2Table for any given SdnSwitch
+   * \return The learning table of the switch, NULL if its switch up event was not seen
    */
-  L2TABLE* get_l2table (Ptr<SdnConnection> ofconn);
+  SdnL2Table* get_l2table (Ptr<SdnConnection> ofconn);
   /**
    * \brief SdnListener defined behavior. Create an L2Table when a switch goes up, and remove it when it goes doewn
    */
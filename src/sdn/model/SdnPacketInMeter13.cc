@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "SdnPacketInMeter13.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnPacketInMeter13");
+
+// Tolerance on token counts, so a refill landing a hair short of a token still counts
+static const double TOKEN_EPSILON = 1e-9;
+
+SdnPacketInMeter13::SdnPacketInMeter13 ()
+  : m_rate (0),
+    m_burst (1),
+    m_portRate (0),
+    m_portBurst (1),
+    m_queueSize (0),
+    m_coalesceTimeout (Seconds (0)),
+    m_pending (SDN_PACKET_IN_PENDING_SLOTS),
+    m_generation (1)
+{
+  m_bucket.tokens = 1;
+  for (std::vector<Pending>::iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      i->generation = 0;
+    }
+}
+
+void
+SdnPacketInMeter13::SetSwitchRate (double rate, uint32_t burst)
+{
+  NS_LOG_FUNCTION (this << rate << burst);
+  m_rate = rate;
+  m_burst = std::max<uint32_t> (burst, 1);
+  m_bucket.tokens = m_burst;
+  m_bucket.last = Simulator::Now ();
+}
+
+void
+SdnPacketInMeter13::SetPortRate (double rate, uint32_t burst)
+{
+  NS_LOG_FUNCTION (this << rate << burst);
+  m_portRate = rate;
+  m_portBurst = std::max<uint32_t> (burst, 1);
+  Clear ();
+  m_ports.clear ();
+}
+
+void
+SdnPacketInMeter13::SetQueueSize (uint32_t size)
+{
+  m_queueSize = size;
+}
+
+void
+SdnPacketInMeter13::SetCoalesceTimeout (Time timeout)
+{
+  m_coalesceTimeout = timeout;
+}
+
+bool
+SdnPacketInMeter13::IsEnabled (void) const
+{
+  return m_rate > 0 || m_portRate > 0 || IsCoalescing ();
+}
+
+bool
+SdnPacketInMeter13::IsCoalescing (void) const
+{
+  return m_coalesceTimeout.IsStrictlyPositive ();
+}
+
+SdnPacketInMeter13::Verdict
+SdnPacketInMeter13::Admit (const Miss &miss)
+{
+  NS_LOG_FUNCTION (this << miss.packet << miss.inPort);
+  if (IsCoalescing () && IsPending (miss.key))
+    {
+      return SUPPRESS;
+    }
+  Port &port = GetPort (miss.inPort);
+  // Misses already waiting on this port keep their turn
+  if (port.queue.empty () && Consume (port))
+    {
+      if (IsCoalescing ())
+        {
+          SetPending (miss.key);
+        }
+      return SEND;
+    }
+  if (port.queue.size () >= m_queueSize)
+    {
+      return SUPPRESS;
+    }
+  if (port.queue.empty ())
+    {
+      m_backlog.push_back (miss.inPort);
+    }
+  port.queue.push_back (miss);
+  // The pipeline may still rewrite the packet after this output
+  port.queue.back ().packet = miss.packet->Copy ();
+  return DEFER;
+}
+
+void
+SdnPacketInMeter13::Drain (std::vector<Miss> &ready, std::vector<Miss> &suppressed)
+{
+  NS_LOG_FUNCTION (this);
+  // Stop once every port with queued misses was visited without sending anything
+  uint32_t idle = 0;
+  while (!m_backlog.empty () && idle < m_backlog.size ())
+    {
+      uint32_t inPort = m_backlog.front ();
+      m_backlog.pop_front ();
+      Port &port = m_ports[inPort];
+      Miss &miss = port.queue.front ();
+      if (IsCoalescing () && IsPending (miss.key))
+        {
+          suppressed.push_back (miss);
+        }
+      else if (Consume (port))
+        {
+          if (IsCoalescing ())
+            {
+              SetPending (miss.key);
+            }
+          ready.push_back (miss);
+        }
+      else
+        {
+          m_backlog.push_back (inPort);
+          idle++;
+          continue;
+        }
+      idle = 0;
+      port.queue.pop_front ();
+      if (!port.queue.empty ())
+        {
+          m_backlog.push_back (inPort);
+        }
+    }
+}
+
+bool
+SdnPacketInMeter13::HasQueued (void) const
+{
+  return !m_backlog.empty ();
+}
+
+Time
+SdnPacketInMeter13::GetDrainDelay (void) const
+{
+  Time portWait = Time::Max ();
+  for (std::deque<uint32_t>::const_iterator i = m_backlog.begin (); i != m_backlog.end (); ++i)
+    {
+      portWait = std::min (portWait, Wait (m_ports[*i].bucket, m_portRate, m_portBurst));
+    }
+  return std::max (portWait, Wait (m_bucket, m_rate, m_burst));
+}
+
+void
+SdnPacketInMeter13::ClearPending (void)
+{
+  m_generation++;
+}
+
+void
+SdnPacketInMeter13::Clear (void)
+{
+  for (std::vector<Port>::iterator i = m_ports.begin (); i != m_ports.end (); ++i)
+    {
+      i->queue.clear ();
+    }
+  m_backlog.clear ();
+}
+
+void
+SdnPacketInMeter13::Refill (Bucket &bucket, double rate, uint32_t burst)
+{
+  Time now = Simulator::Now ();
+  if (rate > 0)
+    {
+      bucket.tokens = std::min<double> (burst, bucket.tokens + rate * (now - bucket.last).GetSeconds ());
+    }
+  bucket.last = now;
+}
+
+Time
+SdnPacketInMeter13::Wait (const Bucket &bucket, double rate, uint32_t burst)
+{
+  if (rate <= 0)
+    {
+      return Seconds (0);
+    }
+  double tokens = std::min<double> (burst, bucket.tokens + rate * (Simulator::Now () - bucket.last).GetSeconds ());
+  if (tokens >= 1 - TOKEN_EPSILON)
+    {
+      return Seconds (0);
+    }
+  // Round up so the bucket does hold its token when the wait is over
+  return Seconds ((1 - tokens) / rate) + TimeStep (1);
+}
+
+SdnPacketInMeter13::Port&
+SdnPacketInMeter13::GetPort (uint32_t inPort)
+{
+  if (inPort >= m_ports.size ())
+    {
+      Port port;
+      port.bucket.tokens = m_portBurst;
+      port.bucket.last = Simulator::Now ();
+      m_ports.resize (inPort + 1, port);
+    }
+  return m_ports[inPort];
+}
+
+bool
+SdnPacketInMeter13::IsPending (const SdnFlowKey &key) const
+{
+  const Pending &pending = m_pending[key.Hash () % SDN_PACKET_IN_PENDING_SLOTS];
+  return pending.generation == m_generation && pending.key.Equals (key) &&
+         pending.sent + m_coalesceTimeout > Simulator::Now ();
+}
+
+void
+SdnPacketInMeter13::SetPending (const SdnFlowKey &key)
+{
+  Pending &pending = m_pending[key.Hash () % SDN_PACKET_IN_PENDING_SLOTS];
+  pending.generation = m_generation;
+  pending.key = key;
+  pending.sent = Simulator::Now ();
+}
+
+bool
+SdnPacketInMeter13::Consume (Port &port)
+{
+  Refill (m_bucket, m_rate, m_burst);
+  Refill (port.bucket, m_portRate, m_portBurst);
+  if (m_bucket.tokens < 1 - TOKEN_EPSILON || port.bucket.tokens < 1 - TOKEN_EPSILON)
+    {
+      return false;
+    }
+  if (m_rate > 0)
+    {
+      m_bucket.tokens -= 1;
+    }
+  if (m_portRate > 0)
+    {
+      port.bucket.tokens -= 1;
+    }
+  return true;
+}
+
+} //End namespace ns3
@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_PACKET_IN_METER13_H
+#define SDN_PACKET_IN_METER13_H
+
+//Stdlib packages
+#include <vector>
+#include <deque>
+//ns3 utilities
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+//Sdn classes
+#include "SdnFlowKey.h"
+
+#define SDN_PACKET_IN_PENDING_SLOTS 256 //!< Number of slots remembering the keys of recent PacketIns
+
+namespace ns3 {
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnPacketInMeter13
+ *
+ * \brief Rate limiter for the table misses an SdnSwitch13 reports to its controller
+ *
+ * A PacketIn needs a token from the bucket of the switch and one from the bucket of its
+ * ingress port. Buckets refill from the elapsed simulation time when they are looked at,
+ * so an idle meter costs nothing. A miss without tokens waits in the queue of its port;
+ * the queues are drained round robin so one busy port cannot starve the others, and a
+ * miss finding its queue full is suppressed.
+ *
+ * Misses can also be coalesced: once a PacketIn went out for a flow key, further misses
+ * with the same key are suppressed until the controller sends a flow mod or the coalescing
+ * timeout passes.
+ */
+class SdnPacketInMeter13
+{
+public:
+  /**
+   * A table miss to report to the controller
+   */
+  struct Miss
+  {
+    Ptr<Packet> packet; //!< The missed packet
+    uint32_t inPort;    //!< The port it arrived on
+    uint8_t reason;     //!< The OFPR reason of the PacketIn
+    SdnFlowKey key;     //!< Its flow key
+  };
+  /**
+   * What to do with a miss
+   */
+  enum Verdict
+  {
+    SEND,    //!< Send the PacketIn now
+    DEFER,   //!< Queued, Drain returns it once tokens are available
+    SUPPRESS //!< Coalesced with a pending PacketIn, or its queue is full
+  };
+
+  SdnPacketInMeter13 ();
+  /**
+   * \brief Sets the bucket shared by every port
+   * \param rate Sustained PacketIns per second, 0 for no limit
+   * \param burst Bucket depth
+   */
+  void SetSwitchRate (double rate, uint32_t burst);
+  /**
+   * \brief Sets the bucket each ingress port gets
+   * \param rate Sustained PacketIns per second, 0 for no limit
+   * \param burst Bucket depth
+   */
+  void SetPortRate (double rate, uint32_t burst);
+  /**
+   * \param size Number of misses each port may queue, 0 suppresses every miss without tokens
+   */
+  void SetQueueSize (uint32_t size);
+  /**
+   * \param timeout How long the key of a PacketIn suppresses further misses, 0 disables coalescing
+   */
+  void SetCoalesceTimeout (Time timeout);
+  /**
+   * \return True if any limit or coalescing is configured
+   */
+  bool IsEnabled (void) const;
+  /**
+   * \return True if misses must carry their flow key
+   */
+  bool IsCoalescing (void) const;
+  /**
+   * \brief Decides what happens to a miss, taking its tokens if it may go now
+   * \param miss The miss, copied into its port queue when deferred
+   * \return The verdict
+   */
+  Verdict Admit (const Miss &miss);
+  /**
+   * \brief Takes the queued misses the buckets allow, round robin over the ports
+   * \param ready Receives the misses to send now
+   * \param suppressed Receives the queued misses coalesced meanwhile
+   */
+  void Drain (std::vector<Miss> &ready, std::vector<Miss> &suppressed);
+  /**
+   * \return True if some misses are queued
+   */
+  bool HasQueued (void) const;
+  /**
+   * \return The delay until Drain can release a queued miss. Only meaningful if HasQueued
+   */
+  Time GetDrainDelay (void) const;
+  /**
+   * \brief Forgets the keys of the PacketIns sent so far, the controller has answered
+   */
+  void ClearPending (void);
+  /**
+   * \brief Drops every queued miss
+   */
+  void Clear (void);
+
+private:
+  /**
+   * A token bucket
+   */
+  struct Bucket
+  {
+    double tokens; //!< Tokens left at last
+    Time last;     //!< Last refill
+  };
+  /**
+   * The bucket and miss queue of an ingress port
+   */
+  struct Port
+  {
+    Bucket bucket;          //!< Tokens of the port
+    std::deque<Miss> queue; //!< Misses waiting for tokens
+  };
+  /**
+   * The key of a recent PacketIn
+   */
+  struct Pending
+  {
+    uint64_t generation; //!< ClearPending generation it was sent in, 0 if empty
+    SdnFlowKey key;      //!< The flow key
+    Time sent;           //!< When the PacketIn went out
+  };
+
+  /**
+   * \brief Adds the tokens earned since the last refill
+   */
+  static void Refill (Bucket &bucket, double rate, uint32_t burst);
+  /**
+   * \return The delay until the bucket holds a token
+   */
+  static Time Wait (const Bucket &bucket, double rate, uint32_t burst);
+  /**
+   * \return The bucket and queue of a port, created full on first use
+   */
+  Port& GetPort (uint32_t inPort);
+  bool IsPending (const SdnFlowKey &key) const;
+  void SetPending (const SdnFlowKey &key);
+  /**
+   * \brief Takes a token from both buckets if both have one
+   * \return True if the tokens were taken
+   */
+  bool Consume (Port &port);
+
+  double m_rate;            //!< Switch rate, 0 for no limit
+  uint32_t m_burst;         //!< Switch bucket depth
+  double m_portRate;        //!< Port rate, 0 for no limit
+  uint32_t m_portBurst;     //!< Port bucket depth
+  uint32_t m_queueSize;     //!< Misses each port may queue
+  Time m_coalesceTimeout;   //!< Lifetime of a pending key, 0 disables coalescing
+  Bucket m_bucket;          //!< Tokens of the switch
+  std::vector<Port> m_ports;                   //!< Buckets and queues by port number
+  std::deque<uint32_t> m_backlog;              //!< Ports with queued misses, in round robin order
+  std::vector<Pending> m_pending;              //!< Recent PacketIn keys, indexed by key hash
+  uint64_t m_generation;                       //!< Current ClearPending generation, never 0
+};
+
+} //End namespace ns3
+#endif
@@ -0,0 +1,495 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include "SdnPacketParser.h"
+#include "ns3/header.h"
+
+namespace ns3 {
+
+#define ETH_HEADER_LEN  14
+#define LLC_SNAP_LEN    8
+#define ETH_TYPE_IPV4   0x0800
+#define ETH_TYPE_ARP    0x0806
+#define ETH_TYPE_IPV6   0x86DD
+#define ARP_PACKET_LEN  28
+#define IPV4_HEADER_LEN 20
+#define IPV6_HEADER_LEN 40
+#define IP_PROTO_ICMP   1
+#define IP_PROTO_TCP    6
+#define IP_PROTO_UDP    17
+#define IP_PROTO_ICMPV6 58
+#define IP_PROTO_SCTP   132
+#define ICMPV6_ND_SOLICIT 135
+#define ICMPV6_ND_ADVERT  136
+#define IPV4_CHECKSUM_OFFSET 10
+#define TCP_CHECKSUM_OFFSET  16
+#define UDP_CHECKSUM_OFFSET  6
+
+/**
+ * Where the headers of a frame start inside the copied bytes
+ */
+struct SdnPacketLayout
+{
+  uint32_t size;    //!< Number of bytes copied out of the packet
+  uint16_t ethType; //!< Ethernet type, taken from the SNAP header for 802.3 frames
+  uint32_t l3;      //!< Offset of the network header
+  uint8_t proto;    //!< IPv4 protocol or last IPv6 next header
+  uint32_t l4;      //!< Offset of the transport header, 0 if there is none to parse
+};
+
+static inline uint16_t
+Read16 (const uint8_t *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+/**
+ * \brief The head of a frame rewritten by RewriteOf10, put back in front of the packet as raw bytes
+ */
+class SdnFrameHeader : public Header
+{
+public:
+  static TypeId GetTypeId (void);
+  SdnFrameHeader ();
+  /**
+   * \param data The bytes, they must outlive the header
+   * \param size Number of bytes
+   */
+  SdnFrameHeader (const uint8_t *data, uint32_t size);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  const uint8_t *m_data; //!< The rewritten bytes
+  uint32_t m_size;       //!< Number of rewritten bytes
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SdnFrameHeader);
+
+TypeId
+SdnFrameHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SdnFrameHeader")
+    .SetParent<Header> ()
+    .AddConstructor<SdnFrameHeader> ()
+  ;
+  return tid;
+}
+
+SdnFrameHeader::SdnFrameHeader ()
+  : m_data (0),
+    m_size (0)
+{
+}
+
+SdnFrameHeader::SdnFrameHeader (const uint8_t *data, uint32_t size)
+  : m_data (data),
+    m_size (size)
+{
+}
+
+TypeId
+SdnFrameHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+SdnFrameHeader::Print (std::ostream &os) const
+{
+  os << "rewritten frame head";
+}
+
+uint32_t
+SdnFrameHeader::GetSerializedSize (void) const
+{
+  return m_size;
+}
+
+void
+SdnFrameHeader::Serialize (Buffer::Iterator start) const
+{
+  start.Write (m_data, m_size);
+}
+
+uint32_t
+SdnFrameHeader::Deserialize (Buffer::Iterator start)
+{
+  // Only ever added to packets, the bytes are read back by the headers they contain
+  return 0;
+}
+
+/**
+ * Walks the IPv6 extension headers up to the transport header
+ */
+static void
+ParseIpv6Extensions (const uint8_t *data, SdnPacketLayout &layout)
+{
+  uint8_t next = data[layout.l3 + 6];
+  uint32_t offset = layout.l3 + IPV6_HEADER_LEN;
+  // Bounded walk, a well-formed packet does not chain this many headers
+  for (uint8_t i = 0; i < 8 && offset + 8 <= layout.size; ++i)
+    {
+      if (next == 0 || next == 43 || next == 60) // hop-by-hop, routing, destination options
+        {
+          uint32_t length = (data[offset + 1] + 1) * 8;
+          next = data[offset];
+          offset += length;
+        }
+      else if (next == 51) // authentication header
+        {
+          uint32_t length = (data[offset + 1] + 2) * 4;
+          next = data[offset];
+          offset += length;
+        }
+      else if (next == 44) // fragment, only the first fragment carries the transport header
+        {
+          bool first = (Read16 (data + offset + 2) & 0xfff8) == 0;
+          next = data[offset];
+          offset += 8;
+          if (!first)
+            {
+              layout.proto = next;
+              layout.l4 = 0;
+              return;
+            }
+        }
+      else
+        {
+          break;
+        }
+    }
+  layout.proto = next;
+  layout.l4 = offset;
+}
+
+/**
+ * Copies the head of the packet and locates its headers
+ */
+static void
+ParseLayout (Ptr<const Packet> packet, uint8_t *data, SdnPacketLayout &layout)
+{
+  layout.size = packet->CopyData (data, SDN_PARSER_BYTES);
+  layout.ethType = 0;
+  layout.l3 = 0;
+  layout.proto = 0;
+  layout.l4 = 0;
+  if (layout.size < ETH_HEADER_LEN)
+    {
+      return;
+    }
+  layout.ethType = Read16 (data + 12);
+  layout.l3 = ETH_HEADER_LEN;
+  if (layout.ethType <= 1500)
+    {
+      // 802.3 length interpretation, the type is in the LLC/SNAP header
+      if (layout.size < ETH_HEADER_LEN + LLC_SNAP_LEN)
+        {
+          layout.ethType = 0;
+          return;
+        }
+      layout.ethType = Read16 (data + ETH_HEADER_LEN + 6);
+      layout.l3 += LLC_SNAP_LEN;
+    }
+  if (layout.ethType == ETH_TYPE_IPV4 && layout.l3 + IPV4_HEADER_LEN <= layout.size)
+    {
+      const uint8_t *ip = data + layout.l3;
+      layout.proto = ip[9];
+      // Later fragments do not carry the transport header
+      if ((Read16 (ip + 6) & 0x1fff) == 0)
+        {
+          layout.l4 = layout.l3 + (ip[0] & 0x0f) * 4;
+        }
+    }
+  else if (layout.ethType == ETH_TYPE_IPV6 && layout.l3 + IPV6_HEADER_LEN <= layout.size)
+    {
+      ParseIpv6Extensions (data, layout);
+    }
+}
+
+/**
+ * \return True if length bytes of the transport header were copied
+ */
+static inline bool
+HasL4 (const SdnPacketLayout &layout, uint32_t length)
+{
+  return layout.l4 != 0 && layout.l4 + length <= layout.size;
+}
+
+/**
+ * Folds the change of a 16-bit word into a ones' complement checksum, as in RFC 1624.
+ * A zero checksum is one ns-3 did not compute and is left alone
+ */
+static void
+UpdateChecksum (uint8_t *checksum, uint16_t before, uint16_t after)
+{
+  if (checksum == 0 || (checksum[0] | checksum[1]) == 0)
+    {
+      return;
+    }
+  uint32_t sum = (uint16_t)~Read16 (checksum) + (uint16_t)~before + after;
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  uint16_t result = ~sum;
+  // Both zeros are the same in ones' complement, keep the one telling the checksum is in use
+  if (result == 0)
+    {
+      result = 0xffff;
+    }
+  checksum[0] = result >> 8;
+  checksum[1] = result & 0xff;
+}
+
+/**
+ * Copies a field of the key over the frame if it changed, updating the checksums covering it.
+ * All the fields RewriteOf10 writes are whole 16-bit words of their headers
+ */
+static void
+PatchField (uint8_t *data, uint8_t field, const SdnFlowKey &extracted, const SdnFlowKey &key,
+            uint8_t *checksum, uint8_t *l4Checksum)
+{
+  uint8_t offset = SdnFlowKey::FieldOffset (field);
+  uint8_t length = SdnFlowKey::FieldLength (field);
+  const uint8_t *value = key.Bytes () + offset;
+  if (memcmp (value, extracted.Bytes () + offset, length) == 0)
+    {
+      return;
+    }
+  for (uint8_t i = 0; i < length; i += 2)
+    {
+      uint16_t before = Read16 (data + i);
+      data[i] = value[i];
+      data[i + 1] = value[i + 1];
+      UpdateChecksum (checksum, before, Read16 (data + i));
+      UpdateChecksum (l4Checksum, before, Read16 (data + i));
+    }
+}
+
+void
+SdnPacketParser::Extract (Ptr<const Packet> packet, uint32_t inPort, SdnFlowKey &key)
+{
+  uint8_t data[SDN_PARSER_BYTES];
+  SdnPacketLayout layout;
+  ParseLayout (packet, data, layout);
+
+  key.Clear ();
+  key.SetField32 (fluid_msg::of13::OFPXMT_OFB_IN_PORT, inPort);
+  key.SetField32 (fluid_msg::of13::OFPXMT_OFB_IN_PHY_PORT, inPort);
+  if (layout.size < ETH_HEADER_LEN)
+    {
+      return;
+    }
+  key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_DST, data);
+  key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_SRC, data + 6);
+  key.SetField16 (fluid_msg::of13::OFPXMT_OFB_ETH_TYPE, layout.ethType);
+  //No VLAN support in ns-3 frames, report OFPVID_NONE
+  key.SetField16 (fluid_msg::of13::OFPXMT_OFB_VLAN_VID, 0);
+
+  const uint8_t *l3 = data + layout.l3;
+  if (layout.ethType == ETH_TYPE_ARP)
+    {
+      if (layout.l3 + ARP_PACKET_LEN <= layout.size)
+        {
+          key.SetField16 (fluid_msg::of13::OFPXMT_OFB_ARP_OP, Read16 (l3 + 6));
+          key.SetField (fluid_msg::of13::OFPXMT_OFB_ARP_SHA, l3 + 8);
+          key.SetField (fluid_msg::of13::OFPXMT_OFB_ARP_SPA, l3 + 14);
+          key.SetField (fluid_msg::of13::OFPXMT_OFB_ARP_THA, l3 + 18);
+          key.SetField (fluid_msg::of13::OFPXMT_OFB_ARP_TPA, l3 + 24);
+        }
+      return;
+    }
+  if (layout.ethType == ETH_TYPE_IPV4 && layout.l3 + IPV4_HEADER_LEN <= layout.size)
+    {
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_DSCP, l3[1] >> 2);
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_ECN, l3[1] & 0x03);
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_PROTO, layout.proto);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, l3 + 12);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_DST, l3 + 16);
+      if (layout.proto == IP_PROTO_ICMP && HasL4 (layout, 2))
+        {
+          key.SetField8 (fluid_msg::of13::OFPXMT_OFB_ICMPV4_TYPE, data[layout.l4]);
+          key.SetField8 (fluid_msg::of13::OFPXMT_OFB_ICMPV4_CODE, data[layout.l4 + 1]);
+        }
+    }
+  else if (layout.ethType == ETH_TYPE_IPV6 && layout.l3 + IPV6_HEADER_LEN <= layout.size)
+    {
+      uint8_t trafficClass = ((l3[0] & 0x0f) << 4) | (l3[1] >> 4);
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_DSCP, trafficClass >> 2);
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_ECN, trafficClass & 0x03);
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_PROTO, layout.proto);
+      key.SetField32 (fluid_msg::of13::OFPXMT_OFB_IPV6_FLABEL, ((l3[1] & 0x0f) << 16) | (l3[2] << 8) | l3[3]);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV6_SRC, l3 + 8);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV6_DST, l3 + 24);
+      if (layout.proto == IP_PROTO_ICMPV6 && HasL4 (layout, 2))
+        {
+          const uint8_t *icmp = data + layout.l4;
+          key.SetField8 (fluid_msg::of13::OFPXMT_OFB_ICMPV6_TYPE, icmp[0]);
+          key.SetField8 (fluid_msg::of13::OFPXMT_OFB_ICMPV6_CODE, icmp[1]);
+          if ((icmp[0] == ICMPV6_ND_SOLICIT || icmp[0] == ICMPV6_ND_ADVERT) && HasL4 (layout, 24))
+            {
+              key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV6_ND_TARGET, icmp + 8);
+              // Source (1) or target (2) link-layer address option, whichever the message carries
+              uint8_t wanted = icmp[0] == ICMPV6_ND_SOLICIT ? 1 : 2;
+              uint32_t option = layout.l4 + 24;
+              while (option + 8 <= layout.size && data[option + 1] != 0)
+                {
+                  if (data[option] == wanted)
+                    {
+                      key.SetField (wanted == 1 ? fluid_msg::of13::OFPXMT_OFB_IPV6_ND_SLL
+                                    : fluid_msg::of13::OFPXMT_OFB_IPV6_ND_TLL, data + option + 2);
+                      break;
+                    }
+                  option += data[option + 1] * 8;
+                }
+            }
+        }
+    }
+  else
+    {
+      return;
+    }
+
+  if (!HasL4 (layout, 4))
+    {
+      return;
+    }
+  const uint8_t *l4 = data + layout.l4;
+  switch (layout.proto)
+    {
+    case IP_PROTO_TCP:
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_SRC, Read16 (l4));
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_DST, Read16 (l4 + 2));
+      break;
+    case IP_PROTO_UDP:
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_UDP_SRC, Read16 (l4));
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_UDP_DST, Read16 (l4 + 2));
+      break;
+    case IP_PROTO_SCTP:
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_SCTP_SRC, Read16 (l4));
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_SCTP_DST, Read16 (l4 + 2));
+      break;
+    default:
+      break;
+    }
+}
+
+void
+SdnPacketParser::ExtractOf10 (Ptr<const Packet> packet, uint16_t inPort, SdnFlowKey &key)
+{
+  uint8_t data[SDN_PARSER_BYTES];
+  SdnPacketLayout layout;
+  ParseLayout (packet, data, layout);
+
+  key.Clear ();
+  key.SetField32 (fluid_msg::of13::OFPXMT_OFB_IN_PORT, inPort);
+  if (layout.size >= ETH_HEADER_LEN)
+    {
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_DST, data);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_ETH_SRC, data + 6);
+      key.SetField16 (fluid_msg::of13::OFPXMT_OFB_ETH_TYPE, layout.ethType);
+    }
+
+  const uint8_t *l3 = data + layout.l3;
+  if (layout.ethType == ETH_TYPE_ARP && layout.l3 + ARP_PACKET_LEN <= layout.size)
+    {
+      // The low byte of the opcode goes in nw_proto
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_PROTO, l3[7]);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, l3 + 14);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_DST, l3 + 24);
+    }
+  else if (layout.ethType == ETH_TYPE_IPV4 && layout.l3 + IPV4_HEADER_LEN <= layout.size)
+    {
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_DSCP, l3[1] & 0xfc); //zero out the last 2 bits that are ignored by the ToS
+      key.SetField8 (fluid_msg::of13::OFPXMT_OFB_IP_PROTO, layout.proto);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, l3 + 12);
+      key.SetField (fluid_msg::of13::OFPXMT_OFB_IPV4_DST, l3 + 16);
+      if (layout.proto == IP_PROTO_ICMP && HasL4 (layout, 2))
+        {
+          key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_SRC, data[layout.l4]);
+          key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_DST, data[layout.l4 + 1]);
+        }
+      else if ((layout.proto == IP_PROTO_TCP || layout.proto == IP_PROTO_UDP) && HasL4 (layout, 4))
+        {
+          key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_SRC, Read16 (data + layout.l4));
+          key.SetField16 (fluid_msg::of13::OFPXMT_OFB_TCP_DST, Read16 (data + layout.l4 + 2));
+        }
+    }
+  // OpenFlow 1.0 has no prerequisites, see SdnFlowKey::Compile
+  key.fields = 0;
+}
+
+bool
+SdnPacketParser::RewriteOf10 (Ptr<Packet> packet, const SdnFlowKey &extracted, const SdnFlowKey &key)
+{
+  if (key.Equals (extracted))
+    {
+      return false;
+    }
+  uint8_t data[SDN_PARSER_BYTES];
+  SdnPacketLayout layout;
+  ParseLayout (packet, data, layout);
+  if (layout.size < ETH_HEADER_LEN)
+    {
+      return false;
+    }
+  PatchField (data, fluid_msg::of13::OFPXMT_OFB_ETH_DST, extracted, key, 0, 0);
+  PatchField (data + 6, fluid_msg::of13::OFPXMT_OFB_ETH_SRC, extracted, key, 0, 0);
+
+  if (layout.ethType == ETH_TYPE_IPV4 && layout.l3 + IPV4_HEADER_LEN <= layout.size)
+    {
+      uint8_t *ip = data + layout.l3;
+      uint8_t *checksum = ip + IPV4_CHECKSUM_OFFSET;
+      uint8_t *l4Checksum = 0;
+      if (layout.proto == IP_PROTO_TCP && HasL4 (layout, TCP_CHECKSUM_OFFSET + 2))
+        {
+          l4Checksum = data + layout.l4 + TCP_CHECKSUM_OFFSET;
+        }
+      else if (layout.proto == IP_PROTO_UDP && HasL4 (layout, UDP_CHECKSUM_OFFSET + 2))
+        {
+          l4Checksum = data + layout.l4 + UDP_CHECKSUM_OFFSET;
+        }
+
+      // The key holds the whole ToS byte with the ECN bits cleared, those stay as they are
+      uint8_t tos = key.Bytes ()[SdnFlowKey::FieldOffset (fluid_msg::of13::OFPXMT_OFB_IP_DSCP)];
+      if ((tos & 0xfc) != (ip[1] & 0xfc))
+        {
+          uint16_t before = Read16 (ip);
+          ip[1] = (tos & 0xfc) | (ip[1] & 0x03);
+          UpdateChecksum (checksum, before, Read16 (ip));
+        }
+      // The addresses are part of the TCP/UDP pseudo header
+      PatchField (ip + 12, fluid_msg::of13::OFPXMT_OFB_IPV4_SRC, extracted, key, checksum, l4Checksum);
+      PatchField (ip + 16, fluid_msg::of13::OFPXMT_OFB_IPV4_DST, extracted, key, checksum, l4Checksum);
+      if (l4Checksum)
+        {
+          PatchField (data + layout.l4, fluid_msg::of13::OFPXMT_OFB_TCP_SRC, extracted, key, l4Checksum, 0);
+          PatchField (data + layout.l4 + 2, fluid_msg::of13::OFPXMT_OFB_TCP_DST, extracted, key, l4Checksum, 0);
+        }
+    }
+
+  SdnFrameHeader head (data, layout.size);
+  packet->RemoveAtStart (layout.size);
+  packet->AddHeader (head);
+  return true;
+}
+
+} //End namespace ns3
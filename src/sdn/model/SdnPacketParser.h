@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_PACKET_PARSER_H
+#define SDN_PACKET_PARSER_H
+
+//ns3 utilities
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+//Sdn classes
+#include "SdnFlowKey.h"
+
+namespace ns3 {
+
+#define SDN_PARSER_BYTES 128 //!< Number of leading packet bytes copied out for parsing
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnPacketParser
+ *
+ * \brief Extracts the flow key of a packet straight from its bytes
+ *
+ * The switch sees whole Ethernet frames, so the headers are parsed from a copy of the
+ * first SDN_PARSER_BYTES bytes held on the stack: Ethernet (DIX or LLC/SNAP), ARP,
+ * IPv4, IPv6 with its extension headers, ICMPv4, ICMPv6 neighbor discovery, TCP, UDP
+ * and SCTP. Nothing is allocated and the packet metadata is not needed.
+ */
+class SdnPacketParser
+{
+public:
+  /**
+   * \brief Builds the OpenFlow 1.3 key of a packet
+   *
+   * Only the fields actually present in the packet are marked in the key.
+   * \param packet The frame, starting with its Ethernet header
+   * \param inPort The switch port the packet arrived on
+   * \param key The key receiving the fields
+   */
+  static void Extract (Ptr<const Packet> packet, uint32_t inPort, SdnFlowKey &key);
+  /**
+   * \brief Builds the OpenFlow 1.0 key of a packet
+   *
+   * Follows the OpenFlow 1.0 conventions: the ARP opcode and addresses go in nw_proto,
+   * nw_src and nw_dst, ICMP type and code in tp_src and tp_dst, and absent fields are zero.
+   * \param packet The frame, starting with its Ethernet header
+   * \param inPort The switch port the packet arrived on
+   * \param key The key receiving the fields
+   */
+  static void ExtractOf10 (Ptr<const Packet> packet, uint16_t inPort, SdnFlowKey &key);
+  /**
+   * \brief Writes the OpenFlow 1.0 fields edited in a key back into its frame
+   *
+   * Set field actions only edit the key. The fields that differ from the extracted key
+   * are patched into a copy of the head of the frame, the IPv4 header and TCP/UDP
+   * checksums being updated incrementally, and the head replaces the original bytes.
+   * No header is deserialized and nothing is done if no field changed.
+   * \param packet The frame the key was extracted from
+   * \param extracted The key ExtractOf10 returned for the frame
+   * \param key The key after the set field actions
+   * \return True if the frame was rewritten
+   */
+  static bool RewriteOf10 (Ptr<Packet> packet, const SdnFlowKey &extracted, const SdnFlowKey &key);
+};
+
+} //End namespace ns3
+#endif
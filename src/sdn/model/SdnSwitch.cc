@@ -20,6 +20,7 @@
 #include "SdnSwitch.h"
 #include "SdnController.h"
 #include "SdnConnection.h"
+#include "SdnPacketParser.h"
 #include "ns3/log.h"
 #include "ns3/socket.h"
 #include "ns3/socket-factory.h"
@@ -40,8 +41,6 @@ namespace ns3 {
 #define MB 8000000
 #define mb 1000000
 
-#define MAX_BUFFERS 1000000000
-
 #ifndef INT16_MAX
 #define INT16_MAX 32767
 #endif
@@ -63,6 +62,24 @@ TypeId SdnSwitch::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&SdnSwitch::m_kernel),
                    MakeBooleanChecker ())
+    .AddAttribute ("PacketBufferSize",
+                   "Number of packets buffered for PacketIn messages. The oldest is evicted when full, 0 disables buffering.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&SdnSwitch::SetPacketBufferSize,
+                                         &SdnSwitch::GetPacketBufferSize),
+                   MakeUintegerChecker<uint32_t> (0, 0x7fffffff))
+    .AddAttribute ("PacketBufferTimeout",
+                   "How long a packet stays buffered for a PacketIn before it may be evicted.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SdnSwitch::SetPacketBufferTimeout,
+                                     &SdnSwitch::GetPacketBufferTimeout),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("FastReceive",
+                   "Put the Layer2P2PNetDevice ports in fast sdn receive mode and run received frames "
+                   "through the pipeline without copying them.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SdnSwitch::m_fastReceive),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -76,12 +93,10 @@ SdnSwitch::SdnSwitch () : m_flowTable(this)
   m_missSendLen = INT16_MAX;
   m_recvEvent = EventId ();
   TOTAL_PORTS = 0;
+  m_fastReceive = false;
   m_controllerConn = CreateObject<SdnConnection> ();
 
-  m_bufferIdStream = CreateObject<UniformRandomVariable> ();
-  m_bufferIdStream->SetAttribute("Min", DoubleValue(0.0));
-  m_bufferIdStream->SetAttribute("Max", DoubleValue(MAX_BUFFERS));
-  m_switchFeatures.n_buffers = MAX_BUFFERS;
+  m_switchFeatures.n_buffers = 0;
 
   m_kernel = false;
 }
@@ -91,6 +106,29 @@ SdnSwitch::~SdnSwitch ()
   NS_LOG_FUNCTION (this);
 }
 
+void SdnSwitch::SetPacketBufferSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_packetBuffers.SetCapacity (size);
+  m_switchFeatures.n_buffers = size;
+}
+
+uint32_t SdnSwitch::GetPacketBufferSize (void) const
+{
+  return m_packetBuffers.GetCapacity ();
+}
+
+void SdnSwitch::SetPacketBufferTimeout (Time timeout)
+{
+  NS_LOG_FUNCTION (this << timeout);
+  m_packetBuffers.SetTimeout (timeout);
+}
+
+Time SdnSwitch::GetPacketBufferTimeout (void) const
+{
+  return m_packetBuffers.GetTimeout ();
+}
+
 void SdnSwitch::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
@@ -232,7 +270,8 @@ void SdnSwitch::EstablishConnection (Ptr<NetDevice> device,
   if(l2Device)
     {
       l2Device->SetSdnEnable(true);
-      l2Device->SetSdnReceiveCallback(MakeCallback(&SdnSwitch::HandleReadFromNetDevice, this));
+      l2Device->SetSdnFastReceive (m_fastReceive);
+      l2Device->SetSdnReceiveCallback(MakeCallback(&SdnSwitch::HandleReadFromPort, this).Bind (switchPort));
       Ptr<SdnConnection> c = CreateObject<SdnConnection> (device, socket);
       Ptr<Layer2P2PChannel> channel = DynamicCast<Layer2P2PChannel>(device->GetChannel());
       uint32_t portFeaturesMask = 0;
@@ -259,7 +298,7 @@ void SdnSwitch::EstablishConnection (Ptr<NetDevice> device,
 	    }
 	}
       Ptr<SdnPort> p = CreateObject<SdnPort> (device, c, switchPort, 0, 0, portFeaturesMask);
-      m_portMap.insert (std::make_pair (p->getPortNumber(),p));
+      AddPort (p);
     }
 }
 
@@ -301,57 +340,59 @@ void SdnSwitch::HandleReadController (Ptr<Socket> socket)
 
       NS_ASSERT (m_controllerConn->get_socket () == socket);
 
-      packet->RemoveAllPacketTags ();
-      packet->RemoveAllByteTags ();
-
       NS_LOG_DEBUG ("Switch recv " << packet->GetSize () << " bytes");
+      m_controllerConn->receive (packet);
 
-      uint8_t buffer[packet->GetSize ()];
-      packet->CopyData (buffer,packet->GetSize ());
-      fluid_msg::OFMsg* message = new fluid_msg::OFMsg (buffer);
-
-      //These handlers should return number of bytes sent
-      if (message->type () == fluid_msg::of10::OFPT_HELLO)
-        {
-          OFHandle_Hello_Request(message);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_FEATURES_REQUEST)
-        {
-          OFHandle_Feature_Request(message);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_GET_CONFIG_REQUEST)
-        {
-          OFHandle_Get_Config_Request();
-        }
-      if (message->type () == fluid_msg::of10::OFPT_SET_CONFIG)
-        {
-          OFHandle_Set_Config(buffer);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_FLOW_MOD)
+      // Dispatch every complete message in place, a packet may carry several of them
+      uint8_t* buffer;
+      uint16_t length;
+      while ((buffer = m_controllerConn->next_message (length)))
         {
-          OFHandle_Flow_Mod(buffer);
-        }
-//      if (message->type () == fluid_msg::of10::OFPT_PORT_STATUS)
-//        {
-//          OFHandle_Port_Status(buffer);
-//        }
-      if (message->type () == fluid_msg::of10::OFPT_STATS_REQUEST)
-        {
-          OFHandle_Stats_Request(buffer);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_PACKET_OUT)
-        {
-          OFHandle_Packet_Out(buffer);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_PORT_MOD)
-        {
-          OFHandle_Port_Mod(buffer);
-        }
-      if (message->type () == fluid_msg::of10::OFPT_BARRIER_REQUEST)
-        {
-          OFHandle_Barrier_Request(buffer);
+          fluid_msg::OFMsg message (buffer);
+          uint8_t type = buffer[1];
+
+          //These handlers should return number of bytes sent
+          if (type == fluid_msg::of10::OFPT_HELLO)
+            {
+              OFHandle_Hello_Request(&message);
+            }
+          if (type == fluid_msg::of10::OFPT_FEATURES_REQUEST)
+            {
+              OFHandle_Feature_Request(&message);
+            }
+          if (type == fluid_msg::of10::OFPT_GET_CONFIG_REQUEST)
+            {
+              OFHandle_Get_Config_Request();
+            }
+          if (type == fluid_msg::of10::OFPT_SET_CONFIG)
+            {
+              OFHandle_Set_Config(buffer);
+            }
+          if (type == fluid_msg::of10::OFPT_FLOW_MOD)
+            {
+              OFHandle_Flow_Mod(buffer);
+            }
+    //      if (type == fluid_msg::of10::OFPT_PORT_STATUS)
+    //        {
+    //          OFHandle_Port_Status(buffer);
+    //        }
+          if (type == fluid_msg::of10::OFPT_STATS_REQUEST)
+            {
+              OFHandle_Stats_Request(buffer);
+            }
+          if (type == fluid_msg::of10::OFPT_PACKET_OUT)
+            {
+              OFHandle_Packet_Out(buffer);
+            }
+          if (type == fluid_msg::of10::OFPT_PORT_MOD)
+            {
+              OFHandle_Port_Mod(buffer);
+            }
+          if (type == fluid_msg::of10::OFPT_BARRIER_REQUEST)
+            {
+              OFHandle_Barrier_Request(buffer);
+            }
         }
-      delete (message);
     }
 }
 
@@ -360,24 +401,74 @@ bool SdnSwitch::HandleReadFromNetDevice (Ptr<NetDevice> device, Ptr<const Packet
 {
   NS_LOG_FUNCTION (this << device << originalPacket << protocol << source);
 
+  Ptr<SdnPort> port = GetPortByDevice (device);
+  return HandleReadFromPort (port ? port->getPortNumber () : 0, device, originalPacket, protocol, source);
+}
+
+bool SdnSwitch::HandleReadFromPort (uint16_t inPort, Ptr<NetDevice> device, Ptr<const Packet> originalPacket, uint16_t protocol, const Address &source )
+{
+  NS_LOG_FUNCTION (this << inPort << device << originalPacket << protocol << source);
+
   if(m_controllerConn->get_state() != fluid_base::OFConnection::STATE_RUNNING)
     {
       NS_LOG_WARN ("Received a packet on a switch but we're not in running mode yet! Dropping packet");
       return 0;
     }
-  Ptr<Packet> packet = originalPacket->Copy();
+  // In fast receive mode the device hands the frame over, there is nobody to copy it for
+  Ptr<Packet> packet = m_fastReceive ? ConstCast<Packet> (originalPacket) : originalPacket->Copy ();
+
+  return HandlePacket (packet, inPort);
+}
 
-  uint16_t inPort = 0;
-  for(std::map<uint16_t,Ptr<SdnPort> >::iterator portIterator = m_portMap.begin(); portIterator != m_portMap.end(); ++portIterator)
+void SdnSwitch::AddPort (Ptr<SdnPort> port)
+{
+  NS_LOG_FUNCTION (this << port);
+  uint16_t portNo = port->getPortNumber ();
+  m_portMap[portNo] = port;
+  if (portNo >= m_portIndex.size ())
     {
-      if(portIterator->second && portIterator->second->getDevice() == device)
-        {
-          inPort = portIterator->first;
-          break;
-        }
+      m_portIndex.resize (portNo + 1);
+    }
+  m_portIndex[portNo] = port;
+  uint32_t ifIndex = port->getDevice ()->GetIfIndex ();
+  if (ifIndex >= m_devicePorts.size ())
+    {
+      m_devicePorts.resize (ifIndex + 1);
     }
+  m_devicePorts[ifIndex] = port;
+}
 
-  return HandlePacket (packet, inPort);
+void SdnSwitch::RemovePort (uint16_t portNo)
+{
+  NS_LOG_FUNCTION (this << portNo);
+  Ptr<SdnPort> port = GetPort (portNo);
+  if (!port)
+    {
+      return;
+    }
+  Ptr<Layer2P2PNetDevice> l2Device = DynamicCast<Layer2P2PNetDevice> (port->getDevice ());
+  if (l2Device)
+    {
+      l2Device->SetSdnEnable (false);
+    }
+  m_devicePorts[port->getDevice ()->GetIfIndex ()] = 0;
+  m_portIndex[portNo] = 0;
+  m_portMap.erase (portNo);
+}
+
+Ptr<SdnPort> SdnSwitch::GetPort (uint16_t portNo) const
+{
+  return portNo < m_portIndex.size () ? m_portIndex[portNo] : 0;
+}
+
+Ptr<SdnPort> SdnSwitch::GetPortByDevice (Ptr<NetDevice> device) const
+{
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex < m_devicePorts.size () && m_devicePorts[ifIndex] && m_devicePorts[ifIndex]->getDevice () == device)
+    {
+      return m_devicePorts[ifIndex];
+    }
+  return 0;
 }
 
 bool SdnSwitch::HandlePacket (Ptr<Packet>packet, uint16_t inPort)
@@ -386,17 +477,18 @@ bool SdnSwitch::HandlePacket (Ptr<Packet>packet, uint16_t inPort)
   std::vector<uint16_t> outPorts = m_flowTable.handlePacket (packet, inPort);
 
   //Handle packet in message
-  if (outPorts.empty() && m_portMap.count(inPort))
+  Ptr<SdnPort> inputPort = GetPort (inPort);
+  if (outPorts.empty() && inputPort)
     {
-      SendPacketInToController(packet, m_portMap[inPort]->getDevice (), fluid_msg::of10::OFPR_NO_MATCH);
+      SendPacketInToController(packet, inputPort->getDevice (), fluid_msg::of10::OFPR_NO_MATCH);
       return 1;
     }
   //Send out on port assuming it's enabled
   for (std::vector<uint16_t>::iterator outPort = outPorts.begin(); outPort != outPorts.end(); ++outPort)
   {
-    if ((*outPort == fluid_msg::of10::OFPP_CONTROLLER) && m_portMap.count(inPort))
+    if ((*outPort == fluid_msg::of10::OFPP_CONTROLLER) && inputPort)
       {
-        SendPacketInToController(packet, m_portMap[inPort]->getDevice (), fluid_msg::of10::OFPR_ACTION);
+        SendPacketInToController(packet, inputPort->getDevice (), fluid_msg::of10::OFPR_ACTION);
         return 1;
       }
     //Handle flooding
@@ -406,13 +498,10 @@ bool SdnSwitch::HandlePacket (Ptr<Packet>packet, uint16_t inPort)
         return 1;
       }
     //Handle packet output
-    if (m_portMap.count (*outPort) != 0)
+    Ptr<SdnPort> portStruct = GetPort (*outPort);
+    if(portStruct && !(portStruct->getConfig() & (fluid_msg::of10::OFPPC_PORT_DOWN | fluid_msg::of10::OFPPC_NO_RECV | fluid_msg::of10::OFPPC_NO_FWD)))
       {
-        Ptr<SdnPort> portStruct = m_portMap[*outPort];
-        if(portStruct && !(portStruct->getConfig() & (fluid_msg::of10::OFPPC_PORT_DOWN | fluid_msg::of10::OFPPC_NO_RECV | fluid_msg::of10::OFPPC_NO_FWD)))
-          {
-            portStruct->getConn()->sendOnNetDevice (packet);
-          }
+        portStruct->getConn()->sendOnNetDevice (packet);
       }
   }
   return 0;
@@ -512,11 +601,11 @@ void SdnSwitch::OFHandle_Flow_Mod(uint8_t* buffer)
       if (flowMod->command () != fluid_msg::of10::OFPFC_DELETE &&
 	      flowMod->command () != fluid_msg::of10::OFPFC_DELETE_STRICT)
 	{
+          Ptr<Packet> bufferedPacket;
           if ((flowMod->buffer_id () != (uint32_t)(-1)) &&
-      	    (m_packetBuffers.count (flowMod->buffer_id ())))
+              (bufferedPacket = m_packetBuffers.Take (flowMod->buffer_id ())))
             {
-              Ptr<Packet> copyPacket = m_packetBuffers[flowMod->buffer_id ()]->Copy ();
-              HandlePacket (copyPacket, flowMod->match ().in_port ());
+              HandlePacket (bufferedPacket, flowMod->match ().in_port ());
             }
 	}
     }
@@ -731,34 +820,37 @@ void SdnSwitch::OFHandle_Packet_Out(uint8_t* buffer)
       dataBuffer = (uint8_t*)packetOut->data();
       packet = Create<Packet>(dataBuffer, dataSize);
     }
-  // Buffer ID matches one from packet buffers.
-  else if (m_packetBuffers.count (packetOut->buffer_id ()))
-    {
-      packet = m_packetBuffers[packetOut->buffer_id ()]->Copy ();
-//      m_packetBuffers.erase (packetOut->buffer_id ());
-    }
+  // Buffer ID matches one from packet buffers, the packet leaves the buffer.
   else
     {
-      NS_LOG_WARN ("Received buffer id without an associated packet");
-      return;
+      packet = m_packetBuffers.Take (packetOut->buffer_id ());
+      if (!packet)
+        {
+          NS_LOG_WARN ("Received buffer id without an associated packet");
+          return;
+        }
     }
   uint16_t outPort = fluid_msg::of10::OFPP_NONE;
   
   std::list<fluid_msg::Action*> action_list = packetOut->actions().action_list();
 
+  SdnFlowKey extracted;
+  SdnPacketParser::ExtractOf10 (packet, packetOut->in_port (), extracted);
+  SdnFlowKey key = extracted;
   fluid_msg::Action* action;
   for (std::list<fluid_msg::Action*>::iterator j = action_list.begin (); j != action_list.end(); ++j)
     {
       action = *j;
       if(action->type() == fluid_msg::of10::OFPAT_OUTPUT)
         {
-          outPort = m_flowTable.handleAction(packet,action);
+          outPort = m_flowTable.handleAction(packet,action,key);
         }
       else
         {
-          m_flowTable.handleAction(packet,action);
+          m_flowTable.handleAction(packet,action,key);
         }
     }
+  SdnPacketParser::RewriteOf10 (packet, extracted, key);
   if(outPort == fluid_msg::of10::OFPP_FLOOD)
     {
       Flood(packet, packetOut->in_port());
@@ -769,9 +861,9 @@ void SdnSwitch::OFHandle_Packet_Out(uint8_t* buffer)
 	  HandlePacket (packet, packetOut->in_port());
 	  return;
     }
-  if (m_portMap.count(outPort) != 0)
+  Ptr<SdnPort> outputPort = GetPort (outPort);
+  if (outputPort)
     {
-      Ptr<SdnPort> outputPort = m_portMap[outPort]; //Might be wrong?
       outputPort->getConn()->sendOnNetDevice(packet);
     }
 }
@@ -779,36 +871,12 @@ void SdnSwitch::OFHandle_Packet_Out(uint8_t* buffer)
 void SdnSwitch::SendPacketInToController(Ptr<Packet> packet, Ptr<NetDevice> device, uint8_t reason)
 {
   NS_LOG_FUNCTION (this << packet << device << reason);
-  Ptr<SdnPort> port;
-  for(std::map<uint16_t,Ptr<SdnPort> >::iterator portIterator = m_portMap.begin(); portIterator != m_portMap.end(); ++portIterator)
-    {
-      if(portIterator->second && portIterator->second->getDevice() == device)
-        {
-          port = portIterator->second;
-          break;
-        }
-    }
+  Ptr<SdnPort> port = GetPortByDevice (device);
   
-  // While the maximum number of buffered packets has not been exceeded, add the
-  // packet to the buffer before sending
-  fluid_msg::of10::PacketIn* packetIn;
-  if (m_packetBuffers.size () <= MAX_BUFFERS)
-    {
-      uint32_t newId = 0;
-      do
-	{
-	  newId = m_bufferIdStream->GetInteger ();
-	} while (m_packetBuffers.count (newId) == 1);
-
-      m_packetBuffers[newId] = packet->Copy ();
-      packetIn = new fluid_msg::of10::PacketIn(SdnCommon::GenerateXId(),
-    	  newId, port->getPortNumber(), packet->GetSize(), reason);
-    }
-  else
-    {
-      packetIn = new fluid_msg::of10::PacketIn(SdnCommon::GenerateXId(),
-    	  -1, port->getPortNumber(), packet->GetSize(), reason);
-    }
+  // Buffer the packet before sending, unless buffering is disabled (SDN_NO_BUFFER)
+  uint32_t bufferId = m_packetBuffers.Store (packet->Copy ());
+  fluid_msg::of10::PacketIn* packetIn = new fluid_msg::of10::PacketIn(SdnCommon::GenerateXId(),
+      bufferId, port->getPortNumber(), packet->GetSize(), reason);
   uint8_t buffer[packet->GetSize ()];
   packet->CopyData (buffer,packet->GetSize ());
   packetIn->data(buffer,packet->GetSize());
@@ -24,6 +24,7 @@
 #include "SdnFlowTable.h"
 #include "SdnConnection.h"
 #include "SdnPort.h"
+#include "SdnBufferPool.h"
 //NS3 objects
 #include "ns3/application.h"
 #include "ns3/bridge-channel.h"
@@ -139,6 +140,24 @@ public:
    * \brief Sends a Flow Removed Message To Controller. Used by the flow table so it's public
    */
   void SendFlowRemovedMessageToController(Flow flow, uint8_t reason);
+  /**
+   * \brief Resizes the pool of packets buffered for PacketIn messages, dropping every buffered packet
+   * \param size The number of buffers, 0 sends every PacketIn unbuffered
+   */
+  void SetPacketBufferSize (uint32_t size);
+  /**
+   * \return The number of packet buffers
+   */
+  uint32_t GetPacketBufferSize (void) const;
+  /**
+   * \brief Sets how long a packet stays buffered before it may be evicted
+   * \param timeout The buffering time
+   */
+  void SetPacketBufferTimeout (Time timeout);
+  /**
+   * \return The buffering time of a packet
+   */
+  Time GetPacketBufferTimeout (void) const;
   SdnSwitch ();
   ~SdnSwitch ();
   static uint32_t TOTAL_SERIAL_NUMBERS; //!< Global counter for all unique switch IDs
@@ -179,6 +198,34 @@ protected:
    * \brief Overarching receive callback function to handle data from a switch. Calls many other supporting functions
    */
   virtual bool HandleReadFromNetDevice (Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address &);
+  /**
+   * \brief Receive callback of a single port. Bound to the port number when the port is attached, so the
+   * ingress port is known without a lookup
+   * \param inPort The port the device is attached to
+   */
+  virtual bool HandleReadFromPort (uint16_t inPort, Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address &);
+  /**
+   * \brief Attaches a port, indexing it by port number and by device
+   * \param port The port to attach
+   */
+  void AddPort (Ptr<SdnPort> port);
+  /**
+   * \brief Detaches a port and drops it from the indexes
+   * \param portNo The number of the port to detach
+   */
+  void RemovePort (uint16_t portNo);
+  /**
+   * \brief Looks up a port by number
+   * \param portNo The port number
+   * \return The port, 0 if there is none
+   */
+  Ptr<SdnPort> GetPort (uint16_t portNo) const;
+  /**
+   * \brief Looks up the port a device is attached to
+   * \param device A device of the switch node
+   * \return The port, 0 if the device is not attached
+   */
+  Ptr<SdnPort> GetPortByDevice (Ptr<NetDevice> device) const;
   /**
    * \brief Handle the packet
    */
@@ -370,12 +417,14 @@ protected:
   Ptr<SdnConnection> m_controllerConn;
   Features m_switchFeatures; //!<Features on the switch that we need to return when asked from the controller
   PortMap m_portMap; //!<Making a mapping of all devices to the virtual ports for the flow table to use
+  std::vector< Ptr<SdnPort> > m_portIndex; //!< Ports by port number, kept in sync with m_portMap
+  std::vector< Ptr<SdnPort> > m_devicePorts; //!< Ports by the interface index of their device
 
   static uint32_t xid; //!< A Unique XID for the switch. XIDs are global unique identifiers for messages/siwtches/controllers within sdn
   uint16_t TOTAL_PORTS; //!< A counter counting the total number of ports ever used by this switch
 
-  Ptr<UniformRandomVariable> m_bufferIdStream;
-  std::map< uint32_t, Ptr<Packet> > m_packetBuffers;
+  SdnBufferPool m_packetBuffers; //!< Packets buffered for PacketIn messages
+  bool m_fastReceive;            //!< Frames are received without copies, see Layer2P2PNetDevice::SetSdnFastReceive
 
   bool m_kernel; //!< Use the Linux kernel stack (DCE-only)
 
@@ -30,6 +30,7 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/layer2-p2p-module.h"
 #include "ns3/ipv4.h"
+#include "SdnPacketParser.h"
 
 #include "fluid/util/ethaddr.hh"
 
@@ -40,8 +41,6 @@ namespace ns3 {
 #define MB 8000000
 #define mb 1000000
 
-#define MAX_BUFFERS 1000000000
-
 #ifndef INT16_MAX
 #define INT16_MAX 32767
 #endif
@@ -58,6 +57,98 @@ TypeId SdnSwitch13::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::SdnSwitch13")
     .SetParent<Application> ()
     .AddConstructor<SdnSwitch13> ()
+    .AddAttribute ("FlowClassifier",
+                   "The packet classifier used by the flow tables of the switch.",
+                   EnumValue (SdnFlowTable13::TUPLE_SPACE_CLASSIFIER),
+                   MakeEnumAccessor (&SdnSwitch13::SetFlowClassifier,
+                                     &SdnSwitch13::GetFlowClassifier),
+                   MakeEnumChecker (SdnFlowTable13::TUPLE_SPACE_CLASSIFIER, "TupleSpace",
+                                    SdnFlowTable13::LINEAR_CLASSIFIER, "Linear"))
+    .AddAttribute ("FlowCacheSize",
+                   "Number of slots of the exact-match microflow cache in front of the flow tables, 0 to disable it.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&SdnSwitch13::SetFlowCacheSize,
+                                         &SdnSwitch13::GetFlowCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("FlowCacheHits",
+                     "Number of packets forwarded straight from the microflow cache.",
+                     MakeTraceSourceAccessor (&SdnSwitch13::m_flowCacheHits))
+    .AddTraceSource ("FlowCacheMisses",
+                     "Number of packets that had to go through the flow tables.",
+                     MakeTraceSourceAccessor (&SdnSwitch13::m_flowCacheMisses))
+    .AddAttribute ("FlowTimeoutGranularity",
+                   "Tick length of the wheel expiring idle and hard flow timeouts. Flows expire at most this late.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&SdnSwitch13::SetFlowTimeoutGranularity,
+                                     &SdnSwitch13::GetFlowTimeoutGranularity),
+                   MakeTimeChecker (TimeStep (1)))
+    .AddAttribute ("FlowModBatching",
+                   "When flow mods from the controller are installed. Batching checks conflicts and "
+                   "rebuilds the classifier once per batch. With Barrier, flow mods wait for the next "
+                   "barrier request, so the controller must send one.",
+                   EnumValue (SdnSwitch13::FLOW_MOD_BATCH_READ),
+                   MakeEnumAccessor (&SdnSwitch13::m_flowModBatching),
+                   MakeEnumChecker (SdnSwitch13::FLOW_MOD_BATCH_READ, "Read",
+                                    SdnSwitch13::FLOW_MOD_IMMEDIATE, "Immediate",
+                                    SdnSwitch13::FLOW_MOD_BATCH_BARRIER, "Barrier"))
+    .AddTraceSource ("FlowModBatch",
+                     "A batch of flow mods was installed: number of flow mods, and time since the oldest one was received.",
+                     MakeTraceSourceAccessor (&SdnSwitch13::m_flowModBatchTrace))
+    .AddAttribute ("PacketBufferSize",
+                   "Number of packets buffered for PacketIn messages. The oldest is evicted when full, 0 disables buffering.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&SdnSwitch13::SetPacketBufferSize,
+                                         &SdnSwitch13::GetPacketBufferSize),
+                   MakeUintegerChecker<uint32_t> (0, 0x7fffffff))
+    .AddAttribute ("PacketBufferTimeout",
+                   "How long a packet stays buffered for a PacketIn before it may be evicted.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SdnSwitch13::SetPacketBufferTimeout,
+                                     &SdnSwitch13::GetPacketBufferTimeout),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("FastReceive",
+                   "Put the Layer2P2PNetDevice ports in fast sdn receive mode and run received frames "
+                   "through the pipeline without copying them.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SdnSwitch13::m_fastReceive),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PacketInRate",
+                   "PacketIns per second the switch may send to the controller, 0 for no limit.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&SdnSwitch13::m_packetInRate),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PacketInBurst",
+                   "PacketIns the switch may send back to back above PacketInRate.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&SdnSwitch13::m_packetInBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacketInPortRate",
+                   "PacketIns per second each ingress port may send to the controller, 0 for no limit.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&SdnSwitch13::m_packetInPortRate),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PacketInPortBurst",
+                   "PacketIns an ingress port may send back to back above PacketInPortRate.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&SdnSwitch13::m_packetInPortBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacketInQueueSize",
+                   "PacketIns each ingress port may hold back while out of tokens. Beyond that they are dropped.",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&SdnSwitch13::m_packetInQueueSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PacketInCoalesceTimeout",
+                   "How long a PacketIn suppresses further misses of the same flow key, unless a flow mod "
+                   "arrives first. 0 disables coalescing.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SdnSwitch13::m_packetInCoalesceTimeout),
+                   MakeTimeChecker (Seconds (0)))
+    .AddTraceSource ("PacketInSuppressed",
+                     "A table miss was not reported: coalesced with a pending PacketIn or its port queue was full.",
+                     MakeTraceSourceAccessor (&SdnSwitch13::m_packetInSuppressedTrace))
+    .AddTraceSource ("PacketInDeferred",
+                     "A table miss was held back until the PacketIn meter has tokens again.",
+                     MakeTraceSourceAccessor (&SdnSwitch13::m_packetInDeferredTrace))
   ;
   return tid;
 }
@@ -66,6 +157,16 @@ SdnSwitch13::SdnSwitch13 ()
 {
   NS_LOG_FUNCTION (this);
   PacketMetadata::Enable();
+  m_flowClassifier = SdnFlowTable13::TUPLE_SPACE_CLASSIFIER;
+  m_flowCacheHits = 0;
+  m_flowCacheMisses = 0;
+  m_flowModBatching = FLOW_MOD_BATCH_READ;
+  m_packetInRate = 0;
+  m_packetInBurst = 64;
+  m_packetInPortRate = 0;
+  m_packetInPortBurst = 16;
+  m_packetInQueueSize = 64;
+  m_fastReceive = false;
   m_datapathID =  getNewDatapathID ();
   m_vendor = 0xFFFF;
   m_missSendLen = INT16_MAX;
@@ -73,10 +174,7 @@ SdnSwitch13::SdnSwitch13 ()
   TOTAL_PORTS = 0;
   m_controllerConn = CreateObject<SdnConnection> ();
 
-  m_bufferIdStream = CreateObject<UniformRandomVariable> ();
-  m_bufferIdStream->SetAttribute("Min", DoubleValue(0.0));
-  m_bufferIdStream->SetAttribute("Max", DoubleValue(MAX_BUFFERS));
-  m_switchFeatures.n_buffers = MAX_BUFFERS;
+  m_switchFeatures.n_buffers = 0;
 
   m_flowTable13 = SdnFlowTable13::addTablesForNewSwitch(this);
   m_kernel = false;
@@ -87,9 +185,121 @@ SdnSwitch13::~SdnSwitch13 ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+SdnSwitch13::SetFlowClassifier (SdnFlowTable13::ClassifierType type)
+{
+  NS_LOG_FUNCTION (this << type);
+  m_flowClassifier = type;
+  std::vector< Ptr<SdnFlowTable13> > &tables = SdnFlowTable13::g_flowTables[m_datapathID];
+  for (std::vector< Ptr<SdnFlowTable13> >::iterator i = tables.begin (); i != tables.end (); ++i)
+    {
+      (*i)->SetClassifierType (type);
+    }
+}
+
+SdnFlowTable13::ClassifierType
+SdnSwitch13::GetFlowClassifier (void) const
+{
+  return m_flowClassifier;
+}
+
+void
+SdnSwitch13::SetFlowCacheSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_flowCache.SetSize (size);
+}
+
+uint32_t
+SdnSwitch13::GetFlowCacheSize (void) const
+{
+  return m_flowCache.GetSize ();
+}
+
+void
+SdnSwitch13::InvalidateFlowCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flowCache.Invalidate ();
+}
+
+void
+SdnSwitch13::SetFlowTimeoutGranularity (Time granularity)
+{
+  NS_LOG_FUNCTION (this << granularity);
+  m_flowTimeouts.SetGranularity (granularity);
+}
+
+Time
+SdnSwitch13::GetFlowTimeoutGranularity (void) const
+{
+  return m_flowTimeouts.GetGranularity ();
+}
+
+void
+SdnSwitch13::ScheduleFlowTimeout (SdnFlowTable13 *table, uint64_t flowId, Time deadline)
+{
+  NS_LOG_FUNCTION (this << table << flowId << deadline);
+  m_flowTimeouts.Insert (table, flowId, deadline);
+  if (!m_flowTimeoutEvent.IsRunning ())
+    {
+      m_flowTimeoutEvent = Simulator::Schedule (m_flowTimeouts.GetNextTick () - Simulator::Now (),
+                                                &SdnSwitch13::SweepFlowTimeouts, this);
+    }
+}
+
+void
+SdnSwitch13::SweepFlowTimeouts (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<SdnTimeoutWheel13::Timer> due;
+  m_flowTimeouts.Advance (due);
+  // Flows still in use put a new timer in the wheel, which also schedules the next sweep
+  for (std::vector<SdnTimeoutWheel13::Timer>::iterator i = due.begin (); i != due.end (); ++i)
+    {
+      i->table->checkTimeouts (i->flowId);
+    }
+  if (m_flowTimeouts.GetSize () > 0 && !m_flowTimeoutEvent.IsRunning ())
+    {
+      m_flowTimeoutEvent = Simulator::Schedule (m_flowTimeouts.GetNextTick () - Simulator::Now (),
+                                                &SdnSwitch13::SweepFlowTimeouts, this);
+    }
+}
+
+void SdnSwitch13::SetPacketBufferSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_packetBuffers.SetCapacity (size);
+  m_switchFeatures.n_buffers = size;
+}
+
+uint32_t SdnSwitch13::GetPacketBufferSize (void) const
+{
+  return m_packetBuffers.GetCapacity ();
+}
+
+void SdnSwitch13::SetPacketBufferTimeout (Time timeout)
+{
+  NS_LOG_FUNCTION (this << timeout);
+  m_packetBuffers.SetTimeout (timeout);
+}
+
+Time SdnSwitch13::GetPacketBufferTimeout (void) const
+{
+  return m_packetBuffers.GetTimeout ();
+}
+
 void SdnSwitch13::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_flowTimeoutEvent.Cancel ();
+  for (std::vector<fluid_msg::of13::FlowMod*>::iterator i = m_stagedFlowMods.begin (); i != m_stagedFlowMods.end (); ++i)
+    {
+      delete *i;
+    }
+  m_stagedFlowMods.clear ();
+  m_packetInDrainEvent.Cancel ();
+  m_packetInMeter.Clear ();
 
   Application::DoDispose ();
 }
@@ -158,7 +368,8 @@ void SdnSwitch13::EstablishConnection (Ptr<NetDevice> device,
   if(l2Device)
     {
       l2Device->SetSdnEnable(true);
-      l2Device->SetSdnReceiveCallback(MakeCallback(&SdnSwitch13::HandleReadFromNetDevice, this));
+      l2Device->SetSdnFastReceive (m_fastReceive);
+      l2Device->SetSdnReceiveCallback(MakeCallback(&SdnSwitch13::HandleReadFromPort, this).Bind (switchPort));
       Ptr<SdnConnection> c = CreateObject<SdnConnection> (device, socket);
       Ptr<Layer2P2PChannel> channel = DynamicCast<Layer2P2PChannel>(device->GetChannel());
       uint32_t portFeaturesMask = 0;
@@ -185,7 +396,7 @@ void SdnSwitch13::EstablishConnection (Ptr<NetDevice> device,
 	    }
 	}
       Ptr<SdnPort> p = CreateObject<SdnPort> (device, c, switchPort, 0, 0, portFeaturesMask);
-      m_portMap.insert (std::make_pair (p->getPortNumber(),p));
+      AddPort (p);
     }
 }
 
@@ -193,6 +404,11 @@ void SdnSwitch13::StartApplication (void)
 {
   NS_LOG_FUNCTION (this);
 
+  m_packetInMeter.SetSwitchRate (m_packetInRate, m_packetInBurst);
+  m_packetInMeter.SetPortRate (m_packetInPortRate, m_packetInPortBurst);
+  m_packetInMeter.SetQueueSize (m_packetInQueueSize);
+  m_packetInMeter.SetCoalesceTimeout (m_packetInCoalesceTimeout);
+
   uint32_t t_numDevices = GetNode ()->GetNDevices ();
   for (uint32_t i = 0; i < t_numDevices; ++i)
     {
@@ -296,61 +512,74 @@ void SdnSwitch13::HandleReadController (Ptr<Socket> socket)
 
       NS_ASSERT (m_controllerConn->get_socket () == socket);
 
-      packet->RemoveAllPacketTags ();
-      packet->RemoveAllByteTags ();
-
       NS_LOG_DEBUG ("Switch recv " << packet->GetSize () << " bytes");
+      m_controllerConn->receive (packet);
 
-      uint8_t buffer[packet->GetSize ()];
-      packet->CopyData (buffer,packet->GetSize ());
-      fluid_msg::OFMsg* message = new fluid_msg::OFMsg (buffer);
-
-      //These handlers should return number of bytes sent
-      if (message->type () == fluid_msg::of13::OFPT_HELLO)
+      // Dispatch every complete message in place, a packet may carry several of them
+      uint8_t* buffer;
+      uint16_t length;
+      while ((buffer = m_controllerConn->next_message (length)))
         {
-          OFHandle_Hello_Request(message);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_FEATURES_REQUEST)
-        {
-          OFHandle_Feature_Request(message);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_GET_CONFIG_REQUEST)
-        {
-          OFHandle_Get_Config_Request();
-        }
-      if (message->type () == fluid_msg::of13::OFPT_SET_CONFIG)
-        {
-          OFHandle_Set_Config(buffer);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_FLOW_MOD)
-        {
-          OFHandle_Flow_Mod(buffer);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_GROUP_MOD)
-        {
-    	  OFHandle_Group_Mod(buffer);
-        }
-//      if (message->type () == fluid_msg::of10::OFPT_PORT_STATUS)
-//        {
-//          OFHandle_Port_Status(buffer);
-//        }
-      if (message->type () == fluid_msg::of13::OFPT_PACKET_OUT)
-        {
-          OFHandle_Packet_Out(buffer);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_PORT_MOD)
-        {
-          OFHandle_Port_Mod(buffer);
-        }
-      if (message->type () == fluid_msg::of13::OFPT_BARRIER_REQUEST)
-        {
-          OFHandle_Barrier_Request(buffer);
+          fluid_msg::OFMsg message (buffer);
+          uint8_t type = buffer[1];
+
+          // Staged flow mods must take effect before any other message is handled
+          if (type != fluid_msg::of13::OFPT_FLOW_MOD &&
+              (m_flowModBatching != FLOW_MOD_BATCH_BARRIER || type == fluid_msg::of13::OFPT_BARRIER_REQUEST))
+            {
+              FlushFlowMods ();
+            }
+
+          //These handlers should return number of bytes sent
+          if (type == fluid_msg::of13::OFPT_HELLO)
+            {
+              OFHandle_Hello_Request(&message);
+            }
+          if (type == fluid_msg::of13::OFPT_FEATURES_REQUEST)
+            {
+              OFHandle_Feature_Request(&message);
+            }
+          if (type == fluid_msg::of13::OFPT_GET_CONFIG_REQUEST)
+            {
+              OFHandle_Get_Config_Request();
+            }
+          if (type == fluid_msg::of13::OFPT_SET_CONFIG)
+            {
+              OFHandle_Set_Config(buffer);
+            }
+          if (type == fluid_msg::of13::OFPT_FLOW_MOD)
+            {
+              OFHandle_Flow_Mod(buffer);
+            }
+          if (type == fluid_msg::of13::OFPT_GROUP_MOD)
+            {
+              OFHandle_Group_Mod(buffer);
+            }
+    //      if (type == fluid_msg::of10::OFPT_PORT_STATUS)
+    //        {
+    //          OFHandle_Port_Status(buffer);
+    //        }
+          if (type == fluid_msg::of13::OFPT_PACKET_OUT)
+            {
+              OFHandle_Packet_Out(buffer);
+            }
+          if (type == fluid_msg::of13::OFPT_PORT_MOD)
+            {
+              OFHandle_Port_Mod(buffer);
+            }
+          if (type == fluid_msg::of13::OFPT_BARRIER_REQUEST)
+            {
+              OFHandle_Barrier_Request(buffer);
+            }
+          if (type == fluid_msg::of13::OFPT_MULTIPART_REQUEST)
+            {
+              OFHandle_Multipart_Request(buffer);
+            }
         }
-      if (message->type() == fluid_msg::of13::OFPT_MULTIPART_REQUEST)
-       {
-    	  OFHandle_Multipart_Request(buffer);
-       }
-      delete (message);
+    }
+  if (m_flowModBatching == FLOW_MOD_BATCH_READ)
+    {
+      FlushFlowMods ();
     }
 }
 
@@ -359,40 +588,125 @@ bool SdnSwitch13::HandleReadFromNetDevice (Ptr<NetDevice> device, Ptr<const Pack
 {
   NS_LOG_FUNCTION (this << device << originalPacket << protocol << source);
 
+  Ptr<SdnPort> port = GetPortByDevice (device);
+  return HandleReadFromPort (port ? port->getPortNumber () : 0, device, originalPacket, protocol, source);
+}
+
+bool SdnSwitch13::HandleReadFromPort (uint32_t inPort, Ptr<NetDevice> device, Ptr<const Packet> originalPacket, uint16_t protocol, const Address &source )
+{
+  NS_LOG_FUNCTION (this << inPort << device << originalPacket << protocol << source);
+
   if(m_controllerConn->get_state() != fluid_base::OFConnection::STATE_RUNNING)
     {
       NS_LOG_WARN ("Received a packet on a switch but we're not in running mode yet! Dropping packet");
       return 0;
     }
-  Ptr<Packet> packet = originalPacket->Copy();
+  // In fast receive mode the device hands the frame over, there is nobody to copy it for
+  Ptr<Packet> packet = m_fastReceive ? ConstCast<Packet> (originalPacket) : originalPacket->Copy ();
 
-  uint32_t inPort = 0;
-  for(std::map<uint32_t,Ptr<SdnPort> >::iterator portIterator = m_portMap.begin(); portIterator != m_portMap.end(); ++portIterator)
+  return HandlePacket (packet, inPort);
+}
+
+void SdnSwitch13::AddPort (Ptr<SdnPort> port)
+{
+  NS_LOG_FUNCTION (this << port);
+  uint32_t portNo = port->getPortNumber ();
+  m_portMap[portNo] = port;
+  if (portNo >= m_portIndex.size ())
     {
-      if(portIterator->second && portIterator->second->getDevice() == device)
-        {
-          inPort = portIterator->first;
-          break;
-        }
+      m_portIndex.resize (portNo + 1);
+    }
+  m_portIndex[portNo] = port;
+  uint32_t ifIndex = port->getDevice ()->GetIfIndex ();
+  if (ifIndex >= m_devicePorts.size ())
+    {
+      m_devicePorts.resize (ifIndex + 1);
     }
+  m_devicePorts[ifIndex] = port;
+}
 
-  return HandlePacket (packet, inPort);
+void SdnSwitch13::RemovePort (uint32_t portNo)
+{
+  NS_LOG_FUNCTION (this << portNo);
+  Ptr<SdnPort> port = GetPort (portNo);
+  if (!port)
+    {
+      return;
+    }
+  Ptr<Layer2P2PNetDevice> l2Device = DynamicCast<Layer2P2PNetDevice> (port->getDevice ());
+  if (l2Device)
+    {
+      l2Device->SetSdnEnable (false);
+    }
+  m_devicePorts[port->getDevice ()->GetIfIndex ()] = 0;
+  m_portIndex[portNo] = 0;
+  m_portMap.erase (portNo);
+  InvalidateFlowCache ();
+}
+
+Ptr<SdnPort> SdnSwitch13::GetPort (uint32_t portNo) const
+{
+  return portNo < m_portIndex.size () ? m_portIndex[portNo] : 0;
+}
+
+Ptr<SdnPort> SdnSwitch13::GetPortByDevice (Ptr<NetDevice> device) const
+{
+  uint32_t ifIndex = device->GetIfIndex ();
+  if (ifIndex < m_devicePorts.size () && m_devicePorts[ifIndex] && m_devicePorts[ifIndex]->getDevice () == device)
+    {
+      return m_devicePorts[ifIndex];
+    }
+  return 0;
 }
 
 bool SdnSwitch13::HandlePacket (Ptr<Packet>packet, uint32_t inPort)
 {
   NS_LOG_FUNCTION (this << packet << inPort);
+  SdnFlowKey key;
+  SdnPacketParser::Extract (packet, inPort, key);
+
+  // Replay what the pipeline did for the last packet with this exact key
+  const SdnFlowCache13::Entry *cached = m_flowCache.Find (key);
+  if (cached)
+    {
+      m_flowCacheHits++;
+      for (std::vector<SdnFlowCache13::Lookup>::const_iterator i = cached->lookups.begin (); i != cached->lookups.end (); ++i)
+        {
+          i->table->recordLookup (i->flow, packet);
+        }
+      // HandlePorts may re-enter HandlePacket and overwrite the slot, work on a copy
+      std::vector< std::vector<uint32_t> > applied = cached->applied;
+      std::vector<uint32_t> outPorts = cached->outPorts;
+      for (std::vector< std::vector<uint32_t> >::iterator i = applied.begin (); i != applied.end (); ++i)
+        {
+          HandlePorts (packet, *i, inPort);
+        }
+      if (!outPorts.empty ())
+        {
+          HandlePorts (packet, outPorts, inPort);
+        }
+      return 0;
+    }
+  m_flowCacheMisses++;
+
+  SdnFlowCache13::Entry record;
+  record.Reset (m_flowCache.GetGeneration ());
+  record.key = key;
   fluid_msg::ActionSet *action_set = new fluid_msg::ActionSet ();
   std::vector<uint32_t> outPorts;
-  fluid_msg::ActionSet *resulting_action_set = m_flowTable13->handlePacket (packet, action_set, inPort);
+  fluid_msg::ActionSet *resulting_action_set = m_flowTable13->handlePacket (packet, action_set, inPort, key,
+                                                                            m_flowCache.GetSize () ? &record : NULL);
 
   // Process action set instead of sending out port vector (need to send reason along with messages to controller
   outPorts = m_flowTable13->handleActions (packet, resulting_action_set);
+  record.outPorts = outPorts;
 
   if (!outPorts.empty())
   {
 	  HandlePorts (packet, outPorts, inPort);
   }
+  // Dropped if flows, groups or ports changed meanwhile
+  m_flowCache.Store (record);
 
   return 0;
 }
@@ -405,8 +719,11 @@ void SdnSwitch13::HandlePorts (Ptr<Packet> packet, std::vector<uint32_t> outPort
 		    {
 			  if (*outPort == fluid_msg::of13::OFPP_IN_PORT)
 			    {
-				  Ptr<SdnPort> outputPort = m_portMap[inPort];
-				  outputPort->getConn()->sendOnNetDevice(packet);
+				  Ptr<SdnPort> outputPort = GetPort (inPort);
+				  if (outputPort)
+				    {
+				      outputPort->getConn()->sendOnNetDevice(packet);
+				    }
 			    }
 			  else if (*outPort == fluid_msg::of13::OFPP_TABLE)
 				{
@@ -428,7 +745,7 @@ void SdnSwitch13::HandlePorts (Ptr<Packet> packet, std::vector<uint32_t> outPort
 			    {
 				  // Send to controller with a reason
 				  uint8_t reason = (outPort + 1 == outPorts.end() ? fluid_msg::of13::OFPR_NO_MATCH : fluid_msg::of13::OFPR_ACTION);
-			      SendPacketInToController(packet, m_portMap[inPort]->getDevice (), reason);
+			      MeterPacketIn (packet, inPort, reason);
 			    }
 			  else if (*outPort == fluid_msg::of13::OFPP_LOCAL)
 			    {
@@ -440,9 +757,9 @@ void SdnSwitch13::HandlePorts (Ptr<Packet> packet, std::vector<uint32_t> outPort
 				}
 			  continue;
 		    }
-		  if (m_portMap.count(*outPort) != 0)
+		  Ptr<SdnPort> outputPort = GetPort (*outPort);
+		  if (outputPort)
 			{
-			  Ptr<SdnPort> outputPort = m_portMap[*outPort]; //Might be wrong?
 			  outputPort->getConn()->sendOnNetDevice(packet);
 			}
 	    }
@@ -512,13 +829,47 @@ void SdnSwitch13::OFHandle_Flow_Mod(uint8_t* buffer)
   NS_LOG_FUNCTION (this << buffer);
   fluid_msg::of13::FlowMod* flowMod = new fluid_msg::of13::FlowMod();
   flowMod->unpack(buffer);
-  if (flowMod)
+  if (m_stagedFlowMods.empty ())
+    {
+      m_stagedSince = Simulator::Now ();
+    }
+  m_stagedFlowMods.push_back (flowMod);
+  if (m_flowModBatching == FLOW_MOD_IMMEDIATE)
     {
+      FlushFlowMods ();
+    }
+}
+
+void SdnSwitch13::FlushFlowMods (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_stagedFlowMods.empty ())
+    {
+      return;
+    }
+  std::vector<fluid_msg::of13::FlowMod*> batch;
+  batch.swap (m_stagedFlowMods);
+  InvalidateFlowCache ();
+  // The controller answered, misses may be reported again
+  m_packetInMeter.ClearPending ();
+
+  // Consecutive adds go in together, any other command ends the run to keep the order
+  std::vector<fluid_msg::of13::FlowMod*> adds;
+  for (std::vector<fluid_msg::of13::FlowMod*>::iterator i = batch.begin (); i != batch.end (); ++i)
+    {
+      fluid_msg::of13::FlowMod* flowMod = *i;
+      if (flowMod->command () == fluid_msg::of13::OFPFC_ADD)
+        {
+          adds.push_back (flowMod);
+          continue;
+        }
+      if (!adds.empty ())
+        {
+          addFlows (adds);
+          adds.clear ();
+        }
       switch (flowMod->command())
         {
-          case fluid_msg::of13::OFPFC_ADD:
-            addFlow(flowMod);
-            break;
           case fluid_msg::of13::OFPFC_MODIFY:
             modifyFlow(flowMod);
             break;
@@ -532,17 +883,30 @@ void SdnSwitch13::OFHandle_Flow_Mod(uint8_t* buffer)
             deleteFlowStrict(flowMod);
             break;
         }
+    }
+  if (!adds.empty ())
+    {
+      addFlows (adds);
+    }
+  m_flowModBatchTrace (batch.size (), Simulator::Now () - m_stagedSince);
 
-		if (flowMod->command () != fluid_msg::of13::OFPFC_DELETE &&
-				flowMod->command () != fluid_msg::of13::OFPFC_DELETE_STRICT)
-		{
-			if ((flowMod->buffer_id () != (uint32_t)(-1)) &&
-			(m_packetBuffers.count (flowMod->buffer_id ())))
-			{
-			  Ptr<Packet> copyPacket = m_packetBuffers[flowMod->buffer_id ()]->Copy ();
-			  HandlePacket (copyPacket, flowMod->match ().in_port ()->value ());
-			}
-		}
+  // Buffered packets go through the pipeline once the whole batch is installed
+  for (std::vector<fluid_msg::of13::FlowMod*>::iterator i = batch.begin (); i != batch.end (); ++i)
+    {
+      fluid_msg::of13::FlowMod* flowMod = *i;
+      if (flowMod->command () != fluid_msg::of13::OFPFC_DELETE &&
+          flowMod->command () != fluid_msg::of13::OFPFC_DELETE_STRICT &&
+          flowMod->buffer_id () != (uint32_t)(-1))
+        {
+          // The match need not name in_port, the packet comes back in on the port it was buffered from
+          uint32_t inPort;
+          Ptr<Packet> bufferedPacket = m_packetBuffers.Take (flowMod->buffer_id (), inPort);
+          if (bufferedPacket)
+            {
+              HandlePacket (bufferedPacket, inPort);
+            }
+        }
+      delete flowMod;
     }
 }
 
@@ -553,6 +917,7 @@ void SdnSwitch13::OFHandle_Group_Mod(uint8_t* buffer)
   groupMod->unpack(buffer);
   if (groupMod)
     {
+      InvalidateFlowCache ();
       switch (groupMod->command())
         {
           case fluid_msg::of13::OFPGC_ADD:
@@ -597,9 +962,9 @@ void SdnSwitch13::OFHandle_Multipart_Request(uint8_t* buffer)
 void SdnSwitch13::addFlow(fluid_msg::of13::FlowMod* message)
 {
   NS_LOG_FUNCTION (this << message);
-  Flow13 flow = m_flowTable13->addFlow(message);
+  Flow13 *flow = m_flowTable13->addFlow(message);
   
-  if(flow.cookie_ != message->cookie())
+  if(flow == NULL)
     {
     
       fluid_msg::of13::Error* errorMessage = new fluid_msg::of13::Error(SdnCommon::GenerateXId(),
@@ -609,6 +974,21 @@ void SdnSwitch13::addFlow(fluid_msg::of13::FlowMod* message)
     }
 }
 
+void SdnSwitch13::addFlows(const std::vector<fluid_msg::of13::FlowMod*> &messages)
+{
+  NS_LOG_FUNCTION (this << messages.size ());
+  std::vector<bool> added = m_flowTable13->addFlows(messages);
+  for (uint32_t i = 0; i < added.size (); ++i)
+    {
+      if (!added[i])
+        {
+          fluid_msg::of13::Error* errorMessage = new fluid_msg::of13::Error(SdnCommon::GenerateXId(),
+              fluid_msg::of13::OFPET_FLOW_MOD_FAILED,fluid_msg::of13::OFPFMFC_OVERLAP);
+          m_controllerConn->send(errorMessage);
+        }
+    }
+}
+
 void SdnSwitch13::modifyFlow(fluid_msg::of13::FlowMod* message)
 {
   NS_LOG_FUNCTION (this << message);
@@ -674,6 +1054,7 @@ void SdnSwitch13::OFHandle_Port_Mod (uint8_t* buffer)
         Ptr<SdnPort> port = m_portMap[portMod->port_no()];
         uint32_t newConfig = ((portMod->config() & portMod->mask()) | (port->getConfig() & ~portMod->mask())); // & port->getAdvertised();
         port->setConfig(newConfig);
+        InvalidateFlowCache ();
       }
   }
 }
@@ -712,16 +1093,15 @@ void SdnSwitch13::OFHandle_Packet_Out(uint8_t* buffer)
       dataBuffer = (uint8_t*)packetOut->data();
       packet = Create<Packet>(dataBuffer, dataSize);
     }
-  // Buffer ID matches one from packet buffers.
-  else if (m_packetBuffers.count (packetOut->buffer_id ()))
-    {
-      packet = m_packetBuffers[packetOut->buffer_id ()]->Copy ();
-//      m_packetBuffers.erase (packetOut->buffer_id ());
-    }
+  // Buffer ID matches one from packet buffers, the packet leaves the buffer.
   else
     {
-      NS_LOG_WARN ("Received buffer id without an associated packet");
-      return;
+      packet = m_packetBuffers.Take (packetOut->buffer_id ());
+      if (!packet)
+        {
+          NS_LOG_WARN ("Received buffer id without an associated packet");
+          return;
+        }
     }
   std::vector<uint32_t> outPorts;
   
@@ -734,48 +1114,22 @@ void SdnSwitch13::OFHandle_Packet_Out(uint8_t* buffer)
   }
 }
 
-void SdnSwitch13::SendPacketInToController(Ptr<Packet> packet, Ptr<NetDevice> device, uint8_t reason)
+void SdnSwitch13::SendPacketInToController(Ptr<Packet> packet, const SdnFlowKey &key, uint8_t reason)
 {
-  NS_LOG_FUNCTION (this << packet << device << reason);
-  Ptr<SdnPort> port;
-  for(std::map<uint32_t,Ptr<SdnPort> >::iterator portIterator = m_portMap.begin(); portIterator != m_portMap.end(); ++portIterator)
-    {
-      if(portIterator->second && portIterator->second->getDevice() == device)
-        {
-          port = portIterator->second;
-          break;
-        }
-    }
+  NS_LOG_FUNCTION (this << packet << (uint32_t)reason);
   
-  // While the maximum number of buffered packets has not been exceeded, add the
-  // packet to the buffer before sending
-  fluid_msg::of13::PacketIn* packetIn;
-  if (m_packetBuffers.size () <= MAX_BUFFERS)
-    {
-      uint32_t newId = 0;
-      do
-	{
-	  newId = m_bufferIdStream->GetInteger ();
-	} while (m_packetBuffers.count (newId) == 1);
-      std::cout<<"newId is "<<newId<<std::endl;
+  // Buffer the packet before sending, unless buffering is disabled (SDN_NO_BUFFER)
+  uint32_t bufferId = m_packetBuffers.Store (packet->Copy (), key.GetField32 (fluid_msg::of13::OFPXMT_OFB_IN_PORT));
+  fluid_msg::of13::PacketIn* packetIn = new fluid_msg::of13::PacketIn(SdnCommon::GenerateXId(),
+      bufferId, packet->GetSize(), reason, 0, 0); // Last 2 are table ID and cookie.
 
-      m_packetBuffers[newId] = packet->Copy ();
-      packetIn = new fluid_msg::of13::PacketIn(SdnCommon::GenerateXId(),
-    	  newId, packet->GetSize(), reason, 0, 0); // Last 2 are table ID and cookie.
-    }
-  else
-    {
-      packetIn = new fluid_msg::of13::PacketIn(SdnCommon::GenerateXId(),
-    	  -1, packet->GetSize(), reason, 0, 0);
-    }
-
-  m_flowTable13->DestructHeader(packet);
-  fluid_msg::of13::Match match = m_flowTable13->getPacketFields((uint32_t)port->getFluidPort().port_no());
-  m_flowTable13->RestructHeader(packet);
+  fluid_msg::of13::Match match;
+  key.ToMatch (match);
 
+  // The PacketIn takes copies, the fields stay owned by match
   for (uint8_t i=0; i<OXM_NUM; ++i){
 	  if (match.oxm_field(i))
-	    packetIn->add_oxm_field(match.oxm_field(i));
+	    packetIn->add_oxm_field(*match.oxm_field(i));
 
   }
 
@@ -788,7 +1142,69 @@ void SdnSwitch13::SendPacketInToController(Ptr<Packet> packet, Ptr<NetDevice> de
  // delete(packetIn);
 }
 
-void SdnSwitch13::SendFlowRemovedMessageToController(Flow13 flow, uint8_t reason)
+void SdnSwitch13::MeterPacketIn (Ptr<Packet> packet, uint32_t inPort, uint8_t reason)
+{
+  NS_LOG_FUNCTION (this << packet << inPort << (uint32_t)reason);
+  Ptr<SdnPort> inputPort = GetPort (inPort);
+  if (!inputPort)
+    {
+      return;
+    }
+  // Parsed again, actions may have rewritten the packet since its lookup
+  SdnPacketInMeter13::Miss miss;
+  miss.packet = packet;
+  miss.inPort = inPort;
+  miss.reason = reason;
+  SdnPacketParser::Extract (packet, inPort, miss.key);
+  if (!m_packetInMeter.IsEnabled ())
+    {
+      SendPacketInToController (packet, miss.key, reason);
+      return;
+    }
+  switch (m_packetInMeter.Admit (miss))
+    {
+      case SdnPacketInMeter13::SEND:
+        SendPacketInToController (packet, miss.key, reason);
+        break;
+      case SdnPacketInMeter13::DEFER:
+        m_packetInDeferredTrace (packet, inPort);
+        if (!m_packetInDrainEvent.IsRunning ())
+          {
+            m_packetInDrainEvent = Simulator::Schedule (m_packetInMeter.GetDrainDelay (),
+                                                        &SdnSwitch13::DrainPacketIns, this);
+          }
+        break;
+      case SdnPacketInMeter13::SUPPRESS:
+        m_packetInSuppressedTrace (packet, inPort);
+        break;
+    }
+}
+
+void SdnSwitch13::DrainPacketIns (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<SdnPacketInMeter13::Miss> ready;
+  std::vector<SdnPacketInMeter13::Miss> suppressed;
+  m_packetInMeter.Drain (ready, suppressed);
+  for (std::vector<SdnPacketInMeter13::Miss>::iterator i = suppressed.begin (); i != suppressed.end (); ++i)
+    {
+      m_packetInSuppressedTrace (i->packet, i->inPort);
+    }
+  for (std::vector<SdnPacketInMeter13::Miss>::iterator i = ready.begin (); i != ready.end (); ++i)
+    {
+      if (GetPort (i->inPort))
+        {
+          SendPacketInToController (i->packet, i->key, i->reason);
+        }
+    }
+  if (m_packetInMeter.HasQueued ())
+    {
+      m_packetInDrainEvent = Simulator::Schedule (m_packetInMeter.GetDrainDelay (),
+                                                  &SdnSwitch13::DrainPacketIns, this);
+    }
+}
+
+void SdnSwitch13::SendFlowRemovedMessageToController(const Flow13 &flow, uint8_t reason)
 {
   NS_LOG_FUNCTION (this << reason);
   fluid_msg::of13::FlowRemoved* flowRemoved = new fluid_msg::of13::FlowRemoved(
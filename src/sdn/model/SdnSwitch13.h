@@ -22,8 +22,11 @@
 //Sdn Common library
 #include "SdnCommon.h"
 #include "SdnFlowTable13.h"
+#include "SdnTimeoutWheel13.h"
 #include "SdnConnection.h"
 #include "SdnPort.h"
+#include "SdnBufferPool.h"
+#include "SdnPacketInMeter13.h"
 //NS3 objects
 #include "ns3/application.h"
 #include "ns3/bridge-channel.h"
@@ -39,6 +42,9 @@
 #include "ns3/string.h"
 #include "ns3/integer.h"
 #include "ns3/uinteger.h"
+#include "ns3/traced-value.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/traced-callback.h"
 //libfluid libraries
 #include <fluid/of13msg.hh>
 #include <fluid/OFServer.hh>
@@ -147,10 +153,37 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+  /**
+   * When flow mods received from the controller are installed
+   */
+  enum FlowModBatching
+  {
+    FLOW_MOD_IMMEDIATE,    //!< Each flow mod is installed as soon as it is received
+    FLOW_MOD_BATCH_READ,   //!< Flow mods received together are installed as one batch
+    FLOW_MOD_BATCH_BARRIER //!< Flow mods are staged until the next barrier request
+  };
   /**
    * \brief Sends a Flow Removed Message To Controller. Used by the flow table so it's public
    */
-  void SendFlowRemovedMessageToController(Flow13 flow, uint8_t reason);
+  void SendFlowRemovedMessageToController(const Flow13 &flow, uint8_t reason);
+  /**
+   * \brief Resizes the pool of packets buffered for PacketIn messages, dropping every buffered packet
+   * \param size The number of buffers, 0 sends every PacketIn unbuffered
+   */
+  void SetPacketBufferSize (uint32_t size);
+  /**
+   * \return The number of packet buffers
+   */
+  uint32_t GetPacketBufferSize (void) const;
+  /**
+   * \brief Sets how long a packet stays buffered before it may be evicted
+   * \param timeout The buffering time
+   */
+  void SetPacketBufferTimeout (Time timeout);
+  /**
+   * \return The buffering time of a packet
+   */
+  Time GetPacketBufferTimeout (void) const;
   SdnSwitch13 ();
   ~SdnSwitch13 ();
   static uint32_t TOTAL_SERIAL_NUMBERS; //!< Global counter for all unique switch IDs
@@ -158,6 +191,44 @@ public:
   Ptr<SdnFlowTable13> m_flowTable13; //!< The containing flow table for this switch
   virtual uint32_t getDatapathID () { return m_datapathID; }
   virtual void HandlePorts (Ptr<Packet> packet, std::vector<uint32_t> outPorts, uint32_t inPort);
+  /**
+   * \brief Selects the packet classifier of every flow table of the switch
+   * \param type The classifier to use
+   */
+  void SetFlowClassifier (SdnFlowTable13::ClassifierType type);
+  /**
+   * \return The packet classifier used by the flow tables of the switch
+   */
+  SdnFlowTable13::ClassifierType GetFlowClassifier (void) const;
+  /**
+   * \brief Resizes the microflow cache in front of the flow tables, dropping its entries
+   * \param size The number of cache slots, 0 disables the cache
+   */
+  void SetFlowCacheSize (uint32_t size);
+  /**
+   * \return The number of microflow cache slots
+   */
+  uint32_t GetFlowCacheSize (void) const;
+  /**
+   * \brief Invalidates every microflow cache entry. Must be called whenever flows, groups or ports change
+   */
+  void InvalidateFlowCache (void);
+  /**
+   * \brief Sets the tick length of the flow timeout wheel. Only allowed before any flow with a timeout is added
+   * \param granularity The tick length, flows expire at most this late
+   */
+  void SetFlowTimeoutGranularity (Time granularity);
+  /**
+   * \return The tick length of the flow timeout wheel
+   */
+  Time GetFlowTimeoutGranularity (void) const;
+  /**
+   * \brief Sets a timer on a flow. Used by the flow tables so it's public
+   * \param table The table holding the flow
+   * \param flowId The id of the flow within the table
+   * \param deadline The simulation time at which the table wants to check the flow
+   */
+  void ScheduleFlowTimeout (SdnFlowTable13 *table, uint64_t flowId, Time deadline);
 
   /**
     * \return The 32 DPID number of the switch
@@ -192,6 +263,34 @@ protected:
    * \brief Overarching receive callback function to handle data from a switch. Calls many other supporting functions
    */
   virtual bool HandleReadFromNetDevice (Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address &);
+  /**
+   * \brief Receive callback of a single port. Bound to the port number when the port is attached, so the
+   * ingress port is known without a lookup
+   * \param inPort The port the device is attached to
+   */
+  virtual bool HandleReadFromPort (uint32_t inPort, Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address &);
+  /**
+   * \brief Attaches a port, indexing it by port number and by device
+   * \param port The port to attach
+   */
+  void AddPort (Ptr<SdnPort> port);
+  /**
+   * \brief Detaches a port and drops it from the indexes
+   * \param portNo The number of the port to detach
+   */
+  void RemovePort (uint32_t portNo);
+  /**
+   * \brief Looks up a port by number
+   * \param portNo The port number
+   * \return The port, 0 if there is none
+   */
+  Ptr<SdnPort> GetPort (uint32_t portNo) const;
+  /**
+   * \brief Looks up the port a device is attached to
+   * \param device A device of the switch node
+   * \return The port, 0 if the device is not attached
+   */
+  Ptr<SdnPort> GetPortByDevice (Ptr<NetDevice> device) const;
   /**
    * \brief Handle the packet
    */
@@ -217,10 +316,21 @@ protected:
   /**
    * \brief send a packet in message to the controller. Usually sent when a packet is not handled in the flow table
    * \param packet The packet to send to the controller
-   * \param device The device the original packet was received from
+   * \param key The flow key of the packet, in_port included, which becomes the match of the PacketIn
    * \param reason a fluid_msg OFPR reason for sending the packet in to the controller. The default is set to no match
    */
-  virtual void SendPacketInToController(Ptr<Packet> packet,Ptr<NetDevice> device, uint8_t reason = fluid_msg::of13::OFPR_NO_MATCH);
+  virtual void SendPacketInToController(Ptr<Packet> packet, const SdnFlowKey &key, uint8_t reason = fluid_msg::of13::OFPR_NO_MATCH);
+  /**
+   * \brief Passes a packet headed for the controller through the PacketIn meter
+   * \param packet The packet to send to the controller
+   * \param inPort The port the packet arrived on
+   * \param reason a fluid_msg OFPR reason for sending the packet in to the controller
+   */
+  void MeterPacketIn (Ptr<Packet> packet, uint32_t inPort, uint8_t reason);
+  /**
+   * \brief Sends the queued PacketIns the meter lets through, then waits for the next tokens
+   */
+  void DrainPacketIns (void);
   /**
    * \brief send a port status message to the controller. Usually sent when requested a port status message from the controller. This very rarely gets called in ns3 unless you are adding and removing nodes from the program
    * \param port a libfluid port structure defining the port we're concerned with
@@ -282,6 +392,15 @@ protected:
    * \param message the original flowmod message. Contains the new flow to add
    */
   void addFlow(fluid_msg::of13::FlowMod* message);
+  /**
+   * \brief Add a batch of flows to the flow table
+   * \param messages the original flowmod messages, all OFPFC_ADD
+   */
+  void addFlows(const std::vector<fluid_msg::of13::FlowMod*> &messages);
+  /**
+   * \brief Installs the staged flow mods as one batch, in the order they were received, and frees them
+   */
+  void FlushFlowMods (void);
   /**
    * \brief Modify all matching flows
    * \param message the original flowmod message. Contains the modify instructions
@@ -346,14 +465,41 @@ protected:
   Ptr<SdnConnection> m_controllerConn;
   Features13 m_switchFeatures; //!<Features on the switch that we need to return when asked from the controller
   PortMap m_portMap; //!<Making a mapping of all devices to the virtual ports for the flow table to use
+  std::vector< Ptr<SdnPort> > m_portIndex; //!< Ports by port number, kept in sync with m_portMap
+  std::vector< Ptr<SdnPort> > m_devicePorts; //!< Ports by the interface index of their device
 
   static uint32_t xid; //!< A Unique XID for the switch. XIDs are global unique identifiers for messages/siwtches/controllers within sdn
   uint32_t TOTAL_PORTS; //!< A counter counting the total number of ports ever used by this switch
 
-  Ptr<UniformRandomVariable> m_bufferIdStream;
-  std::map< uint32_t, Ptr<Packet> > m_packetBuffers;
+  SdnBufferPool m_packetBuffers; //!< Packets buffered for PacketIn messages
+  bool m_fastReceive;            //!< Frames are received without copies, see Layer2P2PNetDevice::SetSdnFastReceive
 
   bool m_kernel; //!< Use the Linux kernel stack (DCE-only)
+  SdnFlowTable13::ClassifierType m_flowClassifier; //!< Packet classifier used by the flow tables
+  SdnFlowCache13 m_flowCache; //!< Microflow cache in front of the flow tables
+  TracedValue<uint64_t> m_flowCacheHits; //!< Packets forwarded from the microflow cache
+  TracedValue<uint64_t> m_flowCacheMisses; //!< Packets that went through the flow tables
+  SdnTimeoutWheel13 m_flowTimeouts; //!< Idle and hard timeouts of the flows of every table
+  EventId m_flowTimeoutEvent; //!< The next sweep of m_flowTimeouts, only scheduled while it holds timers
+  FlowModBatching m_flowModBatching; //!< When received flow mods are installed
+  std::vector<fluid_msg::of13::FlowMod*> m_stagedFlowMods; //!< Flow mods received but not installed yet
+  Time m_stagedSince; //!< Arrival time of the oldest staged flow mod
+  TracedCallback<uint32_t, Time> m_flowModBatchTrace; //!< Fired for each installed batch with its size and install latency
+  SdnPacketInMeter13 m_packetInMeter; //!< Rate limiter of the PacketIns
+  double m_packetInRate; //!< PacketIns per second of the whole switch, 0 for no limit
+  uint32_t m_packetInBurst; //!< Bucket depth of the switch
+  double m_packetInPortRate; //!< PacketIns per second of each ingress port, 0 for no limit
+  uint32_t m_packetInPortBurst; //!< Bucket depth of each ingress port
+  uint32_t m_packetInQueueSize; //!< PacketIns each port may hold back
+  Time m_packetInCoalesceTimeout; //!< How long a PacketIn suppresses misses of the same flow key
+  EventId m_packetInDrainEvent; //!< The next drain of the PacketIn queues, only scheduled while some are held back
+  TracedCallback<Ptr<const Packet>, uint32_t> m_packetInSuppressedTrace; //!< A PacketIn was coalesced or dropped
+  TracedCallback<Ptr<const Packet>, uint32_t> m_packetInDeferredTrace; //!< A PacketIn was held back
+
+  /**
+   * \brief Periodic sweep of the flow timeout wheel, one tick at a time
+   */
+  void SweepFlowTimeouts (void);
 
   virtual void ConnectionSucceeded (Ptr<Socket> socket);
   virtual void ConnectionFailed (Ptr<Socket> socket);
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "SdnTimeoutWheel13.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnTimeoutWheel13");
+
+SdnTimeoutWheel13::SdnTimeoutWheel13 ()
+  : m_slots (SDN_TIMEOUT_WHEEL_SLOTS),
+    m_granularity (Seconds (1)),
+    m_tick (0),
+    m_size (0)
+{
+}
+
+void
+SdnTimeoutWheel13::SetGranularity (Time granularity)
+{
+  NS_ASSERT_MSG (m_size == 0, "Cannot change the tick length of a wheel holding timers");
+  NS_ASSERT_MSG (granularity.IsStrictlyPositive (), "The tick length must be positive");
+  m_granularity = granularity;
+}
+
+Time
+SdnTimeoutWheel13::GetGranularity (void) const
+{
+  return m_granularity;
+}
+
+void
+SdnTimeoutWheel13::Insert (SdnFlowTable13 *table, uint64_t flowId, Time deadline)
+{
+  int64_t step = m_granularity.GetTimeStep ();
+  if (m_size == 0)
+    {
+      // Nothing is ticking, catch up with the simulation time
+      m_tick = Simulator::Now ().GetTimeStep () / step;
+    }
+  Timer timer;
+  timer.table = table;
+  timer.flowId = flowId;
+  timer.tick = std::max ((deadline.GetTimeStep () + step - 1) / step, m_tick + 1);
+  m_slots[timer.tick % SDN_TIMEOUT_WHEEL_SLOTS].push_back (timer);
+  m_size++;
+}
+
+void
+SdnTimeoutWheel13::Advance (std::vector<Timer> &due)
+{
+  m_tick++;
+  std::vector<Timer> &slot = m_slots[m_tick % SDN_TIMEOUT_WHEEL_SLOTS];
+  std::vector<Timer>::iterator keep = slot.begin ();
+  for (std::vector<Timer>::iterator i = slot.begin (); i != slot.end (); ++i)
+    {
+      if (i->tick <= m_tick)
+        {
+          due.push_back (*i);
+        }
+      else
+        {
+          // A later round of the wheel
+          *keep++ = *i;
+        }
+    }
+  m_size -= slot.end () - keep;
+  slot.erase (keep, slot.end ());
+}
+
+Time
+SdnTimeoutWheel13::GetNextTick (void) const
+{
+  return TimeStep ((m_tick + 1) * m_granularity.GetTimeStep ());
+}
+
+uint32_t
+SdnTimeoutWheel13::GetSize (void) const
+{
+  return m_size;
+}
+
+} //End namespace ns3
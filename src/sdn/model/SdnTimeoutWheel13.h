@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+#ifndef SDN_TIMEOUT_WHEEL13_H
+#define SDN_TIMEOUT_WHEEL13_H
+
+//Stdlib packages
+#include <vector>
+//ns3 utilities
+#include "ns3/nstime.h"
+
+#define SDN_TIMEOUT_WHEEL_SLOTS 512 //!< Number of slots of the wheel, one tick each
+
+namespace ns3 {
+
+class SdnFlowTable13;
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnTimeoutWheel13
+ *
+ * \brief Hashed timer wheel holding the flow timeouts of an SdnSwitch13
+ *
+ * Time is cut in ticks of a fixed granularity and a timer sits in the slot of the tick
+ * its deadline rounds up to, so a flow expires at most one tick late. Timers are never
+ * cancelled: when one comes due the table checks the flow it names and either expires it
+ * or inserts a new timer for its next deadline. A busy flow therefore costs one timer per
+ * idle period instead of one scheduler event per packet.
+ */
+class SdnTimeoutWheel13
+{
+public:
+  /**
+   * A pending flow timeout
+   */
+  struct Timer
+  {
+    SdnFlowTable13 *table; //!< The table holding the flow
+    uint64_t flowId;       //!< The flow to check, unique within its table
+    int64_t tick;          //!< The tick the timer comes due
+  };
+
+  SdnTimeoutWheel13 ();
+  /**
+   * \brief Sets the tick length. Only allowed while the wheel is empty
+   * \param granularity The tick length
+   */
+  void SetGranularity (Time granularity);
+  /**
+   * \return The tick length
+   */
+  Time GetGranularity (void) const;
+  /**
+   * \brief Adds a timer
+   * \param table The table holding the flow
+   * \param flowId The flow to check once the deadline has passed
+   * \param deadline Simulation time at which the flow may expire
+   */
+  void Insert (SdnFlowTable13 *table, uint64_t flowId, Time deadline);
+  /**
+   * \brief Moves to the next tick and takes the timers due at it
+   * \param due Receives the timers of the tick
+   */
+  void Advance (std::vector<Timer> &due);
+  /**
+   * \return The simulation time of the next tick
+   */
+  Time GetNextTick (void) const;
+  /**
+   * \return The number of pending timers
+   */
+  uint32_t GetSize (void) const;
+
+private:
+  std::vector< std::vector<Timer> > m_slots; //!< Timers by tick modulo the number of slots
+  Time m_granularity;                        //!< Length of a tick
+  int64_t m_tick;                            //!< Last tick advanced to
+  uint32_t m_size;                           //!< Number of pending timers
+};
+
+} //End namespace ns3
+#endif
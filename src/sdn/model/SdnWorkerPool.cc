@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "SdnListener.h"
+#include "SdnWorkerPool.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SdnWorkerPool");
+
+SdnWorkerPool::SdnWorkerPool ()
+  : m_listener (NULL)
+{
+}
+
+SdnWorkerPool::~SdnWorkerPool ()
+{
+  Stop ();
+}
+
+void
+SdnWorkerPool::Start (uint32_t workers, SdnListener* listener)
+{
+  NS_LOG_FUNCTION (this << workers << listener);
+  NS_ASSERT_MSG (m_workers.empty (), "The worker pool is already running");
+
+#ifdef HAVE_PTHREAD_H
+  m_listener = listener;
+  for (uint32_t i = 0; i < workers; ++i)
+    {
+      Worker* worker = new Worker;
+      worker->pool = this;
+      worker->stop = false;
+      worker->thread = Create<SystemThread> (MakeCallback (&Worker::Run, worker));
+      m_workers.push_back (worker);
+      worker->thread->Start ();
+    }
+#else
+  if (workers > 0)
+    {
+      NS_LOG_WARN ("No thread support, controller events are worked on inline");
+    }
+#endif
+}
+
+void
+SdnWorkerPool::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Worker*>::iterator i = m_workers.begin (); i != m_workers.end (); ++i)
+    {
+      Worker* worker = *i;
+      worker->mutex.Lock ();
+      worker->stop = true;
+      worker->wake.SetCondition (true);
+      worker->mutex.Unlock ();
+      worker->wake.Signal ();
+      worker->thread->Join ();
+      delete worker;
+    }
+#endif
+  m_workers.clear ();
+  m_listener = NULL;
+}
+
+uint32_t
+SdnWorkerPool::GetSize (void) const
+{
+  return m_workers.size ();
+}
+
+void
+SdnWorkerPool::Submit (uint32_t key, Job* job)
+{
+  NS_ASSERT (!m_workers.empty ());
+
+  job->worker = key % m_workers.size ();
+  job->done = false;
+  Worker* worker = m_workers[job->worker];
+  worker->mutex.Lock ();
+  worker->jobs.push_back (job);
+  worker->wake.SetCondition (true);
+  worker->mutex.Unlock ();
+  worker->wake.Signal ();
+}
+
+void
+SdnWorkerPool::Wait (Job* job)
+{
+  Worker* worker = m_workers[job->worker];
+  worker->mutex.Lock ();
+  while (!job->done)
+    {
+      // Cleared under the worker mutex, so the worker cannot set it before we sleep
+      m_done.SetCondition (false);
+      worker->mutex.Unlock ();
+      m_done.TimedWait (SDN_WORKER_WAIT);
+      worker->mutex.Lock ();
+    }
+  worker->mutex.Unlock ();
+}
+
+void
+SdnWorkerPool::Worker::Run (void)
+{
+  mutex.Lock ();
+  while (true)
+    {
+      if (jobs.empty ())
+        {
+          if (stop)
+            {
+              break;
+            }
+          wake.SetCondition (false);
+          mutex.Unlock ();
+          wake.TimedWait (SDN_WORKER_WAIT);
+          mutex.Lock ();
+          continue;
+        }
+      Job* job = jobs.front ();
+      jobs.pop_front ();
+      mutex.Unlock ();
+
+      pool->m_listener->event_work (job->event);
+
+      mutex.Lock ();
+      job->done = true;
+      pool->m_done.SetCondition (true);
+      pool->m_done.Signal ();
+    }
+  mutex.Unlock ();
+}
+
+} //End namespace ns3
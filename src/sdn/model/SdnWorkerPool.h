@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#ifndef SDN_WORKER_POOL_H
+#define SDN_WORKER_POOL_H
+
+//Stdlib packages
+#include <deque>
+#include <vector>
+//ns3 utilities
+#include "ns3/core-config.h"
+#include "ns3/ptr.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+
+#define SDN_WORKER_WAIT 10000000 //!< Longest a thread sleeps before checking again for work, in ns
+
+namespace ns3 {
+
+class ControllerEvent;
+class SdnListener;
+
+/**
+ * \ingroup sdn
+ * \defgroup SdnWorkerPool
+ *
+ * \brief Threads running SdnListener::event_work for the events of an SdnController
+ *
+ * Every connection is tied to one worker, chosen from its id, so the events of a connection
+ * are worked on one at a time and in order while different connections run in parallel.
+ * The pool never touches the simulator: the controller submits events as it reads them and
+ * waits for them at the simulation time their batch is delivered, which only depends on the
+ * controller processing-time model, so results do not depend on thread timing.
+ */
+class SdnWorkerPool
+{
+public:
+  /**
+   * An event submitted to the pool
+   */
+  struct Job
+  {
+    ControllerEvent* event; //!< The event to work on
+    uint32_t worker;        //!< The worker the job was submitted to
+    bool done;              //!< Set once event_work has returned, guarded by the worker mutex
+  };
+
+  SdnWorkerPool ();
+  ~SdnWorkerPool ();
+  /**
+   * \brief Starts the worker threads
+   * \param workers The number of threads
+   * \param listener The listener whose event_work the threads run
+   */
+  void Start (uint32_t workers, SdnListener* listener);
+  /**
+   * \brief Lets the threads finish the jobs they hold and joins them
+   */
+  void Stop (void);
+  /**
+   * \return The number of running threads, 0 if the pool is stopped
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \brief Hands a job to the worker of its connection
+   * \param key The connection id, jobs with the same key are run in order
+   * \param job The job, left untouched by the caller until Wait returns
+   */
+  void Submit (uint32_t key, Job* job);
+  /**
+   * \brief Blocks until a submitted job is done
+   * \param job The job to wait for
+   */
+  void Wait (Job* job);
+
+private:
+  /**
+   * A thread and the jobs queued for it
+   */
+  struct Worker
+  {
+    SdnWorkerPool* pool;     //!< The pool the worker belongs to
+    SystemMutex mutex;       //!< Guards jobs, stop and the done flag of the jobs
+    SystemCondition wake;    //!< Signalled when a job is queued or the worker is stopped
+    std::deque<Job*> jobs;   //!< Jobs waiting to be run, in submission order
+    bool stop;               //!< Set to make the thread return once jobs is empty
+#ifdef HAVE_PTHREAD_H
+    Ptr<SystemThread> thread; //!< The thread running Run
+#endif
+    /**
+     * \brief Thread body, runs queued jobs until stopped
+     */
+    void Run (void);
+  };
+
+  std::vector<Worker*> m_workers; //!< The running workers
+  SdnListener* m_listener;        //!< The listener the jobs are run on
+  SystemCondition m_done;         //!< Signalled whenever a job is done
+};
+
+} //End namespace ns3
+#endif
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/SdnBufferPool.h"
+
+using namespace ns3;
+
+/**
+ * Checks packets are found by their id until taken, and that ids of released
+ * slots no longer resolve once the slot is reused
+ */
+class SdnBufferPoolStoreTestCase : public TestCase
+{
+public:
+  SdnBufferPoolStoreTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnBufferPoolStoreTestCase::SdnBufferPoolStoreTestCase ()
+  : TestCase ("Check buffer pool store and take")
+{
+}
+
+void
+SdnBufferPoolStoreTestCase::DoRun (void)
+{
+  SdnBufferPool pool;
+  NS_TEST_ASSERT_MSG_EQ (pool.Store (Create<Packet> (10)), SDN_NO_BUFFER, "A pool without slots must not buffer");
+
+  pool.SetCapacity (4);
+  Ptr<Packet> a = Create<Packet> (10);
+  Ptr<Packet> b = Create<Packet> (20);
+  uint32_t idA = pool.Store (a);
+  uint32_t idB = pool.Store (b);
+  NS_TEST_ASSERT_MSG_NE (idA, idB, "Buffer ids must differ");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 2, "Bad number of buffered packets");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idA), a, "Bad packet found");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idB), b, "Bad packet found");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idA), a, "Find must leave the packet in the pool");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (SDN_NO_BUFFER), 0, "OFP_NO_BUFFER must not resolve");
+
+  NS_TEST_ASSERT_MSG_EQ (pool.Take (idA), a, "Bad packet taken");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 1, "Take must release the slot");
+  NS_TEST_ASSERT_MSG_EQ (pool.Take (idA), 0, "A packet can only be taken once");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idA), 0, "A taken packet must not be found");
+
+  // the released slot is reused first, under a new generation
+  Ptr<Packet> c = Create<Packet> (30);
+  uint32_t idC = pool.Store (c);
+  NS_TEST_ASSERT_MSG_NE (idC, idA, "A reused slot must hand out a new id");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idA), 0, "A stale id must not resolve to the new packet");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idC), c, "Bad packet found");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idB), b, "Other packets must stay buffered");
+
+  // the port a packet arrived on comes back with it
+  uint32_t idD = pool.Store (Create<Packet> (40), 7);
+  uint32_t inPort = 0;
+  NS_TEST_ASSERT_MSG_NE (pool.Take (idD, inPort), 0, "Bad packet taken");
+  NS_TEST_ASSERT_MSG_EQ (inPort, 7, "Take must return the port given to Store");
+  inPort = 3;
+  NS_TEST_ASSERT_MSG_EQ (pool.Take (idD, inPort), 0, "A packet can only be taken once");
+  NS_TEST_ASSERT_MSG_EQ (inPort, 3, "A failed take must leave the port alone");
+
+  pool.SetCapacity (8);
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 0, "Resizing must drop the buffered packets");
+  NS_TEST_ASSERT_MSG_EQ (pool.Find (idB), 0, "Resizing must drop the buffered packets");
+}
+
+/**
+ * Checks the oldest packet makes room when the pool is full, and that packets
+ * older than the timeout are evicted on the next store
+ */
+class SdnBufferPoolEvictionTestCase : public TestCase
+{
+public:
+  SdnBufferPoolEvictionTestCase ();
+  virtual void DoRun (void);
+private:
+  void Store (uint32_t index);
+  SdnBufferPool m_pool;
+  std::vector<uint32_t> m_ids;
+};
+
+SdnBufferPoolEvictionTestCase::SdnBufferPoolEvictionTestCase ()
+  : TestCase ("Check buffer pool eviction")
+{
+}
+
+void
+SdnBufferPoolEvictionTestCase::Store (uint32_t index)
+{
+  m_ids[index] = m_pool.Store (Create<Packet> (index));
+}
+
+void
+SdnBufferPoolEvictionTestCase::DoRun (void)
+{
+  m_pool.SetCapacity (3);
+  m_pool.SetTimeout (Seconds (10));
+  m_ids.resize (6);
+
+  // a full pool evicts its oldest packet, whatever its age
+  Store (0);
+  Store (1);
+  Store (2);
+  Store (3);
+  NS_TEST_ASSERT_MSG_EQ (m_pool.GetSize (), 3, "A full pool must stay full");
+  NS_TEST_ASSERT_MSG_EQ (m_pool.Find (m_ids[0]), 0, "The oldest packet must be evicted");
+  for (uint32_t i = 1; i < 4; ++i)
+    {
+      NS_TEST_ASSERT_MSG_NE (m_pool.Find (m_ids[i]), 0, "Packet " << i << " must stay buffered");
+    }
+
+  // packet 1 is taken, 2 and 3 time out before packet 4 is stored
+  m_pool.Take (m_ids[1]);
+  Simulator::Schedule (Seconds (5), &SdnBufferPoolEvictionTestCase::Store, this, 4);
+  Simulator::Schedule (Seconds (10), &SdnBufferPoolEvictionTestCase::Store, this, 5);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_pool.GetSize (), 2, "Bad number of buffered packets");
+  NS_TEST_ASSERT_MSG_EQ (m_pool.Find (m_ids[2]), 0, "A timed out packet must be evicted");
+  NS_TEST_ASSERT_MSG_EQ (m_pool.Find (m_ids[3]), 0, "A timed out packet must be evicted");
+  NS_TEST_ASSERT_MSG_NE (m_pool.Find (m_ids[4]), 0, "A recent packet must stay buffered");
+  NS_TEST_ASSERT_MSG_NE (m_pool.Find (m_ids[5]), 0, "The new packet must be buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_pool.Find (m_ids[5])->GetSize (), 5, "Bad packet found");
+}
+
+class SdnBufferPoolTestSuite : public TestSuite
+{
+public:
+  SdnBufferPoolTestSuite ();
+};
+
+SdnBufferPoolTestSuite::SdnBufferPoolTestSuite ()
+  : TestSuite ("sdn-buffer-pool", UNIT)
+{
+  AddTestCase (new SdnBufferPoolStoreTestCase, TestCase::QUICK);
+  AddTestCase (new SdnBufferPoolEvictionTestCase, TestCase::QUICK);
+}
+
+static SdnBufferPoolTestSuite g_sdnBufferPoolTestSuite;
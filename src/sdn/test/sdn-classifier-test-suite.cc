@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/ptr.h"
+#include "ns3/object.h"
+#include "ns3/SdnClassifier13.h"
+
+using namespace ns3;
+using namespace fluid_msg;
+
+namespace {
+
+/**
+ * Builds the key of an IPv4 packet received on a port
+ */
+SdnFlowKey
+MakePacketKey (uint32_t inPort, uint32_t ipv4Dst, uint16_t tcpDst)
+{
+  SdnFlowKey key;
+  key.SetField32 (of13::OFPXMT_OFB_IN_PORT, inPort);
+  key.SetField16 (of13::OFPXMT_OFB_ETH_TYPE, 0x0800);
+  key.SetField8 (of13::OFPXMT_OFB_IP_PROTO, 6);
+  key.SetField32 (of13::OFPXMT_OFB_IPV4_DST, ipv4Dst);
+  key.SetField16 (of13::OFPXMT_OFB_TCP_DST, tcpDst);
+  return key;
+}
+
+/**
+ * The flows of a test, with their compiled matches built field by field
+ */
+class FlowSet
+{
+public:
+  ~FlowSet ()
+  {
+    for (std::vector<Flow13*>::iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+      {
+        delete *i;
+      }
+  }
+  /**
+   * \brief Creates a flow matching everything
+   * \param priority The priority of the flow
+   * \return The flow, owned by the set
+   */
+  Flow13* Add (uint16_t priority)
+  {
+    Flow13 *flow = new Flow13 ();
+    flow->priority_ = priority;
+    m_flows.push_back (flow);
+    return flow;
+  }
+  static void Exact16 (Flow13 *flow, uint8_t field, uint16_t value)
+  {
+    flow->compiled.value.SetField16 (field, value);
+    flow->compiled.mask.SetField16 (field, 0xffff);
+    SdnFlowKey::MaskRange (flow->compiled.mask, flow->compiled.first, flow->compiled.last);
+  }
+  static void Exact32 (Flow13 *flow, uint8_t field, uint32_t value)
+  {
+    Masked32 (flow, field, value, 0xffffffff);
+  }
+  static void Masked32 (Flow13 *flow, uint8_t field, uint32_t value, uint32_t mask)
+  {
+    flow->compiled.value.SetField32 (field, value & mask);
+    flow->compiled.mask.SetField32 (field, mask);
+    SdnFlowKey::MaskRange (flow->compiled.mask, flow->compiled.first, flow->compiled.last);
+  }
+
+private:
+  std::vector<Flow13*> m_flows;
+};
+
+} // anonymous namespace
+
+/**
+ * Checks both classifiers return the highest priority flow when the
+ * candidates sit in different tuples, and the first inserted on a tie
+ */
+class SdnClassifierPriorityTestCase : public TestCase
+{
+public:
+  SdnClassifierPriorityTestCase (std::string classifier);
+  virtual void DoRun (void);
+private:
+  std::string m_classifier;
+};
+
+SdnClassifierPriorityTestCase::SdnClassifierPriorityTestCase (std::string classifier)
+  : TestCase ("Check priority ordering across tuples with " + classifier),
+    m_classifier (classifier)
+{
+}
+
+void
+SdnClassifierPriorityTestCase::DoRun (void)
+{
+  ObjectFactory factory (m_classifier);
+  Ptr<SdnClassifier13> classifier = factory.Create<SdnClassifier13> ();
+  FlowSet flows;
+
+  Flow13 *all = flows.Add (0);
+  Flow13 *ipv4 = flows.Add (10);
+  FlowSet::Exact16 (ipv4, of13::OFPXMT_OFB_ETH_TYPE, 0x0800);
+  Flow13 *port = flows.Add (30);
+  FlowSet::Exact32 (port, of13::OFPXMT_OFB_IN_PORT, 2);
+  Flow13 *web = flows.Add (20);
+  FlowSet::Exact16 (web, of13::OFPXMT_OFB_ETH_TYPE, 0x0800);
+  FlowSet::Exact16 (web, of13::OFPXMT_OFB_TCP_DST, 80);
+  Flow13 *webTie = flows.Add (20);
+  FlowSet::Exact32 (webTie, of13::OFPXMT_OFB_IPV4_DST, 0x0a000001);
+
+  // insert the lower priority tuples first so the search order matters
+  classifier->Insert (all);
+  classifier->Insert (ipv4);
+  classifier->Insert (web);
+  classifier->Insert (webTie);
+  classifier->Insert (port);
+  NS_TEST_ASSERT_MSG_EQ (classifier->GetSize (), 5, "Bad classifier size");
+
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (2, 0x0a000001, 80)), port,
+                         "The priority 30 flow must win over every other tuple");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a000001, 80)), web,
+                         "Equal priorities must go to the flow inserted first");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a000001, 22)), webTie,
+                         "The second priority 20 flow must win once the first misses");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a000002, 22)), ipv4,
+                         "The IPv4 flow must win over the table miss flow");
+
+  SdnFlowKey arp;
+  arp.SetField32 (of13::OFPXMT_OFB_IN_PORT, 1);
+  arp.SetField16 (of13::OFPXMT_OFB_ETH_TYPE, 0x0806);
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (arp), all, "Only the table miss flow matches ARP");
+
+  std::vector<Flow13*> hits = classifier->LookupAll (MakePacketKey (2, 0x0a000001, 80));
+  NS_TEST_ASSERT_MSG_EQ (hits.size (), 5, "Every flow matches this packet");
+  Flow13 *expected[] = { port, web, webTie, ipv4, all };
+  for (uint32_t i = 0; i < hits.size () && i < 5; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (hits[i], expected[i], "LookupAll is not in priority order at " << i);
+    }
+}
+
+/**
+ * Checks masked fields match every packet in their prefix and no other,
+ * and that the fields a flow needs must be present in the packet
+ */
+class SdnClassifierMaskTestCase : public TestCase
+{
+public:
+  SdnClassifierMaskTestCase (std::string classifier);
+  virtual void DoRun (void);
+private:
+  std::string m_classifier;
+};
+
+SdnClassifierMaskTestCase::SdnClassifierMaskTestCase (std::string classifier)
+  : TestCase ("Check masked matches with " + classifier),
+    m_classifier (classifier)
+{
+}
+
+void
+SdnClassifierMaskTestCase::DoRun (void)
+{
+  ObjectFactory factory (m_classifier);
+  Ptr<SdnClassifier13> classifier = factory.Create<SdnClassifier13> ();
+  FlowSet flows;
+
+  Flow13 *wide = flows.Add (10);
+  FlowSet::Masked32 (wide, of13::OFPXMT_OFB_IPV4_DST, 0x0a010000, 0xffff0000);
+  Flow13 *narrow = flows.Add (20);
+  FlowSet::Masked32 (narrow, of13::OFPXMT_OFB_IPV4_DST, 0x0a010200, 0xffffff00);
+  Flow13 *sloppy = flows.Add (5);
+  FlowSet::Masked32 (sloppy, of13::OFPXMT_OFB_IPV4_DST, 0x0a020000, 0xffff0000);
+  classifier->Insert (wide);
+  classifier->Insert (narrow);
+  classifier->Insert (sloppy);
+
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a010203, 80)), narrow, "10.1.2.3 is in the /24");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a0103ff, 80)), wide, "10.1.3.255 is only in the /16");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0a020001, 80)), sloppy, "10.2.0.1 is in 10.2.0.0/16");
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (MakePacketKey (1, 0x0b010203, 80)), 0, "11.1.2.3 matches no prefix");
+
+  SdnFlowKey noIp;
+  noIp.SetField32 (of13::OFPXMT_OFB_IN_PORT, 1);
+  NS_TEST_ASSERT_MSG_EQ (classifier->Lookup (noIp), 0, "A packet without IPv4 destination cannot match a prefix");
+}
+
+/**
+ * Checks removed flows stop matching, that the next flow in line takes over
+ * and that a tuple goes away with its last flow
+ */
+class SdnClassifierRemoveTestCase : public TestCase
+{
+public:
+  SdnClassifierRemoveTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnClassifierRemoveTestCase::SdnClassifierRemoveTestCase ()
+  : TestCase ("Check flow removal")
+{
+}
+
+void
+SdnClassifierRemoveTestCase::DoRun (void)
+{
+  Ptr<SdnTupleSpaceClassifier13> tuples = CreateObject<SdnTupleSpaceClassifier13> ();
+  Ptr<SdnLinearClassifier13> linear = CreateObject<SdnLinearClassifier13> ();
+  FlowSet flows;
+
+  Flow13 *low = flows.Add (1);
+  FlowSet::Exact16 (low, of13::OFPXMT_OFB_ETH_TYPE, 0x0800);
+  Flow13 *high = flows.Add (100);
+  FlowSet::Exact32 (high, of13::OFPXMT_OFB_IPV4_DST, 0x0a000001);
+  Flow13 *other = flows.Add (100);
+  FlowSet::Exact32 (other, of13::OFPXMT_OFB_IPV4_DST, 0x0a000002);
+  std::vector<Flow13*> batch;
+  batch.push_back (low);
+  batch.push_back (high);
+  batch.push_back (other);
+  tuples->InsertBatch (batch);
+  linear->InsertBatch (batch);
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetNTuples (), 2, "Two masks are in use");
+
+  SdnFlowKey key = MakePacketKey (1, 0x0a000001, 80);
+  NS_TEST_ASSERT_MSG_EQ (tuples->Lookup (key), high, "Bad lookup before removal");
+  tuples->Remove (high);
+  linear->Remove (high);
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetSize (), 2, "Bad size after removal");
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetNTuples (), 2, "The tuple still holds a flow");
+  NS_TEST_ASSERT_MSG_EQ (tuples->Lookup (key), low, "The next flow in line must match");
+  NS_TEST_ASSERT_MSG_EQ (linear->Lookup (key), low, "The classifiers disagree after removal");
+  NS_TEST_ASSERT_MSG_EQ (tuples->Lookup (MakePacketKey (1, 0x0a000002, 80)), other,
+                         "Removal must not disturb the other flows of the tuple");
+
+  tuples->Remove (other);
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetNTuples (), 1, "The empty tuple must go away");
+  NS_TEST_ASSERT_MSG_EQ (tuples->Lookup (MakePacketKey (1, 0x0a000002, 80)), low, "Bad lookup after removal");
+  // removing a flow twice is harmless
+  tuples->Remove (other);
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetSize (), 1, "Bad size after removing twice");
+
+  tuples->Clear ();
+  NS_TEST_ASSERT_MSG_EQ (tuples->GetSize (), 0, "Bad size after clear");
+  NS_TEST_ASSERT_MSG_EQ (tuples->Lookup (key), 0, "An empty classifier matches nothing");
+}
+
+class SdnClassifierTestSuite : public TestSuite
+{
+public:
+  SdnClassifierTestSuite ();
+};
+
+SdnClassifierTestSuite::SdnClassifierTestSuite ()
+  : TestSuite ("sdn-classifier", UNIT)
+{
+  AddTestCase (new SdnClassifierPriorityTestCase ("ns3::SdnTupleSpaceClassifier13"), TestCase::QUICK);
+  AddTestCase (new SdnClassifierPriorityTestCase ("ns3::SdnLinearClassifier13"), TestCase::QUICK);
+  AddTestCase (new SdnClassifierMaskTestCase ("ns3::SdnTupleSpaceClassifier13"), TestCase::QUICK);
+  AddTestCase (new SdnClassifierMaskTestCase ("ns3::SdnLinearClassifier13"), TestCase::QUICK);
+  AddTestCase (new SdnClassifierRemoveTestCase, TestCase::QUICK);
+}
+
+static SdnClassifierTestSuite g_sdnClassifierTestSuite;
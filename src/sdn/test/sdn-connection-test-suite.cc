@@ -0,0 +1,394 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/SdnConnection.h"
+
+using namespace ns3;
+
+namespace {
+
+const uint16_t PORT = 6653;
+
+/**
+ * Builds an OpenFlow message of the given size numbered by its xid
+ */
+std::vector<uint8_t>
+MakeMessage (uint32_t xid, uint16_t size)
+{
+  std::vector<uint8_t> data (size, 0);
+  data[0] = 4;
+  data[1] = 2;
+  data[2] = size >> 8;
+  data[3] = size & 0xff;
+  data[4] = xid >> 24;
+  data[5] = (xid >> 16) & 0xff;
+  data[6] = (xid >> 8) & 0xff;
+  data[7] = xid & 0xff;
+  for (uint16_t i = OF_HEADER_LENGTH; i < size; ++i)
+    {
+      data[i] = (xid + i) & 0xff;
+    }
+  return data;
+}
+
+uint32_t
+GetXid (const uint8_t *data)
+{
+  return (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+}
+
+} // anonymous namespace
+
+/**
+ * Connects an SdnConnection to a TCP server over a simple link and frames what
+ * the server receives
+ */
+class SdnConnectionTestCase : public TestCase
+{
+public:
+  SdnConnectionTestCase (std::string name);
+
+protected:
+  /**
+   * \brief Builds the link and the connection, nothing is sent before 1s
+   * \param sndBufSize Transmit buffer of the client socket
+   */
+  void Setup (uint32_t sndBufSize);
+  void Send (uint32_t xid, uint16_t size);
+  void TxFlush (uint32_t messages, uint32_t bytes);
+
+  Ptr<SdnConnection> m_connection;
+  std::vector<uint32_t> m_rxXids;        //!< Xids of the messages the server framed
+  std::vector<uint16_t> m_rxSizes;       //!< Sizes of the messages the server framed
+  uint32_t m_rxBad;                      //!< Messages whose payload was corrupted
+  std::vector<uint32_t> m_flushMessages; //!< Messages of each TxFlush
+  std::vector<uint32_t> m_flushBytes;    //!< Bytes of each TxFlush
+  std::vector<Time> m_flushTimes;        //!< Time of each TxFlush
+
+private:
+  void Accept (Ptr<Socket> socket, const Address &from);
+  void Receive (Ptr<Socket> socket);
+
+  Ptr<SdnConnection> m_server; //!< Frames the server side of the stream
+  Ptr<Socket> m_listener;
+};
+
+SdnConnectionTestCase::SdnConnectionTestCase (std::string name)
+  : TestCase (name),
+    m_rxBad (0)
+{
+}
+
+void
+SdnConnectionTestCase::Setup (uint32_t sndBufSize)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  NetDeviceContainer devices = link.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign (devices);
+
+  m_listener = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  m_listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), PORT));
+  m_listener->Listen ();
+  m_listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                 MakeCallback (&SdnConnectionTestCase::Accept, this));
+
+  Ptr<Socket> client = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  client->SetAttribute ("SndBufSize", UintegerValue (sndBufSize));
+  client->Bind ();
+  client->Connect (InetSocketAddress (interfaces.GetAddress (1), PORT));
+  m_connection = CreateObject<SdnConnection> (client);
+  m_connection->TraceConnectWithoutContext ("TxFlush", MakeCallback (&SdnConnectionTestCase::TxFlush, this));
+}
+
+void
+SdnConnectionTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  m_server = CreateObject<SdnConnection> (socket);
+  socket->SetRecvCallback (MakeCallback (&SdnConnectionTestCase::Receive, this));
+}
+
+void
+SdnConnectionTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      m_server->receive (p);
+      uint16_t length;
+      uint8_t *data;
+      while ((data = m_server->next_message (length)) != NULL)
+        {
+          uint32_t xid = GetXid (data);
+          if (MakeMessage (xid, length) != std::vector<uint8_t> (data, data + length))
+            {
+              m_rxBad++;
+            }
+          m_rxXids.push_back (xid);
+          m_rxSizes.push_back (length);
+        }
+    }
+}
+
+void
+SdnConnectionTestCase::Send (uint32_t xid, uint16_t size)
+{
+  std::vector<uint8_t> data = MakeMessage (xid, size);
+  m_connection->send (&data[0], size, 4);
+}
+
+void
+SdnConnectionTestCase::TxFlush (uint32_t messages, uint32_t bytes)
+{
+  m_flushMessages.push_back (messages);
+  m_flushBytes.push_back (bytes);
+  m_flushTimes.push_back (Simulator::Now ());
+}
+
+/**
+ * Checks a burst larger than the transmit buffer of the socket arrives whole
+ */
+class SdnConnectionBurstTestCase : public SdnConnectionTestCase
+{
+public:
+  SdnConnectionBurstTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnConnectionBurstTestCase::SdnConnectionBurstTestCase ()
+  : SdnConnectionTestCase ("Check a burst larger than the socket buffer is not lost")
+{
+}
+
+void
+SdnConnectionBurstTestCase::DoRun (void)
+{
+  const uint32_t messages = 300;
+  const uint32_t sndBufSize = 4096;
+  Setup (sndBufSize);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < messages; ++i)
+    {
+      uint16_t size = 40 + (i * 37) % 200;
+      total += size;
+      Simulator::Schedule (Seconds (1), &SdnConnectionBurstTestCase::Send, this, i, size);
+    }
+  NS_TEST_ASSERT_MSG_GT (total, 4 * sndBufSize, "The burst must not fit the socket buffer");
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxXids.size (), messages, "Every message must arrive");
+  for (uint32_t i = 0; i < m_rxXids.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_rxXids[i], i, "Messages must arrive in order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_rxBad, 0, "Messages must arrive intact");
+
+  // the first flush stops at the socket buffer, the rest follows as it drains
+  NS_TEST_ASSERT_MSG_GT (m_flushBytes.size (), 1, "The burst must take several flushes");
+  NS_TEST_ASSERT_MSG_EQ (m_flushBytes[0], sndBufSize, "The first flush must fill the socket buffer");
+  uint32_t flushedMessages = 0;
+  uint32_t flushedBytes = 0;
+  for (uint32_t i = 0; i < m_flushBytes.size (); ++i)
+    {
+      flushedMessages += m_flushMessages[i];
+      flushedBytes += m_flushBytes[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ (flushedMessages, messages, "Every message must be counted once");
+  NS_TEST_ASSERT_MSG_EQ (flushedBytes, total, "Every byte must be counted once");
+  m_connection = 0;
+}
+
+/**
+ * Checks messages sent within the coalescing window leave in one flush, and
+ * the messages and bytes TxFlush reports
+ */
+class SdnConnectionCoalescingTestCase : public SdnConnectionTestCase
+{
+public:
+  SdnConnectionCoalescingTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnConnectionCoalescingTestCase::SdnConnectionCoalescingTestCase ()
+  : SdnConnectionTestCase ("Check the coalescing window and the TxFlush counters")
+{
+}
+
+void
+SdnConnectionCoalescingTestCase::DoRun (void)
+{
+  Setup (131072);
+  m_connection->SetAttribute ("TxCoalescingWindow", TimeValue (MilliSeconds (1)));
+  // the window opens with the first message and doesn't move with the later ones
+  Simulator::Schedule (Seconds (1), &SdnConnectionCoalescingTestCase::Send, this, 0, 20);
+  Simulator::Schedule (Seconds (1), &SdnConnectionCoalescingTestCase::Send, this, 1, 30);
+  Simulator::Schedule (Seconds (1) + MicroSeconds (500), &SdnConnectionCoalescingTestCase::Send, this, 2, 40);
+  Simulator::Schedule (Seconds (1) + MicroSeconds (999), &SdnConnectionCoalescingTestCase::Send, this, 3, 50);
+  Simulator::Schedule (Seconds (1) + MicroSeconds (1500), &SdnConnectionCoalescingTestCase::Send, this, 4, 60);
+  Simulator::Schedule (Seconds (2), &SdnConnectionCoalescingTestCase::Send, this, 5, 70);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_flushMessages.size (), 3, "Bad number of flushes");
+  NS_TEST_ASSERT_MSG_EQ (m_connection->m_flushes, 3, "Bad flush counter");
+  NS_TEST_ASSERT_MSG_EQ (m_flushTimes[0], Seconds (1) + MilliSeconds (1), "The first flush must close the window");
+  NS_TEST_ASSERT_MSG_EQ (m_flushMessages[0], 4, "The messages of the window must leave together");
+  NS_TEST_ASSERT_MSG_EQ (m_flushBytes[0], 140, "Bad bytes of the first flush");
+  NS_TEST_ASSERT_MSG_EQ (m_flushTimes[1], Seconds (1) + MicroSeconds (2500), "A later message must open a new window");
+  NS_TEST_ASSERT_MSG_EQ (m_flushMessages[1], 1, "Bad messages of the second flush");
+  NS_TEST_ASSERT_MSG_EQ (m_flushBytes[1], 60, "Bad bytes of the second flush");
+  NS_TEST_ASSERT_MSG_EQ (m_flushMessages[2], 1, "Bad messages of the third flush");
+  NS_TEST_ASSERT_MSG_EQ (m_flushBytes[2], 70, "Bad bytes of the third flush");
+  NS_TEST_ASSERT_MSG_EQ (m_connection->m_sent, 6, "Bad sent counter");
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxXids.size (), 6, "Every message must arrive");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBad, 0, "Messages must arrive intact");
+  m_connection = 0;
+}
+
+/**
+ * Checks the receive buffer frames split and coalesced messages
+ */
+class SdnConnectionFramingTestCase : public TestCase
+{
+public:
+  SdnConnectionFramingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Checks the next framed message is the given one
+   */
+  void CheckNext (Ptr<SdnConnection> connection, uint32_t xid, uint16_t size);
+};
+
+SdnConnectionFramingTestCase::SdnConnectionFramingTestCase ()
+  : TestCase ("Check the framing of split and coalesced messages")
+{
+}
+
+void
+SdnConnectionFramingTestCase::CheckNext (Ptr<SdnConnection> connection, uint32_t xid, uint16_t size)
+{
+  uint16_t length = 0;
+  uint8_t *data = connection->next_message (length);
+  NS_TEST_ASSERT_MSG_NE (data, 0, "Message " << xid << " must be complete");
+  NS_TEST_ASSERT_MSG_EQ (length, size, "Bad length of message " << xid);
+  NS_TEST_ASSERT_MSG_EQ ((MakeMessage (xid, size) == std::vector<uint8_t> (data, data + length)), true,
+                         "Bad content of message " << xid);
+}
+
+void
+SdnConnectionFramingTestCase::DoRun (void)
+{
+  Ptr<SdnConnection> connection = CreateObject<SdnConnection> ();
+  uint16_t length = 0;
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "A new connection has no message");
+
+  // three messages coalesced in one segment
+  std::vector<uint8_t> stream;
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      std::vector<uint8_t> message = MakeMessage (i, 8 + 10 * i);
+      stream.insert (stream.end (), message.begin (), message.end ());
+    }
+  connection->receive (Create<Packet> (&stream[0], stream.size ()));
+  CheckNext (connection, 0, 8);
+  CheckNext (connection, 1, 18);
+  CheckNext (connection, 2, 28);
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "Every message has been taken");
+  NS_TEST_ASSERT_MSG_EQ (connection->m_recv, 3, "Bad receive counter");
+
+  // one message split inside its header and inside its body, followed by the
+  // start of the next one
+  std::vector<uint8_t> split = MakeMessage (3, 100);
+  std::vector<uint8_t> next = MakeMessage (4, 50);
+  split.insert (split.end (), next.begin (), next.end ());
+  connection->receive (Create<Packet> (&split[0], 3));
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "A partial header is not a message");
+  connection->receive (Create<Packet> (&split[3], 60));
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "A partial body is not a message");
+  connection->receive (Create<Packet> (&split[63], 57));
+  CheckNext (connection, 3, 100);
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "The next message is still partial");
+  connection->receive (Create<Packet> (&split[120], split.size () - 120));
+  CheckNext (connection, 4, 50);
+
+  // more than the initial buffer, kept while nothing is taken out
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < 2 * SDN_RX_BUFFER_SIZE / 1000 + 1; ++i)
+    {
+      std::vector<uint8_t> message = MakeMessage (100 + i, 1000);
+      connection->receive (Create<Packet> (&message[0], 700));
+      connection->receive (Create<Packet> (&message[700], 300));
+      count++;
+    }
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      CheckNext (connection, 100 + i, 1000);
+    }
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "Every message has been taken");
+
+  // a length shorter than the header loses the framing, the buffer is dropped
+  std::vector<uint8_t> bad = MakeMessage (200, 16);
+  bad[2] = 0;
+  bad[3] = 4;
+  connection->receive (Create<Packet> (&bad[0], bad.size ()));
+  NS_TEST_ASSERT_MSG_EQ (connection->next_message (length), 0, "A bad length is not a message");
+  std::vector<uint8_t> good = MakeMessage (201, 12);
+  connection->receive (Create<Packet> (&good[0], good.size ()));
+  CheckNext (connection, 201, 12);
+  connection->Dispose ();
+}
+
+class SdnConnectionTestSuite : public TestSuite
+{
+public:
+  SdnConnectionTestSuite ();
+};
+
+SdnConnectionTestSuite::SdnConnectionTestSuite ()
+  : TestSuite ("sdn-connection", UNIT)
+{
+  AddTestCase (new SdnConnectionFramingTestCase, TestCase::QUICK);
+  AddTestCase (new SdnConnectionBurstTestCase, TestCase::QUICK);
+  AddTestCase (new SdnConnectionCoalescingTestCase, TestCase::QUICK);
+}
+
+static SdnConnectionTestSuite g_sdnConnectionTestSuite;
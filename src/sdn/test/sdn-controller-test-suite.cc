@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/SdnController.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Records the batches and the events the controller delivers
+ */
+class BatchListener : public SdnListener
+{
+public:
+  virtual void event_batch_callback (std::vector<ControllerEvent*> &events)
+  {
+    batchSizes.push_back (events.size ());
+    batchTimes.push_back (Simulator::Now ());
+    // the default hands the events over to event_callback one by one
+    SdnListener::event_batch_callback (events);
+  }
+  virtual void event_callback (ControllerEvent* ev)
+  {
+    types.push_back (ev->get_type ());
+    connected.push_back (ev->ofconn != 0);
+    if (ev->get_type () == EVENT_PACKET_IN)
+      {
+        PacketInEvent* packetIn = static_cast<PacketInEvent*> (ev);
+        xids.push_back (packetIn->len >= 8 ? packetIn->data[7] : 0);
+      }
+  }
+
+  std::vector<uint32_t> batchSizes;
+  std::vector<Time> batchTimes;
+  std::vector<int> types;
+  std::vector<bool> connected;
+  std::vector<uint32_t> xids;
+};
+
+} // anonymous namespace
+
+/**
+ * Checks the controller serves the events of a read as one batch after
+ * BatchProcessingTime plus EventProcessingTime per event, one batch at a time,
+ * and delivers them in order through event_batch_callback
+ */
+class SdnControllerBatchTestCase : public TestCase
+{
+public:
+  SdnControllerBatchTestCase ();
+  virtual void DoRun (void);
+
+private:
+  void Connected (Ptr<Socket> socket);
+  void Drain (Ptr<Socket> socket);
+  /**
+   * \brief Sends OpenFlow 1.0 headers of the given type in a single segment
+   */
+  void SendMessages (uint8_t type, uint32_t count);
+  void EventBatch (uint32_t size, Time delay);
+
+  Ptr<Socket> m_switch;       //!< Stands for a switch on the controller connection
+  uint8_t m_xid;
+  std::vector<uint32_t> m_traceSizes;
+  std::vector<Time> m_traceDelays;
+};
+
+SdnControllerBatchTestCase::SdnControllerBatchTestCase ()
+  : TestCase ("Check the batching and the service times of controller events"),
+    m_xid (0)
+{
+}
+
+void
+SdnControllerBatchTestCase::Connected (Ptr<Socket> socket)
+{
+}
+
+void
+SdnControllerBatchTestCase::Drain (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+    }
+}
+
+void
+SdnControllerBatchTestCase::SendMessages (uint8_t type, uint32_t count)
+{
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      uint8_t header[8] = { 1, type, 0, 8, 0, 0, 0, m_xid++ };
+      data.insert (data.end (), header, header + 8);
+    }
+  m_switch->Send (Create<Packet> (&data[0], data.size ()));
+}
+
+void
+SdnControllerBatchTestCase::EventBatch (uint32_t size, Time delay)
+{
+  m_traceSizes.push_back (size);
+  m_traceDelays.push_back (delay);
+}
+
+void
+SdnControllerBatchTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper link;
+  NetDeviceContainer devices = link.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign (devices);
+
+  Ptr<BatchListener> listener = CreateObject<BatchListener> ();
+  Ptr<SdnController> controller = CreateObject<SdnController> (listener);
+  controller->SetAttribute ("EventProcessingTime", TimeValue (MilliSeconds (1)));
+  controller->SetAttribute ("BatchProcessingTime", TimeValue (MilliSeconds (5)));
+  controller->TraceConnectWithoutContext ("EventBatch", MakeCallback (&SdnControllerBatchTestCase::EventBatch, this));
+  nodes.Get (1)->AddApplication (controller);
+  controller->SetStartTime (Seconds (0));
+
+  m_switch = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  m_switch->Bind ();
+  m_switch->SetConnectCallback (MakeCallback (&SdnControllerBatchTestCase::Connected, this),
+                                MakeNullCallback<void, Ptr<Socket> > ());
+  m_switch->SetRecvCallback (MakeCallback (&SdnControllerBatchTestCase::Drain, this));
+  Simulator::Schedule (MilliSeconds (100), &Socket::Connect, m_switch,
+                       Address (InetSocketAddress (interfaces.GetAddress (1), OFCONTROLLERPORT)));
+
+  // the features reply ends the handshake and makes a switch up event
+  Simulator::Schedule (Seconds (1), &SdnControllerBatchTestCase::SendMessages, this,
+                       uint8_t (fluid_msg::of10::OFPT_FEATURES_REPLY), 1);
+  // three packet ins read at once, then two more while the controller is busy
+  Simulator::Schedule (Seconds (2), &SdnControllerBatchTestCase::SendMessages, this,
+                       uint8_t (fluid_msg::of10::OFPT_PACKET_IN), 3);
+  Simulator::Schedule (Seconds (2) + MilliSeconds (1), &SdnControllerBatchTestCase::SendMessages, this,
+                       uint8_t (fluid_msg::of10::OFPT_PACKET_IN), 2);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (listener->batchSizes.size (), 3, "Bad number of batches");
+  NS_TEST_ASSERT_MSG_EQ (listener->batchSizes[0], 1, "The switch up event is a batch of its own");
+  NS_TEST_ASSERT_MSG_EQ (listener->batchSizes[1], 3, "The events of a read make one batch");
+  NS_TEST_ASSERT_MSG_EQ (listener->batchSizes[2], 2, "The events of a later read make another batch");
+
+  // a batch costs 5ms plus 1ms per event, and waits for the one ahead of it
+  NS_TEST_ASSERT_MSG_EQ (m_traceSizes.size (), 3, "Bad number of EventBatch traces");
+  NS_TEST_ASSERT_MSG_EQ (m_traceDelays[0], MilliSeconds (6), "Bad delay of the first batch");
+  NS_TEST_ASSERT_MSG_EQ (m_traceDelays[1], MilliSeconds (8), "Bad delay of an idle controller");
+  NS_TEST_ASSERT_MSG_EQ (m_traceDelays[2], MilliSeconds (14), "A batch must wait for the one being served");
+  NS_TEST_ASSERT_MSG_EQ (listener->batchTimes[2] - listener->batchTimes[1], MilliSeconds (7),
+                         "Batches must be served back to back");
+
+  NS_TEST_ASSERT_MSG_EQ (listener->types.size (), 6, "Every event must reach event_callback");
+  NS_TEST_ASSERT_MSG_EQ (listener->types[0], EVENT_SWITCH_UP, "Bad type of the first event");
+  for (uint32_t i = 1; i < listener->types.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (listener->types[i], EVENT_PACKET_IN, "Bad type of event " << i);
+      NS_TEST_ASSERT_MSG_EQ (listener->xids[i - 1], i, "Events must be delivered in arrival order");
+    }
+  for (uint32_t i = 0; i < listener->connected.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (listener->connected[i], true, "Event " << i << " must carry its connection");
+    }
+
+  Simulator::Destroy ();
+  m_switch = 0;
+}
+
+class SdnControllerTestSuite : public TestSuite
+{
+public:
+  SdnControllerTestSuite ();
+};
+
+SdnControllerTestSuite::SdnControllerTestSuite ()
+  : TestSuite ("sdn-controller", UNIT)
+{
+  AddTestCase (new SdnControllerBatchTestCase, TestCase::QUICK);
+}
+
+static SdnControllerTestSuite g_sdnControllerTestSuite;
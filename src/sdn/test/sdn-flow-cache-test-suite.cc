@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/SdnFlowCache13.h"
+
+using namespace ns3;
+using namespace fluid_msg;
+
+namespace {
+
+SdnFlowKey
+MakeKey (uint32_t inPort, uint16_t ethType)
+{
+  SdnFlowKey key;
+  key.SetField32 (of13::OFPXMT_OFB_IN_PORT, inPort);
+  key.SetField16 (of13::OFPXMT_OFB_ETH_TYPE, ethType);
+  return key;
+}
+
+/**
+ * Records an entry sending the key out of one port
+ */
+void
+Record (SdnFlowCache13 &cache, const SdnFlowKey &key, uint64_t generation, uint32_t port)
+{
+  SdnFlowCache13::Entry entry;
+  entry.Reset (generation);
+  entry.key = key;
+  entry.outPorts.push_back (port);
+  cache.Store (entry);
+}
+
+} // anonymous namespace
+
+/**
+ * Checks entries are found for their exact key only, and that sizes round up
+ */
+class SdnFlowCacheLookupTestCase : public TestCase
+{
+public:
+  SdnFlowCacheLookupTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowCacheLookupTestCase::SdnFlowCacheLookupTestCase ()
+  : TestCase ("Check flow cache lookups")
+{
+}
+
+void
+SdnFlowCacheLookupTestCase::DoRun (void)
+{
+  SdnFlowCache13 cache;
+  SdnFlowKey key = MakeKey (1, 0x0800);
+  Record (cache, key, cache.GetGeneration (), 2);
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (key), 0, "A cache without slots must stay empty");
+
+  cache.SetSize (100);
+  NS_TEST_ASSERT_MSG_EQ (cache.GetSize (), 128, "The size must round up to a power of two");
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (key), 0, "A new cache must be empty");
+  Record (cache, key, cache.GetGeneration (), 2);
+  const SdnFlowCache13::Entry *entry = cache.Find (key);
+  NS_TEST_ASSERT_MSG_NE (entry, 0, "The stored entry must be found");
+  NS_TEST_ASSERT_MSG_EQ (entry->outPorts.size (), 1, "Bad entry contents");
+  NS_TEST_ASSERT_MSG_EQ (entry->outPorts[0], 2, "Bad entry contents");
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (MakeKey (2, 0x0800)), 0, "Another port must miss");
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (MakeKey (1, 0x0806)), 0, "Another ether type must miss");
+
+  // a single slot holds the last key stored in it
+  cache.SetSize (1);
+  SdnFlowKey other = MakeKey (3, 0x0806);
+  Record (cache, key, cache.GetGeneration (), 2);
+  Record (cache, other, cache.GetGeneration (), 4);
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (key), 0, "The replaced key must miss");
+  NS_TEST_ASSERT_MSG_NE (cache.Find (other), 0, "The last key stored must be found");
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (other)->outPorts[0], 4, "Bad entry contents");
+}
+
+/**
+ * Checks invalidation drops every entry at once, including the ones being
+ * recorded while it happens
+ */
+class SdnFlowCacheGenerationTestCase : public TestCase
+{
+public:
+  SdnFlowCacheGenerationTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowCacheGenerationTestCase::SdnFlowCacheGenerationTestCase ()
+  : TestCase ("Check flow cache generation invalidation")
+{
+}
+
+void
+SdnFlowCacheGenerationTestCase::DoRun (void)
+{
+  SdnFlowCache13 cache;
+  cache.SetSize (64);
+  std::vector<SdnFlowKey> keys;
+  for (uint32_t port = 1; port <= 8; ++port)
+    {
+      keys.push_back (MakeKey (port, 0x0800));
+      Record (cache, keys.back (), cache.GetGeneration (), port);
+    }
+
+  uint64_t generation = cache.GetGeneration ();
+  cache.Invalidate ();
+  NS_TEST_ASSERT_MSG_GT (cache.GetGeneration (), generation, "Invalidation must start a new generation");
+  for (uint32_t i = 0; i < keys.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (cache.Find (keys[i]), 0, "Entry " << i << " survived the invalidation");
+    }
+
+  // an entry recorded across an invalidation describes stale flows
+  Record (cache, keys[0], generation, 1);
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (keys[0]), 0, "A stale entry must not be stored");
+
+  Record (cache, keys[0], cache.GetGeneration (), 1);
+  NS_TEST_ASSERT_MSG_NE (cache.Find (keys[0]), 0, "Entries of the new generation must be found");
+  NS_TEST_ASSERT_MSG_EQ (cache.Find (keys[1]), 0, "Only the new entry must be found");
+}
+
+class SdnFlowCacheTestSuite : public TestSuite
+{
+public:
+  SdnFlowCacheTestSuite ();
+};
+
+SdnFlowCacheTestSuite::SdnFlowCacheTestSuite ()
+  : TestSuite ("sdn-flow-cache", UNIT)
+{
+  AddTestCase (new SdnFlowCacheLookupTestCase, TestCase::QUICK);
+  AddTestCase (new SdnFlowCacheGenerationTestCase, TestCase::QUICK);
+}
+
+static SdnFlowCacheTestSuite g_sdnFlowCacheTestSuite;
@@ -0,0 +1,253 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/Flow.h"
+#include "ns3/Flow13.h"
+
+using namespace ns3;
+using namespace fluid_msg;
+
+namespace {
+
+/**
+ * Builds the match of a TCP packet as a switch would, every field exact
+ */
+of13::Match
+MakePacketMatch (uint32_t inPort, const char *ipv4Dst, uint16_t tcpDst)
+{
+  of13::Match match;
+  match.add_oxm_field (new of13::InPort (inPort));
+  match.add_oxm_field (new of13::EthType (0x0800));
+  match.add_oxm_field (new of13::IPProto (6));
+  match.add_oxm_field (new of13::IPv4Dst (IPAddress (ipv4Dst)));
+  match.add_oxm_field (new of13::TCPDst (tcpDst));
+  return match;
+}
+
+/**
+ * Builds a flow matching IPv4 packets to a masked destination, and to a
+ * TCP port when one is given
+ */
+void
+MakeFlow (Flow13 &flow, uint16_t priority, const char *ipv4Dst, const char *ipv4Mask, uint16_t tcpDst)
+{
+  flow.priority_ = priority;
+  flow.match.add_oxm_field (new of13::EthType (0x0800));
+  flow.match.add_oxm_field (new of13::IPv4Dst (IPAddress (ipv4Dst), IPAddress (ipv4Mask)));
+  if (tcpDst)
+    {
+      flow.match.add_oxm_field (new of13::IPProto (6));
+      flow.match.add_oxm_field (new of13::TCPDst (tcpDst));
+    }
+  flow.compileMatch ();
+}
+
+} // anonymous namespace
+
+/**
+ * Checks a compiled OpenFlow 1.3 match takes the packets its fields and
+ * masks select, and only those
+ */
+class SdnFlowMatchPacketTestCase : public TestCase
+{
+public:
+  SdnFlowMatchPacketTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Matches a packet against its match and against its key, which must agree
+   * \return True if the flow takes the packet
+   */
+  bool Takes (const Flow13 &flow, of13::Match packet);
+};
+
+SdnFlowMatchPacketTestCase::SdnFlowMatchPacketTestCase ()
+  : TestCase ("Check compiled matches against packets")
+{
+}
+
+bool
+SdnFlowMatchPacketTestCase::Takes (const Flow13 &flow, of13::Match packet)
+{
+  SdnFlowKey key;
+  SdnFlowKey::Compile (packet, key);
+  bool byKey = Flow13::pkt_match (flow, key);
+  NS_TEST_EXPECT_MSG_EQ (Flow13::pkt_match (flow, packet), byKey, "The match and the key of a packet disagree");
+  return byKey;
+}
+
+void
+SdnFlowMatchPacketTestCase::DoRun (void)
+{
+  Flow13 web;
+  MakeFlow (web, 10, "10.1.0.0", "255.255.0.0", 80);
+
+  NS_TEST_ASSERT_MSG_EQ (Takes (web, MakePacketMatch (3, "10.1.2.3", 80)), true, "The packet is in the prefix");
+  NS_TEST_ASSERT_MSG_EQ (Takes (web, MakePacketMatch (3, "10.2.2.3", 80)), false, "The packet is out of the prefix");
+  NS_TEST_ASSERT_MSG_EQ (Takes (web, MakePacketMatch (3, "10.1.2.3", 81)), false, "The port differs");
+
+  // The UDP port sits in the bytes of the TCP port, only the field bit tells them apart
+  of13::Match udp;
+  udp.add_oxm_field (new of13::EthType (0x0800));
+  udp.add_oxm_field (new of13::IPProto (6));
+  udp.add_oxm_field (new of13::IPv4Dst (IPAddress ("10.1.2.3")));
+  udp.add_oxm_field (new of13::UDPDst (80));
+  NS_TEST_ASSERT_MSG_EQ (Takes (web, udp), false, "A UDP port is not a TCP port");
+
+  // A field of the flow the packet does not carry never matches, even as zeros
+  of13::Match noPort;
+  noPort.add_oxm_field (new of13::EthType (0x0800));
+  noPort.add_oxm_field (new of13::IPv4Dst (IPAddress ("10.1.2.3")));
+  Flow13 anyPort;
+  MakeFlow (anyPort, 10, "10.1.0.0", "255.255.0.0", 0);
+  NS_TEST_ASSERT_MSG_EQ (Takes (web, noPort), false, "The packet has no TCP port");
+  NS_TEST_ASSERT_MSG_EQ (Takes (anyPort, noPort), true, "The flow does not need a port");
+
+  // The bits of the value outside the mask are dropped when compiling
+  Flow13 loose;
+  MakeFlow (loose, 10, "10.1.255.255", "255.255.0.0", 80);
+  NS_TEST_ASSERT_MSG_EQ (Takes (loose, MakePacketMatch (3, "10.1.0.1", 80)), true, "Bits out of the mask must be dropped");
+
+  Flow13 all;
+  all.compileMatch ();
+  NS_TEST_ASSERT_MSG_EQ (Takes (all, MakePacketMatch (3, "192.168.0.1", 22)), true, "An empty match takes everything");
+  NS_TEST_ASSERT_MSG_EQ (Takes (all, of13::Match ()), true, "An empty match takes an empty packet");
+}
+
+/**
+ * Checks the strict and non strict comparisons of compiled matches used by
+ * the flow modifications
+ */
+class SdnFlowMatchOverlapTestCase : public TestCase
+{
+public:
+  SdnFlowMatchOverlapTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowMatchOverlapTestCase::SdnFlowMatchOverlapTestCase ()
+  : TestCase ("Check strict and non strict comparisons of compiled matches")
+{
+}
+
+void
+SdnFlowMatchOverlapTestCase::DoRun (void)
+{
+  Flow13 all;
+  all.priority_ = 10;
+  all.compileMatch ();
+  Flow13 wide;
+  MakeFlow (wide, 10, "10.1.0.0", "255.255.0.0", 0);
+  Flow13 narrow;
+  MakeFlow (narrow, 10, "10.1.2.0", "255.255.255.0", 0);
+  Flow13 other;
+  MakeFlow (other, 10, "10.2.2.0", "255.255.255.0", 0);
+  Flow13 web;
+  MakeFlow (web, 10, "10.1.0.0", "255.255.0.0", 80);
+
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (all, narrow), true, "An empty match covers any flow");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (wide, narrow), true, "A /16 covers a /24 inside it");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (narrow, wide), false, "A /24 does not cover its /16");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (wide, other), false, "A /16 does not cover a /24 outside it");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (wide, web), true, "Fewer fields cover more fields");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::non_strict_match (web, wide), false, "More fields do not cover fewer");
+
+  // The same match written with other bits out of the mask
+  Flow13 same;
+  MakeFlow (same, 10, "10.1.99.99", "255.255.0.0", 0);
+  NS_TEST_ASSERT_MSG_EQ (Flow13::strict_match (wide, same), true, "The matches are the same once compiled");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::strict_match (wide, narrow), false, "The masks differ");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::strict_match (wide, web), false, "The fields differ");
+  same.priority_ = 11;
+  NS_TEST_ASSERT_MSG_EQ (Flow13::strict_match (wide, same), false, "The priorities differ");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::pkt_match_strict (wide, same.match), true, "A strict match ignores the priority");
+  NS_TEST_ASSERT_MSG_EQ (Flow13::pkt_match_strict (wide, narrow.match), false, "The masks differ");
+}
+
+/**
+ * Checks an OpenFlow 1.0 match compiles its wildcards into masks, the
+ * prefix of the addresses included
+ */
+class SdnFlowMatchOf10TestCase : public TestCase
+{
+public:
+  SdnFlowMatchOf10TestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowMatchOf10TestCase::SdnFlowMatchOf10TestCase ()
+  : TestCase ("Check compiled OpenFlow 1.0 matches")
+{
+}
+
+void
+SdnFlowMatchOf10TestCase::DoRun (void)
+{
+  // IPv4 to 10.1.0.0/16 on TCP port 80, everything else wildcarded
+  Flow flow;
+  flow.match.dl_type (0x0800);
+  flow.match.nw_dst (IPAddress ("10.1.0.0"), 16);
+  flow.match.tp_dst (80);
+  flow.match.wildcards (of10::OFPFW_ALL & ~(of10::OFPFW_DL_TYPE | of10::OFPFW_NW_DST_MASK | of10::OFPFW_TP_DST));
+  flow.match.wildcards (flow.match.wildcards () | (16 << of10::OFPFW_NW_DST_SHIFT));
+  flow.compileMatch ();
+
+  of10::Match packet;
+  packet.in_port (4);
+  packet.dl_type (0x0800);
+  packet.nw_proto (6);
+  packet.nw_src (IPAddress ("10.9.9.9"));
+  packet.nw_dst (IPAddress ("10.1.2.3"));
+  packet.tp_src (1234);
+  packet.tp_dst (80);
+  NS_TEST_ASSERT_MSG_EQ (Flow::pkt_match (flow, packet), true, "The wildcarded fields must be ignored");
+
+  packet.nw_dst (IPAddress ("10.2.2.3"));
+  NS_TEST_ASSERT_MSG_EQ (Flow::pkt_match (flow, packet), false, "The packet is out of the prefix");
+  packet.nw_dst (IPAddress ("10.1.2.3"));
+  packet.tp_dst (81);
+  NS_TEST_ASSERT_MSG_EQ (Flow::pkt_match (flow, packet), false, "The port differs");
+
+  Flow all;
+  all.match.wildcards (of10::OFPFW_ALL);
+  all.compileMatch ();
+  NS_TEST_ASSERT_MSG_EQ (Flow::pkt_match (all, packet), true, "A fully wildcarded match takes everything");
+  NS_TEST_ASSERT_MSG_EQ (Flow::non_strict_match (all, flow), true, "A fully wildcarded match covers any flow");
+  NS_TEST_ASSERT_MSG_EQ (Flow::non_strict_match (flow, all), false, "A flow does not cover the wildcards");
+}
+
+class SdnFlowMatchTestSuite : public TestSuite
+{
+public:
+  SdnFlowMatchTestSuite ();
+};
+
+SdnFlowMatchTestSuite::SdnFlowMatchTestSuite ()
+  : TestSuite ("sdn-flow-match", UNIT)
+{
+  AddTestCase (new SdnFlowMatchPacketTestCase, TestCase::QUICK);
+  AddTestCase (new SdnFlowMatchOverlapTestCase, TestCase::QUICK);
+  AddTestCase (new SdnFlowMatchOf10TestCase, TestCase::QUICK);
+}
+
+static SdnFlowMatchTestSuite g_sdnFlowMatchTestSuite;
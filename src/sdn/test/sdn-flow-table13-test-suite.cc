@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/SdnFlowTable13.h"
+
+#include <sstream>
+
+using namespace ns3;
+using namespace fluid_msg;
+
+namespace {
+
+/**
+ * Fills an add flow mod for IPv4 packets to a /16, or for every packet
+ * when no destination is given
+ */
+void
+MakeFlowMod (of13::FlowMod &message, uint16_t priority, const char *ipv4Dst, uint16_t flags = 0)
+{
+  message.command (of13::OFPFC_ADD);
+  message.priority (priority);
+  message.flags (flags);
+  if (ipv4Dst)
+    {
+      message.add_oxm_field (new of13::EthType (0x0800));
+      message.add_oxm_field (new of13::IPv4Dst (IPAddress (ipv4Dst), IPAddress ("255.255.0.0")));
+    }
+}
+
+/**
+ * Adds a flow to the table
+ * \return The flow, NULL if it was refused
+ */
+Flow13*
+AddFlow (Ptr<SdnFlowTable13> table, uint16_t priority, const char *ipv4Dst, uint16_t flags = 0)
+{
+  of13::FlowMod message;
+  MakeFlowMod (message, priority, ipv4Dst, flags);
+  return table->addFlow (&message);
+}
+
+/**
+ * \return The priorities of the flows of the table, in the order flows () gives them
+ */
+std::vector<uint16_t>
+Priorities (Ptr<SdnFlowTable13> table)
+{
+  std::vector<uint16_t> priorities;
+  std::vector<Flow13*> flows = table->flows ();
+  for (std::vector<Flow13*>::iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      priorities.push_back ((*i)->priority_);
+    }
+  return priorities;
+}
+
+} // anonymous namespace
+
+/**
+ * Checks the flows of a table stay in priority order, oldest first on a
+ * tie, through additions, replacements and deletions
+ */
+class SdnFlowTable13OrderTestCase : public TestCase
+{
+public:
+  SdnFlowTable13OrderTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowTable13OrderTestCase::SdnFlowTable13OrderTestCase ()
+  : TestCase ("Check the priority index of the flow table")
+{
+}
+
+void
+SdnFlowTable13OrderTestCase::DoRun (void)
+{
+  Ptr<SdnFlowTable13> table = CreateObject<SdnFlowTable13> ();
+  Flow13 *first = AddFlow (table, 10, "10.1.0.0");
+  Flow13 *high = AddFlow (table, 20, "10.9.0.0");
+  Flow13 *second = AddFlow (table, 10, "10.2.0.0");
+  Flow13 *low = AddFlow (table, 5, 0);
+
+  std::vector<Flow13*> flows = table->flows ();
+  NS_TEST_ASSERT_MSG_EQ (flows.size (), 4, "Every flow must be in the table");
+  NS_TEST_ASSERT_MSG_EQ (flows[0], high, "The highest priority comes first");
+  NS_TEST_ASSERT_MSG_EQ (flows[1], first, "The oldest flow comes first on a tie");
+  NS_TEST_ASSERT_MSG_EQ (flows[2], second, "The newest flow comes last on a tie");
+  NS_TEST_ASSERT_MSG_EQ (flows[3], low, "The lowest priority comes last");
+  NS_TEST_ASSERT_MSG_EQ (table->m_active_count, 4, "Bad active count");
+
+  // An identical flow replaces the old one and goes after its equals
+  uint64_t firstId = first->id_;
+  Flow13 *replaced = AddFlow (table, 10, "10.1.0.0");
+  NS_TEST_ASSERT_MSG_NE (replaced, 0, "An identical flow must replace the old one");
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (firstId), 0, "The replaced flow must be gone");
+  flows = table->flows ();
+  NS_TEST_ASSERT_MSG_EQ (flows.size (), 4, "A replacement must not grow the table");
+  NS_TEST_ASSERT_MSG_EQ (flows[1], second, "The flow left must move up");
+  NS_TEST_ASSERT_MSG_EQ (flows[2], replaced, "The replacement is the newest of its priority");
+
+  // Unless overlaps are checked
+  NS_TEST_ASSERT_MSG_EQ (AddFlow (table, 10, "10.1.0.0", of13::OFPFF_CHECK_OVERLAP), 0, "The overlap must be refused");
+  NS_TEST_ASSERT_MSG_EQ (table->flows ().size (), 4, "A refused flow must not be added");
+  NS_TEST_ASSERT_MSG_NE (table->findFlow (replaced->id_), 0, "The installed flow must stay");
+
+  // Deleting the only flow of a priority, then adding at that priority again
+  of13::FlowMod remove;
+  MakeFlowMod (remove, 20, "10.9.0.0");
+  remove.command (of13::OFPFC_DELETE);
+  table->deleteFlow (&remove);
+  NS_TEST_ASSERT_MSG_EQ (table->m_active_count, 3, "Bad active count after the deletion");
+  Flow13 *again = AddFlow (table, 20, "10.8.0.0");
+  Flow13 *middle = AddFlow (table, 15, "10.7.0.0");
+  std::vector<uint16_t> priorities = Priorities (table);
+  uint16_t expected[] = { 20, 15, 10, 10, 5 };
+  NS_TEST_ASSERT_MSG_EQ ((priorities == std::vector<uint16_t> (expected, expected + 5)), true,
+                         "The flows must stay by decreasing priority");
+  NS_TEST_ASSERT_MSG_EQ (table->flows ()[0], again, "Bad flow at the head");
+  NS_TEST_ASSERT_MSG_EQ (table->flows ()[1], middle, "Bad flow between two priorities");
+}
+
+/**
+ * Checks flow entries keep their address and id while they are installed,
+ * and that an id is never found again once its flow is gone
+ */
+class SdnFlowTable13PoolTestCase : public TestCase
+{
+public:
+  SdnFlowTable13PoolTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowTable13PoolTestCase::SdnFlowTable13PoolTestCase ()
+  : TestCase ("Check the stable ids and addresses of pooled flow entries")
+{
+}
+
+void
+SdnFlowTable13PoolTestCase::DoRun (void)
+{
+  Ptr<SdnFlowTable13> table = CreateObject<SdnFlowTable13> ();
+  Flow13 *kept = AddFlow (table, 10, "10.0.0.0");
+  uint64_t keptId = kept->id_;
+  Flow13 *gone = AddFlow (table, 20, "10.1.0.0");
+  uint64_t goneId = gone->id_;
+  NS_TEST_ASSERT_MSG_NE (keptId, goneId, "Ids must be unique");
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (goneId), gone, "A flow must be found by its id");
+
+  // Lookups update the installed entry in place
+  Ptr<Packet> packet = Create<Packet> (100);
+  table->recordLookup (kept, packet);
+  table->recordLookup (kept, packet);
+  table->recordLookup (0, packet);
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (keptId)->packet_count_, 2, "Bad packet count");
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (keptId)->byte_count_, 200, "Bad byte count");
+  NS_TEST_ASSERT_MSG_EQ (table->m_lookup_count, 3, "A miss is a lookup too");
+  NS_TEST_ASSERT_MSG_EQ (table->m_matched_count, 2, "A miss is not a match");
+
+  // The slot of a deleted flow is reused under a new id
+  of13::FlowMod remove;
+  MakeFlowMod (remove, 20, "10.1.0.0");
+  remove.command (of13::OFPFC_DELETE);
+  table->deleteFlow (&remove);
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (goneId), 0, "A deleted flow must not be found");
+  Flow13 *reused = AddFlow (table, 20, "10.1.0.0");
+  NS_TEST_ASSERT_MSG_EQ (reused, gone, "The free entry must be reused");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)reused->id_, (uint32_t)goneId, "The free slot must be reused");
+  NS_TEST_ASSERT_MSG_NE (reused->id_, goneId, "A reused slot needs a new id");
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (goneId), 0, "An old id must not find the new flow");
+  NS_TEST_ASSERT_MSG_EQ (reused->packet_count_, 0, "A reused entry starts its counters again");
+
+  // Growing the pool leaves the installed entries where they are
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      std::ostringstream dst;
+      dst << "10." << 2 + i % 250 << ".0.0";
+      AddFlow (table, 30 + i, dst.str ().c_str ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (keptId), kept, "An entry must not move while installed");
+  NS_TEST_ASSERT_MSG_EQ (kept->packet_count_, 2, "An entry must keep its counters while installed");
+  NS_TEST_ASSERT_MSG_EQ (table->flows ().size (), 202, "Bad number of flows");
+  NS_TEST_ASSERT_MSG_EQ (table->flows ().back (), kept, "The lowest priority must stay last");
+}
+
+/**
+ * Checks a batch of flow mods ends as adding them one by one would
+ */
+class SdnFlowTable13BatchTestCase : public TestCase
+{
+public:
+  SdnFlowTable13BatchTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnFlowTable13BatchTestCase::SdnFlowTable13BatchTestCase ()
+  : TestCase ("Check batches of flow additions")
+{
+}
+
+void
+SdnFlowTable13BatchTestCase::DoRun (void)
+{
+  Ptr<SdnFlowTable13> table = CreateObject<SdnFlowTable13> ();
+  Flow13 *installed = AddFlow (table, 10, "10.1.0.0");
+  uint64_t installedId = installed->id_;
+
+  // Replaces the installed flow, is replaced within the batch, and overlaps
+  of13::FlowMod messages[5];
+  MakeFlowMod (messages[0], 10, "10.1.0.0");
+  MakeFlowMod (messages[1], 20, "10.2.0.0");
+  MakeFlowMod (messages[2], 20, "10.2.0.0");
+  MakeFlowMod (messages[3], 10, "10.1.0.0", of13::OFPFF_CHECK_OVERLAP);
+  MakeFlowMod (messages[4], 15, 0);
+  std::vector<of13::FlowMod*> batch;
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      batch.push_back (&messages[i]);
+    }
+  std::vector<bool> added = table->addFlows (batch);
+
+  bool expected[] = { true, true, true, false, true };
+  NS_TEST_ASSERT_MSG_EQ ((added == std::vector<bool> (expected, expected + 5)), true, "Bad outcome of the batch");
+  NS_TEST_ASSERT_MSG_EQ (table->findFlow (installedId), 0, "The installed flow must be replaced");
+  std::vector<uint16_t> priorities = Priorities (table);
+  uint16_t order[] = { 20, 15, 10 };
+  NS_TEST_ASSERT_MSG_EQ ((priorities == std::vector<uint16_t> (order, order + 3)), true,
+                         "The batch must leave one flow per match, by decreasing priority");
+  NS_TEST_ASSERT_MSG_EQ (table->m_active_count, 3, "Bad active count");
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Flow13 *flow = table->flows ()[i];
+      NS_TEST_ASSERT_MSG_EQ (table->findFlow (flow->id_), flow, "Every flow of the batch must be found by its id");
+    }
+}
+
+class SdnFlowTable13TestSuite : public TestSuite
+{
+public:
+  SdnFlowTable13TestSuite ();
+};
+
+SdnFlowTable13TestSuite::SdnFlowTable13TestSuite ()
+  : TestSuite ("sdn-flow-table13", UNIT)
+{
+  AddTestCase (new SdnFlowTable13OrderTestCase, TestCase::QUICK);
+  AddTestCase (new SdnFlowTable13PoolTestCase, TestCase::QUICK);
+  AddTestCase (new SdnFlowTable13BatchTestCase, TestCase::QUICK);
+}
+
+static SdnFlowTable13TestSuite g_sdnFlowTable13TestSuite;
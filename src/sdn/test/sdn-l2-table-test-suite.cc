@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/SdnL2Table.h"
+
+using namespace ns3;
+
+/**
+ * Checks learnt addresses resolve to their last port, across growth and removal
+ */
+class SdnL2TableLearnTestCase : public TestCase
+{
+public:
+  SdnL2TableLearnTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnL2TableLearnTestCase::SdnL2TableLearnTestCase ()
+  : TestCase ("Check L2 table learning and lookup")
+{
+}
+
+void
+SdnL2TableLearnTestCase::DoRun (void)
+{
+  SdnL2Table table;
+  uint32_t port = 0;
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup (0x000000000001ULL, port), false, "A new table must be empty");
+
+  table.Learn (0x000000000001ULL, 1);
+  table.Learn (0xffffffffffffULL, 2);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 2, "Bad number of entries");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup (0x000000000001ULL, port), true, "A learnt address must resolve");
+  NS_TEST_ASSERT_MSG_EQ (port, 1, "Bad port");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup (0xffffffffffffULL, port), true, "The broadcast address is a key like any other");
+  NS_TEST_ASSERT_MSG_EQ (port, 2, "Bad port");
+
+  // a station moving to another port overwrites its entry
+  table.Learn (0x000000000001ULL, 3);
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 2, "Relearning an address must not add an entry");
+  NS_TEST_ASSERT_MSG_EQ (table.Lookup (0x000000000001ULL, port), true, "A relearnt address must resolve");
+  NS_TEST_ASSERT_MSG_EQ (port, 3, "The last port seen must win");
+
+  // many addresses grow the table well past its first slots
+  table.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), 0, "Clear must drop every entry");
+  const uint32_t count = 20 * SDN_L2_MIN_SLOTS;
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      table.Learn (0x0a0000000000ULL + i, i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), count, "Bad number of entries");
+
+  // removing every other address must keep the rest reachable
+  for (uint32_t i = 0; i < count; i += 2)
+    {
+      NS_TEST_ASSERT_MSG_EQ (table.Remove (0x0a0000000000ULL + i), true, "Address " << i << " must be removed");
+    }
+  NS_TEST_ASSERT_MSG_EQ (table.Remove (0x0a0000000000ULL), false, "An address can only be removed once");
+  NS_TEST_ASSERT_MSG_EQ (table.GetSize (), count / 2, "Bad number of entries");
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      bool found = table.Lookup (0x0a0000000000ULL + i, port);
+      NS_TEST_ASSERT_MSG_EQ (found, (i % 2 == 1), "Bad lookup of address " << i);
+      if (found)
+        {
+          NS_TEST_ASSERT_MSG_EQ (port, i, "Bad port of address " << i);
+        }
+    }
+}
+
+/**
+ * Checks entries age out once not seen for the aging time, and that a full
+ * table makes room by dropping aged then least recently seen entries
+ */
+class SdnL2TableAgingTestCase : public TestCase
+{
+public:
+  SdnL2TableAgingTestCase ();
+  virtual void DoRun (void);
+private:
+  void Learn (uint64_t mac, uint32_t port);
+  void CheckAging (void);
+  void CheckEviction (void);
+  SdnL2Table m_table;
+};
+
+SdnL2TableAgingTestCase::SdnL2TableAgingTestCase ()
+  : TestCase ("Check L2 table aging and eviction")
+{
+}
+
+void
+SdnL2TableAgingTestCase::Learn (uint64_t mac, uint32_t port)
+{
+  m_table.Learn (mac, port);
+}
+
+void
+SdnL2TableAgingTestCase::CheckAging (void)
+{
+  uint32_t port;
+  NS_TEST_EXPECT_MSG_EQ (m_table.Lookup (1, port), false, "An address not seen for the aging time must age out");
+  NS_TEST_EXPECT_MSG_EQ (m_table.Lookup (2, port), true, "An address seen again must stay known");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetSize (), 2, "Aged entries stay until expired");
+  NS_TEST_EXPECT_MSG_EQ (m_table.Expire (), 1, "Expire must drop the aged entry");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetSize (), 1, "Bad number of entries");
+}
+
+void
+SdnL2TableAgingTestCase::CheckEviction (void)
+{
+  uint32_t port;
+  // addresses 10 to 17 were learnt one second apart, 10 and 11 were seen again
+  m_table.Learn (100, 1);
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetSize (), 8, "A full table must stay at its capacity");
+  NS_TEST_EXPECT_MSG_EQ (m_table.Lookup (12, port), false, "The least recently seen address must be evicted");
+  NS_TEST_EXPECT_MSG_EQ (m_table.Lookup (10, port), true, "An address seen again must stay");
+  NS_TEST_EXPECT_MSG_EQ (m_table.Lookup (100, port), true, "The new address must be learnt");
+}
+
+void
+SdnL2TableAgingTestCase::DoRun (void)
+{
+  m_table.SetAgingTime (Seconds (10));
+  m_table.Learn (1, 1);
+  m_table.Learn (2, 2);
+  Simulator::Schedule (Seconds (5), &SdnL2TableAgingTestCase::Learn, this, 2, 2);
+  Simulator::Schedule (Seconds (10), &SdnL2TableAgingTestCase::CheckAging, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // without aging, a full table evicts the least recently seen eighth of it
+  m_table.SetAgingTime (Seconds (0));
+  m_table.SetCapacity (8);
+  NS_TEST_ASSERT_MSG_EQ (m_table.GetSize (), 0, "Setting the capacity must drop every entry");
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      Simulator::Schedule (Seconds (i), &SdnL2TableAgingTestCase::Learn, this, 10 + i, i);
+    }
+  Simulator::Schedule (Seconds (8), &SdnL2TableAgingTestCase::Learn, this, 10, 0);
+  Simulator::Schedule (Seconds (9), &SdnL2TableAgingTestCase::Learn, this, 11, 1);
+  Simulator::Schedule (Seconds (10), &SdnL2TableAgingTestCase::CheckEviction, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+class SdnL2TableTestSuite : public TestSuite
+{
+public:
+  SdnL2TableTestSuite ();
+};
+
+SdnL2TableTestSuite::SdnL2TableTestSuite ()
+  : TestSuite ("sdn-l2-table", UNIT)
+{
+  AddTestCase (new SdnL2TableLearnTestCase, TestCase::QUICK);
+  AddTestCase (new SdnL2TableAgingTestCase, TestCase::QUICK);
+}
+
+static SdnL2TableTestSuite g_sdnL2TableTestSuite;
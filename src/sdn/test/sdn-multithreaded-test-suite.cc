@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/node-container.h"
+#include "ns3/layer2-p2p-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/udp-echo-helper.h"
+#include "ns3/SdnController.h"
+#include "ns3/SdnSwitch.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * A controller floods every packet its switches report
+ */
+class FloodingListener : public SdnListener
+{
+public:
+  virtual void event_callback (ControllerEvent* ev)
+  {
+    if (ev->get_type () != EVENT_PACKET_IN)
+      {
+        return;
+      }
+    PacketInEvent* pi = static_cast<PacketInEvent*> (ev);
+    fluid_msg::of10::PacketIn packetIn;
+    packetIn.unpack (pi->data);
+    fluid_msg::of10::PacketOut packetOut (packetIn.xid (), packetIn.buffer_id (), packetIn.in_port ());
+    if (packetIn.buffer_id () == (uint32_t)(-1))
+      {
+        packetOut.data (packetIn.data (), packetIn.data_len ());
+      }
+    fluid_msg::of10::OutputAction action (fluid_msg::of10::OFPP_FLOOD, 1024);
+    packetOut.add_action (action);
+    uint8_t* buffer = packetOut.pack ();
+    ev->ofconn->send (buffer, packetOut.length ());
+    fluid_msg::OFMsg::free_buffer (buffer);
+  }
+};
+
+/**
+ * A frame received by a host
+ */
+struct RxRecord
+{
+  int64_t ts;
+  uint32_t size;
+};
+
+typedef std::vector<std::vector<RxRecord> > Trace;
+
+/**
+ * \brief Records a frame received by host index of the trace
+ */
+void
+HostRx (Trace *trace, uint32_t index, Ptr<const Packet> packet)
+{
+  RxRecord record;
+  record.ts = Simulator::Now ().GetTimeStep ();
+  record.size = packet->GetSize ();
+  (*trace)[index].push_back (record);
+}
+
+} // anonymous namespace
+
+/**
+ * Runs an SDN dumbbell, the controller and the switches in one partition and
+ * the hosts of each side in another, under the serial and the multithreaded
+ * simulators, and checks every host receives the same frames at the same times
+ */
+class SdnMultithreadedDumbbellTestCase : public TestCase
+{
+public:
+  SdnMultithreadedDumbbellTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Builds and runs the dumbbell, recording the frames received by the hosts
+   *
+   * \param implementation The type of the simulator implementation
+   * \param threads The MaxThreads of a MultithreadedSimulatorImpl
+   * \param trace The receptions, one list per host
+   */
+  void RunDumbbell (std::string implementation, uint32_t threads, Trace &trace);
+  void Compare (const Trace &expected, const Trace &trace, std::string what);
+
+  static const uint32_t HOSTS = 3;     //!< Hosts on each side
+  static const uint32_t SWITCHES = 2;
+};
+
+SdnMultithreadedDumbbellTestCase::SdnMultithreadedDumbbellTestCase ()
+  : TestCase ("Check an SDN dumbbell runs the same with the multithreaded simulator")
+{
+}
+
+void
+SdnMultithreadedDumbbellTestCase::RunDumbbell (std::string implementation, uint32_t threads, Trace &trace)
+{
+  Simulator::Destroy ();
+  ObjectFactory factory;
+  factory.SetTypeId (implementation);
+  if (implementation == "ns3::MultithreadedSimulatorImpl")
+    {
+      factory.Set ("MaxThreads", UintegerValue (threads));
+    }
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  // the control connections are not Layer2P2P links, so the controller and
+  // the switches share partition 0; the hosts of each side get their own
+  Ptr<Node> controller = CreateObject<Node> (0);
+  NodeContainer switches, left, right;
+  for (uint32_t i = 0; i < SWITCHES; ++i)
+    {
+      switches.Add (CreateObject<Node> (0));
+    }
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      left.Add (CreateObject<Node> (1));
+      right.Add (CreateObject<Node> (2));
+    }
+
+  Layer2P2PHelper layer2;
+  layer2.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  layer2.SetChannelAttribute ("Delay", StringValue ("20us"));
+  PointToPointHelper control;
+  control.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  control.SetChannelAttribute ("Delay", StringValue ("50us"));
+
+  NetDeviceContainer data;
+  NetDeviceContainer hostDevices;
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      NetDeviceContainer l = layer2.Install (left.Get (i), switches.Get (0));
+      NetDeviceContainer r = layer2.Install (right.Get (i), switches.Get (SWITCHES - 1));
+      data.Add (l);
+      data.Add (r);
+      hostDevices.Add (l.Get (0));
+      hostDevices.Add (r.Get (0));
+    }
+  for (uint32_t i = 1; i < SWITCHES; ++i)
+    {
+      data.Add (layer2.Install (switches.Get (i - 1), switches.Get (i)));
+    }
+  std::vector<NetDeviceContainer> controlDevices;
+  for (uint32_t i = 0; i < SWITCHES; ++i)
+    {
+      controlDevices.push_back (control.Install (switches.Get (i), controller));
+    }
+
+  InternetStackHelper internet;
+  internet.Install (controller);
+  internet.Install (switches);
+  internet.Install (left);
+  internet.Install (right);
+  // the ARP jitter draws from streams numbered on creation, fix them so every run draws the same
+  NodeContainer all (NodeContainer (controller), switches, left, right);
+  internet.AssignStreams (all, 0);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer dataInterfaces = addresses.Assign (data);
+  for (uint32_t i = 0; i < SWITCHES; ++i)
+    {
+      std::ostringstream base;
+      base << "192.168." << i + 1 << ".0";
+      addresses.SetBase (base.str ().c_str (), "255.255.255.0");
+      addresses.Assign (controlDevices[i]);
+    }
+
+  Ptr<SdnController> sdnController = CreateObject<SdnController> (CreateObject<FloodingListener> ());
+  controller->AddApplication (sdnController);
+  sdnController->SetStartTime (Seconds (0));
+  for (uint32_t i = 0; i < SWITCHES; ++i)
+    {
+      Ptr<SdnSwitch> sdnSwitch = CreateObject<SdnSwitch> ();
+      switches.Get (i)->AddApplication (sdnSwitch);
+      sdnSwitch->SetStartTime (Seconds (0));
+    }
+
+  // every left host echoes with the right host facing it, the first
+  // packets also resolve the addresses through the flooded ARP requests
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      UdpEchoServerHelper server (9);
+      ApplicationContainer serverApp = server.Install (right.Get (i));
+      serverApp.Start (Seconds (0));
+
+      UdpEchoClientHelper client (dataInterfaces.GetAddress (4 * i + 2), 9);
+      client.SetAttribute ("MaxPackets", UintegerValue (5));
+      client.SetAttribute ("Interval", TimeValue (MilliSeconds (10)));
+      client.SetAttribute ("PacketSize", UintegerValue (100 + 200 * i));
+      ApplicationContainer clientApp = client.Install (left.Get (i));
+      clientApp.Start (Seconds (1) + MicroSeconds (300 * i));
+    }
+
+  trace.assign (hostDevices.GetN (), std::vector<RxRecord> ());
+  for (uint32_t i = 0; i < hostDevices.GetN (); ++i)
+    {
+      hostDevices.Get (i)->TraceConnectWithoutContext ("MacRx", MakeBoundCallback (&HostRx, &trace, i));
+    }
+
+  Simulator::Stop (Seconds (1.2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+SdnMultithreadedDumbbellTestCase::Compare (const Trace &expected, const Trace &trace, std::string what)
+{
+  for (uint32_t i = 0; i < expected.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (trace[i].size (), expected[i].size (), what << ": bad number of receptions at host " << i);
+      for (uint32_t j = 0; j < expected[i].size (); ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (trace[i][j].ts, expected[i][j].ts, what << ": bad time of reception " << j << " at host " << i);
+          NS_TEST_ASSERT_MSG_EQ (trace[i][j].size, expected[i][j].size, what << ": bad size of reception " << j << " at host " << i);
+        }
+    }
+}
+
+void
+SdnMultithreadedDumbbellTestCase::DoRun (void)
+{
+  Trace serial;
+  RunDumbbell ("ns3::DefaultSimulatorImpl", 0, serial);
+  // each client gets its five echoes back through the controller
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      uint32_t echoes = 0;
+      for (uint32_t j = 0; j < serial[2 * i].size (); ++j)
+        {
+          echoes += serial[2 * i][j].size == 100 + 200 * i + 46;
+        }
+      NS_TEST_ASSERT_MSG_EQ (echoes, 5, "Bad number of echoes at left host " << i);
+    }
+
+  Trace single;
+  RunDumbbell ("ns3::MultithreadedSimulatorImpl", 1, single);
+  Compare (serial, single, "1 thread");
+
+  Trace multiple;
+  RunDumbbell ("ns3::MultithreadedSimulatorImpl", 3, multiple);
+  Compare (serial, multiple, "3 threads");
+}
+
+class SdnMultithreadedTestSuite : public TestSuite
+{
+public:
+  SdnMultithreadedTestSuite ();
+};
+
+SdnMultithreadedTestSuite::SdnMultithreadedTestSuite ()
+  : TestSuite ("sdn-multithreaded", UNIT)
+{
+  AddTestCase (new SdnMultithreadedDumbbellTestCase, TestCase::QUICK);
+}
+
+static SdnMultithreadedTestSuite g_sdnMultithreadedTestSuite;
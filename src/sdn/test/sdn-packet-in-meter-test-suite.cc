@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/SdnPacketInMeter13.h"
+
+using namespace ns3;
+using namespace fluid_msg;
+
+namespace {
+
+SdnPacketInMeter13::Miss
+MakeMiss (uint32_t inPort, uint16_t ethType)
+{
+  SdnPacketInMeter13::Miss miss;
+  miss.packet = Create<Packet> (64);
+  miss.inPort = inPort;
+  miss.reason = of13::OFPR_NO_MATCH;
+  miss.key.SetField32 (of13::OFPXMT_OFB_IN_PORT, inPort);
+  miss.key.SetField16 (of13::OFPXMT_OFB_ETH_TYPE, ethType);
+  return miss;
+}
+
+/**
+ * \return The ether type of the key of a miss
+ */
+uint16_t
+GetEthType (const SdnPacketInMeter13::Miss &miss)
+{
+  const uint8_t *data = miss.key.Bytes () + SdnFlowKey::FieldOffset (of13::OFPXMT_OFB_ETH_TYPE);
+  return (data[0] << 8) | data[1];
+}
+
+} // anonymous namespace
+
+/**
+ * Checks the switch bucket lets its burst through, then defers or suppresses
+ * misses until it refills
+ */
+class SdnPacketInMeterRateTestCase : public TestCase
+{
+public:
+  SdnPacketInMeterRateTestCase ();
+  virtual void DoRun (void);
+private:
+  void Drain (void);
+  SdnPacketInMeter13 m_meter;
+  std::vector<Time> m_sent;
+};
+
+SdnPacketInMeterRateTestCase::SdnPacketInMeterRateTestCase ()
+  : TestCase ("Check PacketIn rate limiting")
+{
+}
+
+void
+SdnPacketInMeterRateTestCase::Drain (void)
+{
+  std::vector<SdnPacketInMeter13::Miss> ready, suppressed;
+  m_meter.Drain (ready, suppressed);
+  for (uint32_t i = 0; i < ready.size (); ++i)
+    {
+      m_sent.push_back (Simulator::Now ());
+    }
+  if (m_meter.HasQueued ())
+    {
+      Simulator::Schedule (m_meter.GetDrainDelay (), &SdnPacketInMeterRateTestCase::Drain, this);
+    }
+}
+
+void
+SdnPacketInMeterRateTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_meter.IsEnabled (), false, "A new meter must be disabled");
+  m_meter.SetSwitchRate (10, 2);
+  NS_TEST_ASSERT_MSG_EQ (m_meter.IsEnabled (), true, "A rate must enable the meter");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.IsCoalescing (), false, "A rate alone must not coalesce");
+
+  // without a queue, misses beyond the burst are suppressed
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x0800)), SdnPacketInMeter13::SEND, "The burst must go through");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x0806)), SdnPacketInMeter13::SEND, "The burst must go through");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x86dd)), SdnPacketInMeter13::SUPPRESS, "An empty bucket without a queue must suppress");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.HasQueued (), false, "Nothing must be queued");
+
+  // with one, they wait for the bucket to refill at 10 per second
+  m_meter.SetQueueSize (2);
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x86dd)), SdnPacketInMeter13::DEFER, "An empty bucket must defer");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (2, 0x86dd)), SdnPacketInMeter13::DEFER, "An empty bucket must defer");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x8847)), SdnPacketInMeter13::DEFER, "An empty bucket must defer");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x8848)), SdnPacketInMeter13::SUPPRESS, "A full queue must suppress");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.HasQueued (), true, "Misses must be queued");
+  Time delay = m_meter.GetDrainDelay ();
+  NS_TEST_ASSERT_MSG_EQ ((delay >= MilliSeconds (100) && delay <= MilliSeconds (101)), true, "Bad drain delay " << delay);
+
+  Simulator::Schedule (delay, &SdnPacketInMeterRateTestCase::Drain, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 3, "Every queued miss must be drained");
+  for (uint32_t i = 0; i < m_sent.size (); ++i)
+    {
+      Time expected = MilliSeconds (100 * (i + 1));
+      NS_TEST_ASSERT_MSG_EQ ((m_sent[i] >= expected && m_sent[i] <= expected + MilliSeconds (1)), true,
+                             "Miss " << i << " drained at " << m_sent[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_meter.HasQueued (), false, "The queues must be empty");
+}
+
+/**
+ * Checks the queues of the ports are drained round robin
+ */
+class SdnPacketInMeterFairnessTestCase : public TestCase
+{
+public:
+  SdnPacketInMeterFairnessTestCase ();
+  virtual void DoRun (void);
+private:
+  void Drain (void);
+  SdnPacketInMeter13 m_meter;
+  std::vector<uint16_t> m_order;
+};
+
+SdnPacketInMeterFairnessTestCase::SdnPacketInMeterFairnessTestCase ()
+  : TestCase ("Check PacketIn queues are drained round robin")
+{
+}
+
+void
+SdnPacketInMeterFairnessTestCase::Drain (void)
+{
+  std::vector<SdnPacketInMeter13::Miss> ready, suppressed;
+  m_meter.Drain (ready, suppressed);
+  for (uint32_t i = 0; i < ready.size (); ++i)
+    {
+      m_order.push_back (GetEthType (ready[i]));
+    }
+  if (m_meter.HasQueued ())
+    {
+      Simulator::Schedule (m_meter.GetDrainDelay (), &SdnPacketInMeterFairnessTestCase::Drain, this);
+    }
+}
+
+void
+SdnPacketInMeterFairnessTestCase::DoRun (void)
+{
+  m_meter.SetSwitchRate (10, 1);
+  m_meter.SetQueueSize (10);
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 1)), SdnPacketInMeter13::SEND, "The burst must go through");
+  // port 1 queues three misses before port 2 queues its one
+  m_meter.Admit (MakeMiss (1, 2));
+  m_meter.Admit (MakeMiss (1, 3));
+  m_meter.Admit (MakeMiss (1, 4));
+  m_meter.Admit (MakeMiss (2, 5));
+
+  Simulator::Schedule (m_meter.GetDrainDelay (), &SdnPacketInMeterFairnessTestCase::Drain, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_order.size (), 4, "Every queued miss must be drained");
+  uint16_t expected[4] = { 2, 5, 3, 4 };
+  for (uint32_t i = 0; i < m_order.size () && i < 4; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_order[i], expected[i], "Bad drain order at " << i);
+    }
+}
+
+/**
+ * Checks misses of a key already sent are suppressed until the controller
+ * answers or the coalescing timeout passes
+ */
+class SdnPacketInMeterCoalesceTestCase : public TestCase
+{
+public:
+  SdnPacketInMeterCoalesceTestCase ();
+  virtual void DoRun (void);
+private:
+  void Admit (SdnPacketInMeter13::Verdict expected, std::string message);
+  SdnPacketInMeter13 m_meter;
+};
+
+SdnPacketInMeterCoalesceTestCase::SdnPacketInMeterCoalesceTestCase ()
+  : TestCase ("Check PacketIn coalescing")
+{
+}
+
+void
+SdnPacketInMeterCoalesceTestCase::Admit (SdnPacketInMeter13::Verdict expected, std::string message)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x0800)), expected, message << " at " << Simulator::Now ());
+}
+
+void
+SdnPacketInMeterCoalesceTestCase::DoRun (void)
+{
+  m_meter.SetCoalesceTimeout (Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (m_meter.IsEnabled (), true, "Coalescing must enable the meter");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.IsCoalescing (), true, "The meter must coalesce");
+
+  Admit (SdnPacketInMeter13::SEND, "The first miss must go through");
+  Admit (SdnPacketInMeter13::SUPPRESS, "A pending key must be suppressed");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (1, 0x0806)), SdnPacketInMeter13::SEND, "Another key must go through");
+  NS_TEST_ASSERT_MSG_EQ (m_meter.Admit (MakeMiss (2, 0x0800)), SdnPacketInMeter13::SEND, "Another port must go through");
+
+  // a flow mod from the controller clears the pending keys
+  m_meter.ClearPending ();
+  Admit (SdnPacketInMeter13::SEND, "A cleared key must go through");
+
+  // the pending key expires with the timeout
+  Simulator::Schedule (MilliSeconds (999), &SdnPacketInMeterCoalesceTestCase::Admit, this,
+                       SdnPacketInMeter13::SUPPRESS, "A pending key must be suppressed");
+  Simulator::Schedule (Seconds (1), &SdnPacketInMeterCoalesceTestCase::Admit, this,
+                       SdnPacketInMeter13::SEND, "An expired key must go through");
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+class SdnPacketInMeterTestSuite : public TestSuite
+{
+public:
+  SdnPacketInMeterTestSuite ();
+};
+
+SdnPacketInMeterTestSuite::SdnPacketInMeterTestSuite ()
+  : TestSuite ("sdn-packet-in-meter", UNIT)
+{
+  AddTestCase (new SdnPacketInMeterRateTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPacketInMeterFairnessTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPacketInMeterCoalesceTestCase, TestCase::QUICK);
+}
+
+static SdnPacketInMeterTestSuite g_sdnPacketInMeterTestSuite;
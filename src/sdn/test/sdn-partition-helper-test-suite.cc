@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/sdn-partition-helper.h"
+
+using namespace ns3;
+
+/**
+ * Checks the largest threshold is kept: on a ring of two 1ms chains joined
+ * by 10ms links, both 10ms links are cut and nothing else
+ */
+class SdnPartitionThresholdTestCase : public TestCase
+{
+public:
+  SdnPartitionThresholdTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnPartitionThresholdTestCase::SdnPartitionThresholdTestCase ()
+  : TestCase ("Check the partition maximizes the smallest delay across ranks")
+{
+}
+
+void
+SdnPartitionThresholdTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (8);
+  SdnPartitionHelper partition;
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      partition.AddLink (nodes.Get (i), nodes.Get ((i + 1) % 8), MilliSeconds (i % 4 == 3 ? 10 : 1));
+    }
+  partition.Partition (nodes, 2);
+
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (10), "Only the 10ms links may cross ranks");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (0), MilliSeconds (10), "Bad lookahead of rank 0");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (1), MilliSeconds (10), "Bad lookahead of rank 1");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetNNodes (0), 4, "Each chain must fill a rank");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetNNodes (1), 4, "Each chain must fill a rank");
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (nodes.Get (i)->GetSystemId (), nodes.Get (i / 4 * 4)->GetSystemId (),
+                             "Node " << i << " must stay with its chain");
+    }
+  NS_TEST_ASSERT_MSG_NE (nodes.Get (0)->GetSystemId (), nodes.Get (4)->GetSystemId (),
+                         "The chains must be on different ranks");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Checks switches join the rank of their controller as long as the rank
+ * stays within the limit, and not beyond
+ */
+class SdnPartitionControllerTestCase : public TestCase
+{
+public:
+  SdnPartitionControllerTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnPartitionControllerTestCase::SdnPartitionControllerTestCase ()
+  : TestCase ("Check switches share the rank of their controller when the balance allows")
+{
+}
+
+void
+SdnPartitionControllerTestCase::DoRun (void)
+{
+  // Two pairs of switches 10ms apart, and a controller 20ms from each switch;
+  // with 5 nodes on 2 ranks and a 20% imbalance a rank holds 3 nodes at most
+  NodeContainer switches;
+  switches.Create (4);
+  Ptr<Node> controller = CreateObject<Node> ();
+  NodeContainer nodes (switches, NodeContainer (controller));
+
+  SdnPartitionHelper partition;
+  partition.SetImbalance (0.2);
+  partition.AddLink (switches.Get (0), switches.Get (1), MilliSeconds (1));
+  partition.AddLink (switches.Get (1), switches.Get (2), MilliSeconds (10));
+  partition.AddLink (switches.Get (2), switches.Get (3), MilliSeconds (1));
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      partition.AddControlLink (switches.Get (i), controller, MilliSeconds (20));
+    }
+  partition.Partition (nodes, 2);
+
+  NS_TEST_ASSERT_MSG_EQ (switches.Get (0)->GetSystemId (), switches.Get (1)->GetSystemId (), "Pairs stay together");
+  NS_TEST_ASSERT_MSG_EQ (switches.Get (2)->GetSystemId (), switches.Get (3)->GetSystemId (), "Pairs stay together");
+  NS_TEST_ASSERT_MSG_NE (switches.Get (1)->GetSystemId (), switches.Get (2)->GetSystemId (), "The pairs must be split");
+  NS_TEST_ASSERT_MSG_EQ (controller->GetSystemId (), switches.Get (0)->GetSystemId (),
+                         "The first switch must join its controller");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetWeight (controller->GetSystemId ()), 3,
+                         "The second pair cannot join the controller too");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (10), "The 10ms link is the shortest cut");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Checks the weights of the ranks stay within the imbalance, and that a
+ * node too heavy for any rank still gets the least bad packing
+ */
+class SdnPartitionImbalanceTestCase : public TestCase
+{
+public:
+  SdnPartitionImbalanceTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnPartitionImbalanceTestCase::SdnPartitionImbalanceTestCase ()
+  : TestCase ("Check the imbalance limit and the packing when no threshold fits it")
+{
+}
+
+void
+SdnPartitionImbalanceTestCase::DoRun (void)
+{
+  // A chain of 1ms links with a heavy middle: the limit, not the delays,
+  // decides where it is cut
+  NodeContainer chain;
+  chain.Create (6);
+  SdnPartitionHelper balanced;
+  for (uint32_t i = 0; i + 1 < 6; ++i)
+    {
+      balanced.AddLink (chain.Get (i), chain.Get (i + 1), MilliSeconds (1));
+    }
+  balanced.SetWeight (chain.Get (2), 3);
+  balanced.SetWeight (chain.Get (3), 3);
+  balanced.Partition (chain, 2);
+
+  // total 10, a rank may weigh 5.5
+  NS_TEST_ASSERT_MSG_EQ ((balanced.GetWeight (0) <= 5.5), true, "Rank 0 is over the limit");
+  NS_TEST_ASSERT_MSG_EQ ((balanced.GetWeight (1) <= 5.5), true, "Rank 1 is over the limit");
+  NS_TEST_ASSERT_MSG_EQ (balanced.GetWeight (0) + balanced.GetWeight (1), 10, "Every node must be placed");
+  NS_TEST_ASSERT_MSG_NE (chain.Get (2)->GetSystemId (), chain.Get (3)->GetSystemId (),
+                         "The heavy nodes cannot share a rank");
+  NS_TEST_ASSERT_MSG_EQ (balanced.GetLookAhead (), MilliSeconds (1), "Only 1ms links can be cut");
+
+  // A node heavier than a rank may be: no threshold packs, even with
+  // nothing contracted, and the last packing is kept
+  NodeContainer star;
+  star.Create (4);
+  SdnPartitionHelper overloaded;
+  for (uint32_t i = 1; i < 4; ++i)
+    {
+      overloaded.AddLink (star.Get (0), star.Get (i), MilliSeconds (i));
+    }
+  overloaded.SetWeight (star.Get (0), 10);
+  overloaded.Partition (star, 2);
+
+  uint32_t heavy = star.Get (0)->GetSystemId ();
+  NS_TEST_ASSERT_MSG_EQ (overloaded.GetWeight (heavy), 10, "The heavy node must be alone");
+  NS_TEST_ASSERT_MSG_EQ (overloaded.GetWeight (1 - heavy), 3, "The light nodes must share the other rank");
+  NS_TEST_ASSERT_MSG_EQ (overloaded.GetNNodes (1 - heavy), 3, "The light nodes must share the other rank");
+  NS_TEST_ASSERT_MSG_EQ (overloaded.GetLookAhead (), MilliSeconds (1), "Every link is cut");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Runs the test cases of SdnPartitionHelper
+ */
+class SdnPartitionHelperTestSuite : public TestSuite
+{
+public:
+  SdnPartitionHelperTestSuite ();
+};
+
+SdnPartitionHelperTestSuite::SdnPartitionHelperTestSuite ()
+  : TestSuite ("sdn-partition-helper", UNIT)
+{
+  AddTestCase (new SdnPartitionThresholdTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPartitionControllerTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPartitionImbalanceTestCase, TestCase::QUICK);
+}
+
+static SdnPartitionHelperTestSuite g_sdnPartitionHelperTestSuite;
@@ -0,0 +1,400 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/node-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/layer2-p2p-helper.h"
+#include "ns3/layer2-p2p-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/SdnSwitch13.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * A switch whose pipeline only records the packets handed to it, so the
+ * packets coming back out of the buffer pool can be checked
+ */
+class RecordingSwitch13 : public SdnSwitch13
+{
+public:
+  uint32_t Buffer (Ptr<Packet> packet, uint32_t inPort)
+  {
+    return m_packetBuffers.Store (packet, inPort);
+  }
+  uint32_t GetBuffered (void) const
+  {
+    return m_packetBuffers.GetSize ();
+  }
+  void SetRunning (void)
+  {
+    m_controllerConn->set_state (fluid_base::OFConnection::STATE_RUNNING);
+  }
+  Ptr<SdnPort> Port (uint32_t portNo) const
+  {
+    return GetPort (portNo);
+  }
+  Ptr<SdnPort> PortOf (Ptr<NetDevice> device) const
+  {
+    return GetPortByDevice (device);
+  }
+  void Detach (uint32_t portNo)
+  {
+    RemovePort (portNo);
+  }
+  bool Read (Ptr<NetDevice> device, Ptr<const Packet> packet)
+  {
+    return HandleReadFromNetDevice (device, packet, 0, Address ());
+  }
+  virtual bool HandlePacket (Ptr<Packet> packet, uint32_t inPort)
+  {
+    inPorts.push_back (inPort);
+    times.push_back (Simulator::Now ());
+    sizes.push_back (packet->GetSize ());
+    return true;
+  }
+
+  std::vector<uint32_t> inPorts;
+  std::vector<Time> times;
+  std::vector<uint32_t> sizes;
+};
+
+/**
+ * \brief Sends a frame of an unused protocol, which no stack takes, to the switch
+ */
+void
+SendFrame (Ptr<NetDevice> device, Ptr<NetDevice> to, uint32_t size)
+{
+  device->Send (Create<Packet> (size), to->GetAddress (), 0x88b5);
+}
+
+/**
+ * \brief Appends an OpenFlow 1.3 flow mod adding a flow with an empty match
+ */
+void
+AppendFlowMod (std::vector<uint8_t> &data, uint16_t priority, uint32_t bufferId)
+{
+  uint8_t flowMod[56] = { 0 };
+  flowMod[0] = 4;
+  flowMod[1] = fluid_msg::of13::OFPT_FLOW_MOD;
+  flowMod[3] = sizeof (flowMod);
+  flowMod[25] = fluid_msg::of13::OFPFC_ADD;
+  flowMod[30] = priority >> 8;
+  flowMod[31] = priority & 0xff;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      flowMod[32 + i] = bufferId >> (24 - 8 * i);
+      flowMod[36 + i] = 0xff; // out_port, OFPP_ANY
+      flowMod[40 + i] = 0xff; // out_group, OFPG_ANY
+    }
+  // an OXM match without fields
+  flowMod[49] = 1;
+  flowMod[51] = 4;
+  data.insert (data.end (), flowMod, flowMod + sizeof (flowMod));
+}
+
+} // anonymous namespace
+
+/**
+ * Checks when the flow mods read from the controller are installed under each
+ * FlowModBatching mode, and that a buffered packet released by a flow mod whose
+ * match does not name in_port goes back through the pipeline on its own port
+ */
+class SdnSwitch13FlowModBatchTestCase : public TestCase
+{
+public:
+  SdnSwitch13FlowModBatchTestCase (SdnSwitch13::FlowModBatching mode, std::string name);
+  virtual void DoRun (void);
+
+private:
+  void Accept (Ptr<Socket> socket, const Address &from);
+  void Drain (Ptr<Socket> socket);
+  /**
+   * \brief Sends flow mods, the one releasing the buffered packet second, in a single segment
+   */
+  void SendFlowMods (uint16_t priority, bool buffered);
+  void SendBarrier (void);
+  void FlowModBatch (uint32_t size, Time latency);
+
+  SdnSwitch13::FlowModBatching m_mode;
+  Ptr<RecordingSwitch13> m_switch;
+  Ptr<Socket> m_controller;   //!< Stands for the controller end of the switch connection
+  uint32_t m_bufferId;
+  std::vector<uint32_t> m_sizes;
+  std::vector<Time> m_latencies;
+  std::vector<Time> m_times;
+};
+
+SdnSwitch13FlowModBatchTestCase::SdnSwitch13FlowModBatchTestCase (SdnSwitch13::FlowModBatching mode, std::string name)
+  : TestCase ("Check flow mods are installed in batches with FlowModBatching=" + name),
+    m_mode (mode),
+    m_bufferId (0)
+{
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  m_controller = socket;
+  m_controller->SetRecvCallback (MakeCallback (&SdnSwitch13FlowModBatchTestCase::Drain, this));
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::Drain (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+    }
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::SendFlowMods (uint16_t priority, bool buffered)
+{
+  std::vector<uint8_t> data;
+  AppendFlowMod (data, priority, SDN_NO_BUFFER);
+  if (buffered)
+    {
+      AppendFlowMod (data, priority + 1, m_bufferId);
+    }
+  m_controller->Send (Create<Packet> (&data[0], data.size ()));
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::SendBarrier (void)
+{
+  uint8_t barrier[8] = { 4, fluid_msg::of13::OFPT_BARRIER_REQUEST, 0, 8, 0, 0, 0, 1 };
+  m_controller->Send (Create<Packet> (barrier, sizeof (barrier)));
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::FlowModBatch (uint32_t size, Time latency)
+{
+  m_sizes.push_back (size);
+  m_latencies.push_back (latency);
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+SdnSwitch13FlowModBatchTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer devices = link.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  addresses.Assign (devices);
+
+  Ptr<Socket> listener = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), OFCONTROLLERPORT));
+  listener->Listen ();
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&SdnSwitch13FlowModBatchTestCase::Accept, this));
+
+  m_switch = CreateObject<RecordingSwitch13> ();
+  m_switch->SetAttribute ("FlowModBatching", EnumValue (m_mode));
+  m_switch->TraceConnectWithoutContext ("FlowModBatch", MakeCallback (&SdnSwitch13FlowModBatchTestCase::FlowModBatch, this));
+  nodes.Get (0)->AddApplication (m_switch);
+  m_switch->SetStartTime (Seconds (0));
+
+  m_bufferId = m_switch->Buffer (Create<Packet> (64), 5);
+
+  // two flow mods read at once, the second releasing the buffered packet,
+  // then a third in a later read and finally a barrier
+  Simulator::Schedule (Seconds (1), &SdnSwitch13FlowModBatchTestCase::SendFlowMods, this, 1, true);
+  Simulator::Schedule (Seconds (1.2), &SdnSwitch13FlowModBatchTestCase::SendFlowMods, this, 3, false);
+  Simulator::Schedule (Seconds (1.5), &SdnSwitch13FlowModBatchTestCase::SendBarrier, this);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  std::vector<uint32_t> sizes;
+  std::vector<Time> latencies;
+  switch (m_mode)
+    {
+    case SdnSwitch13::FLOW_MOD_IMMEDIATE:
+      sizes.resize (3, 1);
+      latencies.resize (3, Seconds (0));
+      break;
+    case SdnSwitch13::FLOW_MOD_BATCH_READ:
+      sizes.push_back (2);
+      sizes.push_back (1);
+      latencies.resize (2, Seconds (0));
+      break;
+    case SdnSwitch13::FLOW_MOD_BATCH_BARRIER:
+      sizes.push_back (3);
+      latencies.push_back (MilliSeconds (500));
+      break;
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_sizes.size (), sizes.size (), "Bad number of batches");
+  for (uint32_t i = 0; i < sizes.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_sizes[i], sizes[i], "Bad size of batch " << i);
+      // the reads differ in size, so the flow mods and the barrier take slightly different times to arrive
+      NS_TEST_ASSERT_MSG_EQ_TOL (m_latencies[i], latencies[i], MicroSeconds (10), "Bad latency of batch " << i);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_switch->inPorts.size (), 1, "The buffered packet must be handled once");
+  NS_TEST_ASSERT_MSG_EQ (m_switch->inPorts[0], 5, "The buffered packet must come back on the port it was buffered from");
+  NS_TEST_ASSERT_MSG_EQ (m_switch->times[0], m_times[0], "The buffered packet must wait for its batch");
+  NS_TEST_ASSERT_MSG_EQ (m_switch->GetBuffered (), 0, "The buffer must be released");
+
+  Simulator::Destroy ();
+  m_switch = 0;
+  m_controller = 0;
+}
+
+/**
+ * Checks the ports attached by the switch are found by number and by
+ * device, that frames reach the pipeline on the port of the link they came
+ * in from, and that a removed port is gone from both and takes no frames
+ */
+class SdnSwitch13PortTestCase : public TestCase
+{
+public:
+  SdnSwitch13PortTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnSwitch13PortTestCase::SdnSwitch13PortTestCase ()
+  : TestCase ("Check the switch ports are indexed by number and by device")
+{
+}
+
+void
+SdnSwitch13PortTestCase::DoRun (void)
+{
+  static const uint32_t HOSTS = 3;
+  Ptr<Node> switchNode = CreateObject<Node> ();
+  NodeContainer hosts;
+  hosts.Create (HOSTS);
+  Layer2P2PHelper layer2;
+  layer2.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  layer2.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer hostDevices;
+  NetDeviceContainer switchDevices;
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      NetDeviceContainer link = layer2.Install (hosts.Get (i), switchNode);
+      hostDevices.Add (link.Get (0));
+      switchDevices.Add (link.Get (1));
+    }
+  InternetStackHelper internet;
+  internet.Install (switchNode);
+  internet.Install (hosts);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  addresses.Assign (NetDeviceContainer (hostDevices, switchDevices));
+
+  Ptr<RecordingSwitch13> sdnSwitch = CreateObject<RecordingSwitch13> ();
+  switchNode->AddApplication (sdnSwitch);
+  sdnSwitch->SetStartTime (Seconds (0));
+  sdnSwitch->SetRunning ();
+
+  // A frame from each host, then again once the port of the second host is removed;
+  // the hundreds of the size tell the host, the layer 2 framing only adds some bytes
+  std::vector<uint32_t> ports (HOSTS);
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      Simulator::Schedule (Seconds (1), &SendFrame, hostDevices.Get (i), switchDevices.Get (i), 100 * (i + 1));
+      Simulator::Schedule (Seconds (3), &SendFrame, hostDevices.Get (i), switchDevices.Get (i), 100 * (i + 1));
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      Ptr<SdnPort> port = sdnSwitch->PortOf (switchDevices.Get (i));
+      NS_TEST_ASSERT_MSG_NE (port, 0, "Every link of the switch must be a port");
+      NS_TEST_ASSERT_MSG_EQ (port->getDevice (), switchDevices.Get (i), "Bad device of a port");
+      ports[i] = port->getPortNumber ();
+      NS_TEST_ASSERT_MSG_EQ (sdnSwitch->Port (ports[i]), port, "A port must be found by its number");
+      for (uint32_t j = 0; j < i; ++j)
+        {
+          NS_TEST_ASSERT_MSG_NE (ports[i], ports[j], "Ports must have their own numbers");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->PortOf (hostDevices.Get (0)), 0, "A device of another node is no port");
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->Port (1000), 0, "An unknown number is no port");
+
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts.size (), HOSTS, "Every frame must reach the pipeline");
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      uint32_t host = sdnSwitch->sizes[i] / 100 - 1;
+      NS_TEST_ASSERT_MSG_LT (host, HOSTS, "Bad frame in the pipeline");
+      NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts[i], ports[host], "A frame must come in on the port of its link");
+    }
+  // Through the device, as a callback not bound to a port would
+  sdnSwitch->Read (switchDevices.Get (2), Create<Packet> (50));
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts.back (), ports[2], "A device must be resolved to its port");
+  sdnSwitch->Read (hostDevices.Get (2), Create<Packet> (50));
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts.back (), 0, "A device of no port must come in on no port");
+
+  sdnSwitch->inPorts.clear ();
+  sdnSwitch->sizes.clear ();
+  sdnSwitch->Detach (ports[1]);
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->Port (ports[1]), 0, "A removed port must not be found by number");
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->PortOf (switchDevices.Get (1)), 0, "A removed port must not be found by device");
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->Port (ports[2])->getDevice (), switchDevices.Get (2), "The other ports must stay");
+  Ptr<Layer2P2PNetDevice> removed = DynamicCast<Layer2P2PNetDevice> (switchDevices.Get (1));
+  NS_TEST_ASSERT_MSG_EQ (removed->IsSdnEnabled (), false, "A removed port must give its device back to the stack");
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts.size (), HOSTS - 1, "A removed port must not take frames");
+  for (uint32_t i = 0; i < sdnSwitch->inPorts.size (); ++i)
+    {
+      uint32_t host = sdnSwitch->sizes[i] / 100 - 1;
+      NS_TEST_ASSERT_MSG_NE (host, 1, "The frame of the removed port reached the pipeline");
+      NS_TEST_ASSERT_MSG_EQ (sdnSwitch->inPorts[i], ports[host], "A frame must come in on the port of its link");
+    }
+
+  Simulator::Destroy ();
+}
+
+class SdnSwitch13TestSuite : public TestSuite
+{
+public:
+  SdnSwitch13TestSuite ();
+};
+
+SdnSwitch13TestSuite::SdnSwitch13TestSuite ()
+  : TestSuite ("sdn-switch13", UNIT)
+{
+  AddTestCase (new SdnSwitch13FlowModBatchTestCase (SdnSwitch13::FLOW_MOD_IMMEDIATE, "Immediate"), TestCase::QUICK);
+  AddTestCase (new SdnSwitch13FlowModBatchTestCase (SdnSwitch13::FLOW_MOD_BATCH_READ, "Read"), TestCase::QUICK);
+  AddTestCase (new SdnSwitch13FlowModBatchTestCase (SdnSwitch13::FLOW_MOD_BATCH_BARRIER, "Barrier"), TestCase::QUICK);
+  AddTestCase (new SdnSwitch13PortTestCase, TestCase::QUICK);
+}
+
+static SdnSwitch13TestSuite g_sdnSwitch13TestSuite;
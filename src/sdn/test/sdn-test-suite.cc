@@ -1,54 +1,494 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
 
-// Include a header file from your module to test.
 
-// An essential include is test.h
+#include <string.h>
 #include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/arp-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/icmpv4.h"
+#include "ns3/mac48-address.h"
+#include "ns3/SdnPacketParser.h"
 
-// Do not put your test classes in namespace ns3.  You may find it useful
-// to use the using directive to access the ns3 namespace directly
 using namespace ns3;
+using namespace fluid_msg;
 
-// This is an example TestCase.
-class SdnTestCase1 : public TestCase
+namespace {
+
+const uint32_t IN_PORT = 3;
+
+/**
+ * \return The value of a field of a key, at most 8 bytes long
+ */
+uint64_t
+GetField (const SdnFlowKey &key, uint8_t field)
 {
-public:
-  SdnTestCase1 ();
-  virtual ~SdnTestCase1 ();
+  uint64_t value = 0;
+  const uint8_t *data = key.Bytes () + SdnFlowKey::FieldOffset (field);
+  for (uint8_t i = 0; i < SdnFlowKey::FieldLength (field); ++i)
+    {
+      value = (value << 8) | data[i];
+    }
+  return value;
+}
+
+uint64_t
+GetMac (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < 6; ++i)
+    {
+      value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+/**
+ * \return The key holding the Ethernet fields of a frame built by AddEthernet
+ */
+SdnFlowKey
+EthernetKey (uint16_t type)
+{
+  SdnFlowKey key;
+  uint8_t buffer[6];
+  Mac48Address ("00:00:00:00:00:02").CopyTo (buffer);
+  key.SetField (of13::OFPXMT_OFB_ETH_DST, buffer);
+  Mac48Address ("00:00:00:00:00:01").CopyTo (buffer);
+  key.SetField (of13::OFPXMT_OFB_ETH_SRC, buffer);
+  key.SetField16 (of13::OFPXMT_OFB_ETH_TYPE, type);
+  return key;
+}
+
+/**
+ * \return The OpenFlow 1.3 key of the IPv4 headers built by AddIpv4
+ */
+SdnFlowKey
+Ipv4Key (uint8_t protocol)
+{
+  SdnFlowKey key = EthernetKey (0x0800);
+  key.SetField32 (of13::OFPXMT_OFB_IN_PORT, IN_PORT);
+  key.SetField32 (of13::OFPXMT_OFB_IN_PHY_PORT, IN_PORT);
+  key.SetField16 (of13::OFPXMT_OFB_VLAN_VID, 0);
+  key.SetField8 (of13::OFPXMT_OFB_IP_DSCP, 46);
+  key.SetField8 (of13::OFPXMT_OFB_IP_ECN, 1);
+  key.SetField8 (of13::OFPXMT_OFB_IP_PROTO, protocol);
+  key.SetField32 (of13::OFPXMT_OFB_IPV4_SRC, Ipv4Address ("10.1.1.1").Get ());
+  key.SetField32 (of13::OFPXMT_OFB_IPV4_DST, Ipv4Address ("10.1.2.3").Get ());
+  return key;
+}
+
+/**
+ * \return The OpenFlow 1.0 key of the IPv4 headers built by AddIpv4
+ */
+SdnFlowKey
+Ipv4KeyOf10 (uint8_t protocol)
+{
+  SdnFlowKey key = EthernetKey (0x0800);
+  key.SetField32 (of13::OFPXMT_OFB_IN_PORT, IN_PORT);
+  // nw_tos is the whole ToS byte with the ECN bits cleared
+  key.SetField8 (of13::OFPXMT_OFB_IP_DSCP, 0xb8);
+  key.SetField8 (of13::OFPXMT_OFB_IP_PROTO, protocol);
+  key.SetField32 (of13::OFPXMT_OFB_IPV4_SRC, Ipv4Address ("10.1.1.1").Get ());
+  key.SetField32 (of13::OFPXMT_OFB_IPV4_DST, Ipv4Address ("10.1.2.3").Get ());
+  return key;
+}
+
+Ptr<Packet>
+AddEthernet (Ptr<Packet> packet, uint16_t type)
+{
+  EthernetHeader ethernet;
+  ethernet.SetSource (Mac48Address ("00:00:00:00:00:01"));
+  ethernet.SetDestination (Mac48Address ("00:00:00:00:00:02"));
+  ethernet.SetLengthType (type);
+  packet->AddHeader (ethernet);
+  return packet;
+}
+
+Ptr<Packet>
+AddIpv4 (Ptr<Packet> packet, uint8_t protocol)
+{
+  Ipv4Header ipv4;
+  ipv4.SetSource (Ipv4Address ("10.1.1.1"));
+  ipv4.SetDestination (Ipv4Address ("10.1.2.3"));
+  ipv4.SetProtocol (protocol);
+  // DSCP EF (46) and ECN ECT(1)
+  ipv4.SetTos (0xb9);
+  ipv4.SetPayloadSize (packet->GetSize ());
+  packet->AddHeader (ipv4);
+  return packet;
+}
 
+Ptr<Packet>
+MakeTcpFrame (void)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  TcpHeader tcp;
+  tcp.SetSourcePort (1234);
+  tcp.SetDestinationPort (80);
+  packet->AddHeader (tcp);
+  return AddEthernet (AddIpv4 (packet, 6), 0x0800);
+}
+
+Ptr<Packet>
+MakeUdpFrame (void)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (5000);
+  udp.SetDestinationPort (53);
+  packet->AddHeader (udp);
+  return AddEthernet (AddIpv4 (packet, 17), 0x0800);
+}
+
+Ptr<Packet>
+MakeIcmpFrame (void)
+{
+  Ptr<Packet> packet = Create<Packet> (28);
+  Icmpv4Header icmp;
+  // destination host unreachable, so type and code differ
+  icmp.SetType (3);
+  icmp.SetCode (1);
+  packet->AddHeader (icmp);
+  return AddEthernet (AddIpv4 (packet, 1), 0x0800);
+}
+
+Ptr<Packet>
+MakeArpFrame (void)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  ArpHeader arp;
+  arp.SetRequest (Mac48Address ("00:00:00:00:00:01"), Ipv4Address ("10.1.1.1"),
+                  Mac48Address ("ff:ff:ff:ff:ff:ff"), Ipv4Address ("10.1.1.2"));
+  packet->AddHeader (arp);
+  return AddEthernet (packet, 0x0806);
+}
+
+/**
+ * A TCP frame with the IPv4 and TCP checksums computed
+ */
+Ptr<Packet>
+MakeChecksummedTcpFrame (void)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  TcpHeader tcp;
+  tcp.SetSourcePort (1234);
+  tcp.SetDestinationPort (80);
+  tcp.EnableChecksums ();
+  tcp.InitializeChecksum (Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.2.3"), 6);
+  packet->AddHeader (tcp);
+  Ipv4Header ipv4;
+  ipv4.SetSource (Ipv4Address ("10.1.1.1"));
+  ipv4.SetDestination (Ipv4Address ("10.1.2.3"));
+  ipv4.SetProtocol (6);
+  ipv4.SetTos (0xb9);
+  ipv4.SetPayloadSize (packet->GetSize ());
+  ipv4.EnableChecksum ();
+  packet->AddHeader (ipv4);
+  return AddEthernet (packet, 0x0800);
+}
+
+/**
+ * An 802.1Q tagged IPv4 frame: VLAN 100, priority 5
+ */
+Ptr<Packet>
+MakeVlanFrame (void)
+{
+  Ptr<Packet> inner = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (5000);
+  udp.SetDestinationPort (53);
+  inner->AddHeader (udp);
+  AddIpv4 (inner, 17);
+  uint8_t tag[4] = { 0xa0, 0x64, 0x08, 0x00 };
+  Ptr<Packet> packet = Create<Packet> (tag, 4);
+  packet->AddAtEnd (inner);
+  return AddEthernet (packet, 0x8100);
+}
+
+} // anonymous namespace
+
+/**
+ * Checks the fields the parser extracts from Ethernet, VLAN, IPv4, ARP, ICMP,
+ * TCP and UDP frames
+ */
+class SdnPacketParserTestCase : public TestCase
+{
+public:
+  SdnPacketParserTestCase ();
+  virtual void DoRun (void);
 private:
+  void CheckEthernet (const SdnFlowKey &key, uint16_t type);
+  void CheckIpv4 (const SdnFlowKey &key, uint8_t protocol);
+};
+
+SdnPacketParserTestCase::SdnPacketParserTestCase ()
+  : TestCase ("Check the fields extracted from frames")
+{
+}
+
+void
+SdnPacketParserTestCase::CheckEthernet (const SdnFlowKey &key, uint16_t type)
+{
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IN_PORT), IN_PORT, "Bad in_port");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IN_PHY_PORT), IN_PORT, "Bad in_phy_port");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ETH_SRC), GetMac (Mac48Address ("00:00:00:00:00:01")), "Bad eth_src");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ETH_DST), GetMac (Mac48Address ("00:00:00:00:00:02")), "Bad eth_dst");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_ETH_TYPE), true, "Missing eth_type");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ETH_TYPE), type, "Bad eth_type");
+}
+
+void
+SdnPacketParserTestCase::CheckIpv4 (const SdnFlowKey &key, uint8_t protocol)
+{
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IP_PROTO), protocol, "Bad ip_proto");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IP_DSCP), 46, "Bad ip_dscp");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IP_ECN), 1, "Bad ip_ecn");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IPV4_SRC), Ipv4Address ("10.1.1.1").Get (), "Bad ipv4_src");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IPV4_DST), Ipv4Address ("10.1.2.3").Get (), "Bad ipv4_dst");
+}
+
+void
+SdnPacketParserTestCase::DoRun (void)
+{
+  SdnFlowKey key;
+  SdnPacketParser::Extract (MakeTcpFrame (), IN_PORT, key);
+  CheckEthernet (key, 0x0800);
+  CheckIpv4 (key, 6);
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_TCP_SRC), 1234, "Bad tcp_src");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_TCP_DST), 80, "Bad tcp_dst");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_UDP_DST), false, "A TCP segment has no UDP port");
+
+  SdnPacketParser::Extract (MakeUdpFrame (), IN_PORT, key);
+  CheckEthernet (key, 0x0800);
+  CheckIpv4 (key, 17);
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_UDP_SRC), 5000, "Bad udp_src");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_UDP_DST), 53, "Bad udp_dst");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_TCP_DST), false, "A UDP datagram has no TCP port");
+
+  SdnPacketParser::Extract (MakeIcmpFrame (), IN_PORT, key);
+  CheckEthernet (key, 0x0800);
+  CheckIpv4 (key, 1);
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ICMPV4_TYPE), 3, "Bad icmpv4_type");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ICMPV4_CODE), 1, "Bad icmpv4_code");
+
+  SdnPacketParser::Extract (MakeArpFrame (), IN_PORT, key);
+  CheckEthernet (key, 0x0806);
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ARP_OP), 1, "Bad arp_op");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ARP_SPA), Ipv4Address ("10.1.1.1").Get (), "Bad arp_spa");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ARP_TPA), Ipv4Address ("10.1.1.2").Get (), "Bad arp_tpa");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ARP_SHA), GetMac (Mac48Address ("00:00:00:00:00:01")), "Bad arp_sha");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_ARP_THA), GetMac (Mac48Address ("ff:ff:ff:ff:ff:ff")), "Bad arp_tha");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_IPV4_SRC), false, "An ARP packet has no IPv4 header");
+
+  // Like the header based parsing it replaces, the parser does not look inside
+  // 802.1Q tags: the frame keeps the tag type and reports no VLAN
+  SdnPacketParser::Extract (MakeVlanFrame (), IN_PORT, key);
+  CheckEthernet (key, 0x8100);
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_VLAN_VID), true, "Missing vlan_vid");
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_VLAN_VID), 0, "Bad vlan_vid");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_IPV4_SRC), false, "A tagged frame must not be parsed further");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_UDP_DST), false, "A tagged frame must not be parsed further");
+
+  // a runt frame only has its port
+  SdnPacketParser::Extract (Create<Packet> (10), IN_PORT, key);
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IN_PORT), IN_PORT, "Bad in_port");
+  NS_TEST_ASSERT_MSG_EQ (key.HasField (of13::OFPXMT_OFB_ETH_TYPE), false, "A runt frame has no Ethernet header");
+}
+
+/**
+ * Checks the keys extracted from frames against keys built field by field,
+ * and that a key survives the trip through the PacketIn match
+ */
+class SdnPacketParserKeyTestCase : public TestCase
+{
+public:
+  SdnPacketParserKeyTestCase ();
   virtual void DoRun (void);
+private:
+  void Compare (std::string name, const SdnFlowKey &key, const SdnFlowKey &expected);
 };
 
-// Add some help text to this case to describe what it is intended to test
-SdnTestCase1::SdnTestCase1 ()
-  : TestCase ("Sdn test case (does nothing)")
+SdnPacketParserKeyTestCase::SdnPacketParserKeyTestCase ()
+  : TestCase ("Check the extracted keys against hand-built keys")
 {
 }
 
-// This destructor does nothing but we include it as a reminder that
-// the test case should clean up after itself
-SdnTestCase1::~SdnTestCase1 ()
+void
+SdnPacketParserKeyTestCase::Compare (std::string name, const SdnFlowKey &key, const SdnFlowKey &expected)
 {
+  for (uint8_t field = 0; field < SDN_FLOWKEY_FIELDS; ++field)
+    {
+      NS_TEST_ASSERT_MSG_EQ (key.HasField (field), expected.HasField (field), name << ": presence of field " << (uint32_t)field);
+      if (SdnFlowKey::FieldLength (field) <= 8)
+        {
+          NS_TEST_ASSERT_MSG_EQ (GetField (key, field), GetField (expected, field), name << ": bad field " << (uint32_t)field);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (key.Equals (expected), true, name << ": keys differ");
 }
 
-//
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
-//
 void
-SdnTestCase1::DoRun (void)
+SdnPacketParserKeyTestCase::DoRun (void)
 {
-  // A wide variety of test macros are available in src/core/test.h
-  NS_TEST_ASSERT_MSG_EQ (true, true, "true doesn't equal true for some reason");
-  // Use this one for floating point comparisons
-  NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
+  SdnFlowKey key;
+  SdnFlowKey expected = Ipv4Key (6);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_SRC, 1234);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_DST, 80);
+  SdnPacketParser::Extract (MakeTcpFrame (), IN_PORT, key);
+  Compare ("TCP", key, expected);
+
+  of13::Match packetIn;
+  key.ToMatch (packetIn);
+  SdnFlowKey back;
+  SdnFlowKey::Compile (packetIn, back);
+  NS_TEST_ASSERT_MSG_EQ (back.Equals (key), true, "The key changed through its PacketIn match");
+
+  expected = Ipv4Key (17);
+  expected.SetField16 (of13::OFPXMT_OFB_UDP_SRC, 5000);
+  expected.SetField16 (of13::OFPXMT_OFB_UDP_DST, 53);
+  SdnPacketParser::Extract (MakeUdpFrame (), IN_PORT, key);
+  Compare ("UDP", key, expected);
+
+  expected = Ipv4Key (1);
+  expected.SetField8 (of13::OFPXMT_OFB_ICMPV4_TYPE, 3);
+  expected.SetField8 (of13::OFPXMT_OFB_ICMPV4_CODE, 1);
+  SdnPacketParser::Extract (MakeIcmpFrame (), IN_PORT, key);
+  Compare ("ICMP", key, expected);
+
+  expected = EthernetKey (0x0806);
+  expected.SetField32 (of13::OFPXMT_OFB_IN_PORT, IN_PORT);
+  expected.SetField32 (of13::OFPXMT_OFB_IN_PHY_PORT, IN_PORT);
+  expected.SetField16 (of13::OFPXMT_OFB_VLAN_VID, 0);
+  expected.SetField16 (of13::OFPXMT_OFB_ARP_OP, 1);
+  expected.SetField32 (of13::OFPXMT_OFB_ARP_SPA, Ipv4Address ("10.1.1.1").Get ());
+  expected.SetField32 (of13::OFPXMT_OFB_ARP_TPA, Ipv4Address ("10.1.1.2").Get ());
+  uint8_t buffer[6];
+  Mac48Address ("00:00:00:00:00:01").CopyTo (buffer);
+  expected.SetField (of13::OFPXMT_OFB_ARP_SHA, buffer);
+  Mac48Address ("ff:ff:ff:ff:ff:ff").CopyTo (buffer);
+  expected.SetField (of13::OFPXMT_OFB_ARP_THA, buffer);
+  SdnPacketParser::Extract (MakeArpFrame (), IN_PORT, key);
+  Compare ("ARP", key, expected);
+
+  // OpenFlow 1.0 keys have no prerequisites so no field is marked present
+  expected = Ipv4KeyOf10 (6);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_SRC, 1234);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_DST, 80);
+  expected.fields = 0;
+  SdnPacketParser::ExtractOf10 (MakeTcpFrame (), IN_PORT, key);
+  Compare ("OF1.0 TCP", key, expected);
+
+  // ICMP type and code go in tp_src and tp_dst
+  expected = Ipv4KeyOf10 (1);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_SRC, 3);
+  expected.SetField16 (of13::OFPXMT_OFB_TCP_DST, 1);
+  expected.fields = 0;
+  SdnPacketParser::ExtractOf10 (MakeIcmpFrame (), IN_PORT, key);
+  Compare ("OF1.0 ICMP", key, expected);
+
+  // the low byte of the ARP opcode goes in nw_proto, the addresses in nw_src and nw_dst
+  expected = EthernetKey (0x0806);
+  expected.SetField32 (of13::OFPXMT_OFB_IN_PORT, IN_PORT);
+  expected.SetField8 (of13::OFPXMT_OFB_IP_PROTO, 1);
+  expected.SetField32 (of13::OFPXMT_OFB_IPV4_SRC, Ipv4Address ("10.1.1.1").Get ());
+  expected.SetField32 (of13::OFPXMT_OFB_IPV4_DST, Ipv4Address ("10.1.1.2").Get ());
+  expected.fields = 0;
+  SdnPacketParser::ExtractOf10 (MakeArpFrame (), IN_PORT, key);
+  Compare ("OF1.0 ARP", key, expected);
+}
+
+/**
+ * Checks set field edits of an OpenFlow 1.0 key are written into the frame with
+ * valid checksums, and that the frame then matches a flow on the new fields
+ */
+class SdnPacketRewriteTestCase : public TestCase
+{
+public:
+  SdnPacketRewriteTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnPacketRewriteTestCase::SdnPacketRewriteTestCase ()
+  : TestCase ("Check set field edits of a key are written into the frame")
+{
+}
+
+void
+SdnPacketRewriteTestCase::DoRun (void)
+{
+  Ptr<Packet> frame = MakeChecksummedTcpFrame ();
+  uint64_t uid = frame->GetUid ();
+  uint32_t size = frame->GetSize ();
+  SdnFlowKey extracted;
+  SdnPacketParser::ExtractOf10 (frame, IN_PORT, extracted);
+  NS_TEST_ASSERT_MSG_EQ (SdnPacketParser::RewriteOf10 (frame, extracted, extracted), false,
+                         "An unchanged key must leave the frame alone");
+
+  // what the set_nw_src, set_nw_tos and set_tp_dst handlers of SdnFlowTable do
+  SdnFlowKey key = extracted;
+  key.SetIPv4 (of13::OFPXMT_OFB_IPV4_SRC, IPAddress ("10.1.1.9"));
+  key.SetField8 (of13::OFPXMT_OFB_IP_DSCP, 0x28);
+  key.SetField16 (of13::OFPXMT_OFB_TCP_DST, 8080);
+  key.fields = 0;
+  NS_TEST_ASSERT_MSG_EQ (GetField (key, of13::OFPXMT_OFB_IPV4_SRC), Ipv4Address ("10.1.1.9").Get (),
+                         "The key must hold the address in network byte order");
+  NS_TEST_ASSERT_MSG_EQ (SdnPacketParser::RewriteOf10 (frame, extracted, key), true, "The frame must be rewritten");
+  NS_TEST_ASSERT_MSG_EQ (frame->GetUid (), uid, "The rewrite must keep the packet");
+  NS_TEST_ASSERT_MSG_EQ (frame->GetSize (), size, "The rewrite must not change the frame size");
+
+  SdnFlowKey rewritten;
+  SdnPacketParser::ExtractOf10 (frame, IN_PORT, rewritten);
+  NS_TEST_ASSERT_MSG_EQ (rewritten.Equals (key), true, "The frame must carry the edited fields");
+
+  // a flow on the new source only matches the rewritten frame
+  SdnFlowMatch match;
+  match.value.SetField32 (of13::OFPXMT_OFB_IPV4_SRC, Ipv4Address ("10.1.1.9").Get ());
+  match.mask.SetField32 (of13::OFPXMT_OFB_IPV4_SRC, 0xffffffff);
+  match.value.fields = match.mask.fields = 0;
+  SdnFlowKey::MaskRange (match.mask, match.first, match.last);
+  NS_TEST_ASSERT_MSG_EQ (match.Matches (rewritten), true, "The rewritten frame must match on its new source");
+  NS_TEST_ASSERT_MSG_EQ (match.Matches (extracted), false, "The original frame must not match on the new source");
+
+  EthernetHeader ethernet;
+  frame->RemoveHeader (ethernet);
+  Ipv4Header ipv4;
+  ipv4.EnableChecksum ();
+  frame->RemoveHeader (ipv4);
+  NS_TEST_ASSERT_MSG_EQ (ipv4.IsChecksumOk (), true, "Bad IPv4 checksum");
+  NS_TEST_ASSERT_MSG_EQ (ipv4.GetSource (), Ipv4Address ("10.1.1.9"), "Bad IPv4 source");
+  NS_TEST_ASSERT_MSG_EQ (ipv4.GetDestination (), Ipv4Address ("10.1.2.3"), "Bad IPv4 destination");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)ipv4.GetTos (), 0x29, "The ECN bits must be kept");
+  TcpHeader tcp;
+  tcp.EnableChecksums ();
+  tcp.InitializeChecksum (ipv4.GetSource (), ipv4.GetDestination (), 6);
+  frame->RemoveHeader (tcp);
+  NS_TEST_ASSERT_MSG_EQ (tcp.IsChecksumOk (), true, "Bad TCP checksum");
+  NS_TEST_ASSERT_MSG_EQ (tcp.GetSourcePort (), 1234, "Bad TCP source port");
+  NS_TEST_ASSERT_MSG_EQ (tcp.GetDestinationPort (), 8080, "Bad TCP destination port");
 }
 
-// The TestSuite class names the TestSuite, identifies what type of TestSuite,
-// and enables the TestCases to be run.  Typically, only the constructor for
-// this class must be defined
-//
 class SdnTestSuite : public TestSuite
 {
 public:
@@ -58,10 +498,9 @@ public:
 SdnTestSuite::SdnTestSuite ()
   : TestSuite ("sdn", UNIT)
 {
-  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
-  AddTestCase (new SdnTestCase1, TestCase::QUICK);
+  AddTestCase (new SdnPacketParserTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPacketParserKeyTestCase, TestCase::QUICK);
+  AddTestCase (new SdnPacketRewriteTestCase, TestCase::QUICK);
 }
 
-// Do not forget to allocate an instance of this TestSuite
-static SdnTestSuite sdnTestSuite;
-
+static SdnTestSuite g_sdnTestSuite;
@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/SdnTimeoutWheel13.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * Advances the wheel tick by tick until the first timer comes due
+ * \return The tick it came due at, or -1 if none did within maxTicks
+ */
+int64_t
+AdvanceUntilDue (SdnTimeoutWheel13 &wheel, std::vector<SdnTimeoutWheel13::Timer> &due, uint32_t maxTicks)
+{
+  for (uint32_t i = 0; i < maxTicks; ++i)
+    {
+      Time tick = wheel.GetNextTick ();
+      wheel.Advance (due);
+      if (!due.empty ())
+        {
+          return tick.GetTimeStep () / wheel.GetGranularity ().GetTimeStep ();
+        }
+    }
+  return -1;
+}
+
+} // anonymous namespace
+
+/**
+ * Checks timers come due at the tick their deadline rounds up to, never early
+ * and at most one tick late
+ */
+class SdnTimeoutWheelExpiryTestCase : public TestCase
+{
+public:
+  SdnTimeoutWheelExpiryTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnTimeoutWheelExpiryTestCase::SdnTimeoutWheelExpiryTestCase ()
+  : TestCase ("Check timeout wheel expiry")
+{
+}
+
+void
+SdnTimeoutWheelExpiryTestCase::DoRun (void)
+{
+  SdnTimeoutWheel13 wheel;
+  wheel.SetGranularity (MilliSeconds (100));
+  std::vector<SdnTimeoutWheel13::Timer> due;
+
+  // 250ms rounds up to the third tick, 300ms falls on it
+  wheel.Insert (0, 1, MilliSeconds (250));
+  wheel.Insert (0, 2, MilliSeconds (300));
+  wheel.Insert (0, 3, MilliSeconds (301));
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), 3, "Bad number of pending timers");
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetNextTick (), MilliSeconds (100), "Bad next tick");
+
+  NS_TEST_ASSERT_MSG_EQ (AdvanceUntilDue (wheel, due, 10), 3, "Timers came due at the wrong tick");
+  NS_TEST_ASSERT_MSG_EQ (due.size (), 2, "Bad number of due timers");
+  NS_TEST_ASSERT_MSG_EQ (due[0].flowId, 1, "Timers of a tick must come in insertion order");
+  NS_TEST_ASSERT_MSG_EQ (due[1].flowId, 2, "Timers of a tick must come in insertion order");
+  NS_TEST_ASSERT_MSG_EQ (due[0].tick, 3, "Bad timer tick");
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), 1, "Due timers must leave the wheel");
+
+  // a deadline already passed comes due at the next tick
+  due.clear ();
+  wheel.Insert (0, 4, MilliSeconds (100));
+  NS_TEST_ASSERT_MSG_EQ (AdvanceUntilDue (wheel, due, 10), 4, "Timers came due at the wrong tick");
+  NS_TEST_ASSERT_MSG_EQ (due.size (), 2, "Bad number of due timers");
+  NS_TEST_ASSERT_MSG_EQ (due[0].flowId, 3, "Bad due timer");
+  NS_TEST_ASSERT_MSG_EQ (due[1].flowId, 4, "A late timer must come due at the next tick");
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), 0, "The wheel must be empty");
+}
+
+/**
+ * Checks timers further away than one turn of the wheel wait for their round
+ */
+class SdnTimeoutWheelRoundTestCase : public TestCase
+{
+public:
+  SdnTimeoutWheelRoundTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnTimeoutWheelRoundTestCase::SdnTimeoutWheelRoundTestCase ()
+  : TestCase ("Check timeout wheel rounds")
+{
+}
+
+void
+SdnTimeoutWheelRoundTestCase::DoRun (void)
+{
+  SdnTimeoutWheel13 wheel;
+  wheel.SetGranularity (Seconds (1));
+  std::vector<SdnTimeoutWheel13::Timer> due;
+
+  // both timers share slot 10, two rounds apart
+  wheel.Insert (0, 1, Seconds (10 + 2 * SDN_TIMEOUT_WHEEL_SLOTS));
+  wheel.Insert (0, 2, Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ (AdvanceUntilDue (wheel, due, 3 * SDN_TIMEOUT_WHEEL_SLOTS), 10, "Bad tick of the near timer");
+  NS_TEST_ASSERT_MSG_EQ (due.size (), 1, "A later round must stay in the wheel");
+  NS_TEST_ASSERT_MSG_EQ (due[0].flowId, 2, "Bad due timer");
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), 1, "Bad number of pending timers");
+
+  due.clear ();
+  NS_TEST_ASSERT_MSG_EQ (AdvanceUntilDue (wheel, due, 3 * SDN_TIMEOUT_WHEEL_SLOTS), 10 + 2 * SDN_TIMEOUT_WHEEL_SLOTS,
+                         "Bad tick of the far timer");
+  NS_TEST_ASSERT_MSG_EQ (due[0].flowId, 1, "Bad due timer");
+  NS_TEST_ASSERT_MSG_EQ (wheel.GetSize (), 0, "The wheel must be empty");
+}
+
+/**
+ * Checks an empty wheel catches up with the simulation time before taking a
+ * timer, instead of sweeping every tick it missed
+ */
+class SdnTimeoutWheelCatchUpTestCase : public TestCase
+{
+public:
+  SdnTimeoutWheelCatchUpTestCase ();
+  virtual void DoRun (void);
+private:
+  void Insert (void);
+  SdnTimeoutWheel13 m_wheel;
+};
+
+SdnTimeoutWheelCatchUpTestCase::SdnTimeoutWheelCatchUpTestCase ()
+  : TestCase ("Check an empty timeout wheel catches up")
+{
+}
+
+void
+SdnTimeoutWheelCatchUpTestCase::Insert (void)
+{
+  m_wheel.Insert (0, 1, Simulator::Now () + Seconds (5));
+}
+
+void
+SdnTimeoutWheelCatchUpTestCase::DoRun (void)
+{
+  m_wheel.SetGranularity (Seconds (1));
+  Simulator::Schedule (Seconds (1000), &SdnTimeoutWheelCatchUpTestCase::Insert, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_wheel.GetNextTick (), Seconds (1001), "The wheel must resume from the current time");
+  std::vector<SdnTimeoutWheel13::Timer> due;
+  NS_TEST_ASSERT_MSG_EQ (AdvanceUntilDue (m_wheel, due, 10), 1005, "Bad tick of the timer");
+  NS_TEST_ASSERT_MSG_EQ (due.size (), 1, "Bad number of due timers");
+}
+
+class SdnTimeoutWheelTestSuite : public TestSuite
+{
+public:
+  SdnTimeoutWheelTestSuite ();
+};
+
+SdnTimeoutWheelTestSuite::SdnTimeoutWheelTestSuite ()
+  : TestSuite ("sdn-timeout-wheel", UNIT)
+{
+  AddTestCase (new SdnTimeoutWheelExpiryTestCase, TestCase::QUICK);
+  AddTestCase (new SdnTimeoutWheelRoundTestCase, TestCase::QUICK);
+  AddTestCase (new SdnTimeoutWheelCatchUpTestCase, TestCase::QUICK);
+}
+
+static SdnTimeoutWheelTestSuite g_sdnTimeoutWheelTestSuite;
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+
+#include "ns3/test.h"
+#include "ns3/core-config.h"
+#include "ns3/SdnListener.h"
+#include "ns3/SdnWorkerPool.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+
+using namespace ns3;
+
+#ifdef HAVE_PTHREAD_H
+
+namespace {
+
+const uint32_t CONNECTIONS = 7;
+const uint32_t EVENTS = 200;
+
+/**
+ * An event numbered within its connection
+ */
+class OrderEvent : public ControllerEvent
+{
+public:
+  OrderEvent (uint32_t connection, uint32_t seq)
+    : ControllerEvent (0, EVENT_PACKET_IN),
+      connection (connection),
+      seq (seq)
+  {
+  }
+  uint32_t connection;
+  uint32_t seq;
+};
+
+/**
+ * Records the order and the threads the events of each connection are worked on
+ */
+class OrderListener : public SdnListener
+{
+public:
+  OrderListener ()
+    : seen (CONNECTIONS),
+      threads (CONNECTIONS)
+  {
+  }
+  virtual void event_work (ControllerEvent* ev)
+  {
+    OrderEvent* order = static_cast<OrderEvent*> (ev);
+    // uneven work, so the workers drift apart
+    volatile uint32_t spin = 0;
+    for (uint32_t i = 0; i < (order->seq * 7919) % 2000; ++i)
+      {
+        spin += i;
+      }
+    // only the worker of the connection touches its entries
+    seen[order->connection].push_back (order->seq);
+    threads[order->connection].push_back (SystemThread::Self ());
+    ev->work_data = ev;
+  }
+  std::vector< std::vector<uint32_t> > seen;
+  std::vector< std::vector<SystemThread::ThreadId> > threads;
+};
+
+} // anonymous namespace
+
+/**
+ * Checks every submitted event is worked on once, the events of a connection
+ * in submission order and on the same thread
+ */
+class SdnWorkerPoolOrderTestCase : public TestCase
+{
+public:
+  SdnWorkerPoolOrderTestCase ();
+  virtual void DoRun (void);
+};
+
+SdnWorkerPoolOrderTestCase::SdnWorkerPoolOrderTestCase ()
+  : TestCase ("Check worker pool ordering per connection")
+{
+}
+
+void
+SdnWorkerPoolOrderTestCase::DoRun (void)
+{
+  Ptr<OrderListener> listener = CreateObject<OrderListener> ();
+  SdnWorkerPool pool;
+  pool.Start (3, PeekPointer (listener));
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 3, "Bad number of workers");
+
+  // connections interleave, as reads of several switches do
+  std::vector<OrderEvent*> events;
+  std::vector<SdnWorkerPool::Job> jobs (CONNECTIONS * EVENTS);
+  for (uint32_t seq = 0; seq < EVENTS; ++seq)
+    {
+      for (uint32_t connection = 0; connection < CONNECTIONS; ++connection)
+        {
+          OrderEvent* event = new OrderEvent (connection, seq);
+          SdnWorkerPool::Job &job = jobs[events.size ()];
+          events.push_back (event);
+          job.event = event;
+          pool.Submit (connection, &job);
+        }
+    }
+  for (uint32_t i = 0; i < jobs.size (); ++i)
+    {
+      pool.Wait (&jobs[i]);
+      NS_TEST_EXPECT_MSG_EQ (events[i]->work_data, events[i], "Event " << i << " was not worked on");
+    }
+  pool.Stop ();
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 0, "The pool must be stopped");
+
+  for (uint32_t connection = 0; connection < CONNECTIONS; ++connection)
+    {
+      const std::vector<uint32_t> &seen = listener->seen[connection];
+      NS_TEST_EXPECT_MSG_EQ (seen.size (), EVENTS, "Bad number of events of connection " << connection);
+      for (uint32_t seq = 0; seq < seen.size (); ++seq)
+        {
+          NS_TEST_EXPECT_MSG_EQ (seen[seq], seq, "Event out of order on connection " << connection);
+        }
+      const std::vector<SystemThread::ThreadId> &threads = listener->threads[connection];
+      for (uint32_t i = 1; i < threads.size (); ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ ((pthread_equal (threads[i], threads[0]) != 0), true,
+                                 "Connection " << connection << " changed threads");
+        }
+    }
+  for (uint32_t i = 0; i < events.size (); ++i)
+    {
+      delete events[i];
+    }
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+class SdnWorkerPoolTestSuite : public TestSuite
+{
+public:
+  SdnWorkerPoolTestSuite ();
+};
+
+SdnWorkerPoolTestSuite::SdnWorkerPoolTestSuite ()
+  : TestSuite ("sdn-worker-pool", UNIT)
+{
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new SdnWorkerPoolOrderTestCase, TestCase::QUICK);
+#endif
+}
+
+static SdnWorkerPoolTestSuite g_sdnWorkerPoolTestSuite;
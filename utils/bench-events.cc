@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Measure the cost of scheduling and invoking events which do nothing,
+ * that is mostly the creation and destruction of the EventImpl closures
+ * plus the scheduler.
+ *
+ *  - burst: schedule all the events up front, then run them.
+ *  - chain: keep a population of events, each one scheduling the next.
+ */
+
+std::string g_me;
+#define LOG(x)   std::cout << x << std::endl
+#define LOGME(x) LOG (g_me << x)
+
+// Output field width
+int g_fwidth = 14;
+
+class EventBench
+{
+public:
+  EventBench (uint32_t total)
+    : m_total (total),
+      m_count (0)
+  {
+  }
+  void Empty (void)
+  {
+  }
+  void EmptyArgs (uint32_t a, double b)
+  {
+  }
+  void Chain (void)
+  {
+    if (++m_count < m_total)
+      {
+        Simulator::Schedule (NanoSeconds (100), &EventBench::Chain, this);
+      }
+  }
+  uint32_t m_total;
+  uint32_t m_count;
+};
+
+static void
+EmptyFunction (void)
+{
+}
+
+static void
+Report (std::string name, uint32_t events, double init, double simu)
+{
+  LOG (std::left << std::setw (2 * g_fwidth) << name <<
+       std::left << std::setw (g_fwidth) << init <<
+       std::left << std::setw (g_fwidth) << simu <<
+       std::left << std::setw (g_fwidth) << (events / (init + simu)));
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t total = 10000000;
+  uint32_t pop   =     1000;
+  uint32_t runs  =        1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the scheduling and invocation of empty events.");
+  cmd.AddValue ("total", "total number of events (default 1E7)",           total);
+  cmd.AddValue ("pop",   "population of the chain benchmark (default 1E3)", pop);
+  cmd.AddValue ("runs",  "number of runs (default 1)",                       runs);
+  cmd.Parse (argc, argv);
+  g_me = cmd.GetName () + ": ";
+
+  LOGME ("total events: " << total);
+  LOGME ("chain population: " << pop);
+  LOGME ("runs: " << runs);
+
+  LOG ("");
+  LOG (std::left << std::setw (2 * g_fwidth) << "Benchmark" <<
+       std::left << std::setw (g_fwidth) << "Init (s)" <<
+       std::left << std::setw (g_fwidth) << "Run (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)");
+
+  // prime: the first run stops the bookkeeping of the Time objects
+  // created before the resolution is frozen
+  Simulator::Schedule (NanoSeconds (1), &EmptyFunction);
+  Simulator::Run ();
+
+  SystemWallClockMs time;
+  for (uint32_t r = 0; r < runs; r++)
+    {
+      EventBench bench (total);
+      double init, simu;
+
+      time.Start ();
+      for (uint32_t i = 0; i < total; i++)
+        {
+          Simulator::Schedule (NanoSeconds (i), &EmptyFunction);
+        }
+      init = time.End () / 1000.0;
+      time.Start ();
+      Simulator::Run ();
+      simu = time.End () / 1000.0;
+      Report ("burst function", total, init, simu);
+
+      time.Start ();
+      for (uint32_t i = 0; i < total; i++)
+        {
+          Simulator::Schedule (NanoSeconds (i), &EventBench::Empty, &bench);
+        }
+      init = time.End () / 1000.0;
+      time.Start ();
+      Simulator::Run ();
+      simu = time.End () / 1000.0;
+      Report ("burst member", total, init, simu);
+
+      time.Start ();
+      for (uint32_t i = 0; i < total; i++)
+        {
+          Simulator::Schedule (NanoSeconds (i), &EventBench::EmptyArgs, &bench, i, 1.0);
+        }
+      init = time.End () / 1000.0;
+      time.Start ();
+      Simulator::Run ();
+      simu = time.End () / 1000.0;
+      Report ("burst member 2 args", total, init, simu);
+
+      time.Start ();
+      for (uint32_t i = 0; i < pop; i++)
+        {
+          Simulator::Schedule (NanoSeconds (i), &EventBench::Chain, &bench);
+        }
+      init = time.End () / 1000.0;
+      time.Start ();
+      Simulator::Run ();
+      simu = time.End () / 1000.0;
+      Report ("chain", total, init, simu);
+
+      Simulator::Destroy ();
+    }
+
+  LOG ("");
+  return 0;
+}
@@ -23,6 +23,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <stdlib.h> // for exit ()
 
 using namespace ns3;
@@ -241,11 +242,43 @@ benchC (uint32_t n)
   }
 }
 
+static void
+benchE (uint32_t n)
+{
+  BenchHeader<25> ipv4;
+  BenchHeader<8> udp;
+  BenchHeader<14> ethernet;
+
+  // keep a window of packets alive, the way queues and links do, and
+  // replace one of them by a control message or a full frame each time
+  std::vector<Ptr<Packet> > window (256);
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p;
+    if (i % 4 == 0)
+      {
+        p = Create<Packet> (64);
+        p->AddHeader (udp);
+      }
+    else
+      {
+        p = Create<Packet> (1500 - 25 - 8);
+        p->AddHeader (udp);
+        p->AddHeader (ipv4);
+        p->AddHeader (ethernet);
+        Ptr<Packet> o = p->Copy ();
+        o->RemoveHeader (ethernet);
+      }
+    window[(i * 7) % window.size ()] = p;
+  }
+}
+
 
 static void
 runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
 {
   SystemWallClockMs time;
+  uint64_t hits = Buffer::GetPoolHits ();
+  uint64_t misses = Buffer::GetPoolMisses ();
   time.Start ();
   (*bench) (n);
   uint64_t deltaMs = time.End ();
@@ -253,7 +286,9 @@ runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
   ps *= 1000;
   ps /= deltaMs;
   std::cout << ps << " packets/s"
-            << " (" << deltaMs << " ms elapsed)\t"
+            << " (" << deltaMs << " ms elapsed, "
+            << Buffer::GetPoolHits () - hits << " pool hits, "
+            << Buffer::GetPoolMisses () - misses << " misses)\t"
             << name
             << std::endl;
 }
@@ -289,6 +324,7 @@ int main (int argc, char *argv[])
   runBench (&benchB, n, "Just add headers");
   runBench (&benchC, n, "Remove by func call");
   runBench (&benchD, n, "Intermixed add/remove headers and tags");
+  runBench (&benchE, n, "Churn of control messages and frames");
 
   return 0;
 }
@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors: Jared Ivey <j.ivey@gatech.edu>
+ *          Michael Riley <mriley7@gatech.edu>
+ */
+
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+/*
+ * Drive the Scheduler implementations directly, without a simulator,
+ * so that only the cost of Insert, RemoveNext and Remove is measured.
+ *
+ * Two event distributions are available:
+ *  - hold: the classic hold model. A fixed population of events; each
+ *    event removed is inserted back at now plus an exponential delay.
+ *  - sdn: what an SDN run looks like to the scheduler. Most of the
+ *    population is flow timers one to ten seconds ahead, a few senders
+ *    reschedule themselves every few microseconds and every other send
+ *    refreshes a random flow timer. As with EventId::Cancel, the old
+ *    timer stays queued and is dropped when it comes out; one refresh in
+ *    a hundred goes through Scheduler::Remove instead, as Simulator::Remove
+ *    would.
+ */
+
+std::string g_me;
+#define LOG(x)   std::cout << x << std::endl
+#define LOGME(x) LOG (g_me << x)
+
+// Output field width
+int g_fwidth = 14;
+
+class SchedulerBench
+{
+public:
+  SchedulerBench (std::string mode, uint32_t population, uint32_t total)
+    : m_mode (mode),
+      m_population (population),
+      m_total (total),
+      m_uid (0),
+      m_rand (88172645463325252ULL)
+  {
+  }
+  /**
+   * \param scheduler the scheduler to fill and run
+   * \param init set to the time taken to insert the population, in s
+   * \param simu set to the time taken to run total events, in s
+   */
+  void RunBench (Ptr<Scheduler> scheduler, double &init, double &simu);
+
+private:
+  /* xorshift64, cheap enough not to show in the measure */
+  uint64_t Random (void)
+  {
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 7;
+    m_rand ^= m_rand << 17;
+    return m_rand;
+  }
+  /* uniform in [min, max) */
+  uint64_t Uniform (uint64_t min, uint64_t max)
+  {
+    return min + Random () % (max - min);
+  }
+  /* exponential with the given mean */
+  uint64_t Exponential (double mean)
+  {
+    double u = (Random () >> 11) * (1.0 / 9007199254740992.0);
+    return (uint64_t)(-mean * std::log (1.0 - u)) + 1;
+  }
+  Scheduler::Event MakeEvent (uint64_t ts, uint32_t context)
+  {
+    Scheduler::Event ev;
+    ev.impl = 0;
+    ev.key.m_ts = ts;
+    ev.key.m_uid = m_uid++;
+    ev.key.m_context = context;
+    return ev;
+  }
+
+  std::string m_mode;
+  uint32_t m_population;
+  uint32_t m_total;
+  uint32_t m_uid;
+  uint64_t m_rand;
+};
+
+void
+SchedulerBench::RunBench (Ptr<Scheduler> scheduler, double &init, double &simu)
+{
+  SystemWallClockMs time;
+  m_uid = 0;
+  m_rand = 88172645463325252ULL;
+
+  // sdn: context 0 is a send, context i > 0 the timer of flow i - 1
+  uint32_t senders = std::max<uint32_t> (1, m_population / 100);
+  std::vector<Scheduler::Event> timers;
+
+  time.Start ();
+  if (m_mode == "hold")
+    {
+      for (uint32_t i = 0; i < m_population; ++i)
+        {
+          scheduler->Insert (MakeEvent (Exponential (100), 0));
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < senders; ++i)
+        {
+          scheduler->Insert (MakeEvent (Uniform (1000, 10000), 0));
+        }
+      for (uint32_t i = senders; i < m_population; ++i)
+        {
+          timers.push_back (MakeEvent (Uniform (1000000000ULL, 10000000000ULL), timers.size () + 1));
+          scheduler->Insert (timers.back ());
+        }
+    }
+  init = time.End () / 1000.0;
+
+  time.Start ();
+  for (uint32_t i = 0; i < m_total; ++i)
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      uint64_t now = ev.key.m_ts;
+      if (m_mode == "hold")
+        {
+          scheduler->Insert (MakeEvent (now + Exponential (100), 0));
+        }
+      else if (ev.key.m_context == 0)
+        {
+          scheduler->Insert (MakeEvent (now + Uniform (1000, 10000), 0));
+          if (!timers.empty () && (Random () & 1))
+            {
+              uint32_t flow = Random () % timers.size ();
+              if (Random () % 100 == 0)
+                {
+                  scheduler->Remove (timers[flow]);
+                }
+              timers[flow] = MakeEvent (now + Uniform (1000000000ULL, 10000000000ULL), flow + 1);
+              scheduler->Insert (timers[flow]);
+            }
+        }
+      else if (ev.key.m_uid == timers[ev.key.m_context - 1].key.m_uid)
+        {
+          // the flow expired, a new one takes its place
+          uint32_t flow = ev.key.m_context - 1;
+          timers[flow] = MakeEvent (now + Uniform (1000000000ULL, 10000000000ULL), flow + 1);
+          scheduler->Insert (timers[flow]);
+        }
+    }
+  simu = time.End () / 1000.0;
+
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+    }
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t pop   =  100000;
+  uint32_t total = 1000000;
+  uint32_t runs  =       1;
+  std::string mode = "hold";
+  std::string schedulers = "ns3::MapScheduler,ns3::HeapScheduler,ns3::DaryHeapScheduler,"
+                           "ns3::LadderScheduler,ns3::CalendarScheduler,ns3::ListScheduler";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the scheduler implementations against each other.\n"
+             "\n"
+             "Events are inserted and removed directly, without a simulator,\n"
+             "following either the hold model (--mode=hold) or a mix of\n"
+             "frequent sends and long, refreshed flow timers (--mode=sdn).\n"
+             "ListScheduler is skipped for populations above 10000.");
+  cmd.AddValue ("mode",  "event distribution, hold or sdn (default hold)",  mode);
+  cmd.AddValue ("sched", "comma separated list of scheduler TypeIds",       schedulers);
+  cmd.AddValue ("pop",   "event population size (default 1E5)",           pop);
+  cmd.AddValue ("total", "total number of events to run (default 1E6)",   total);
+  cmd.AddValue ("runs",  "number of runs (default 1)",                      runs);
+  cmd.Parse (argc, argv);
+  g_me = cmd.GetName () + ": ";
+
+  if (mode != "hold" && mode != "sdn")
+    {
+      NS_FATAL_ERROR ("Unknown mode " << mode);
+    }
+
+  LOGME ("mode: " << mode);
+  LOGME ("population: " << pop);
+  LOGME ("total events: " << total);
+  LOGME ("runs: " << runs);
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (2 * g_fwidth) << "Scheduler" <<
+       std::left << std::setw (g_fwidth) << "Init (s)" <<
+       std::left << std::setw (g_fwidth) << "Run (s)" <<
+       std::left << std::setw (g_fwidth) << "Per (ns/ev)");
+
+  SchedulerBench bench (mode, pop, total);
+  std::istringstream names (schedulers);
+  std::string name;
+  while (std::getline (names, name, ','))
+    {
+      if (name == "ns3::ListScheduler" && pop > 10000)
+        {
+          continue;
+        }
+      ObjectFactory factory (name);
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          double init, simu;
+          bench.RunBench (factory.Create<Scheduler> (), init, simu);
+          LOG (std::left << std::setw (2 * g_fwidth) << name <<
+               std::left << std::setw (g_fwidth) << init <<
+               std::left << std::setw (g_fwidth) << simu <<
+               std::left << std::setw (g_fwidth) << (simu * 1e9 / total));
+        }
+    }
+
+  LOG ("");
+  return 0;
+}